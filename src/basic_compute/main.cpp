@@ -1,4 +1,5 @@
 #include "../app.hpp"
+#include "../resource_budget.hpp"
 #include <glm/glm.hpp>
 
 #include "shared.inl"
@@ -67,7 +68,7 @@ struct BasicComputeApp : public App {
             .name = "compute pipeline"
         }).value();
 
-        render_image = device.create_image(daxa::ImageInfo{
+        render_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, daxa::ImageInfo{
             .format = daxa::Format::R8G8B8A8_UNORM,
             .size = {size_x, size_y, 1},
             .usage = daxa::ImageUsageFlagBits::SHADER_STORAGE | daxa::ImageUsageFlagBits::TRANSFER_SRC,
@@ -113,7 +114,7 @@ struct BasicComputeApp : public App {
     ~BasicComputeApp() {
         device.wait_idle();
         device.collect_garbage();
-        device.destroy_image(render_image);
+        ResourceBudget::get().destroy_image(device, render_image);
     }
 
     void render() {
@@ -138,8 +139,8 @@ struct BasicComputeApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(render_image);
-            render_image = device.create_image(daxa::ImageInfo{
+            ResourceBudget::get().destroy_image(device, render_image);
+            render_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, daxa::ImageInfo{
                 .format = daxa::Format::R8G8B8A8_UNORM,
                 .size = {size_x, size_y, 1},
                 .usage = daxa::ImageUsageFlagBits::SHADER_STORAGE | daxa::ImageUsageFlagBits::TRANSFER_SRC,
@@ -1,4 +1,5 @@
 #include "../app.hpp"
+#include "../resource_budget.hpp"
 #include "../camera.hpp"
 
 #include <glm/glm.hpp>
@@ -151,7 +152,7 @@ struct BasicForwardApp : public App {
     daxa::ImGuiRenderer imgui_renderer;
 
     BasicForwardApp() : App("Basic Forward Example") {
-        vertex_buffer = device.create_buffer({
+        vertex_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, {
             .size = static_cast<u32>(36 * sizeof(Vertex)),
             .allocate_info = daxa::AutoAllocInfo{daxa::MemoryFlagBits::DEDICATED_MEMORY},
             .name = "vertex buffer"
@@ -176,7 +177,7 @@ struct BasicForwardApp : public App {
             .push_constant_size = sizeof(DrawPush),
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -251,8 +252,8 @@ struct BasicForwardApp : public App {
     ~BasicForwardApp() {
         device.wait_idle();
         device.collect_garbage();
-        device.destroy_buffer(vertex_buffer);
-        device.destroy_image(depth_image);
+        ResourceBudget::get().destroy_buffer(device, vertex_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
     }
 
     void render() {
@@ -291,8 +292,8 @@ struct BasicForwardApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -1,4 +1,6 @@
 #include "../app.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 #include <glm/glm.hpp>
 
 #include <daxa/utils/imgui.hpp>
@@ -269,7 +271,7 @@ struct BloomApp : public App {
     f32 bloom_strength = 2.0f;
 
     BloomApp() : App("Bloom Example") {
-        vertex_buffer = device.create_buffer({
+        vertex_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, {
             .size = 4 * sizeof(Vertex),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "vertex buffer"
@@ -280,7 +282,7 @@ struct BloomApp : public App {
             .name = "task vertex buffer",
         });
 
-        index_buffer = device.create_buffer({
+        index_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, {
             .size = 6 * sizeof(u32),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "index buffer"
@@ -310,7 +312,7 @@ struct BloomApp : public App {
         upload_task_graph.complete({});
         upload_task_graph.execute({});
 
-        render_image = device.create_image({
+        render_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = swapchain.get_format(),
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -322,7 +324,7 @@ struct BloomApp : public App {
             .name = "task render image"
         }};
 
-        bloom_image = device.create_image({
+        bloom_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = swapchain.get_format(),
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -334,7 +336,7 @@ struct BloomApp : public App {
             .name = "task bloom image"
         }};
 
-        sampler_id = device.create_sampler({
+        sampler_id = SamplerCache::get().acquire(device, {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -417,7 +419,7 @@ struct BloomApp : public App {
             BloomMip mip;
             mip.int_size = mip_int_size;
             mip.size = mip_size;
-            mip.texture = device.create_image({
+            mip.texture = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = swapchain.get_format(),
                 .size = { static_cast<u32>(mip_int_size.x), static_cast<u32>(mip_int_size.y), 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -445,13 +447,13 @@ struct BloomApp : public App {
     }
 
     ~BloomApp() {
-        device.destroy_buffer(vertex_buffer);
-        device.destroy_buffer(index_buffer);
-        device.destroy_sampler(sampler_id);
-        device.destroy_image(render_image);
-        device.destroy_image(bloom_image);
+        ResourceBudget::get().destroy_buffer(device, vertex_buffer);
+        ResourceBudget::get().destroy_buffer(device, index_buffer);
+        SamplerCache::get().release(device, sampler_id);
+        ResourceBudget::get().destroy_image(device, render_image);
+        ResourceBudget::get().destroy_image(device, bloom_image);
         for(auto& img : mip_chain) {
-            device.destroy_image(img.texture);
+            ResourceBudget::get().destroy_image(device, img.texture);
         }
 
         ImGui_ImplGlfw_Shutdown();
@@ -475,7 +477,7 @@ struct BloomApp : public App {
             ImGui::Begin("bloom settings");
             if(ImGui::DragInt("mip levels", &mip_levels, 1.0f, 1, 10)) {
                 for(auto& img : mip_chain) {
-                    device.destroy_image(img.texture);
+                    ResourceBudget::get().destroy_image(device, img.texture);
                 }
 
                 mip_chain.clear();
@@ -490,7 +492,7 @@ struct BloomApp : public App {
                     BloomMip mip;
                     mip.int_size = mip_int_size;
                     mip.size = mip_size;
-                    mip.texture = device.create_image({
+                    mip.texture = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                         .format = swapchain.get_format(),
                         .size = { static_cast<u32>(mip_int_size.x), static_cast<u32>(mip_int_size.y), 1 },
                         .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -613,7 +615,7 @@ struct BloomApp : public App {
             size_y = swapchain.get_surface_extent().y;
 
             for(auto& img : mip_chain) {
-                device.destroy_image(img.texture);
+                ResourceBudget::get().destroy_image(device, img.texture);
             }
 
             mip_chain.clear();
@@ -628,7 +630,7 @@ struct BloomApp : public App {
                 BloomMip mip;
                 mip.int_size = mip_int_size;
                 mip.size = mip_size;
-                mip.texture = device.create_image({
+                mip.texture = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                     .format = swapchain.get_format(),
                     .size = { static_cast<u32>(mip_int_size.x), static_cast<u32>(mip_int_size.y), 1 },
                     .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -643,16 +645,16 @@ struct BloomApp : public App {
                 mip_chain.push_back(std::move(mip));
             }
 
-            device.destroy_image(render_image);
-            render_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, render_image);
+            render_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = swapchain.get_format(),
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
             });
             task_render_image.set_images({.images = std::span{&render_image, 1}});
 
-            device.destroy_image(bloom_image);
-            bloom_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, bloom_image);
+            bloom_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = swapchain.get_format(),
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
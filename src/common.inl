@@ -2,36 +2,130 @@
 #define DAXA_ENABLE_SHADER_NO_NAMESPACE 1
 #include <daxa/daxa.inl>
 
+// finest mip any pixel asked for since the TextureStreamer last read it, ~0 when nothing sampled the texture
+struct TextureFeedback {
+    u32 desired_mip;
+};
+
+DAXA_DECL_BUFFER_PTR(TextureFeedback)
+
 struct TextureId {
     daxa_ImageViewId image_id;
     daxa_SamplerId sampler_id;
+    // only used when streamed is set, the image starts at level first_mip of the full chain
+    daxa_RWBufferPtr(TextureFeedback) feedback;
+    u32 first_mip;
+    u32 streamed;
 };
 
-#define sample_texture(tex, uv) texture(daxa_sampler2D(tex.image_id, tex.sampler_id), uv)
+#if DAXA_SHADER
+f32vec4 sample_texture(TextureId tex, f32vec2 uv) {
+#if DAXA_SHADER_STAGE == DAXA_SHADER_STAGE_FRAGMENT
+    // one 2x2 quad out of every 16x16 pixels reports, whole quads so the lod still has its derivatives
+    if(tex.streamed != 0 && ((u32(gl_FragCoord.x) | u32(gl_FragCoord.y)) & 14) == 0) {
+        f32 lod = textureQueryLod(daxa_sampler2D(tex.image_id, tex.sampler_id), uv).y;
+        u32 mip = u32(max(lod, 0.0)) + tex.first_mip;
+        if(mip < deref(tex.feedback).desired_mip) {
+            atomicMin(deref(tex.feedback).desired_mip, mip);
+        }
+    }
+#endif
+    return texture(daxa_sampler2D(tex.image_id, tex.sampler_id), uv);
+}
+#endif
+
+// one entry of the texture table of a model, layer is where the texture sits in a shared array image or
+// MATERIAL_NO_LAYER when it has an image of its own
+struct MaterialTexture {
+    TextureId texture;
+    u32 layer;
+};
+
+DAXA_DECL_BUFFER_PTR(MaterialTexture)
+
+#define MATERIAL_ALBEDO 0
+#define MATERIAL_METALLIC_ROUGHNESS 1
+#define MATERIAL_NORMAL 2
+#define MATERIAL_OCCLUSION 3
+#define MATERIAL_EMISSIVE 4
+#define MATERIAL_SLOT_COUNT 5
+#define MATERIAL_NO_LAYER 0xffffffff
 
+// 32 bytes instead of five TextureIds with a flag each. bit slot of flags is set when the material uses an image in that
+// slot, slots without one index the null texture at the start of the table. the entry of an image that is still
+// streaming in points at the null texture as well
 struct Material {
-    TextureId albedo_image;
-    i32 has_albedo_image;
-    TextureId mettalic_roughness_image;
-    i32 has_mettalic_roughness_image;
-    TextureId normal_image;
-    i32 has_normal_image;
-    TextureId occlusion_image;
-    i32 has_occlusion_image;
-    TextureId emissive_image;
-    i32 has_emissive_image;
+    daxa_BufferPtr(MaterialTexture) textures;
+    u32 texture_indices[MATERIAL_SLOT_COUNT];
+    u32 flags;
 };
 
 DAXA_DECL_BUFFER_PTR(Material)
 
+#if DAXA_SHADER
+// tangent space normal out of the x and y of a normal map, z is whatever makes it unit length and faces out of the surface.
+// works for RG8 and BC5 normal maps as well as RGBA ones, which just ignore their blue channel then
+f32vec3 unpack_normal(f32vec2 xy) {
+    f32vec2 n = xy * 2.0 - 1.0;
+    return f32vec3(n, sqrt(max(1.0 - dot(n, n), 0.0)));
+}
+
+bool material_has(Material material, u32 slot) {
+    return (material.flags & (1u << slot)) != 0;
+}
+
+f32vec4 sample_material(Material material, u32 slot, f32vec2 uv) {
+    MaterialTexture entry = deref(material.textures[material.texture_indices[slot]]);
+    if(entry.layer == MATERIAL_NO_LAYER) {
+        return sample_texture(entry.texture, uv);
+    }
+    return texture(daxa_sampler2DArray(entry.texture.image_id, entry.texture.sampler_id), f32vec3(uv, f32(entry.layer)));
+}
+#endif
+
 struct Primitive {
     u32 first_index;
     u32 first_vertex;
     u32 index_count;
     u32 vertex_count;
     u32 material_index;
+    f32vec3 aabb_min;
+    f32vec3 aabb_max;
+    // sphere around the center of the aabb that still contains every vertex
+    f32 bounding_radius;
+    u32 first_meshlet;
+    u32 meshlet_count;
+    u32 first_lod;
+    u32 lod_count;
+};
+
+DAXA_DECL_BUFFER_PTR(Primitive)
+
+// at most 64 vertices and 124 triangles, vertex_offset indexes the meshlet vertex buffer which holds
+// indices into the vertex buffer, triangle_offset indexes the meshlet triangle buffer which holds
+// three 8 bit meshlet local vertex indices per u32
+struct Meshlet {
+    u32 vertex_offset;
+    u32 triangle_offset;
+    u32 vertex_count;
+    u32 triangle_count;
+    u32 primitive_index;
 };
 
+DAXA_DECL_BUFFER_PTR(Meshlet)
+
+// bounding sphere and normal cone, the meshlet is backfacing when
+// dot(normalize(cone_apex - camera_position), cone_axis) >= cone_cutoff
+struct MeshletBounds {
+    f32vec3 center;
+    f32 radius;
+    f32vec3 cone_apex;
+    f32vec3 cone_axis;
+    f32 cone_cutoff;
+};
+
+DAXA_DECL_BUFFER_PTR(MeshletBounds)
+
 struct Vertex {
     f32vec3 position;
     f32vec3 normal;
@@ -39,4 +133,56 @@ struct Vertex {
     f32vec4 tangent;
 };
 
-DAXA_DECL_BUFFER_PTR(Vertex)
\ No newline at end of file
+DAXA_DECL_BUFFER_PTR(Vertex)
+
+// 20 byte vertex, position is unorm16 inside the primitive aabb with the tangent sign in the last 16 bits,
+// normal and tangent are octahedral snorm16x2 and uv is half2
+struct PackedVertex {
+    u32vec2 position;
+    u32 normal;
+    u32 tangent;
+    u32 uv;
+};
+
+DAXA_DECL_BUFFER_PTR(PackedVertex)
+
+#if defined(PACKED_VERTICES) && PACKED_VERTICES
+#define VertexBufferPtr daxa_BufferPtr(PackedVertex)
+#else
+#define VertexBufferPtr daxa_BufferPtr(Vertex)
+#endif
+
+#if DAXA_SHADER
+u32vec3 unpack_meshlet_triangle(u32 packed_triangle) {
+    return u32vec3(packed_triangle & 0xff, (packed_triangle >> 8) & 0xff, (packed_triangle >> 16) & 0xff);
+}
+
+f32vec3 decode_octahedral(u32 encoded) {
+    f32vec2 e = unpackSnorm2x16(encoded);
+    f32vec3 v = f32vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * mix(f32vec2(-1.0), f32vec2(1.0), greaterThanEqual(v.xy, f32vec2(0.0)));
+    }
+    return normalize(v);
+}
+
+Vertex unpack_vertex(PackedVertex packed_vertex, Primitive primitive) {
+    f32vec3 quantized = f32vec3(packed_vertex.position.x & 0xffff, packed_vertex.position.x >> 16, packed_vertex.position.y & 0xffff) / 65535.0;
+
+    Vertex vertex;
+    vertex.position = primitive.aabb_min + quantized * (primitive.aabb_max - primitive.aabb_min);
+    vertex.normal = decode_octahedral(packed_vertex.normal);
+    vertex.uv = unpackHalf2x16(packed_vertex.uv);
+    vertex.tangent = f32vec4(decode_octahedral(packed_vertex.tangent), (packed_vertex.position.y >> 16) != 0 ? -1.0 : 1.0);
+    return vertex;
+}
+
+// primitive_index is only read for the packed layout
+Vertex get_vertex(VertexBufferPtr vertices, daxa_BufferPtr(Primitive) primitives, u32 primitive_index, u32 vertex_index) {
+#if defined(PACKED_VERTICES) && PACKED_VERTICES
+    return unpack_vertex(deref(vertices[vertex_index]), deref(primitives[primitive_index]));
+#else
+    return deref(vertices[vertex_index]);
+#endif
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "tests.hpp"
+#include "../ktx2.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+    // byte offsets into the KTX2 header and the first entry of the level index behind it
+    constexpr usize FORMAT_OFFSET = 12;
+    constexpr usize LEVEL_COUNT_OFFSET = 40;
+    constexpr usize SUPERCOMPRESSION_OFFSET = 44;
+    constexpr usize LEVEL_INDEX_OFFSET = 80;
+    constexpr usize LEVEL_INDEX_SIZE = 24;
+
+    // RGBA8 chain of a size x size image, every level filled with a different pattern
+    auto make_levels(u32 size) -> std::vector<std::vector<u8>> {
+        std::vector<std::vector<u8>> levels = {};
+        for(u32 level_size = size; level_size > 0; level_size /= 2) {
+            std::vector<u8> level(level_size * level_size * 4);
+            for(usize i = 0; i < level.size(); i++) {
+                level[i] = static_cast<u8>(i * 7 + levels.size() * 31);
+            }
+            levels.push_back(std::move(level));
+        }
+        return levels;
+    }
+
+    auto write_test_file(const std::string& name, const std::vector<std::vector<u8>>& levels, u32 size, Ktx2Supercompression supercompression) -> std::filesystem::path {
+        std::vector<std::span<const u8>> level_spans(levels.begin(), levels.end());
+        std::filesystem::path path = get_test_directory() / name;
+        write_ktx2(path, {
+            .format = daxa::Format::R8G8B8A8_UNORM,
+            .size_x = size,
+            .size_y = size,
+            .levels = level_spans,
+            .supercompression = supercompression,
+        });
+        return path;
+    }
+
+    auto read_file(const std::filesystem::path& path) -> std::vector<u8> {
+        std::ifstream stream(path, std::ios::binary);
+        return std::vector<u8>(std::istreambuf_iterator<char>(stream), {});
+    }
+
+    void write_file(const std::filesystem::path& path, std::span<const u8> bytes) {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    // a copy of source with one u32 or u64 replaced, the rest of the file stays valid
+    template <typename T>
+    auto write_patched(const std::filesystem::path& source, const std::string& name, usize offset, T value) -> std::filesystem::path {
+        std::vector<u8> bytes = read_file(source);
+        std::memcpy(bytes.data() + offset, &value, sizeof(T));
+        std::filesystem::path path = get_test_directory() / name;
+        write_file(path, bytes);
+        return path;
+    }
+
+    void check_levels(const Ktx2File& file, const std::vector<std::vector<u8>>& levels) {
+        check(file.levels.size() == levels.size(), "expected " + std::to_string(levels.size()) + " levels, got " + std::to_string(file.levels.size()));
+
+        std::vector<std::byte> staging(file.get_staging_size());
+        std::vector<usize> offsets = file.get_staging_offsets();
+        for(u32 level = 0; level < levels.size(); level++) {
+            check(offsets[level] % 16 == 0, "staging offset of level " + std::to_string(level) + " isnt aligned");
+            check(file.levels[level].uncompressed_size == levels[level].size(), "wrong size of level " + std::to_string(level));
+            file.read_level(level, std::span(staging).subspan(offsets[level]));
+            check(std::memcmp(staging.data() + offsets[level], levels[level].data(), levels[level].size()) == 0, "level " + std::to_string(level) + " came back different");
+        }
+    }
+
+    void accepts_uncompressed_file() {
+        std::vector<std::vector<u8>> levels = make_levels(32);
+        Ktx2File file(write_test_file("uncompressed.ktx2", levels, 32, Ktx2Supercompression::NONE));
+
+        check(file.format == daxa::Format::R8G8B8A8_UNORM, "wrong format");
+        check(file.size_x == 32 && file.size_y == 32, "wrong size");
+        check(file.supercompression == Ktx2Supercompression::NONE, "wrong supercompression");
+        check(!file.generate_mips, "the file has its whole chain");
+        check_levels(file, levels);
+    }
+
+    void accepts_zstd_file() {
+        std::vector<std::vector<u8>> levels = make_levels(64);
+        std::filesystem::path path = write_test_file("zstd.ktx2", levels, 64, Ktx2Supercompression::ZSTD);
+        Ktx2File file(path);
+
+        check(file.supercompression == Ktx2Supercompression::ZSTD, "wrong supercompression");
+        check(file.levels[0].data.size() < levels[0].size(), "level 0 didnt get smaller");
+        check_levels(file, levels);
+    }
+
+    void rejects_truncated_header() {
+        std::filesystem::path source = write_test_file("valid.ktx2", make_levels(8), 8, Ktx2Supercompression::NONE);
+        std::vector<u8> bytes = read_file(source);
+        for(usize size : { usize{ 0 }, usize{ 11 }, usize{ 40 }, LEVEL_INDEX_OFFSET - 1, LEVEL_INDEX_OFFSET + LEVEL_INDEX_SIZE - 1 }) {
+            std::filesystem::path path = get_test_directory() / "truncated.ktx2";
+            write_file(path, std::span(bytes).first(size));
+            check_throws([&] { Ktx2File file(path); }, "header cut to " + std::to_string(size) + " bytes got accepted");
+        }
+    }
+
+    void rejects_truncated_level_data() {
+        std::filesystem::path source = write_test_file("valid.ktx2", make_levels(8), 8, Ktx2Supercompression::NONE);
+        std::vector<u8> bytes = read_file(source);
+        std::filesystem::path path = get_test_directory() / "truncated_levels.ktx2";
+        write_file(path, std::span(bytes).first(bytes.size() - 1));
+        check_throws([&] { Ktx2File file(path); }, "level running past the end of the file got accepted");
+    }
+
+    void rejects_corrupt_header() {
+        std::filesystem::path source = write_test_file("valid.ktx2", make_levels(8), 8, Ktx2Supercompression::NONE);
+
+        std::filesystem::path bad_identifier = write_patched<u8>(source, "bad_identifier.ktx2", 1, 'X');
+        check_throws([&] { Ktx2File file(bad_identifier); }, "wrong identifier got accepted");
+
+        std::filesystem::path basis = write_patched<u32>(source, "basis.ktx2", SUPERCOMPRESSION_OFFSET, static_cast<u32>(Ktx2Supercompression::BASIS_LZ));
+        check_throws([&] { Ktx2File file(basis); }, "BasisLZ supercompression got accepted");
+
+        std::filesystem::path unknown_scheme = write_patched<u32>(source, "unknown_scheme.ktx2", SUPERCOMPRESSION_OFFSET, 77u);
+        check_throws([&] { Ktx2File file(unknown_scheme); }, "unknown supercompression got accepted");
+
+        std::filesystem::path level_count = write_patched<u32>(source, "level_count.ktx2", LEVEL_COUNT_OFFSET, 1000u);
+        check_throws([&] { Ktx2File file(level_count); }, "level count past the level index got accepted");
+
+        std::filesystem::path level_offset = write_patched<u64>(source, "level_offset.ktx2", LEVEL_INDEX_OFFSET, ~0ull);
+        check_throws([&] { Ktx2File file(level_offset); }, "level offset past the end of the file got accepted");
+    }
+
+    void accepts_block_compressed_file() {
+        // 6x6 rounds up to 2x2 blocks, the 3x3 and 1x1 levels still take a whole block each
+        std::vector<std::vector<u8>> levels = { std::vector<u8>(4 * 16, 1), std::vector<u8>(16, 2), std::vector<u8>(16, 3) };
+        std::vector<std::span<const u8>> level_spans(levels.begin(), levels.end());
+        std::filesystem::path path = get_test_directory() / "bc7.ktx2";
+        write_ktx2(path, { .format = daxa::Format::BC7_UNORM_BLOCK, .size_x = 6, .size_y = 6, .levels = level_spans });
+
+        Ktx2File file(path);
+        check(file.format == daxa::Format::BC7_UNORM_BLOCK, "wrong format");
+        check_levels(file, levels);
+    }
+
+    void rejects_unsupported_format() {
+        std::filesystem::path source = write_test_file("valid.ktx2", make_levels(8), 8, Ktx2Supercompression::NONE);
+        // VK_FORMAT_G8_B8_R8_3PLANE_420_UNORM, multi planar formats have no single block size
+        std::filesystem::path path = write_patched<u32>(source, "unsupported_format.ktx2", FORMAT_OFFSET, 1000156002u);
+        check_throws([&] { Ktx2File file(path); }, "unsupported vkFormat got accepted");
+    }
+
+    void rejects_more_levels_than_a_chain() {
+        // 8x8 has 4 levels, the fifth 1x1 one is in bounds but doesnt belong to any chain
+        std::vector<std::vector<u8>> levels = make_levels(8);
+        levels.push_back(levels.back());
+        std::filesystem::path path = write_test_file("too_many_levels.ktx2", levels, 8, Ktx2Supercompression::NONE);
+        check_throws([&] { Ktx2File file(path); }, "level count past the full chain got accepted");
+    }
+
+    void rejects_wrong_level_size() {
+        std::filesystem::path source = write_test_file("valid.ktx2", make_levels(8), 8, Ktx2Supercompression::NONE);
+        std::filesystem::path short_level = write_patched<u64>(source, "short_level.ktx2", LEVEL_INDEX_OFFSET + 8, 8 * 8 * 4 - 4);
+        check_throws([&] { Ktx2File file(short_level); }, "level 0 shorter than 8x8 RGBA got accepted");
+
+        std::filesystem::path uncompressed_length = write_patched<u64>(source, "uncompressed_length.ktx2", LEVEL_INDEX_OFFSET + 16, 8 * 8 * 4 + 16);
+        check_throws([&] { Ktx2File file(uncompressed_length); }, "uncompressed length different from the byte length got accepted");
+
+        std::filesystem::path zstd = write_test_file("zstd.ktx2", make_levels(8), 8, Ktx2Supercompression::ZSTD);
+        std::filesystem::path zstd_length = write_patched<u64>(zstd, "zstd_length.ktx2", LEVEL_INDEX_OFFSET + LEVEL_INDEX_SIZE + 16, 4 * 4 * 4 * 2);
+        check_throws([&] { Ktx2File file(zstd_length); }, "zstd level 1 inflating past 4x4 RGBA got accepted");
+
+        // a staging buffer sized from a wrong format would overflow too
+        std::filesystem::path wrong_format = write_patched<u32>(source, "wrong_format.ktx2", FORMAT_OFFSET, static_cast<u32>(daxa::Format::R8G8_UNORM));
+        check_throws([&] { Ktx2File file(wrong_format); }, "RGBA sized levels got accepted as R8G8");
+    }
+
+    void rejects_corrupt_zstd_level() {
+        std::vector<std::vector<u8>> levels = make_levels(32);
+        std::filesystem::path source = write_test_file("zstd.ktx2", levels, 32, Ktx2Supercompression::ZSTD);
+
+        u64 level_offset = 0;
+        std::vector<u8> bytes = read_file(source);
+        std::memcpy(&level_offset, bytes.data() + LEVEL_INDEX_OFFSET, sizeof(u64));
+        std::filesystem::path path = write_patched<u32>(source, "corrupt_zstd.ktx2", static_cast<usize>(level_offset), 0xdeadbeefu);
+
+        // the header is fine, the level only fails once it gets decompressed
+        Ktx2File file(path);
+        std::vector<std::byte> staging(file.get_staging_size());
+        check_throws([&] { file.read_level(0, staging); }, "corrupt zstd level decompressed");
+    }
+
+    constexpr TestCase TESTS[] = {
+        { "ktx2/accepts_uncompressed_file", accepts_uncompressed_file },
+        { "ktx2/accepts_zstd_file", accepts_zstd_file },
+        { "ktx2/rejects_truncated_header", rejects_truncated_header },
+        { "ktx2/rejects_truncated_level_data", rejects_truncated_level_data },
+        { "ktx2/rejects_corrupt_header", rejects_corrupt_header },
+        { "ktx2/accepts_block_compressed_file", accepts_block_compressed_file },
+        { "ktx2/rejects_unsupported_format", rejects_unsupported_format },
+        { "ktx2/rejects_more_levels_than_a_chain", rejects_more_levels_than_a_chain },
+        { "ktx2/rejects_wrong_level_size", rejects_wrong_level_size },
+        { "ktx2/rejects_corrupt_zstd_level", rejects_corrupt_zstd_level },
+    };
+}
+
+auto get_ktx2_tests() -> std::span<const TestCase> {
+    return TESTS;
+}
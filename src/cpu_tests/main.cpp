@@ -0,0 +1,63 @@
+// the samples get stb_image out of impl.cpp, which pulls in everything else as well
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "tests.hpp"
+
+void check(bool condition, const std::string& message, std::source_location location) {
+    if(!condition) {
+        throw std::runtime_error(std::string(location.file_name()) + ":" + std::to_string(location.line()) + ": " + message);
+    }
+}
+
+auto get_test_directory() -> std::filesystem::path {
+    static const std::filesystem::path directory = [] {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "cpu_tests";
+        std::filesystem::remove_all(path);
+        std::filesystem::create_directories(path);
+        return path;
+    }();
+    return directory;
+}
+
+auto main(i32 argc, char** argv) -> i32 {
+    std::vector<std::span<const TestCase>> groups = {
+        get_meshlet_tests(),
+        get_ktx2_tests(),
+        get_texture_array_packing_tests(),
+        get_normal_map_tests(),
+        get_threadpool_tests(),
+        get_mip_generator_tests(),
+        get_texture_compression_tests(),
+    };
+
+    // an argument only runs the tests whose name contains it
+    std::string filter = argc > 1 ? argv[1] : "";
+
+    u32 passed = 0;
+    u32 failed = 0;
+    for(std::span<const TestCase> group : groups) {
+        for(const TestCase& test : group) {
+            if(!filter.empty() && std::string(test.name).find(filter) == std::string::npos) {
+                continue;
+            }
+
+            try {
+                test.run();
+                passed++;
+                std::cout << "passed " << test.name << std::endl;
+            } catch(const std::exception& e) {
+                failed++;
+                std::cout << "FAILED " << test.name << "\n  " << e.what() << std::endl;
+            }
+        }
+    }
+
+    std::cout << passed << " passed, " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#include "tests.hpp"
+#include "../meshlet_builder.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+    struct TestMesh {
+        std::vector<Vertex> vertices = {};
+        std::vector<u32> indices = {};
+    };
+
+    // flat grid of size x size quads, two triangles each
+    auto make_grid(u32 size) -> TestMesh {
+        TestMesh mesh = {};
+        for(u32 y = 0; y <= size; y++) {
+            for(u32 x = 0; x <= size; x++) {
+                Vertex vertex = {};
+                vertex.position = { static_cast<f32>(x), static_cast<f32>(y), 0.0f };
+                vertex.normal = { 0.0f, 0.0f, 1.0f };
+                mesh.vertices.push_back(vertex);
+            }
+        }
+
+        for(u32 y = 0; y < size; y++) {
+            for(u32 x = 0; x < size; x++) {
+                u32 a = y * (size + 1) + x;
+                u32 b = a + 1;
+                u32 c = a + size + 1;
+                u32 d = c + 1;
+                mesh.indices.insert(mesh.indices.end(), { a, b, c, b, d, c });
+            }
+        }
+        return mesh;
+    }
+
+    // triangles in random order over random vertices, nothing the greedy growth can follow
+    auto make_triangle_soup(u32 vertex_count, u32 triangle_count, u32 seed) -> TestMesh {
+        TestMesh mesh = {};
+        std::mt19937 generator{ seed };
+        std::uniform_real_distribution<f32> position{ -1.0f, 1.0f };
+        for(u32 i = 0; i < vertex_count; i++) {
+            Vertex vertex = {};
+            vertex.position = { position(generator), position(generator), position(generator) };
+            vertex.normal = { 0.0f, 1.0f, 0.0f };
+            mesh.vertices.push_back(vertex);
+        }
+
+        std::uniform_int_distribution<u32> index{ 0, vertex_count - 1 };
+        while(mesh.indices.size() < triangle_count * 3) {
+            u32 a = index(generator);
+            u32 b = index(generator);
+            u32 c = index(generator);
+            if(a != b && b != c && a != c) {
+                mesh.indices.insert(mesh.indices.end(), { a, b, c });
+            }
+        }
+        return mesh;
+    }
+
+    void check_limits(const MeshletData& data, const MeshletBuildInfo& info) {
+        for(const Meshlet& meshlet : data.meshlets) {
+            check(meshlet.vertex_count <= info.max_vertices, "meshlet has " + std::to_string(meshlet.vertex_count) + " vertices");
+            check(meshlet.triangle_count <= info.max_triangles, "meshlet has " + std::to_string(meshlet.triangle_count) + " triangles");
+            check(meshlet.triangle_count > 0, "meshlet without triangles");
+        }
+    }
+
+    void grid_covers_every_triangle() {
+        TestMesh mesh = make_grid(64);
+        MeshletBuildInfo info = {};
+        MeshletData data = build_meshlets(mesh.vertices, mesh.indices, info);
+
+        check(!data.meshlets.empty(), "no meshlets");
+        check(data.bounds.size() == data.meshlets.size(), "bounds dont match the meshlets");
+        check(data.statistics.triangle_count == mesh.indices.size() / 3, "statistics lost triangles");
+        check_limits(data, info);
+        check(validate_meshlets(mesh.indices, data, info), "triangles are missing or emitted twice");
+    }
+
+    void soup_respects_small_limits() {
+        TestMesh mesh = make_triangle_soup(500, 3000, 7);
+        for(MeshletBuildInfo info : { MeshletBuildInfo{}, MeshletBuildInfo{ .max_vertices = 16, .max_triangles = 8 }, MeshletBuildInfo{ .max_vertices = 255, .max_triangles = 256 } }) {
+            MeshletData data = build_meshlets(mesh.vertices, mesh.indices, info);
+            check_limits(data, info);
+            check(validate_meshlets(mesh.indices, data, info), "triangles are missing or emitted twice with limits " + std::to_string(info.max_vertices) + "/" + std::to_string(info.max_triangles));
+        }
+    }
+
+    void build_is_deterministic() {
+        TestMesh mesh = make_triangle_soup(300, 1000, 11);
+        MeshletData first = build_meshlets(mesh.vertices, mesh.indices, {});
+        MeshletData second = build_meshlets(mesh.vertices, mesh.indices, {});
+        check(first.vertices == second.vertices && first.triangles == second.triangles, "same input gave different meshlets");
+    }
+
+    void empty_input_gives_no_meshlets() {
+        MeshletData data = build_meshlets({}, {}, {});
+        check(data.meshlets.empty() && data.vertices.empty() && data.triangles.empty(), "meshlets out of nothing");
+    }
+
+    void validation_catches_lost_triangles() {
+        TestMesh mesh = make_grid(8);
+        MeshletBuildInfo info = {};
+        MeshletData data = build_meshlets(mesh.vertices, mesh.indices, info);
+        data.triangles[1] = data.triangles[0];
+        check(!validate_meshlets(mesh.indices, data, info), "a duplicated triangle passed");
+
+        MeshletBuildInfo tighter = { .max_vertices = 4, .max_triangles = 2 };
+        MeshletData intact = build_meshlets(mesh.vertices, mesh.indices, info);
+        check(!validate_meshlets(mesh.indices, intact, tighter), "meshlets over the limits passed");
+    }
+
+    constexpr TestCase TESTS[] = {
+        { "meshlets/grid_covers_every_triangle", grid_covers_every_triangle },
+        { "meshlets/soup_respects_small_limits", soup_respects_small_limits },
+        { "meshlets/build_is_deterministic", build_is_deterministic },
+        { "meshlets/empty_input_gives_no_meshlets", empty_input_gives_no_meshlets },
+        { "meshlets/validation_catches_lost_triangles", validation_catches_lost_triangles },
+    };
+}
+
+auto get_meshlet_tests() -> std::span<const TestCase> {
+    return TESTS;
+}
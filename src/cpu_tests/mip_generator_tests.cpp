@@ -0,0 +1,102 @@
+#include "tests.hpp"
+#include "../mip_generator.hpp"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+    struct Size {
+        u32 x;
+        u32 y;
+    };
+
+    // odd and non power of two sizes hit the clamped edges and the scalar tails behind the vector loops
+    constexpr Size SIZES[] = { { 37, 23 }, { 100, 60 }, { 255, 3 }, { 1, 17 }, { 64, 1 }, { 9, 9 }, { 128, 128 } };
+
+    auto make_noise(u32 size_x, u32 size_y, u32 channel_count, u32 seed) -> std::vector<u8> {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<u32> distribution(0, 255);
+        std::vector<u8> pixels(static_cast<usize>(size_x) * size_y * channel_count);
+        for(u8& value : pixels) {
+            value = static_cast<u8>(distribution(random));
+        }
+        return pixels;
+    }
+
+    // the vector paths add in the same order as the scalar one, but a compiler that fuses the scalar multiply adds can
+    // still move a value across a rounding boundary
+    void check_matches_scalar(MipFilter filter, bool srgb, u32 channel_count) {
+        for(const Size& size : SIZES) {
+            std::vector<u8> pixels = make_noise(size.x, size.y, channel_count, size.x * 31 + size.y);
+            u32 mip_level_count = get_mip_level_count(size.x, size.y);
+            usize total_size = 0;
+            std::vector<usize> offsets = get_mip_chain_offsets(size.x, size.y, mip_level_count, total_size);
+
+            std::vector<u8> simd(total_size, 0);
+            std::vector<u8> scalar(total_size, 0);
+            MipGenerateInfo info = { .filter = filter, .srgb = srgb };
+            generate_mip_levels(pixels, channel_count, size.x, size.y, simd, offsets, info);
+            info.allow_simd = false;
+            generate_mip_levels(pixels, channel_count, size.x, size.y, scalar, offsets, info);
+
+            for(usize i = offsets.size() > 1 ? offsets[1] : total_size; i < total_size; i++) {
+                check(std::abs(static_cast<i32>(simd[i]) - static_cast<i32>(scalar[i])) <= 1,
+                      "simd and scalar differ at byte " + std::to_string(i) + " of " + std::to_string(size.x) + "x" + std::to_string(size.y) + ": " + std::to_string(simd[i]) + " vs " + std::to_string(scalar[i]));
+            }
+        }
+    }
+
+    void box_simd_matches_scalar() {
+        check_matches_scalar(MipFilter::BOX, false, 4);
+        check_matches_scalar(MipFilter::BOX, true, 4);
+        check_matches_scalar(MipFilter::BOX, true, 3);
+    }
+
+    void kaiser_simd_matches_scalar() {
+        check_matches_scalar(MipFilter::KAISER, false, 4);
+        check_matches_scalar(MipFilter::KAISER, true, 4);
+        check_matches_scalar(MipFilter::KAISER, true, 3);
+    }
+
+    void srgb_averages_in_linear_space() {
+        // black and white columns, half the light of white is 188 in srgb and only the unorm version lands on 128
+        constexpr u32 SIZE = 16;
+        std::vector<u8> pixels = {};
+        for(u32 y = 0; y < SIZE; y++) {
+            for(u32 x = 0; x < SIZE; x++) {
+                u8 value = x % 2 == 0 ? 0 : 255;
+                pixels.insert(pixels.end(), { value, value, value, 255 });
+            }
+        }
+
+        for(bool allow_simd : { true, false }) {
+            MipChain srgb = generate_mip_chain(pixels, SIZE, SIZE, 2, { .srgb = true, .allow_simd = allow_simd });
+            MipChain unorm = generate_mip_chain(pixels, SIZE, SIZE, 2, { .srgb = false, .allow_simd = allow_simd });
+            for(usize i = srgb.offsets[1]; i < srgb.data.size(); i += 4) {
+                check(srgb.data[i] == 188 && srgb.data[i + 1] == 188 && srgb.data[i + 2] == 188, "srgb stripes averaged to " + std::to_string(srgb.data[i]));
+                check(unorm.data[i] == 128, "unorm stripes averaged to " + std::to_string(unorm.data[i]));
+                check(srgb.data[i + 3] == 255 && unorm.data[i + 3] == 255, "alpha isnt linear");
+            }
+        }
+    }
+
+    void chain_layout_fits_odd_sizes() {
+        usize total_size = 0;
+        std::vector<usize> offsets = get_mip_chain_offsets(37, 23, get_mip_level_count(37, 23), total_size);
+        // 37x23 18x11 9x5 4x2 2x1 1x1
+        check(offsets.size() == 6, "expected 6 levels for 37x23, got " + std::to_string(offsets.size()));
+        check(total_size == (37 * 23 + 18 * 11 + 9 * 5 + 4 * 2 + 2 * 1 + 1) * 4, "chain size is off");
+    }
+
+    constexpr TestCase TESTS[] = {
+        { "mip_generator/box_simd_matches_scalar", box_simd_matches_scalar },
+        { "mip_generator/kaiser_simd_matches_scalar", kaiser_simd_matches_scalar },
+        { "mip_generator/srgb_averages_in_linear_space", srgb_averages_in_linear_space },
+        { "mip_generator/chain_layout_fits_odd_sizes", chain_layout_fits_odd_sizes },
+    };
+}
+
+auto get_mip_generator_tests() -> std::span<const TestCase> {
+    return TESTS;
+}
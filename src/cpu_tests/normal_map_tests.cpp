@@ -0,0 +1,126 @@
+#include "tests.hpp"
+#include "../normal_map.hpp"
+#include "../texture_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+    auto pack_unorm(f32 value) -> u8 {
+        return static_cast<u8>(std::lround((value * 0.5f + 0.5f) * 255.0f));
+    }
+
+    // RGB8 tangent space normals of a sine height field, the slopes go up to about 60 degrees like a rough material would
+    auto make_bumpy_normal_map(u32 size, u32 channel_count) -> std::vector<u8> {
+        std::vector<u8> pixels = {};
+        for(u32 y = 0; y < size; y++) {
+            for(u32 x = 0; x < size; x++) {
+                f32 u = static_cast<f32>(x) / static_cast<f32>(size) * 6.2831853f * 3.0f;
+                f32 v = static_cast<f32>(y) / static_cast<f32>(size) * 6.2831853f * 5.0f;
+                f32 dx = 1.2f * std::cos(u) * std::sin(v * 0.5f);
+                f32 dy = 1.2f * std::sin(u * 0.5f) * std::cos(v);
+                f32 length = std::sqrt(dx * dx + dy * dy + 1.0f);
+                pixels.push_back(pack_unorm(-dx / length));
+                pixels.push_back(pack_unorm(-dy / length));
+                pixels.push_back(pack_unorm(1.0f / length));
+                if(channel_count == 4) {
+                    pixels.push_back(255);
+                }
+            }
+        }
+        return pixels;
+    }
+
+    auto get_chain(u32 size_x, u32 size_y, std::vector<usize>& offsets) -> std::vector<u8> {
+        usize total_size = 0;
+        u32 mip_level_count = 1;
+        while((std::max(size_x, size_y) >> mip_level_count) != 0) {
+            mip_level_count++;
+        }
+        offsets = get_normal_map_offsets(size_x, size_y, mip_level_count, total_size);
+        return std::vector<u8>(total_size, 0);
+    }
+
+    void two_channels_stay_under_a_degree() {
+        for(u32 channel_count : { 3u, 4u }) {
+            std::vector<u8> pixels = make_bumpy_normal_map(256, channel_count);
+            std::vector<usize> offsets = {};
+            std::vector<u8> chain = get_chain(256, 256, offsets);
+            NormalMapError error = pack_normal_map(pixels, channel_count, 256, 256, chain, offsets);
+
+            f64 mean = error.sum_angle_error / static_cast<f64>(error.texel_count);
+            check(error.texel_count == 256 * 256, "level 0 error counts " + std::to_string(error.texel_count) + " texels");
+            check(error.max_angle_error < 1.0f, "max error of " + std::to_string(error.max_angle_error) + " deg");
+            check(mean < 0.25, "mean error of " + std::to_string(mean) + " deg");
+            for(usize i = 0; i < 256 * 256; i++) {
+                check(chain[i * 2] == pixels[i * channel_count] && chain[i * 2 + 1] == pixels[i * channel_count + 1], "level 0 isnt the source x and y");
+            }
+        }
+    }
+
+    void smaller_levels_keep_their_tilt() {
+        // every texel tilted the same way, a filter that doesnt renormalize would pull the smaller levels towards flat
+        std::vector<u8> pixels = {};
+        for(u32 i = 0; i < 64 * 32; i++) {
+            pixels.insert(pixels.end(), { pack_unorm(0.6f), pack_unorm(0.0f), pack_unorm(0.8f) });
+        }
+        std::vector<usize> offsets = {};
+        std::vector<u8> chain = get_chain(64, 32, offsets);
+        pack_normal_map(pixels, 3, 64, 32, chain, offsets);
+
+        check(offsets.size() == 7, "expected 7 levels for 64x32");
+        check(chain.size() - offsets.back() == 2, "the last level isnt a single texel");
+        for(usize level = 1; level < offsets.size(); level++) {
+            check(chain[offsets[level]] == pack_unorm(0.6f) && chain[offsets[level] + 1] == pack_unorm(0.0f), "level " + std::to_string(level) + " lost its tilt");
+        }
+    }
+
+    void reconstruct_matches_the_shader() {
+        f32vec3 up = reconstruct_normal(0.0f, 0.0f);
+        check(up.x == 0.0f && up.y == 0.0f && up.z == 1.0f, "flat normal doesnt point up");
+        // 8 bit x and y can land just outside the unit circle, z has to clamp instead of going nan
+        f32vec3 edge = reconstruct_normal(0.8f, 0.61f);
+        check(edge.z == 0.0f, "z outside the unit circle isnt clamped");
+    }
+
+    void bc5_follows_the_renormalized_chain() {
+        std::vector<u8> pixels = make_bumpy_normal_map(128, 4);
+        std::vector<usize> offsets = {};
+        std::vector<u8> chain = get_chain(128, 128, offsets);
+        NormalMapError packed_error = pack_normal_map(pixels, 4, 128, 128, chain, offsets);
+
+        CompressionStatistics statistics = {};
+        CompressedTexture compressed = compress_normal_map(pixels, 4, 128, 128, 1, statistics);
+        check(compressed.format == BlockFormat::BC5 && statistics.format == BlockFormat::BC5, "normal map didnt end up BC5");
+        check(compressed.offsets.size() == offsets.size(), "BC5 chain has " + std::to_string(compressed.offsets.size()) + " levels");
+        check(compressed.normal_map_error.texel_count == packed_error.texel_count && compressed.normal_map_error.max_angle_error == packed_error.max_angle_error, "normal map error isnt the one of the packed chain");
+        check(statistics.psnr >= 38.0, "BC5 psnr of " + std::to_string(statistics.psnr));
+
+        // every level has to be the RG8 level the uncompressed path uploads run through the encoder, a box filtered chain
+        // only matches on level 0
+        for(u32 level = 0; level < offsets.size(); level++) {
+            u32 size = std::max(1u, 128u >> level);
+            std::vector<u8> rgba(static_cast<usize>(size) * size * 4, 0);
+            for(usize i = 0; i < static_cast<usize>(size) * size; i++) {
+                rgba[i * 4 + 0] = chain[offsets[level] + i * 2 + 0];
+                rgba[i * 4 + 1] = chain[offsets[level] + i * 2 + 1];
+                rgba[i * 4 + 3] = 255;
+            }
+            std::vector<u8> expected = compress_image(rgba, size, size, BlockFormat::BC5);
+            usize end = level + 1 < compressed.offsets.size() ? compressed.offsets[level + 1] : compressed.data.size();
+            check(end - compressed.offsets[level] == expected.size() && std::equal(expected.begin(), expected.end(), compressed.data.begin() + static_cast<std::ptrdiff_t>(compressed.offsets[level])), "level " + std::to_string(level) + " isnt the packed normal map level");
+        }
+    }
+
+    constexpr TestCase TESTS[] = {
+        { "normal_map/two_channels_stay_under_a_degree", two_channels_stay_under_a_degree },
+        { "normal_map/smaller_levels_keep_their_tilt", smaller_levels_keep_their_tilt },
+        { "normal_map/reconstruct_matches_the_shader", reconstruct_matches_the_shader },
+        { "normal_map/bc5_follows_the_renormalized_chain", bc5_follows_the_renormalized_chain },
+    };
+}
+
+auto get_normal_map_tests() -> std::span<const TestCase> {
+    return TESTS;
+}
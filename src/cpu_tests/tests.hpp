@@ -0,0 +1,43 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <filesystem>
+#include <source_location>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+// cpu side checks of the loader modules, nothing in here needs a device or a window
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+// throws with the location of the failed check, a test stops at its first failure and the runner moves on to the next one
+void check(bool condition, const std::string& message, std::source_location location = std::source_location::current());
+
+// fails unless function throws the std::runtime_error the modules report bad input with
+template <typename F>
+void check_throws(F&& function, const std::string& message, std::source_location location = std::source_location::current()) {
+    bool thrown = false;
+    try {
+        function();
+    } catch(const std::runtime_error&) {
+        thrown = true;
+    }
+    check(thrown, message, location);
+}
+
+// empty directory under the system temp directory for tests that need files, the next run clears it again
+auto get_test_directory() -> std::filesystem::path;
+
+auto get_meshlet_tests() -> std::span<const TestCase>;
+auto get_ktx2_tests() -> std::span<const TestCase>;
+auto get_texture_array_packing_tests() -> std::span<const TestCase>;
+auto get_normal_map_tests() -> std::span<const TestCase>;
+auto get_threadpool_tests() -> std::span<const TestCase>;
+auto get_mip_generator_tests() -> std::span<const TestCase>;
+auto get_texture_compression_tests() -> std::span<const TestCase>;
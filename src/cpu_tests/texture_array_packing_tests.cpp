@@ -0,0 +1,116 @@
+#include "tests.hpp"
+#include "../texture_array_packing.hpp"
+
+#include <bit>
+#include <vector>
+
+namespace {
+    auto make_candidate(daxa::Format format, u32 size_x, u32 size_y, u32 mip_level_count) -> TextureArrayCandidate {
+        return TextureArrayCandidate { .format = format, .size_x = size_x, .size_y = size_y, .mip_level_count = mip_level_count };
+    }
+
+    auto is_packed(const TextureArrayPacking& packing, u32 image) -> bool {
+        return packing.placements[image].array != TextureArrayPlacement::NO_ARRAY;
+    }
+
+    void packs_mixed_sizes() {
+        std::vector<TextureArrayCandidate> candidates = {};
+        for(u32 i = 0; i < 12; i++) {
+            u32 size = i % 3 == 0 ? 256 : i % 3 == 1 ? 128 : 64;
+            candidates.push_back(make_candidate(daxa::Format::R8G8B8A8_SRGB, size, size, static_cast<u32>(std::bit_width(size))));
+        }
+        // not square, and one too big for any array
+        candidates.push_back(make_candidate(daxa::Format::R8G8B8A8_SRGB, 128, 64, 8));
+        candidates.push_back(make_candidate(daxa::Format::R8G8B8A8_SRGB, 128, 64, 8));
+        candidates.push_back(make_candidate(daxa::Format::R8G8B8A8_SRGB, 1024, 1024, 11));
+
+        TextureArrayPacking packing = pack_texture_arrays(candidates);
+        check(validate_texture_array_packing(candidates, packing), "packing doesnt validate");
+        check(packing.arrays.size() == 4, "expected 4 arrays, got " + std::to_string(packing.arrays.size()));
+        check(packing.statistics.packed_image_count == 14, "expected 14 packed images, got " + std::to_string(packing.statistics.packed_image_count));
+        check(!is_packed(packing, 14), "an image over max_size got packed");
+        check(packing.statistics.get_view_count() == 5, "expected 5 views");
+
+        // layers follow the candidate order within an array
+        for(const TextureArrayLayout& layout : packing.arrays) {
+            for(usize layer = 1; layer < layout.images.size(); layer++) {
+                check(layout.images[layer - 1] < layout.images[layer], "layers out of candidate order");
+            }
+        }
+    }
+
+    void packs_mixed_formats() {
+        std::vector<TextureArrayCandidate> candidates = {};
+        for(u32 i = 0; i < 9; i++) {
+            daxa::Format format = i % 3 == 0 ? daxa::Format::R8G8B8A8_SRGB : i % 3 == 1 ? daxa::Format::BC7_SRGB_BLOCK : daxa::Format::R8G8_UNORM;
+            candidates.push_back(make_candidate(format, 256, 256, 9));
+        }
+        // same format and size but a shorter chain cant share the layers of the full ones
+        candidates.push_back(make_candidate(daxa::Format::BC7_SRGB_BLOCK, 256, 256, 1));
+        candidates.push_back(make_candidate(daxa::Format::BC7_SRGB_BLOCK, 256, 256, 1));
+
+        TextureArrayPacking packing = pack_texture_arrays(candidates);
+        check(validate_texture_array_packing(candidates, packing), "packing doesnt validate");
+        check(packing.arrays.size() == 4, "expected an array per format and level count, got " + std::to_string(packing.arrays.size()));
+        for(const TextureArrayLayout& layout : packing.arrays) {
+            for(u32 image : layout.images) {
+                check(candidates[image].format == layout.format && candidates[image].mip_level_count == layout.mip_level_count, "array mixes formats or level counts");
+            }
+        }
+    }
+
+    void leaves_too_few_candidates_alone() {
+        check(pack_texture_arrays({}).arrays.empty(), "arrays out of nothing");
+
+        // one of a kind stays on its own, as do images that get streamed
+        std::vector<TextureArrayCandidate> candidates = {
+            make_candidate(daxa::Format::R8G8B8A8_SRGB, 256, 256, 9),
+            make_candidate(daxa::Format::R8G8B8A8_UNORM, 256, 256, 9),
+            make_candidate(daxa::Format::R8G8B8A8_UNORM, 256, 256, 9),
+        };
+        candidates[2].packable = false;
+        TextureArrayPacking packing = pack_texture_arrays(candidates);
+        check(validate_texture_array_packing(candidates, packing), "packing doesnt validate");
+        check(packing.arrays.empty(), "a single image got an array");
+
+        // a group under min_layer_count stays unpacked
+        std::vector<TextureArrayCandidate> pair = { candidates[0], candidates[0] };
+        TextureArrayPackingInfo info = { .min_layer_count = 3 };
+        TextureArrayPacking pair_packing = pack_texture_arrays(pair, info);
+        check(validate_texture_array_packing(pair, pair_packing, info), "packing doesnt validate");
+        check(pair_packing.arrays.empty() && !is_packed(pair_packing, 0) && !is_packed(pair_packing, 1), "a group under min_layer_count got packed");
+
+        // the same goes for what is left over after splitting at max_layer_count
+        std::vector<TextureArrayCandidate> group(9, candidates[0]);
+        TextureArrayPackingInfo split_info = { .max_layer_count = 4 };
+        TextureArrayPacking split = pack_texture_arrays(group, split_info);
+        check(validate_texture_array_packing(group, split, split_info), "packing doesnt validate");
+        check(split.arrays.size() == 2 && split.statistics.packed_image_count == 8 && !is_packed(split, 8), "expected two full arrays and one image left over");
+    }
+
+    void validation_catches_bad_packing() {
+        std::vector<TextureArrayCandidate> candidates(4, make_candidate(daxa::Format::R8G8B8A8_SRGB, 128, 128, 8));
+        candidates.push_back(make_candidate(daxa::Format::R8_UNORM, 128, 128, 8));
+        TextureArrayPacking packing = pack_texture_arrays(candidates);
+
+        TextureArrayPacking swapped = packing;
+        std::swap(swapped.placements[0].layer, swapped.placements[1].layer);
+        check(!validate_texture_array_packing(candidates, swapped), "swapped layers passed");
+
+        TextureArrayPacking mismatched = packing;
+        mismatched.arrays[0].images.push_back(4);
+        mismatched.placements[4] = { .array = 0, .layer = 4 };
+        check(!validate_texture_array_packing(candidates, mismatched), "an R8 image in an RGBA8 array passed");
+    }
+
+    constexpr TestCase TESTS[] = {
+        { "texture_arrays/packs_mixed_sizes", packs_mixed_sizes },
+        { "texture_arrays/packs_mixed_formats", packs_mixed_formats },
+        { "texture_arrays/leaves_too_few_candidates_alone", leaves_too_few_candidates_alone },
+        { "texture_arrays/validation_catches_bad_packing", validation_catches_bad_packing },
+    };
+}
+
+auto get_texture_array_packing_tests() -> std::span<const TestCase> {
+    return TESTS;
+}
@@ -0,0 +1,121 @@
+#include "tests.hpp"
+#include "../texture_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    // smooth gradients with a little noise and a few hard edges, roughly what albedo textures look like to the encoder
+    auto make_test_image(u32 size_x, u32 size_y, bool with_alpha) -> std::vector<u8> {
+        std::mt19937 random(size_x * 131 + size_y);
+        std::uniform_int_distribution<i32> noise(-6, 6);
+        std::vector<u8> pixels = {};
+        for(u32 y = 0; y < size_y; y++) {
+            for(u32 x = 0; x < size_x; x++) {
+                f32 u = static_cast<f32>(x) / static_cast<f32>(size_x);
+                f32 v = static_cast<f32>(y) / static_cast<f32>(size_y);
+                bool edge = ((x / 16) + (y / 16)) % 2 == 0;
+                auto channel = [&](f32 value) {
+                    return static_cast<u8>(std::clamp(static_cast<i32>(value * 255.0f) + noise(random), 0, 255));
+                };
+                pixels.push_back(channel(edge ? u : 1.0f - u));
+                pixels.push_back(channel(0.5f + 0.5f * std::sin(v * 6.0f)));
+                pixels.push_back(channel(edge ? 0.2f : 0.8f * v));
+                pixels.push_back(with_alpha ? channel(u * v) : 255);
+            }
+        }
+        return pixels;
+    }
+
+    auto get_channel_count(BlockFormat format) -> u32 {
+        switch(format) {
+            case BlockFormat::BC1: return 3;
+            case BlockFormat::BC4: return 1;
+            case BlockFormat::BC5: return 2;
+            case BlockFormat::BC7: return 4;
+        }
+        return 4;
+    }
+
+    void round_trips_above_psnr_floor() {
+        struct Floor {
+            BlockFormat format;
+            f64 psnr;
+        };
+        // what each encoder reaches on the test image with a couple of dB to spare
+        constexpr Floor FLOORS[] = {
+            { BlockFormat::BC1, 32.0 },
+            { BlockFormat::BC4, 38.0 },
+            { BlockFormat::BC5, 38.0 },
+            { BlockFormat::BC7, 36.0 },
+        };
+
+        // 70x38 leaves partial blocks on both edges
+        for(bool odd : { false, true }) {
+            u32 size_x = odd ? 70 : 128;
+            u32 size_y = odd ? 38 : 64;
+            std::vector<u8> pixels = make_test_image(size_x, size_y, false);
+            for(const Floor& floor : FLOORS) {
+                std::vector<u8> blocks = compress_image(pixels, size_x, size_y, floor.format);
+                check(blocks.size() == static_cast<usize>((size_x + 3) / 4) * ((size_y + 3) / 4) * get_block_size(floor.format), std::string(get_block_format_name(floor.format)) + " has the wrong size");
+                std::vector<u8> decoded = decompress_image(blocks, size_x, size_y, floor.format);
+                f64 psnr = compute_psnr(pixels, decoded, get_channel_count(floor.format));
+                check(psnr >= floor.psnr, std::string(get_block_format_name(floor.format)) + " round trips at " + std::to_string(psnr) + " dB");
+            }
+        }
+    }
+
+    void solid_blocks_are_lossless() {
+        // mode 6 shares one p bit over all channels of an endpoint, so BC7 can only hit a solid color exactly when every
+        // channel is odd like the opaque alpha
+        std::vector<u8> pixels = {};
+        for(u32 i = 0; i < 8 * 8; i++) {
+            pixels.insert(pixels.end(), { 201, 101, 51, 255 });
+        }
+        for(BlockFormat format : { BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 }) {
+            std::vector<u8> decoded = decompress_image(compress_image(pixels, 8, 8, format), 8, 8, format);
+            check(std::isinf(compute_psnr(pixels, decoded, get_channel_count(format))), std::string(get_block_format_name(format)) + " changed a solid color");
+        }
+    }
+
+    void bc1_falls_back_to_bc7_with_alpha() {
+        CompressionStatistics statistics = {};
+        std::vector<u8> opaque = make_test_image(32, 32, false);
+        CompressedTexture opaque_texture = compress_texture(opaque, 32, 32, BlockFormat::BC1, true, 1, statistics);
+        check(opaque_texture.format == BlockFormat::BC1 && statistics.format == BlockFormat::BC1, "an opaque image left BC1");
+
+        std::vector<u8> translucent = make_test_image(32, 32, true);
+        CompressedTexture translucent_texture = compress_texture(translucent, 32, 32, BlockFormat::BC1, true, 1, statistics);
+        check(translucent_texture.format == BlockFormat::BC7 && statistics.format == BlockFormat::BC7, "an image with alpha stayed BC1");
+        // 32 16 8 4 2 1, a block per level below 4x4
+        check(translucent_texture.offsets.size() == 6 && translucent_texture.data.size() == (64 + 16 + 4 + 1 + 1 + 1) * 16, "BC7 chain has the wrong layout");
+        check(statistics.psnr >= 30.0, "BC7 fallback round trips at " + std::to_string(statistics.psnr) + " dB");
+    }
+
+    void threads_dont_change_the_output() {
+        std::vector<u8> pixels = make_test_image(70, 133, true);
+        for(BlockFormat format : { BlockFormat::BC1, BlockFormat::BC4, BlockFormat::BC5, BlockFormat::BC7 }) {
+            std::vector<u8> single = compress_image(pixels, 70, 133, format, 1);
+            std::vector<u8> threaded = compress_image(pixels, 70, 133, format, 7);
+            check(single == threaded, std::string(get_block_format_name(format)) + " depends on the thread count");
+        }
+
+        CompressionStatistics statistics = {};
+        CompressedTexture single = compress_texture(pixels, 70, 133, BlockFormat::BC7, false, 1, statistics);
+        CompressedTexture threaded = compress_texture(pixels, 70, 133, BlockFormat::BC7, false, 4, statistics);
+        check(single.data == threaded.data && single.offsets == threaded.offsets, "the compressed chain depends on the thread count");
+    }
+
+    constexpr TestCase TESTS[] = {
+        { "texture_compression/round_trips_above_psnr_floor", round_trips_above_psnr_floor },
+        { "texture_compression/solid_blocks_are_lossless", solid_blocks_are_lossless },
+        { "texture_compression/bc1_falls_back_to_bc7_with_alpha", bc1_falls_back_to_bc7_with_alpha },
+        { "texture_compression/threads_dont_change_the_output", threads_dont_change_the_output },
+    };
+}
+
+auto get_texture_compression_tests() -> std::span<const TestCase> {
+    return TESTS;
+}
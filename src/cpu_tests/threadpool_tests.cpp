@@ -0,0 +1,245 @@
+#include "tests.hpp"
+#include "../job_graph.hpp"
+#include "../threadpool.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <vector>
+
+// every allocation of the test executable goes through here so the pool tests can tell how many a task costs. kept out
+// of line, once gcc inlines the free into a new expression it reports it as a mismatched deallocation
+namespace {
+    std::atomic<usize> allocation_count = 0;
+}
+
+[[gnu::noinline]] auto operator new(usize size) -> void* {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if(void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] auto operator new[](usize size) -> void* {
+    return operator new(size);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void* pointer, usize) noexcept {
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete[](void* pointer) noexcept {
+    operator delete(pointer);
+}
+
+[[gnu::noinline]] void operator delete[](void* pointer, usize) noexcept {
+    operator delete(pointer);
+}
+
+namespace {
+    void counted_exception_reaches_wait_for() {
+        ThreadPool pool(4);
+        TaskCounter counter = {};
+        std::atomic<usize> ran = 0;
+        pool.push_tasks(64, [&](usize i) {
+            ran++;
+            if(i == 7 || i == 40) {
+                throw std::runtime_error("task " + std::to_string(i));
+            }
+        }, counter);
+        check_throws([&] { pool.wait_for(counter); }, "wait_for didnt rethrow");
+        check(ran == 64 && counter.get_remaining() == 0, "a throwing task kept the others from running or counting down");
+
+        // the workers are still there and the next counter starts clean
+        TaskCounter next = {};
+        pool.push_tasks(64, [&](usize) { ran++; }, next);
+        pool.wait_for(next);
+        check(ran == 128, "the pool stopped running tasks after an exception");
+        pool.wait_for_tasks();
+    }
+
+    void parallel_for_rethrows_on_the_caller() {
+        ThreadPool pool(4);
+        std::atomic<usize> visited = 0;
+        check_throws([&] {
+            pool.parallel_for(0, 100000, 16, [&](usize begin, usize end) {
+                visited += end - begin;
+                if(begin <= 50000 && 50000 < end) {
+                    throw std::runtime_error("chunk with 50000");
+                }
+            });
+        }, "parallel_for didnt rethrow");
+        check(visited < 100000 + 16, "chunks ran twice");
+
+        check_throws([&] {
+            pool.parallel_reduce(0, 1000, 8, usize{0}, [](usize begin, usize end) -> usize {
+                if(end == 1000) {
+                    throw std::runtime_error("last chunk");
+                }
+                return end - begin;
+            }, [](usize a, usize b) { return a + b; });
+        }, "parallel_reduce didnt rethrow");
+        pool.wait_for_tasks();
+    }
+
+    void uncounted_exception_reaches_wait_for_tasks() {
+        ThreadPool pool(2, 1);
+        std::atomic<usize> ran = 0;
+        pool.push_task([] { throw std::runtime_error("normal task"); });
+        pool.push_task_to(TaskLane::IO, [] { throw std::runtime_error("io task"); });
+        for(u32 i = 0; i < 16; i++) {
+            pool.push_task([&] { ran++; });
+        }
+        check_throws([&] { pool.wait_for_tasks(); }, "wait_for_tasks didnt rethrow");
+        check(ran == 16, "tasks got lost next to the throwing ones");
+        // the first one is gone once it got rethrown, the second one was dropped
+        pool.wait_for_tasks();
+    }
+
+    void job_graph_rethrows_and_skips_dependents() {
+        ThreadPool pool(4, 1);
+        JobGraph graph = {};
+        std::atomic<bool> dependent_ran = false;
+        JobId failing = graph.add("failing", [] { throw std::runtime_error("job"); }, TaskLane::IO);
+        JobId dependent = graph.add("dependent", [&] { dependent_ran = true; });
+        graph.add("independent", [] {});
+        graph.depend(dependent, failing);
+        check_throws([&] { graph.run(pool); }, "run didnt rethrow");
+        check(!dependent_ran, "a job ran after what it depends on threw");
+        pool.wait_for_tasks();
+    }
+
+    // heap allocations of the second round of push. the first round goes in while the pool is paused, so it fills the
+    // node and promise state pools with more than the second round can ever have in flight. a single worker, so the
+    // deque that grew in the first round is the one tasks pushed from a worker go into again
+    template <typename Push>
+    auto count_allocations(u32 task_count, Push push) -> usize {
+        ThreadPool pool(1);
+        pool.pause();
+        push(pool, 2 * task_count);
+        pool.unpause();
+        pool.wait_for_tasks();
+        usize before = allocation_count.load();
+        push(pool, task_count);
+        pool.wait_for_tasks();
+        return allocation_count.load() - before;
+    }
+
+    void inline_tasks_dont_allocate() {
+        constexpr u32 TASK_COUNT = 10000;
+        std::atomic<u32> done = 0;
+        auto task = [&done] { done++; };
+
+        usize push_task = count_allocations(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            for(u32 i = 0; i < count; i++) {
+                pool.push_task(task);
+            }
+        });
+        check(push_task == 0, "push_task allocated " + std::to_string(push_task) + " times");
+
+        usize arguments = count_allocations(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            for(u32 i = 0; i < count; i++) {
+                pool.push_task([&done](u32 a, u32 b) { done += a + b - 1; }, i, 1u);
+            }
+        });
+        check(arguments == 0, "push_task with arguments allocated " + std::to_string(arguments) + " times");
+
+        usize nested = count_allocations(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            pool.push_task([&pool, &task, count] {
+                for(u32 i = 0; i < count; i++) {
+                    pool.push_task(task);
+                }
+            });
+        });
+        check(nested == 0, "push_task from a worker allocated " + std::to_string(nested) + " times");
+
+        TaskCounter counter = {};
+        usize batched = count_allocations(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            pool.push_tasks(count, [&done](usize) { done++; });
+            pool.push_tasks(count, [&done](usize) { done++; }, counter);
+        });
+        check(batched == 0, "push_tasks allocated " + std::to_string(batched) + " times");
+
+        std::vector<std::future<u32>> futures = {};
+        futures.reserve(2 * TASK_COUNT);
+        usize submit = count_allocations(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            // the states of the last round go back to the promise state pool here
+            futures.clear();
+            for(u32 i = 0; i < count; i++) {
+                futures.push_back(pool.submit([](u32 value) { return value * 2; }, i));
+            }
+        });
+        check(submit == 0, "submit allocated " + std::to_string(submit) + " times");
+        check(futures.back().get() == 2 * (TASK_COUNT - 1), "submit lost its result");
+    }
+
+    void inline_size_is_where_allocations_start() {
+        constexpr u32 TASK_COUNT = 1000;
+        std::atomic<u64> sum = 0;
+        // with the pointer to sum the first one captures exactly INLINE_SIZE bytes and the second one 8 more
+        std::array<u64, PoolTask::INLINE_SIZE / sizeof(u64) - 1> fits = {};
+        std::array<u64, PoolTask::INLINE_SIZE / sizeof(u64)> too_big = {};
+        fits.back() = 1;
+
+        usize inline_allocations = count_allocations(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            for(u32 i = 0; i < count; i++) {
+                auto task = [fits, &sum] { sum += fits.back(); };
+                static_assert(sizeof(task) == PoolTask::INLINE_SIZE);
+                pool.push_task(task);
+            }
+        });
+        check(inline_allocations == 0, "a task of INLINE_SIZE bytes allocated " + std::to_string(inline_allocations) + " times");
+
+        usize heap_allocations = count_allocations(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            for(u32 i = 0; i < count; i++) {
+                auto task = [too_big, &sum] { sum += too_big.back(); };
+                static_assert(sizeof(task) > PoolTask::INLINE_SIZE);
+                pool.push_task(task);
+            }
+        });
+        check(heap_allocations >= TASK_COUNT, "a task past INLINE_SIZE didnt allocate, the counting is broken");
+        check(sum == 3 * TASK_COUNT, "tasks got lost");
+    }
+
+    void unpause_wakes_io_threads() {
+        ThreadPool pool(1, 2);
+        pool.pause();
+        // pushed while paused, the io threads see the task and go back to sleep until unpause wakes them
+        std::future<u32> read = pool.submit_to(TaskLane::IO, [] { return 1u; });
+        TaskCounter reads = {};
+        pool.push_tasks_to(TaskLane::IO, 4, [](usize) {}, reads);
+        // long enough for the threads to have started and be asleep again
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        pool.unpause();
+
+        bool ran = read.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+        if(!ran) {
+            // the destructor would wait for them forever
+            pool.pause();
+        }
+        check(ran, "io task still queued after unpause");
+        pool.wait_for(reads);
+        pool.wait_for_tasks();
+    }
+
+    constexpr TestCase TESTS[] = {
+        { "threadpool/counted_exception_reaches_wait_for", counted_exception_reaches_wait_for },
+        { "threadpool/parallel_for_rethrows_on_the_caller", parallel_for_rethrows_on_the_caller },
+        { "threadpool/uncounted_exception_reaches_wait_for_tasks", uncounted_exception_reaches_wait_for_tasks },
+        { "threadpool/job_graph_rethrows_and_skips_dependents", job_graph_rethrows_and_skips_dependents },
+        { "threadpool/inline_tasks_dont_allocate", inline_tasks_dont_allocate },
+        { "threadpool/inline_size_is_where_allocations_start", inline_size_is_where_allocations_start },
+        { "threadpool/unpause_wakes_io_threads", unpause_wakes_io_threads },
+    };
+}
+
+auto get_threadpool_tests() -> std::span<const TestCase> {
+    return TESTS;
+}
@@ -0,0 +1,66 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "../frustum_culling.hpp"
+
+// culls random bounds against a rotating camera on the cpu, once with the simd path and once with the scalar one
+auto main(i32 argc, char** argv) -> i32 {
+    u32 bounds_count = argc > 1 ? static_cast<u32>(std::stoul(argv[1])) : 100'000;
+    u32 iterations = argc > 2 ? static_cast<u32>(std::stoul(argv[2])) : 200;
+
+    std::mt19937 random(1337);
+    std::uniform_real_distribution<f32> position_distribution(-500.0f, 500.0f);
+    std::uniform_real_distribution<f32> size_distribution(0.1f, 10.0f);
+
+    CullingBounds bounds = {};
+    bounds.resize(bounds_count);
+    for(u32 i = 0; i < bounds_count; i++) {
+        f32vec3 center = { position_distribution(random), position_distribution(random), position_distribution(random) };
+        f32vec3 extent = { size_distribution(random), size_distribution(random), size_distribution(random) };
+        f32 radius = std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+        bounds.set(i, { center.x - extent.x, center.y - extent.y, center.z - extent.z }, { center.x + extent.x, center.y + extent.y, center.z + extent.z }, radius);
+    }
+
+    glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    auto get_frustum = [&](u32 iteration) {
+        f32 angle = static_cast<f32>(iteration) * 0.05f;
+        glm::mat4 view = glm::lookAt(glm::vec3{0.0f}, glm::vec3{std::cos(angle), 0.0f, std::sin(angle)}, glm::vec3{0.0f, 1.0f, 0.0f});
+        return extract_frustum_planes(projection * view);
+    };
+
+    auto run = [&](const char* label, void (*cull)(const Frustum&, const CullingBounds&, VisibleList&)) -> std::vector<u32> {
+        VisibleList visible = {};
+        u64 visible_count = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for(u32 i = 0; i < iterations; i++) {
+            cull(get_frustum(i), bounds, visible);
+            visible_count += visible.statistics.visible_count;
+        }
+        f64 time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        f64 time_per_cull_us = time_ms * 1000.0 / static_cast<f64>(iterations);
+        std::cout << label << ": " << time_per_cull_us << " us per cull, " << time_per_cull_us * 1000.0 / static_cast<f64>(bounds_count) << " ns per bound, "
+                  << static_cast<f64>(visible_count) / static_cast<f64>(iterations) << " visible on average" << std::endl;
+
+        cull(get_frustum(0), bounds, visible);
+        return visible.primitive_indices;
+    };
+
+    std::vector<u32> simd_visible = run("simd", cull_frustum);
+    std::vector<u32> scalar_visible = run("scalar", cull_frustum_scalar);
+
+    if(simd_visible != scalar_visible) {
+        std::cerr << "simd and scalar culling disagree" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
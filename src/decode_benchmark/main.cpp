@@ -0,0 +1,211 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+
+#include "../texture.hpp"
+#include "../mapped_file.hpp"
+#include "../mip_generator.hpp"
+#include "../resource_budget.hpp"
+#include "../image_decoder.hpp"
+#include "../threadpool.hpp"
+
+namespace {
+    // peak resident set in KiB, linux only
+    auto get_peak_rss_kib() -> usize {
+#if defined(__linux__)
+        std::ifstream status("/proc/self/status");
+        std::string line = {};
+        while(std::getline(status, line)) {
+            if(line.rfind("VmHWM:", 0) == 0) {
+                return std::stoull(line.substr(6));
+            }
+        }
+#endif
+        return 0;
+    }
+
+    void reset_peak_rss() {
+#if defined(__linux__)
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+#endif
+    }
+
+    // what the glTF loader did before decoding into staging: rgb gets expanded into a vector, the mip chain is built in
+    // another vector and that one gets copied into staging
+    auto upload_legacy(daxa::Device device, UploadManager& uploader, std::span<const u8> bytes) -> daxa::ImageId {
+        i32 width = 0, height = 0, channel_count = 0;
+        u8* data = stbi_load_from_memory(bytes.data(), static_cast<i32>(bytes.size()), &width, &height, &channel_count, 0);
+        if(data == nullptr) {
+            throw std::runtime_error("couldn't decode image");
+        }
+
+        std::vector<u8> image_data = {};
+        u8* pixels = data;
+        if(channel_count == 3) {
+            image_data.resize(static_cast<usize>(width) * height * 4, 255);
+            for(usize i = 0; i < static_cast<usize>(width) * height; i++) {
+                std::memcpy(&image_data[i * 4], &data[i * 3], 3);
+            }
+            pixels = image_data.data();
+        }
+
+        u32 size_x = static_cast<u32>(width);
+        u32 size_y = static_cast<u32>(height);
+        u32 mip_levels = get_mip_level_count(size_x, size_y);
+        MipChain chain = generate_mip_chain({ pixels, static_cast<usize>(size_x) * size_y * 4 }, size_x, size_y, mip_levels, { .srgb = true });
+        stbi_image_free(data);
+
+        daxa::ImageId image = ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, {
+            .dimensions = 2,
+            .format = daxa::Format::R8G8B8A8_SRGB,
+            .size = { size_x, size_y, 1 },
+            .mip_level_count = mip_levels,
+            .array_layer_count = 1,
+            .sample_count = 1,
+            .usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::TRANSFER_DST,
+            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY
+        });
+
+        uploader.upload_image({
+            .image = image,
+            .size_x = size_x,
+            .size_y = size_y,
+            .data = std::as_bytes(std::span<const u8>{chain.data}),
+            .generate_mips = false,
+            .mip_offsets = chain.offsets,
+        });
+        return image;
+    }
+
+    // decodes every image each decoder takes from memory, whole and in strips for the ones that can, and prints MB/s of
+    // decoded pixels. MB are 10^6 bytes here like everyone quotes decoder throughput in
+    void benchmark_decoders(std::span<const std::filesystem::path> image_paths) {
+        std::vector<std::unique_ptr<MappedFile>> files = {};
+        for(const auto& path : image_paths) {
+            files.push_back(std::make_unique<MappedFile>(path));
+        }
+
+        ThreadPool pool(std::thread::hardware_concurrency());
+        for(const ImageDecoder* decoder : ImageDecoderRegistry::get().get_decoders()) {
+            for(ThreadPool* strip_pool : { static_cast<ThreadPool*>(nullptr), &pool }) {
+                if(strip_pool != nullptr && !decoder->supports_strips()) {
+                    continue;
+                }
+
+                u32 image_count = 0;
+                usize encoded_bytes = 0;
+                usize decoded_bytes = 0;
+                f64 total_ms = 0.0;
+                for(const auto& file : files) {
+                    ImageHeader header = {};
+                    std::span<const u8> bytes = file->get_data();
+                    if(!decoder->supports(detect_encoded_image_format(bytes)) || !decoder->read_header(bytes, header)) {
+                        continue;
+                    }
+
+                    auto start = std::chrono::steady_clock::now();
+                    DecodedImage image = decode_image(bytes, { .decoder = decoder, .pool = strip_pool });
+                    total_ms += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    image_count++;
+                    encoded_bytes += bytes.size();
+                    decoded_bytes += image.get_size();
+                }
+
+                if(image_count == 0) {
+                    continue;
+                }
+                f64 seconds = total_ms / 1000.0;
+                std::cout << decoder->get_name() << (strip_pool != nullptr ? " strips" : "") << ": " << image_count << " images in " << total_ms << " ms, "
+                          << static_cast<f64>(decoded_bytes) / 1e6 / seconds << " MB/s decoded, " << static_cast<f64>(encoded_bytes) / 1e6 / seconds << " MB/s encoded" << std::endl;
+            }
+        }
+    }
+}
+
+// decodes every image next to a model with every decoder the build has, then from memory like the embedded glTF images,
+// once the old way and once straight into staging memory, and prints per image times and the peak resident set of both.
+// --decoders stops after the decoders and never touches the gpu
+auto main(i32 argc, char** argv) -> i32 {
+    std::filesystem::path model_path = "assets/Sponza/glTF/Sponza.gltf";
+    bool decoders_only = false;
+    for(i32 i = 1; i < argc; i++) {
+        if(std::string(argv[i]) == "--decoders") {
+            decoders_only = true;
+        } else {
+            model_path = argv[i];
+        }
+    }
+
+    std::vector<std::filesystem::path> image_paths = {};
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(model_path.parent_path())) {
+        std::string extension = entry.path().extension().string();
+        if(extension == ".png" || extension == ".jpg" || extension == ".jpeg") {
+            image_paths.push_back(entry.path());
+        }
+    }
+    std::sort(image_paths.begin(), image_paths.end());
+    std::cout << image_paths.size() << " images" << std::endl;
+
+    benchmark_decoders(image_paths);
+    if(decoders_only) {
+        return 0;
+    }
+
+    daxa::Instance instance = daxa::create_instance({});
+    daxa::Device device = instance.create_device({ .name = "benchmark device" });
+
+    auto run = [&](const char* label, bool direct) {
+        reset_peak_rss();
+        usize baseline_rss = get_peak_rss_kib();
+
+        UploadManager uploader(device, { .name = "decode benchmark uploader" });
+        std::vector<daxa::ImageId> legacy_images = {};
+        std::vector<std::unique_ptr<Texture>> textures = {};
+
+        f64 total_ms = 0.0;
+        for(const auto& path : image_paths) {
+            MappedFile file(path);
+            auto start = std::chrono::steady_clock::now();
+            if(direct) {
+                DecodedImage image = Texture::load_pixels(file.get_data());
+                textures.push_back(std::make_unique<Texture>(device, uploader, image.size_x, image.size_y, image.pixels.get(), image.channel_count, Texture::Type::SRGB));
+            } else {
+                legacy_images.push_back(upload_legacy(device, uploader, file.get_data()));
+            }
+            f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            total_ms += ms;
+            std::cout << "  " << label << " " << path.filename().string() << ": " << ms << " ms" << std::endl;
+        }
+
+        auto wait_start = std::chrono::steady_clock::now();
+        uploader.flush().wait();
+        f64 wait_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - wait_start).count();
+
+        usize peak_rss = get_peak_rss_kib();
+        std::cout << label << ": " << total_ms << " ms decoding and recording, " << wait_ms << " ms waiting for the gpu, peak rss "
+                  << static_cast<f64>(peak_rss) / 1024.0 << " MiB (" << static_cast<f64>(peak_rss - std::min(peak_rss, baseline_rss)) / 1024.0 << " MiB over the start)" << std::endl;
+
+        for(daxa::ImageId image : legacy_images) {
+            ResourceBudget::get().destroy_image(device, image);
+        }
+        textures.clear();
+        device.wait_idle();
+        device.collect_garbage();
+    };
+
+    run("legacy", false);
+    run("direct", true);
+
+    return 0;
+}
@@ -10,9 +10,10 @@ layout(location = 0) out f32vec2 out_uv;
 layout(location = 1) out f32vec3 out_normal;
 
 void main() {
-    out_uv = deref(push.vertices[gl_VertexIndex]).uv;
-    out_normal = normalize(deref(push.vertices[gl_VertexIndex]).normal);
-    gl_Position = push.mvp * f32vec4(deref(push.vertices[gl_VertexIndex]).position, 1.0);
+    Vertex vertex = get_vertex(push.vertices, push.primitives, push.primitive_index, u32(gl_VertexIndex));
+    out_uv = vertex.uv;
+    out_normal = normalize(vertex.normal);
+    gl_Position = push.mvp * f32vec4(vertex.position, 1.0);
 }
 
 #elif DAXA_SHADER_STAGE == DAXA_SHADER_STAGE_FRAGMENT
@@ -24,7 +25,7 @@ layout(location = 0) out f32vec4 out_albedo;
 layout(location = 1) out f32vec4 out_normal;
 
 void main() {
-    out_albedo = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0);
+    out_albedo = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0);
     out_normal = f32vec4(normalize(in_normal), 1.0);
 }
 
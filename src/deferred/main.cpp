@@ -8,6 +8,11 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
+
+// fetch the 20 byte PackedVertex instead of the full 48 byte Vertex
+static constexpr bool USE_PACKED_VERTICES = true;
 
 struct GBufferGatherTask {
     struct Uses {
@@ -19,6 +24,7 @@ struct GBufferGatherTask {
     std::string_view name = "g buffer gather";
     RasterPipelineHolder* pipeline = {};
     Model* model = {};
+    VisibleList* visible = {};
     ControlledCamera3D* camera = {};
 
     void callback(daxa::TaskInterface ti) {
@@ -51,20 +57,25 @@ struct GBufferGatherTask {
         glm::mat4 model_mat = glm::translate(glm::mat4{1.0f}, glm::vec3{0.0f, 0.0f, 0.0f}) * glm::scale(glm::mat4{1.0f}, glm::vec3{0.01f, 0.01f, 0.01f});
         glm::mat4 mvp = camera->camera.get_vp() * model_mat;
 
-        for(auto& primitive : model->primitives) {
+        model->cull(mvp, *visible);
+        for(u32 primitive_index : visible->primitive_indices) {
+            auto& primitive = model->primitives[primitive_index];
             cmd_list.push_constant(GBufferGatherPush {
                 .mvp = *reinterpret_cast<f32mat4x4*>(&mvp),
                 .vertices = ti.get_device().get_device_address(model->vertex_buffer),
                 .materials = ti.get_device().get_device_address(model->material_buffer),
-                .material_index = primitive.material_index
+                .primitives = ti.get_device().get_device_address(model->primitive_buffer),
+                .material_index = primitive.material_index,
+                .primitive_index = primitive_index
             });
 
             if(primitive.index_count > 0) {
+                PrimitiveLod lod = model->select_lod(primitive, camera->camera, model_mat, static_cast<f32>(size_y));
                 cmd_list.set_index_buffer(model->index_buffer, 0);
                 cmd_list.draw_indexed({
-                    .index_count = primitive.index_count,
+                    .index_count = lod.index_count,
                     .instance_count = 1,
-                    .first_index = primitive.first_index,
+                    .first_index = lod.first_index,
                     .vertex_offset = static_cast<i32>(primitive.first_vertex),
                     .first_instance = 0,
                 });
@@ -121,6 +132,7 @@ struct CompositionTask {
 
 struct DeferredApp : public App {
     std::unique_ptr<Model> model = {};
+    VisibleList visible = {};
 
     RasterPipelineHolder g_buffer_gather_pipeline = {};
     RasterPipelineHolder composition_pipeline = {};
@@ -148,9 +160,19 @@ struct DeferredApp : public App {
         g_buffer_gather_pipeline.pipeline = pipeline_manager.add_raster_pipeline(daxa::RasterPipelineCompileInfo {
             .vertex_shader_info = daxa::ShaderCompileInfo {
                 .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/deferred/g_buffer_gather.glsl" }, },
+                .compile_options = {
+                    .defines = {
+                        { .name = "PACKED_VERTICES", .value = USE_PACKED_VERTICES ? "1" : "0" },
+                    }
+                }
             },
             .fragment_shader_info = daxa::ShaderCompileInfo {
                 .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/deferred/g_buffer_gather.glsl" }, },
+                .compile_options = {
+                    .defines = {
+                        { .name = "PACKED_VERTICES", .value = USE_PACKED_VERTICES ? "1" : "0" },
+                    }
+                }
             },
             .color_attachments = {
                 { .format = swapchain.get_format() }, // albedo image
@@ -181,7 +203,7 @@ struct DeferredApp : public App {
             .push_constant_size = sizeof(CompositionPush),
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -194,7 +216,7 @@ struct DeferredApp : public App {
             .name = "task depth image"
         }};
 
-        albedo_image = device.create_image({
+        albedo_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = swapchain.get_format(),
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -206,7 +228,7 @@ struct DeferredApp : public App {
             .name = "task albedo image"
         }};
 
-        normal_image = device.create_image({
+        normal_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::R16G16B16A16_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -218,7 +240,7 @@ struct DeferredApp : public App {
             .name = "task normal image"
         }};
 
-        sampler_id = device.create_sampler({
+        sampler_id = SamplerCache::get().acquire(device, {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -237,7 +259,12 @@ struct DeferredApp : public App {
 
         camera.camera.resize(size_x, size_y);
 
-        model = std::make_unique<Model>(device, "assets/Sponza/glTF/Sponza.gltf");
+        model = std::make_unique<Model>(device, "assets/Sponza/glTF/Sponza.gltf", ModelLoadInfo {
+            .packed_vertices = USE_PACKED_VERTICES,
+            .optimize_meshes = true,
+            .generate_lods = true,
+            .pack_small_textures = true,
+        });
 
         render_task_graph = daxa::TaskGraph({
             .device = device,
@@ -260,6 +287,7 @@ struct DeferredApp : public App {
             },
             .pipeline = &g_buffer_gather_pipeline,
             .model = model.get(),
+            .visible = &visible,
             .camera = &camera
         });
 
@@ -280,10 +308,10 @@ struct DeferredApp : public App {
     }
 
     ~DeferredApp() {
-        device.destroy_image(depth_image);
-        device.destroy_image(albedo_image);
-        device.destroy_image(normal_image);
-        device.destroy_sampler(sampler_id);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_image(device, albedo_image);
+        ResourceBudget::get().destroy_image(device, normal_image);
+        SamplerCache::get().release(device, sampler_id);
     }
 
     void render() {
@@ -314,8 +342,8 @@ struct DeferredApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -323,16 +351,16 @@ struct DeferredApp : public App {
             });
             task_depth_image.set_images({.images = std::span{&depth_image, 1}});
 
-            device.destroy_image(albedo_image);
-            albedo_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, albedo_image);
+            albedo_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = swapchain.get_format(),
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
             });
             task_albedo_image.set_images({.images = std::span{&albedo_image, 1}});
 
-            device.destroy_image(normal_image);
-            normal_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, normal_image);
+            normal_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::R16G16B16A16_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -6,9 +6,11 @@
 
 struct GBufferGatherPush {
     f32mat4x4 mvp;
-    daxa_BufferPtr(Vertex) vertices;
+    VertexBufferPtr vertices;
     daxa_BufferPtr(Material) materials;
+    daxa_BufferPtr(Primitive) primitives;
     u32 material_index;
+    u32 primitive_index;
 };
 
 struct CompositionPush {
@@ -49,7 +49,7 @@ f32 shadow_pcf(daxa_ImageViewId shadow_image, daxa_SamplerId shadow_sampler, f32
 
 void main() {
 
-    color = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0);
+    color = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0);
 #if USE_PCF == 0
     color.rgb *= max(calculate_shadow(
         deref(push.light_buffer).shadow_image, 
@@ -10,6 +10,8 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 
 #include <daxa/utils/imgui.hpp>
 #include <imgui.h>
@@ -23,6 +25,7 @@ struct RenderShadowTask {
     std::string_view name = "render shadow";
     RasterPipelineHolder* pipeline = {};
     Model* model = {};
+    VisibleList* visible = {};
     glm::mat4* light_matrix = {};
 
     void callback(daxa::TaskInterface ti) {
@@ -40,7 +43,9 @@ struct RenderShadowTask {
 
         glm::mat4 shadow_mvp = *light_matrix;
 
-        for(auto& primitive : model->primitives) {
+        model->cull(shadow_mvp, *visible);
+        for(u32 primitive_index : visible->primitive_indices) {
+            auto& primitive = model->primitives[primitive_index];
             cmd_list.push_constant(ShadowPush {
                 .mvp = *reinterpret_cast<f32mat4x4*>(&shadow_mvp),
                 .vertices = ti.get_device().get_device_address(model->vertex_buffer)
@@ -80,6 +85,7 @@ struct RenderTask {
     RasterPipelineHolder* pipeline = {};
     ControlledCamera3D* camera = {};
     Model* model = {};
+    VisibleList* visible = {};
     daxa::BufferId light_buffer = {};
     daxa::ImGuiRenderer imgui_renderer = {};
 
@@ -110,7 +116,9 @@ struct RenderTask {
 
         glm::mat4 mvp = camera->camera.get_vp() * glm::translate(glm::mat4{1.0f}, glm::vec3{0.0f, 0.0f, 0.0f}) * glm::scale(glm::mat4{1.0f}, glm::vec3{0.01f, 0.01f, 0.01f});
 
-        for(auto& primitive : model->primitives) {
+        model->cull(mvp, *visible);
+        for(u32 primitive_index : visible->primitive_indices) {
+            auto& primitive = model->primitives[primitive_index];
             cmd_list.push_constant(DrawPush {
                 .mvp = *reinterpret_cast<f32mat4x4*>(&mvp),
                 .vertices = ti.get_device().get_device_address(model->vertex_buffer),
@@ -150,6 +158,8 @@ struct RenderTask {
 
 struct ESMApp : public App {
     std::unique_ptr<Model> model = {};
+    VisibleList visible = {};
+    VisibleList shadow_visible = {};
     RasterPipelineHolder raster_pipeline = {};
     RasterPipelineHolder shadow_pipeline = {};
 
@@ -230,7 +240,7 @@ struct ESMApp : public App {
             .name = "shadow pipeline"
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -243,7 +253,7 @@ struct ESMApp : public App {
             .name = "task depth image"
         }};
 
-        shadow_image = device.create_image({
+        shadow_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = {1024, 1024, 1},
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -256,7 +266,7 @@ struct ESMApp : public App {
             .name = "task shadow image"
         }};
 
-        shadow_sampler = device.create_sampler(daxa::SamplerInfo {
+        shadow_sampler = SamplerCache::get().acquire(device, daxa::SamplerInfo {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -274,7 +284,7 @@ struct ESMApp : public App {
             .enable_unnormalized_coordinates = false,
         });
 
-        light_buffer = device.create_buffer(daxa::BufferInfo {
+        light_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(LightInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "light buffer"
@@ -309,6 +319,7 @@ struct ESMApp : public App {
             },
             .pipeline = &shadow_pipeline,
             .model = model.get(),
+            .visible = &shadow_visible,
             .light_matrix = &light_matrix
         });
 
@@ -321,6 +332,7 @@ struct ESMApp : public App {
             .pipeline = &raster_pipeline,
             .camera = &camera,
             .model = model.get(),
+            .visible = &visible,
             .light_buffer = light_buffer,
             .imgui_renderer = imgui_renderer,
             .bias = &bias,
@@ -335,10 +347,10 @@ struct ESMApp : public App {
     }
 
     ~ESMApp() {
-        device.destroy_image(depth_image);
-        device.destroy_image(shadow_image);
-        device.destroy_sampler(shadow_sampler);
-        device.destroy_buffer(light_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_image(device, shadow_image);
+        SamplerCache::get().release(device, shadow_sampler);
+        ResourceBudget::get().destroy_buffer(device, light_buffer);
     }
 
     void render() {
@@ -387,6 +399,8 @@ struct ESMApp : public App {
             ImGui::DragFloat("exponential factor", &exponential_factor);
             ImGui::DragFloat("darkening factor", &darkening_factor, 0.01f, 0.0000001f, 10.0f);
             ImGui::DragFloat("shadow intensity", &shadow_intensity, 0.05f, 0.0001f, 1.0f);
+            ImGui::Text("visible primitives: %u/%u in %.1f us", visible.statistics.visible_count, visible.statistics.tested_count, visible.statistics.time_us);
+            ImGui::Text("visible shadow casters: %u/%u in %.1f us", shadow_visible.statistics.visible_count, shadow_visible.statistics.tested_count, shadow_visible.statistics.time_us);
             ImGui::End();
 
             ImGui::Render();
@@ -403,8 +417,8 @@ struct ESMApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
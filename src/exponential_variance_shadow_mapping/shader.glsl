@@ -67,7 +67,7 @@ f32 calculate_shadow(daxa_ImageViewId shadow_image, daxa_SamplerId shadow_sample
 }
 
 void main() {
-    color = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0);
+    color = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0);
     color.rgb *= max(push.shadow_intensity, calculate_shadow(deref(push.light_buffer).shadow_image, deref(push.light_buffer).shadow_sampler, in_position_shadow / in_position_shadow.w));
 }
 
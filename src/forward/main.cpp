@@ -3,11 +3,19 @@
 
 #include <glm/glm.hpp>
 #include <cstring>
+#include <charconv>
+#include <chrono>
+#include <iostream>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
 
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+
+// fetch the 20 byte PackedVertex instead of the full 48 byte Vertex
+static constexpr bool USE_PACKED_VERTICES = true;
 
 struct RenderTask {
     struct Uses {
@@ -18,6 +26,7 @@ struct RenderTask {
     std::string_view name = "render";
     RasterPipelineHolder* pipeline = {};
     Model* model = {};
+    VisibleList* visible = {};
     ControlledCamera3D* camera = {};
 
     void callback(daxa::TaskInterface ti) {
@@ -44,20 +53,25 @@ struct RenderTask {
 
         glm::mat4 mvp = camera->camera.get_vp() * model_mat;
 
-        for(auto& primitive : model->primitives) {
+        model->cull(mvp, *visible);
+        for(u32 primitive_index : visible->primitive_indices) {
+            auto& primitive = model->primitives[primitive_index];
             cmd_list.push_constant(DrawPush {
                 .mvp = *reinterpret_cast<f32mat4x4*>(&mvp),
                 .vertices = ti.get_device().get_device_address(model->vertex_buffer),
                 .materials = ti.get_device().get_device_address(model->material_buffer),
-                .material_index = primitive.material_index
+                .primitives = ti.get_device().get_device_address(model->primitive_buffer),
+                .material_index = primitive.material_index,
+                .primitive_index = primitive_index
             });
 
             if(primitive.index_count > 0) {
+                PrimitiveLod lod = model->select_lod(primitive, camera->camera, model_mat, static_cast<f32>(size_y));
                 cmd_list.set_index_buffer(model->index_buffer, 0);
                 cmd_list.draw_indexed({
-                    .index_count = primitive.index_count,
+                    .index_count = lod.index_count,
                     .instance_count = 1,
-                    .first_index = primitive.first_index,
+                    .first_index = lod.first_index,
                     .vertex_offset = static_cast<i32>(primitive.first_vertex),
                     .first_instance = 0,
                 });
@@ -77,6 +91,7 @@ struct RenderTask {
 
 struct ForwardApp : public App {
     std::unique_ptr<Model> model = {};
+    VisibleList visible = {};
     RasterPipelineHolder raster_pipeline = {};
     daxa::ImageId depth_image = {};
     daxa::TaskImage task_depth_image = {};
@@ -91,13 +106,26 @@ struct ForwardApp : public App {
     f64 delta_time;
     bool paused = false;
 
-    ForwardApp() : App("Forward Example") {
+    // frames of the scripted flythrough, 0 for the usual controlled camera
+    u32 camera_path_frames = 0;
+
+    ForwardApp(const ModelLoadInfo& load_info) : App("Forward Example") {
         raster_pipeline.pipeline = pipeline_manager.add_raster_pipeline(daxa::RasterPipelineCompileInfo {
             .vertex_shader_info = daxa::ShaderCompileInfo {
                 .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/forward/shader.glsl" }, },
+                .compile_options = {
+                    .defines = {
+                        { .name = "PACKED_VERTICES", .value = USE_PACKED_VERTICES ? "1" : "0" },
+                    }
+                }
             },
             .fragment_shader_info = daxa::ShaderCompileInfo {
                 .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/forward/shader.glsl" }, },
+                .compile_options = {
+                    .defines = {
+                        { .name = "PACKED_VERTICES", .value = USE_PACKED_VERTICES ? "1" : "0" },
+                    }
+                }
             },
             .color_attachments = {{ .format = swapchain.get_format() }},
             .depth_test = {
@@ -111,7 +139,7 @@ struct ForwardApp : public App {
             .push_constant_size = sizeof(DrawPush),
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -134,7 +162,7 @@ struct ForwardApp : public App {
         render_task_graph.use_persistent_image(task_swapchain_image);
         render_task_graph.use_persistent_image(task_depth_image);
 
-        model = std::make_unique<Model>(device, "assets/Sponza/glTF/Sponza.gltf");
+        model = std::make_unique<Model>(device, "assets/Sponza/glTF/Sponza.gltf", load_info);
 
         render_task_graph.add_task(RenderTask {
             .uses = {
@@ -143,6 +171,7 @@ struct ForwardApp : public App {
             },
             .pipeline = &raster_pipeline,
             .model = model.get(),
+            .visible = &visible,
             .camera = &camera
         });
 
@@ -156,7 +185,7 @@ struct ForwardApp : public App {
     ~ForwardApp() {
         device.wait_idle();
         device.collect_garbage();
-        device.destroy_image(depth_image);
+        ResourceBudget::get().destroy_image(device, depth_image);
     }
 
     void render() {
@@ -165,19 +194,53 @@ struct ForwardApp : public App {
         if(swapchain_image.is_empty()) { return; }
 
         render_task_graph.execute({});
+        device.collect_garbage();
+    }
+
+    // down the nave and back while turning around twice, the same camera every run no matter how long a frame took
+    void set_camera_path(u32 frame) {
+        f32 t = static_cast<f32>(frame) / static_cast<f32>(camera_path_frames);
+        camera.position = glm::vec3{ 11.0f * std::sin(t * 2.0f * glm::pi<f32>()), 1.5f + 4.0f * t, -0.5f };
+        camera.rotation = glm::vec3{ t * 4.0f * glm::pi<f32>(), 0.3f * std::sin(t * 6.0f * glm::pi<f32>()), 0.0f };
+        camera.update(0.0f);
     }
 
     void update() {
-        while (!glfwWindowShouldClose(glfw_window_ptr)) {
+        auto path_start = std::chrono::steady_clock::now();
+        for (u32 frame = 0; !glfwWindowShouldClose(glfw_window_ptr); frame++) {
             current_frame = glfwGetTime();
             delta_time = current_frame - last_frame;
             last_frame = current_frame;
 
-            camera.update(delta_time);
+            if (camera_path_frames != 0) {
+                if (frame == camera_path_frames) {
+                    break;
+                }
+                set_camera_path(frame);
+                if (frame % 120 == 0 && model->texture_streamer) {
+                    std::cout << "frame " << frame << ": ";
+                    model->texture_streamer->get_statistics().print();
+                }
+            } else {
+                camera.update(delta_time);
+            }
+            ResourceBudget::get().update();
+            model->update();
 
             glfwPollEvents();
             render();
         }
+
+        if (camera_path_frames != 0) {
+            device.wait_idle();
+            f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - path_start).count();
+            std::cout << camera_path_frames << " frames in " << ms << " ms" << std::endl;
+            if (model->texture_streamer) {
+                model->texture_streamer->get_statistics().print();
+            }
+            ResourceBudget::get().get_statistics().print();
+            ResourceBudget::get().dump("resource_budget.json");
+        }
     }
 
     void resize(u32 x, u32 y) override {
@@ -187,8 +250,8 @@ struct ForwardApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -227,8 +290,71 @@ struct ForwardApp : public App {
     }
 };
 
-auto main() -> i32 {
-    ForwardApp app;
+namespace {
+    void print_usage(const char* program) {
+        std::cerr << "usage: " << program << " [options]\n"
+                  << "  --camera-path <frames>  fly a fixed path instead of taking input, print the streaming statistics, dump\n"
+                  << "                          the device memory usage to resource_budget.json and exit\n"
+                  << "  --budget <MiB>          cap the device memory everything may take together\n"
+                  << "  --compress-textures     load the textures as BC blocks, the first run encodes every one of them\n"
+                  << "  --stream-mips <MiB>     start textures out with their coarse levels and stream the finer ones in on\n"
+                  << "                          demand, within that much device memory\n"
+                  << "  --evictable-geometry    let the budget drop the model geometry while it is out of view" << std::endl;
+    }
+
+    // the whole argument has to be a number that fits, stoul would take 12abc and throw out of main on abc
+    template <typename T>
+    auto parse_number(const char* text, T& value) -> bool {
+        std::string_view view = text;
+        auto [end, error] = std::from_chars(view.data(), view.data() + view.size(), value);
+        return error == std::errc{} && end == view.data() + view.size();
+    }
+}
+
+auto main(i32 argc, char** argv) -> i32 {
+    ModelLoadInfo load_info = {
+        .packed_vertices = USE_PACKED_VERTICES,
+        .optimize_meshes = true,
+        .generate_lods = true,
+    };
+
+    u32 camera_path_frames = 0;
+    for (i32 i = 1; i < argc; i++) {
+        std::string_view option = argv[i];
+        if (option == "--compress-textures") {
+            load_info.compress_textures = true;
+            continue;
+        }
+        if (option == "--evictable-geometry") {
+            load_info.evictable_geometry = true;
+            continue;
+        }
+
+        if (option != "--camera-path" && option != "--budget" && option != "--stream-mips") {
+            std::cerr << "unknown option " << option << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        usize mebibytes = 0;
+        bool valid = i + 1 < argc && (option == "--camera-path" ? parse_number(argv[i + 1], camera_path_frames) : parse_number(argv[i + 1], mebibytes));
+        if (!valid) {
+            std::cerr << option << " needs a number" << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+
+        if (option == "--budget") {
+            ResourceBudget::get().set_budget(mebibytes * 1024 * 1024);
+        } else if (option == "--stream-mips") {
+            load_info.stream_mips = true;
+            load_info.texture_streaming_info.budget_bytes = mebibytes * 1024 * 1024;
+        }
+    }
+
+    ForwardApp app(load_info);
+    app.camera_path_frames = camera_path_frames;
     app.update();
     return 0;
 }
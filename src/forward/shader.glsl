@@ -9,8 +9,9 @@ DAXA_DECL_PUSH_CONSTANT(DrawPush, push)
 layout(location = 0) out f32vec2 out_uv;
 
 void main() {
-    out_uv = deref(push.vertices[gl_VertexIndex]).uv;
-    gl_Position = push.mvp * f32vec4(deref(push.vertices[gl_VertexIndex]).position, 1.0);
+    Vertex vertex = get_vertex(push.vertices, push.primitives, push.primitive_index, u32(gl_VertexIndex));
+    out_uv = vertex.uv;
+    gl_Position = push.mvp * f32vec4(vertex.position, 1.0);
 }
 
 #elif DAXA_SHADER_STAGE == DAXA_SHADER_STAGE_FRAGMENT
@@ -20,7 +21,7 @@ layout(location = 0) in f32vec2 in_uv;
 layout(location = 0) out f32vec4 color;
 
 void main() {
-    color = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0);
+    color = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0);
 }
 
 #endif
\ No newline at end of file
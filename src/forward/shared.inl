@@ -6,7 +6,9 @@
 
 struct DrawPush {
     f32mat4x4 mvp;
-    daxa_BufferPtr(Vertex) vertices;
+    VertexBufferPtr vertices;
     daxa_BufferPtr(Material) materials;
+    daxa_BufferPtr(Primitive) primitives;
     u32 material_index;
+    u32 primitive_index;
 };
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "frustum_culling.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if defined(__AVX2__)
+#define FRUSTUM_CULLING_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLING_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr u32 NEAR_PLANE = 4;
+
+    auto get_row(const glm::mat4& matrix, u32 row) -> glm::vec4 {
+        return { matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row] };
+    }
+
+    auto normalize_plane(const glm::vec4& plane) -> glm::vec4 {
+        f32 length = glm::length(glm::vec3(plane));
+        if(length <= 1e-12f) {
+            return plane;
+        }
+        return plane / length;
+    }
+
+    auto elapsed_us(std::chrono::steady_clock::time_point start) -> f64 {
+        return std::chrono::duration<f64, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void reserve_visible(const CullingBounds& bounds, VisibleList& visible) {
+        visible.primitive_indices.clear();
+        visible.distances.clear();
+        visible.primitive_indices.reserve(bounds.count);
+        visible.distances.reserve(bounds.count);
+    }
+
+    auto is_visible(const Frustum& frustum, const CullingBounds& bounds, u32 i) -> bool {
+        for(const glm::vec4& plane : frustum.planes) {
+            f32 distance = plane.x * bounds.center_x[i] + plane.y * bounds.center_y[i] + plane.z * bounds.center_z[i] + plane.w;
+            f32 box_radius = std::abs(plane.x) * bounds.extent_x[i] + std::abs(plane.y) * bounds.extent_y[i] + std::abs(plane.z) * bounds.extent_z[i];
+            if(distance < -std::min(box_radius, bounds.radius[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto get_near_distance(const Frustum& frustum, const CullingBounds& bounds, u32 i) -> f32 {
+        const glm::vec4& plane = frustum.planes[NEAR_PLANE];
+        return plane.x * bounds.center_x[i] + plane.y * bounds.center_y[i] + plane.z * bounds.center_z[i] + plane.w;
+    }
+
+    // the padding lanes at the end never make it into the list
+    void emit_visible_lanes(const Frustum& frustum, const CullingBounds& bounds, VisibleList& visible, u32 first, u32 mask) {
+        while(mask != 0) {
+            u32 lane = static_cast<u32>(std::countr_zero(mask));
+            mask &= mask - 1;
+
+            u32 index = first + lane;
+            if(index >= bounds.count) {
+                break;
+            }
+            visible.primitive_indices.push_back(index);
+            visible.distances.push_back(get_near_distance(frustum, bounds, index));
+        }
+    }
+}
+
+auto extract_frustum_planes(const glm::mat4& clip_matrix) -> Frustum {
+    glm::vec4 row_x = get_row(clip_matrix, 0);
+    glm::vec4 row_y = get_row(clip_matrix, 1);
+    glm::vec4 row_z = get_row(clip_matrix, 2);
+    glm::vec4 row_w = get_row(clip_matrix, 3);
+
+    return Frustum {
+        .planes = {
+            normalize_plane(row_w + row_x),
+            normalize_plane(row_w - row_x),
+            normalize_plane(row_w + row_y),
+            normalize_plane(row_w - row_y),
+            normalize_plane(row_z),
+            normalize_plane(row_w - row_z),
+        }
+    };
+}
+
+void CullingBounds::resize(u32 bounds_count) {
+    count = bounds_count;
+    usize padded_count = (static_cast<usize>(bounds_count) + LANE_COUNT - 1) / LANE_COUNT * LANE_COUNT;
+    for(std::vector<f32>* component : { &center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z, &radius }) {
+        component->assign(padded_count, 0.0f);
+    }
+}
+
+void CullingBounds::set(u32 index, f32vec3 aabb_min, f32vec3 aabb_max, f32 bounding_radius) {
+    center_x[index] = (aabb_min.x + aabb_max.x) * 0.5f;
+    center_y[index] = (aabb_min.y + aabb_max.y) * 0.5f;
+    center_z[index] = (aabb_min.z + aabb_max.z) * 0.5f;
+    extent_x[index] = (aabb_max.x - aabb_min.x) * 0.5f;
+    extent_y[index] = (aabb_max.y - aabb_min.y) * 0.5f;
+    extent_z[index] = (aabb_max.z - aabb_min.z) * 0.5f;
+    radius[index] = bounding_radius;
+}
+
+auto make_culling_bounds(std::span<const Primitive> primitives) -> CullingBounds {
+    CullingBounds bounds = {};
+    bounds.resize(static_cast<u32>(primitives.size()));
+    for(u32 i = 0; i < primitives.size(); i++) {
+        bounds.set(i, primitives[i].aabb_min, primitives[i].aabb_max, primitives[i].bounding_radius);
+    }
+    return bounds;
+}
+
+void CullingStatistics::print() const {
+    std::cout << "culling: " << visible_count << "/" << tested_count << " visible in " << time_us << " us" << std::endl;
+}
+
+void VisibleList::clear() {
+    primitive_indices.clear();
+    distances.clear();
+    statistics = {};
+}
+
+void cull_frustum_scalar(const Frustum& frustum, const CullingBounds& bounds, VisibleList& visible) {
+    auto start = std::chrono::steady_clock::now();
+    reserve_visible(bounds, visible);
+
+    for(u32 i = 0; i < bounds.count; i++) {
+        if(is_visible(frustum, bounds, i)) {
+            visible.primitive_indices.push_back(i);
+            visible.distances.push_back(get_near_distance(frustum, bounds, i));
+        }
+    }
+
+    visible.statistics = {
+        .tested_count = bounds.count,
+        .visible_count = static_cast<u32>(visible.primitive_indices.size()),
+        .time_us = elapsed_us(start),
+    };
+}
+
+void cull_frustum(const Frustum& frustum, const CullingBounds& bounds, VisibleList& visible) {
+#if defined(FRUSTUM_CULLING_AVX2)
+    auto start = std::chrono::steady_clock::now();
+    reserve_visible(bounds, visible);
+
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    for(u32 first = 0; first < bounds.count; first += 8) {
+        __m256 center_x = _mm256_loadu_ps(&bounds.center_x[first]);
+        __m256 center_y = _mm256_loadu_ps(&bounds.center_y[first]);
+        __m256 center_z = _mm256_loadu_ps(&bounds.center_z[first]);
+        __m256 extent_x = _mm256_loadu_ps(&bounds.extent_x[first]);
+        __m256 extent_y = _mm256_loadu_ps(&bounds.extent_y[first]);
+        __m256 extent_z = _mm256_loadu_ps(&bounds.extent_z[first]);
+        __m256 radius = _mm256_loadu_ps(&bounds.radius[first]);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for(const glm::vec4& plane : frustum.planes) {
+            __m256 normal_x = _mm256_set1_ps(plane.x);
+            __m256 normal_y = _mm256_set1_ps(plane.y);
+            __m256 normal_z = _mm256_set1_ps(plane.z);
+
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normal_x, center_x), _mm256_mul_ps(normal_y, center_y)), _mm256_add_ps(_mm256_mul_ps(normal_z, center_z), _mm256_set1_ps(plane.w)));
+            __m256 box_radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(sign_mask, normal_x), extent_x), _mm256_mul_ps(_mm256_andnot_ps(sign_mask, normal_y), extent_y)), _mm256_mul_ps(_mm256_andnot_ps(sign_mask, normal_z), extent_z));
+            __m256 effective_radius = _mm256_min_ps(box_radius, radius);
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_xor_ps(effective_radius, sign_mask), _CMP_GE_OQ));
+        }
+
+        emit_visible_lanes(frustum, bounds, visible, first, static_cast<u32>(_mm256_movemask_ps(inside)));
+    }
+
+    visible.statistics = {
+        .tested_count = bounds.count,
+        .visible_count = static_cast<u32>(visible.primitive_indices.size()),
+        .time_us = elapsed_us(start),
+    };
+#elif defined(FRUSTUM_CULLING_SSE)
+    auto start = std::chrono::steady_clock::now();
+    reserve_visible(bounds, visible);
+
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    for(u32 first = 0; first < bounds.count; first += 4) {
+        __m128 center_x = _mm_loadu_ps(&bounds.center_x[first]);
+        __m128 center_y = _mm_loadu_ps(&bounds.center_y[first]);
+        __m128 center_z = _mm_loadu_ps(&bounds.center_z[first]);
+        __m128 extent_x = _mm_loadu_ps(&bounds.extent_x[first]);
+        __m128 extent_y = _mm_loadu_ps(&bounds.extent_y[first]);
+        __m128 extent_z = _mm_loadu_ps(&bounds.extent_z[first]);
+        __m128 radius = _mm_loadu_ps(&bounds.radius[first]);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(const glm::vec4& plane : frustum.planes) {
+            __m128 normal_x = _mm_set1_ps(plane.x);
+            __m128 normal_y = _mm_set1_ps(plane.y);
+            __m128 normal_z = _mm_set1_ps(plane.z);
+
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normal_x, center_x), _mm_mul_ps(normal_y, center_y)), _mm_add_ps(_mm_mul_ps(normal_z, center_z), _mm_set1_ps(plane.w)));
+            __m128 box_radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, normal_x), extent_x), _mm_mul_ps(_mm_andnot_ps(sign_mask, normal_y), extent_y)), _mm_mul_ps(_mm_andnot_ps(sign_mask, normal_z), extent_z));
+            __m128 effective_radius = _mm_min_ps(box_radius, radius);
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_xor_ps(effective_radius, sign_mask)));
+        }
+
+        emit_visible_lanes(frustum, bounds, visible, first, static_cast<u32>(_mm_movemask_ps(inside)));
+    }
+
+    visible.statistics = {
+        .tested_count = bounds.count,
+        .visible_count = static_cast<u32>(visible.primitive_indices.size()),
+        .time_us = elapsed_us(start),
+    };
+#else
+    cull_frustum_scalar(frustum, bounds, visible);
+#endif
+}
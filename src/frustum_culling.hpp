@@ -0,0 +1,64 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include "common.inl"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <span>
+#include <vector>
+
+// left, right, bottom, top, near, far with normals pointing inside, xyz is the normalized normal and w the distance
+struct Frustum {
+    std::array<glm::vec4, 6> planes = {};
+};
+
+// works for any clip matrix with 0 to 1 depth, a view projection gives world space planes and a model view projection
+// model space ones so the bounds never have to be transformed
+auto extract_frustum_planes(const glm::mat4& clip_matrix) -> Frustum;
+
+// bounds of every primitive split into one array per component so 4 or 8 of them can be tested at once,
+// the arrays are padded to a multiple of LANE_COUNT
+struct CullingBounds {
+    static constexpr usize LANE_COUNT = 8;
+
+    std::vector<f32> center_x = {};
+    std::vector<f32> center_y = {};
+    std::vector<f32> center_z = {};
+    std::vector<f32> extent_x = {};
+    std::vector<f32> extent_y = {};
+    std::vector<f32> extent_z = {};
+    std::vector<f32> radius = {};
+    u32 count = 0;
+
+    void resize(u32 bounds_count);
+    void set(u32 index, f32vec3 aabb_min, f32vec3 aabb_max, f32 bounding_radius);
+};
+
+auto make_culling_bounds(std::span<const Primitive> primitives) -> CullingBounds;
+
+struct CullingStatistics {
+    u32 tested_count = 0;
+    u32 visible_count = 0;
+    f64 time_us = 0.0;
+
+    void print() const;
+};
+
+// visible primitives in the order they were tested, distance is how far in front of the near plane the bounding
+// sphere center is which is enough to sort front to back
+struct VisibleList {
+    std::vector<u32> primitive_indices = {};
+    std::vector<f32> distances = {};
+    CullingStatistics statistics = {};
+
+    void clear();
+};
+
+// keeps a bound when both its sphere and its aabb touch every plane, uses AVX2 or SSE when the compiler targets them
+void cull_frustum(const Frustum& frustum, const CullingBounds& bounds, VisibleList& visible);
+// same test one bound at a time, the reference for the simd path
+void cull_frustum_scalar(const Frustum& frustum, const CullingBounds& bounds, VisibleList& visible);
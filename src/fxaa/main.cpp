@@ -12,6 +12,8 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 
 struct RenderTask {
     struct Uses {
@@ -22,6 +24,7 @@ struct RenderTask {
     std::string_view name = "render";
     RasterPipelineHolder* pipeline = {};
     Model* model = {};
+    VisibleList* visible = {};
     ControlledCamera3D* camera = {};
 
     void callback(daxa::TaskInterface ti) {
@@ -48,7 +51,9 @@ struct RenderTask {
 
         glm::mat4 mvp = camera->camera.get_vp() * model_mat;
 
-        for(auto& primitive : model->primitives) {
+        model->cull(mvp, *visible);
+        for(u32 primitive_index : visible->primitive_indices) {
+            auto& primitive = model->primitives[primitive_index];
             cmd_list.push_constant(DrawPush {
                 .mvp = *reinterpret_cast<f32mat4x4*>(&mvp),
                 .vertices = ti.get_device().get_device_address(model->vertex_buffer),
@@ -126,6 +131,7 @@ struct FXAATask {
 
 struct FXAAApp : public App {
     std::unique_ptr<Model> model = {};
+    VisibleList visible = {};
     RasterPipelineHolder raster_pipeline = {};
     RasterPipelineHolder fxaa_pipeline = {};
 
@@ -195,7 +201,7 @@ struct FXAAApp : public App {
             .push_constant_size = sizeof(FXAAPush),
         }).value();
 
-        render_image = device.create_image({
+        render_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = swapchain.get_format(),
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -207,7 +213,7 @@ struct FXAAApp : public App {
             .name = "task render image"
         }};
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -221,7 +227,7 @@ struct FXAAApp : public App {
 
         task_swapchain_image = daxa::TaskImage{{.swapchain_image = true, .name = "swapchain image"}};
 
-        sampler_id = device.create_sampler({
+        sampler_id = SamplerCache::get().acquire(device, {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -264,6 +270,7 @@ struct FXAAApp : public App {
             },
             .pipeline = &raster_pipeline,
             .model = model.get(),
+            .visible = &visible,
             .camera = &camera
         });
 
@@ -291,9 +298,9 @@ struct FXAAApp : public App {
     ~FXAAApp() {
         device.wait_idle();
         device.collect_garbage();
-        device.destroy_image(render_image);
-        device.destroy_image(depth_image);
-        device.destroy_sampler(sampler_id);
+        ResourceBudget::get().destroy_image(device, render_image);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        SamplerCache::get().release(device, sampler_id);
     }
 
     void render() {
@@ -345,6 +352,7 @@ struct FXAAApp : public App {
             ImGui::DragFloat("mul reduce", &mul_reduce, 0.01f, 0.01f, 512.0f);
             ImGui::DragFloat("min reduce", &min_reduce, 0.01f, 0.01f, 512.0f);
             ImGui::DragFloat("max span", &max_span, 0.01f, 0.01f, 512.0f);
+            ImGui::Text("visible primitives: %u/%u in %.1f us", visible.statistics.visible_count, visible.statistics.tested_count, visible.statistics.time_us);
             ImGui::End();
             ImGui::Render();
 
@@ -360,16 +368,16 @@ struct FXAAApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
 
-            device.destroy_image(render_image);
-            render_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, render_image);
+            render_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = swapchain.get_format(),
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
             });
             task_render_image.set_images({.images = std::span{&render_image, 1}});
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
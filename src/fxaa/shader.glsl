@@ -20,7 +20,7 @@ layout(location = 0) in f32vec2 in_uv;
 layout(location = 0) out f32vec4 color;
 
 void main() {
-    color = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0);
+    color = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,336 @@
+#include "image_decoder.hpp"
+#include "threadpool.hpp"
+
+#include <stb_image.h>
+
+#if defined(IMAGE_DECODER_LIBJPEG) && IMAGE_DECODER_LIBJPEG
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+#if !defined(JCS_ALPHA_EXTENSIONS)
+#error "the jpeg decoder needs libjpeg-turbo for JCS_EXT_RGBA and jpeg_skip_scanlines"
+#endif
+#endif
+
+#if defined(IMAGE_DECODER_SPNG) && IMAGE_DECODER_SPNG
+#include <spng.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // handles everything stb does, which is only ever the whole image and into memory of its own
+    struct StbImageDecoder : ImageDecoder {
+        auto get_name() const -> const char* override {
+            return "stb";
+        }
+
+        auto supports(EncodedImageFormat) const -> bool override {
+            return true;
+        }
+
+        auto read_header(std::span<const u8> bytes, ImageHeader& header) const -> bool override {
+            i32 size_x = 0, size_y = 0, file_channel_count = 0;
+            if(stbi_info_from_memory(bytes.data(), static_cast<i32>(bytes.size()), &size_x, &size_y, &file_channel_count) == 0) {
+                return false;
+            }
+            header = { .size_x = static_cast<u32>(size_x), .size_y = static_cast<u32>(size_y), .channel_count = file_channel_count == 3 ? 3u : 4u };
+            return true;
+        }
+
+        void decode(std::span<const u8> bytes, const ImageHeader& header, u32 first_row, u32 row_count, std::span<u8> rows) const override {
+            i32 size_x = 0, size_y = 0, file_channel_count = 0;
+            u8* data = stbi_load_from_memory(bytes.data(), static_cast<i32>(bytes.size()), &size_x, &size_y, &file_channel_count, static_cast<i32>(header.channel_count));
+            if(data == nullptr) {
+                throw std::runtime_error(std::string("stb couldn't decode image: ") + stbi_failure_reason());
+            }
+
+            usize stride = static_cast<usize>(header.size_x) * header.channel_count;
+            std::memcpy(rows.data(), data + first_row * stride, static_cast<usize>(row_count) * stride);
+            stbi_image_free(data);
+        }
+    };
+
+#if defined(IMAGE_DECODER_LIBJPEG) && IMAGE_DECODER_LIBJPEG
+    struct JpegErrorManager {
+        jpeg_error_mgr manager;
+        std::jmp_buf jump;
+    };
+
+    void jpeg_error_exit(j_common_ptr cinfo) {
+        std::longjmp(reinterpret_cast<JpegErrorManager*>(cinfo->err)->jump, 1);
+    }
+
+    void jpeg_silence(j_common_ptr) {}
+
+    // setjmp skips destructors, so everything between it and the end stays plain c
+    auto decode_jpeg(std::span<const u8> bytes, ImageHeader* header, u32 channel_count, u32 first_row, u32 row_count, u8* rows) -> bool {
+        jpeg_decompress_struct cinfo = {};
+        JpegErrorManager error = {};
+        cinfo.err = jpeg_std_error(&error.manager);
+        error.manager.error_exit = jpeg_error_exit;
+        error.manager.output_message = jpeg_silence;
+        if(setjmp(error.jump) != 0) {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo, const_cast<u8*>(bytes.data()), static_cast<unsigned long>(bytes.size()));
+        jpeg_read_header(&cinfo, TRUE);
+        // cmyk needs an inversion stb knows about and libjpeg doesnt
+        if(cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+            jpeg_destroy_decompress(&cinfo);
+            return false;
+        }
+
+        if(header != nullptr) {
+            *header = { .size_x = cinfo.image_width, .size_y = cinfo.image_height, .channel_count = cinfo.num_components == 3 ? 3u : 4u };
+            jpeg_destroy_decompress(&cinfo);
+            return true;
+        }
+
+        cinfo.out_color_space = channel_count == 4 ? JCS_EXT_RGBA : JCS_RGB;
+        jpeg_start_decompress(&cinfo);
+        // skipped rows still go through the entropy decoder but not through the idct and color conversion, which is
+        // where most of the time goes
+        if(first_row > 0) {
+            jpeg_skip_scanlines(&cinfo, first_row);
+        }
+
+        usize stride = static_cast<usize>(cinfo.output_width) * channel_count;
+        while(cinfo.output_scanline < first_row + row_count) {
+            JSAMPROW row = rows + (cinfo.output_scanline - first_row) * stride;
+            jpeg_read_scanlines(&cinfo, &row, 1);
+        }
+
+        // abort instead of finish, the rows below the strip dont need decoding
+        jpeg_abort_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+        return true;
+    }
+
+    struct LibjpegImageDecoder : ImageDecoder {
+        auto get_name() const -> const char* override {
+            return "libjpeg-turbo";
+        }
+
+        auto supports(EncodedImageFormat format) const -> bool override {
+            return format == EncodedImageFormat::JPEG;
+        }
+
+        auto read_header(std::span<const u8> bytes, ImageHeader& header) const -> bool override {
+            return decode_jpeg(bytes, &header, 0, 0, 0, nullptr);
+        }
+
+        auto supports_strips() const -> bool override {
+            return true;
+        }
+
+        void decode(std::span<const u8> bytes, const ImageHeader& header, u32 first_row, u32 row_count, std::span<u8> rows) const override {
+            if(!decode_jpeg(bytes, nullptr, header.channel_count, first_row, row_count, rows.data())) {
+                throw std::runtime_error("libjpeg-turbo couldn't decode image");
+            }
+        }
+    };
+#endif
+
+#if defined(IMAGE_DECODER_SPNG) && IMAGE_DECODER_SPNG
+    // deflate only runs front to back, so no strips
+    struct SpngImageDecoder : ImageDecoder {
+        auto get_name() const -> const char* override {
+            return "libspng";
+        }
+
+        auto supports(EncodedImageFormat format) const -> bool override {
+            return format == EncodedImageFormat::PNG;
+        }
+
+        auto read_header(std::span<const u8> bytes, ImageHeader& header) const -> bool override {
+            spng_ctx* context = spng_ctx_new(0);
+            spng_ihdr ihdr = {};
+            bool valid = context != nullptr && spng_set_png_buffer(context, bytes.data(), bytes.size()) == 0 && spng_get_ihdr(context, &ihdr) == 0;
+            spng_ctx_free(context);
+            if(!valid) {
+                return false;
+            }
+
+            header = { .size_x = ihdr.width, .size_y = ihdr.height, .channel_count = ihdr.color_type == SPNG_COLOR_TYPE_TRUECOLOR ? 3u : 4u };
+            return true;
+        }
+
+        void decode(std::span<const u8> bytes, const ImageHeader& header, u32, u32, std::span<u8> rows) const override {
+            spng_ctx* context = spng_ctx_new(0);
+            i32 format = header.channel_count == 4 ? SPNG_FMT_RGBA8 : SPNG_FMT_RGB8;
+            usize size = 0;
+            i32 result = context == nullptr ? SPNG_EMEM : spng_set_png_buffer(context, bytes.data(), bytes.size());
+            if(result == 0) {
+                result = spng_decoded_image_size(context, format, &size);
+            }
+            if(result == 0 && size != rows.size()) {
+                result = SPNG_EOVERFLOW;
+            }
+            if(result == 0) {
+                result = spng_decode_image(context, rows.data(), rows.size(), format, SPNG_DECODE_TRNS);
+            }
+            spng_ctx_free(context);
+            if(result != 0) {
+                throw std::runtime_error(std::string("libspng couldn't decode image: ") + spng_strerror(result));
+            }
+        }
+    };
+#endif
+
+    // shared with the helper tasks, which can start after the image is done and then must not touch anything else
+    struct StripJob {
+        u32 strip_count = 0;
+        std::atomic<u32> next_strip = 0;
+        u32 finished_strips = 0;
+        std::exception_ptr error = {};
+        std::mutex mutex = {};
+        std::condition_variable finished = {};
+    };
+
+    void decode_strips(StripJob& job, const ImageDecoder& decoder, std::span<const u8> bytes, const ImageHeader& header, u32 strip_rows, u8* pixels) {
+        usize stride = static_cast<usize>(header.size_x) * header.channel_count;
+        for(u32 strip = job.next_strip++; strip < job.strip_count; strip = job.next_strip++) {
+            u32 first_row = strip * strip_rows;
+            u32 row_count = std::min(strip_rows, header.size_y - first_row);
+            std::exception_ptr error = {};
+            try {
+                decoder.decode(bytes, header, first_row, row_count, { pixels + first_row * stride, row_count * stride });
+            } catch(...) {
+                error = std::current_exception();
+            }
+
+            const std::scoped_lock lock(job.mutex);
+            if(error && !job.error) {
+                job.error = error;
+            }
+            if(++job.finished_strips == job.strip_count) {
+                job.finished.notify_all();
+            }
+        }
+    }
+}
+
+auto detect_encoded_image_format(std::span<const u8> bytes) -> EncodedImageFormat {
+    static constexpr u8 PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+    if(bytes.size() >= sizeof(PNG_SIGNATURE) && std::memcmp(bytes.data(), PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0) {
+        return EncodedImageFormat::PNG;
+    }
+    if(bytes.size() >= 3 && bytes[0] == 0xff && bytes[1] == 0xd8 && bytes[2] == 0xff) {
+        return EncodedImageFormat::JPEG;
+    }
+    return EncodedImageFormat::UNKNOWN;
+}
+
+auto ImageDecoderRegistry::get() -> ImageDecoderRegistry& {
+    static ImageDecoderRegistry registry = {};
+    return registry;
+}
+
+ImageDecoderRegistry::ImageDecoderRegistry() {
+#if defined(IMAGE_DECODER_LIBJPEG) && IMAGE_DECODER_LIBJPEG
+    decoders.push_back(std::make_unique<LibjpegImageDecoder>());
+#endif
+#if defined(IMAGE_DECODER_SPNG) && IMAGE_DECODER_SPNG
+    decoders.push_back(std::make_unique<SpngImageDecoder>());
+#endif
+    decoders.push_back(std::make_unique<StbImageDecoder>());
+}
+
+void ImageDecoderRegistry::add(std::unique_ptr<ImageDecoder> decoder) {
+    const std::scoped_lock lock(mutex);
+    decoders.insert(decoders.begin(), std::move(decoder));
+}
+
+auto ImageDecoderRegistry::find(std::span<const u8> bytes, ImageHeader& header) const -> const ImageDecoder* {
+    EncodedImageFormat format = detect_encoded_image_format(bytes);
+    const std::scoped_lock lock(mutex);
+    for(const auto& decoder : decoders) {
+        if(decoder->supports(format) && decoder->read_header(bytes, header)) {
+            return decoder.get();
+        }
+    }
+    return nullptr;
+}
+
+auto ImageDecoderRegistry::get_decoders() const -> std::vector<const ImageDecoder*> {
+    const std::scoped_lock lock(mutex);
+    std::vector<const ImageDecoder*> result = {};
+    for(const auto& decoder : decoders) {
+        result.push_back(decoder.get());
+    }
+    return result;
+}
+
+auto DecodedImage::get_size() const -> usize {
+    return static_cast<usize>(size_x) * size_y * channel_count;
+}
+
+auto decode_image(std::span<const u8> bytes, const ImageDecodeInfo& info) -> DecodedImage {
+    ImageHeader header = {};
+    const ImageDecoder* decoder = info.decoder;
+    if(decoder != nullptr) {
+        if(!decoder->read_header(bytes, header)) {
+            throw std::runtime_error(std::string(decoder->get_name()) + " couldn't read the image header");
+        }
+    } else {
+        decoder = ImageDecoderRegistry::get().find(bytes, header);
+        if(decoder == nullptr) {
+            throw std::runtime_error("no decoder could read the image header");
+        }
+    }
+    if(info.channel_count == 4) {
+        header.channel_count = 4;
+    }
+
+    DecodedImage image = {
+        .size_x = header.size_x,
+        .size_y = header.size_y,
+        .channel_count = header.channel_count,
+        .decoder = decoder,
+    };
+    image.pixels = std::make_unique_for_overwrite<u8[]>(image.get_size());
+
+    // every strip pays for skipping the rows above it, so there is one strip per thread that is actually free to take
+    // one and none at all while the pool is busy with other images anyway
+    u32 idle_count = 0;
+    if(info.pool != nullptr && decoder->supports_strips()) {
+        usize running = info.pool->get_tasks_running() + info.pool->get_tasks_queued();
+        idle_count = static_cast<u32>(static_cast<usize>(info.pool->get_thread_count()) - std::min<usize>(running, info.pool->get_thread_count()));
+    }
+    u32 strip_count = std::min(header.size_y / std::max(info.strip_rows, 1u), idle_count + 1);
+    if(strip_count <= 1) {
+        decoder->decode(bytes, header, 0, header.size_y, { image.pixels.get(), image.get_size() });
+        return image;
+    }
+    u32 strip_rows = (header.size_y + strip_count - 1) / strip_count;
+    strip_count = (header.size_y + strip_rows - 1) / strip_rows;
+
+    auto job = std::make_shared<StripJob>();
+    job->strip_count = strip_count;
+    u32 helper_count = strip_count - 1;
+    u8* pixels = image.pixels.get();
+    for(u32 i = 0; i < helper_count; i++) {
+        info.pool->push_task([job, decoder, bytes, header, strip_rows, pixels] {
+            decode_strips(*job, *decoder, bytes, header, strip_rows, pixels);
+        });
+    }
+
+    // strips only ever wait on strips that are already running, so a pool thread calling this cant deadlock the pool
+    decode_strips(*job, *decoder, bytes, header, strip_rows, pixels);
+    std::unique_lock lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->finished_strips == job->strip_count; });
+    if(job->error) {
+        std::rethrow_exception(job->error);
+    }
+    return image;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <daxa/types.hpp>
+using namespace daxa::types;
+
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// what the first bytes of a file say it is, UNKNOWN still gets a try from the stb decoder
+enum class EncodedImageFormat : u8 {
+    UNKNOWN = 0,
+    PNG = 1,
+    JPEG = 2,
+};
+
+auto detect_encoded_image_format(std::span<const u8> bytes) -> EncodedImageFormat;
+
+struct ImageHeader {
+    u32 size_x = 0;
+    u32 size_y = 0;
+    // what decode writes per pixel, 3 or 4. rgb sources report 3, the caller can still ask for 4
+    u32 channel_count = 4;
+};
+
+// a backend for some of the encoded formats. decode writes rows first_row to first_row + row_count as tightly packed RGB8
+// or RGBA8 with header.channel_count channels, decoders without strips only ever get asked for the whole image.
+// decoders are shared between threads and must not keep state between calls
+struct ImageDecoder {
+    virtual ~ImageDecoder() = default;
+
+    virtual auto get_name() const -> const char* = 0;
+    virtual auto supports(EncodedImageFormat format) const -> bool = 0;
+    // false when the image turns out to be something this decoder cant handle, the next one gets a try then
+    virtual auto read_header(std::span<const u8> bytes, ImageHeader& header) const -> bool = 0;
+    virtual auto supports_strips() const -> bool { return false; }
+    virtual void decode(std::span<const u8> bytes, const ImageHeader& header, u32 first_row, u32 row_count, std::span<u8> rows) const = 0;
+};
+
+// every decoder the build came with, libjpeg-turbo and libspng when cmake found them and stb for whatever is left.
+// one per process like the sampler cache
+struct ImageDecoderRegistry {
+    static auto get() -> ImageDecoderRegistry&;
+
+    // goes in front of everything added before it, stb always stays last
+    void add(std::unique_ptr<ImageDecoder> decoder);
+    // first decoder for the signature that reads the header, nullptr when none does
+    auto find(std::span<const u8> bytes, ImageHeader& header) const -> const ImageDecoder*;
+    auto get_decoders() const -> std::vector<const ImageDecoder*>;
+
+private:
+    ImageDecoderRegistry();
+
+    std::vector<std::unique_ptr<ImageDecoder>> decoders = {};
+    mutable std::mutex mutex = {};
+};
+
+struct ImageDecodeInfo {
+    // 0 keeps rgb images at 3 channels and turns everything else into 4, 4 turns everything into 4
+    u32 channel_count = 0;
+    // nullptr lets the registry pick
+    const ImageDecoder* decoder = nullptr;
+    // images get split into strips for the idle threads of pool when the decoder supports strips, the calling thread
+    // decodes strips as well so this is fine to call from a task of the same pool. strip_rows is the least a strip gets
+    ThreadPool* pool = nullptr;
+    u32 strip_rows = 256;
+};
+
+struct DecodedImage {
+    u32 size_x = 0;
+    u32 size_y = 0;
+    u32 channel_count = 0;
+    std::unique_ptr<u8[]> pixels = {};
+    const ImageDecoder* decoder = nullptr;
+
+    auto get_size() const -> usize;
+};
+
+// throws when no decoder can make sense of bytes
+auto decode_image(std::span<const u8> bytes, const ImageDecodeInfo& info = {}) -> DecodedImage;
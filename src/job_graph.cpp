@@ -0,0 +1,154 @@
+#include "job_graph.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+void JobGraphStatistics::print() const {
+    std::cout << job_count << " jobs in " << wall_time_ms << " ms, " << work_time_ms << " ms of work (" << work_time_ms / std::max(wall_time_ms, 1e-6) << " threads busy on average), critical path "
+              << critical_path_ms << " ms:";
+    for(usize i = 0; i < critical_path.size(); i++) {
+        std::cout << (i == 0 ? " " : " -> ") << critical_path[i];
+    }
+    std::cout << std::endl;
+}
+
+auto JobGraph::add(std::string name, std::function<void()> job, TaskLane lane) -> JobId {
+    jobs.push_back(std::make_unique<Job>());
+    jobs.back()->name = std::move(name);
+    jobs.back()->function = std::move(job);
+    jobs.back()->lane = lane;
+    return static_cast<JobId>(jobs.size() - 1);
+}
+
+void JobGraph::depend(JobId job, JobId dependency) {
+    if(job >= jobs.size() || dependency >= jobs.size()) {
+        throw std::runtime_error("job graph dependency on a job that doesnt exist");
+    }
+    jobs[job]->dependencies.push_back(dependency);
+    jobs[dependency]->successors.push_back(job);
+}
+
+void JobGraph::depend(JobId job, std::span<const JobId> dependencies) {
+    for(JobId dependency : dependencies) {
+        depend(job, dependency);
+    }
+}
+
+void JobGraph::run(ThreadPool& pool) {
+    // kahn, whatever is left over once nothing has zero dependencies anymore sits on a cycle
+    order.clear();
+    std::vector<u32> dependency_counts(jobs.size(), 0);
+    for(JobId job = 0; job < jobs.size(); job++) {
+        dependency_counts[job] = static_cast<u32>(jobs[job]->dependencies.size());
+        if(dependency_counts[job] == 0) {
+            order.push_back(job);
+        }
+    }
+    for(usize i = 0; i < order.size(); i++) {
+        for(JobId successor : jobs[order[i]]->successors) {
+            if(--dependency_counts[successor] == 0) {
+                order.push_back(successor);
+            }
+        }
+    }
+    if(order.size() != jobs.size()) {
+        throw std::runtime_error("job graph has a cycle");
+    }
+
+    for(const auto& job : jobs) {
+        job->pending = static_cast<u32>(job->dependencies.size());
+    }
+
+    start = std::chrono::steady_clock::now();
+    remaining.add(jobs.size());
+    for(JobId job = 0; job < jobs.size(); job++) {
+        if(jobs[job]->dependencies.empty()) {
+            launch(pool, job);
+        }
+    }
+    pool.wait_for(remaining);
+    wall_time_ms = get_elapsed_ms();
+
+    if(exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobGraph::launch(ThreadPool& pool, JobId job) {
+    pool.push_task_to(jobs[job]->lane, [this, &pool, job] {
+        execute(pool, job);
+    });
+}
+
+void JobGraph::execute(ThreadPool& pool, JobId job_id) {
+    Job& job = *jobs[job_id];
+    job.start_ms = get_elapsed_ms();
+    if(!failed) {
+        try {
+            job.function();
+        } catch(...) {
+            const std::scoped_lock lock(exception_mutex);
+            if(!exception) {
+                exception = std::current_exception();
+            }
+            failed = true;
+        }
+    }
+    job.end_ms = get_elapsed_ms();
+
+    // successors go out before this job counts down, remaining cant reach zero while there is still something to launch
+    for(JobId successor : job.successors) {
+        if(--jobs[successor]->pending == 0) {
+            launch(pool, successor);
+        }
+    }
+    pool.count_down(remaining);
+}
+
+auto JobGraph::get_elapsed_ms() const -> f64 {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+auto JobGraph::get_start_ms(JobId job) const -> f64 {
+    return jobs[job]->start_ms;
+}
+
+auto JobGraph::get_end_ms(JobId job) const -> f64 {
+    return jobs[job]->end_ms;
+}
+
+auto JobGraph::get_statistics() const -> JobGraphStatistics {
+    JobGraphStatistics statistics = {
+        .job_count = static_cast<u32>(jobs.size()),
+        .wall_time_ms = wall_time_ms,
+    };
+
+    // longest path through the measured durations, order has every job behind its dependencies
+    std::vector<f64> path_ms(jobs.size(), 0.0);
+    std::vector<JobId> previous(jobs.size(), static_cast<JobId>(jobs.size()));
+    JobId last = 0;
+    for(JobId job : order) {
+        f64 duration = jobs[job]->end_ms - jobs[job]->start_ms;
+        statistics.work_time_ms += duration;
+        for(JobId dependency : jobs[job]->dependencies) {
+            if(path_ms[dependency] > path_ms[job]) {
+                path_ms[job] = path_ms[dependency];
+                previous[job] = dependency;
+            }
+        }
+        path_ms[job] += duration;
+        if(path_ms[job] > path_ms[last]) {
+            last = job;
+        }
+    }
+
+    if(!jobs.empty()) {
+        statistics.critical_path_ms = path_ms[last];
+        for(JobId job = last; job < jobs.size(); job = previous[job]) {
+            statistics.critical_path.push_back(jobs[job]->name);
+        }
+        std::reverse(statistics.critical_path.begin(), statistics.critical_path.end());
+    }
+    return statistics;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <daxa/types.hpp>
+using namespace daxa::types;
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "threadpool.hpp"
+
+using JobId = u32;
+
+struct JobGraphStatistics {
+    u32 job_count = 0;
+    f64 wall_time_ms = 0.0;
+    // every job added up, over wall_time_ms it is how many threads were busy on average
+    f64 work_time_ms = 0.0;
+    // the longest chain of dependent jobs by how long they actually took, no amount of threads gets below this
+    f64 critical_path_ms = 0.0;
+    std::vector<std::string> critical_path = {};
+
+    void print() const;
+};
+
+// jobs with dependencies between them that run on a ThreadPool. a job gets pushed to the pool as soon as the last job it
+// depends on finished, the ones without dependencies right away. each job gets timed so the graph can tell where the
+// wall time went. a job that throws skips everything that hasnt started yet and run rethrows it once the rest is done
+struct JobGraph {
+    // lane is where the job gets pushed once it is ready, IO for the ones that mostly wait on the disk
+    auto add(std::string name, std::function<void()> job, TaskLane lane = TaskLane::NORMAL) -> JobId;
+    // job doesnt start before dependency finished
+    void depend(JobId job, JobId dependency);
+    void depend(JobId job, std::span<const JobId> dependencies);
+
+    // throws when the dependencies have a cycle. waits with pool.wait_for, so the calling thread runs jobs as well and
+    // this is fine to call from a task of the same pool. a graph only runs once
+    void run(ThreadPool& pool);
+
+    // ms since run started, for jobs that already finished
+    auto get_start_ms(JobId job) const -> f64;
+    auto get_end_ms(JobId job) const -> f64;
+    auto get_statistics() const -> JobGraphStatistics;
+
+private:
+    struct Job {
+        std::string name = {};
+        std::function<void()> function = {};
+        TaskLane lane = TaskLane::NORMAL;
+        std::vector<JobId> dependencies = {};
+        std::vector<JobId> successors = {};
+        std::atomic<u32> pending = 0;
+        f64 start_ms = 0.0;
+        f64 end_ms = 0.0;
+    };
+
+    void launch(ThreadPool& pool, JobId job);
+    void execute(ThreadPool& pool, JobId job);
+    auto get_elapsed_ms() const -> f64;
+
+    std::vector<std::unique_ptr<Job>> jobs = {};
+    // the order run checked the graph in, every job comes after everything it depends on
+    std::vector<JobId> order = {};
+    std::chrono::steady_clock::time_point start = {};
+    TaskCounter remaining = {};
+    std::atomic<bool> failed = false;
+    std::exception_ptr exception = nullptr;
+    std::mutex exception_mutex = {};
+    f64 wall_time_ms = 0.0;
+};
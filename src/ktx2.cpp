@@ -0,0 +1,357 @@
+#include "ktx2.hpp"
+#include "mip_generator.hpp"
+
+#include <stb_image.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr std::array<u8, 12> IDENTIFIER = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    constexpr usize STAGING_ALIGNMENT = 16;
+
+    struct Header {
+        std::array<u8, 12> identifier;
+        u32 vk_format;
+        u32 type_size;
+        u32 pixel_width;
+        u32 pixel_height;
+        u32 pixel_depth;
+        u32 layer_count;
+        u32 face_count;
+        u32 level_count;
+        u32 supercompression_scheme;
+        u32 dfd_byte_offset;
+        u32 dfd_byte_length;
+        u32 kvd_byte_offset;
+        u32 kvd_byte_length;
+        u64 sgd_byte_offset;
+        u64 sgd_byte_length;
+    };
+    static_assert(sizeof(Header) == 80);
+
+    struct LevelIndex {
+        u64 byte_offset;
+        u64 byte_length;
+        u64 uncompressed_byte_length;
+    };
+
+    auto align_up(usize value, usize alignment) -> usize {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // texels per block edge and bytes per block, uncompressed formats are 1x1 blocks
+    struct FormatLayout {
+        u32 block_extent;
+        u32 block_size;
+    };
+
+    // the formats the loader can upload as they are, anything else gets rejected before a level is touched
+    auto get_format_layout(u32 vk_format) -> std::optional<FormatLayout> {
+        switch(static_cast<daxa::Format>(vk_format)) {
+            case daxa::Format::R8_UNORM: return FormatLayout{ 1, 1 };
+            case daxa::Format::R8G8_UNORM: return FormatLayout{ 1, 2 };
+            case daxa::Format::R8G8B8A8_UNORM:
+            case daxa::Format::R8G8B8A8_SRGB: return FormatLayout{ 1, 4 };
+            case daxa::Format::R16G16B16A16_SFLOAT: return FormatLayout{ 1, 8 };
+            case daxa::Format::BC1_RGB_UNORM_BLOCK:
+            case daxa::Format::BC1_RGB_SRGB_BLOCK:
+            case daxa::Format::BC1_RGBA_UNORM_BLOCK:
+            case daxa::Format::BC1_RGBA_SRGB_BLOCK:
+            case daxa::Format::BC4_UNORM_BLOCK: return FormatLayout{ 4, 8 };
+            case daxa::Format::BC3_UNORM_BLOCK:
+            case daxa::Format::BC3_SRGB_BLOCK:
+            case daxa::Format::BC5_UNORM_BLOCK:
+            case daxa::Format::BC6H_UFLOAT_BLOCK:
+            case daxa::Format::BC7_UNORM_BLOCK:
+            case daxa::Format::BC7_SRGB_BLOCK: return FormatLayout{ 4, 16 };
+            default: return std::nullopt;
+        }
+    }
+
+    auto get_level_size(FormatLayout layout, u32 size_x, u32 size_y, u32 level) -> usize {
+        u32 level_x = std::max(1u, size_x >> level);
+        u32 level_y = std::max(1u, size_y >> level);
+        return static_cast<usize>((level_x + layout.block_extent - 1) / layout.block_extent) * ((level_y + layout.block_extent - 1) / layout.block_extent) * layout.block_size;
+    }
+
+    // one sample of the basic data format descriptor block
+    struct Sample {
+        u16 bit_offset;
+        u8 bit_length;
+        u8 channel;
+        u32 upper;
+    };
+
+    // the basic descriptor block for the formats write_ktx2 supports, readers like ktx validate check it against vkFormat
+    auto make_data_format_descriptor(daxa::Format format) -> std::vector<u8> {
+        constexpr u8 MODEL_RGBSDA = 1, MODEL_BC1A = 128, MODEL_BC4 = 131, MODEL_BC5 = 132, MODEL_BC7 = 134;
+        constexpr u8 LINEAR_QUALIFIER = 1 << 4;
+
+        u8 model = MODEL_RGBSDA;
+        bool srgb = false;
+        u8 block_dimension = 0;
+        u8 bytes_plane = 4;
+        std::vector<Sample> samples = {};
+        switch(format) {
+            case daxa::Format::R8G8B8A8_SRGB:
+                srgb = true;
+                [[fallthrough]];
+            case daxa::Format::R8G8B8A8_UNORM:
+                samples = { { 0, 7, 0, 255 }, { 8, 7, 1, 255 }, { 16, 7, 2, 255 }, { 24, 7, static_cast<u8>(15 | (srgb ? LINEAR_QUALIFIER : 0)), 255 } };
+                break;
+            case daxa::Format::BC1_RGB_SRGB_BLOCK:
+                srgb = true;
+                [[fallthrough]];
+            case daxa::Format::BC1_RGB_UNORM_BLOCK:
+                model = MODEL_BC1A;
+                block_dimension = 3;
+                bytes_plane = 8;
+                samples = { { 0, 63, 0, ~0u } };
+                break;
+            case daxa::Format::BC4_UNORM_BLOCK:
+                model = MODEL_BC4;
+                block_dimension = 3;
+                bytes_plane = 8;
+                samples = { { 0, 63, 0, ~0u } };
+                break;
+            case daxa::Format::BC5_UNORM_BLOCK:
+                model = MODEL_BC5;
+                block_dimension = 3;
+                bytes_plane = 16;
+                samples = { { 0, 63, 0, ~0u }, { 64, 63, 1, ~0u } };
+                break;
+            case daxa::Format::BC7_SRGB_BLOCK:
+                srgb = true;
+                [[fallthrough]];
+            case daxa::Format::BC7_UNORM_BLOCK:
+                model = MODEL_BC7;
+                block_dimension = 3;
+                bytes_plane = 16;
+                samples = { { 0, 127, 0, ~0u } };
+                break;
+            default:
+                throw std::runtime_error("no KTX2 data format descriptor for format " + std::to_string(static_cast<u32>(format)));
+        }
+
+        u32 block_size = 24 + 16 * static_cast<u32>(samples.size());
+        std::vector<u8> descriptor(4 + block_size, 0);
+        auto write_u32 = [&](usize offset, u32 value) { std::memcpy(&descriptor[offset], &value, sizeof(u32)); };
+
+        write_u32(0, static_cast<u32>(descriptor.size()));
+        // vendor khronos and descriptor type basic are both 0
+        write_u32(4, 0);
+        write_u32(8, 2 | (block_size << 16));
+        descriptor[12] = model;
+        descriptor[13] = 1; // bt709 primaries
+        descriptor[14] = srgb ? 2 : 1;
+        descriptor[15] = 0;
+        std::memset(&descriptor[16], block_dimension, 2);
+        descriptor[20] = bytes_plane;
+
+        for(usize i = 0; i < samples.size(); i++) {
+            usize offset = 28 + 16 * i;
+            std::memcpy(&descriptor[offset], &samples[i].bit_offset, sizeof(u16));
+            descriptor[offset + 2] = samples[i].bit_length;
+            descriptor[offset + 3] = samples[i].channel;
+            write_u32(offset + 8, 0);
+            write_u32(offset + 12, samples[i].upper);
+        }
+        return descriptor;
+    }
+}
+
+Ktx2File::Ktx2File(const std::filesystem::path& path) : file{std::make_unique<MappedFile>(path)} {
+    std::span<const u8> bytes = file->get_data();
+    if(!is_ktx2_data(bytes) || bytes.size() < sizeof(Header)) {
+        throw std::runtime_error("not a KTX2 file: " + path.string());
+    }
+
+    Header header = {};
+    std::memcpy(&header, bytes.data(), sizeof(Header));
+
+    if(header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1 || header.pixel_width == 0 || header.pixel_height == 0) {
+        throw std::runtime_error("only 2d KTX2 files without layers or faces are supported: " + path.string());
+    }
+    if(header.vk_format == 0) {
+        throw std::runtime_error("KTX2 files without a vkFormat (basis universal) aren't supported: " + path.string());
+    }
+    std::optional<FormatLayout> layout = get_format_layout(header.vk_format);
+    if(!layout) {
+        throw std::runtime_error("unsupported KTX2 vkFormat " + std::to_string(header.vk_format) + ": " + path.string());
+    }
+    if(header.supercompression_scheme > static_cast<u32>(Ktx2Supercompression::ZLIB) || header.supercompression_scheme == static_cast<u32>(Ktx2Supercompression::BASIS_LZ)) {
+        throw std::runtime_error("unsupported KTX2 supercompression scheme " + std::to_string(header.supercompression_scheme) + ": " + path.string());
+    }
+
+    format = static_cast<daxa::Format>(header.vk_format);
+    size_x = header.pixel_width;
+    size_y = header.pixel_height;
+    supercompression = static_cast<Ktx2Supercompression>(header.supercompression_scheme);
+    generate_mips = header.level_count == 0;
+
+    u32 level_count = std::max(1u, header.level_count);
+    if(level_count > get_mip_level_count(size_x, size_y)) {
+        throw std::runtime_error("KTX2 file has " + std::to_string(level_count) + " levels, more than a full chain: " + path.string());
+    }
+    if(sizeof(Header) + level_count * sizeof(LevelIndex) > bytes.size()) {
+        throw std::runtime_error("KTX2 level index is out of bounds: " + path.string());
+    }
+
+    for(u32 level = 0; level < level_count; level++) {
+        LevelIndex index = {};
+        std::memcpy(&index, bytes.data() + sizeof(Header) + level * sizeof(LevelIndex), sizeof(LevelIndex));
+        if(index.byte_offset > bytes.size() || index.byte_length > bytes.size() - index.byte_offset) {
+            throw std::runtime_error("KTX2 level " + std::to_string(level) + " is out of bounds: " + path.string());
+        }
+
+        // read_level and the staging copy trust these sizes, so they have to be exactly what the format and level size make
+        usize expected_size = get_level_size(*layout, size_x, size_y, level);
+        usize uncompressed_size = supercompression == Ktx2Supercompression::NONE ? index.byte_length : index.uncompressed_byte_length;
+        if(uncompressed_size != expected_size || (supercompression == Ktx2Supercompression::NONE && index.uncompressed_byte_length != index.byte_length)) {
+            throw std::runtime_error("KTX2 level " + std::to_string(level) + " has " + std::to_string(uncompressed_size) + " bytes instead of " + std::to_string(expected_size) + ": " + path.string());
+        }
+
+        levels.push_back(Ktx2Level {
+            .data = bytes.subspan(index.byte_offset, index.byte_length),
+            .uncompressed_size = uncompressed_size,
+        });
+    }
+}
+
+auto Ktx2File::get_staging_size() const -> usize {
+    usize size = 0;
+    for(const auto& level : levels) {
+        size += align_up(level.uncompressed_size, STAGING_ALIGNMENT);
+    }
+    return size;
+}
+
+auto Ktx2File::get_staging_offsets() const -> std::vector<usize> {
+    std::vector<usize> offsets = {};
+    usize offset = 0;
+    for(const auto& level : levels) {
+        offsets.push_back(offset);
+        offset += align_up(level.uncompressed_size, STAGING_ALIGNMENT);
+    }
+    return offsets;
+}
+
+void Ktx2File::read_level(u32 level, std::span<std::byte> destination) const {
+    const Ktx2Level& source = levels.at(level);
+    if(destination.size() < source.uncompressed_size) {
+        throw std::runtime_error("KTX2 level doesn't fit into its destination");
+    }
+
+    switch(supercompression) {
+        case Ktx2Supercompression::NONE: {
+            std::memcpy(destination.data(), source.data.data(), source.data.size());
+            break;
+        }
+        case Ktx2Supercompression::ZSTD: {
+            usize size = ZSTD_decompress(destination.data(), source.uncompressed_size, source.data.data(), source.data.size());
+            if(ZSTD_isError(size) || size != source.uncompressed_size) {
+                throw std::runtime_error("couldn't decompress zstd KTX2 level " + std::to_string(level));
+            }
+            break;
+        }
+        case Ktx2Supercompression::ZLIB: {
+            i32 size = stbi_zlib_decode_buffer(reinterpret_cast<char*>(destination.data()), static_cast<i32>(source.uncompressed_size), reinterpret_cast<const char*>(source.data.data()), static_cast<i32>(source.data.size()));
+            if(size < 0 || static_cast<usize>(size) != source.uncompressed_size) {
+                throw std::runtime_error("couldn't decompress zlib KTX2 level " + std::to_string(level));
+            }
+            break;
+        }
+        case Ktx2Supercompression::BASIS_LZ: {
+            throw std::runtime_error("BasisLZ KTX2 levels aren't supported");
+        }
+    }
+}
+
+auto is_ktx2_path(const std::filesystem::path& path) -> bool {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return extension == ".ktx2";
+}
+
+auto is_ktx2_data(std::span<const u8> bytes) -> bool {
+    return bytes.size() >= IDENTIFIER.size() && std::memcmp(bytes.data(), IDENTIFIER.data(), IDENTIFIER.size()) == 0;
+}
+
+void write_ktx2(const std::filesystem::path& path, const Ktx2WriteInfo& info) {
+    if(info.levels.empty()) {
+        throw std::runtime_error("KTX2 file needs at least one level: " + path.string());
+    }
+    if(info.supercompression == Ktx2Supercompression::BASIS_LZ || info.supercompression == Ktx2Supercompression::ZLIB) {
+        throw std::runtime_error("write_ktx2 only writes uncompressed or zstd levels: " + path.string());
+    }
+
+    std::vector<u8> descriptor = make_data_format_descriptor(info.format);
+    u32 level_count = static_cast<u32>(info.levels.size());
+
+    std::vector<std::vector<u8>> supercompressed(level_count);
+    if(info.supercompression == Ktx2Supercompression::ZSTD) {
+        for(u32 level = 0; level < level_count; level++) {
+            supercompressed[level].resize(ZSTD_compressBound(info.levels[level].size()));
+            usize size = ZSTD_compress(supercompressed[level].data(), supercompressed[level].size(), info.levels[level].data(), info.levels[level].size(), info.zstd_level);
+            if(ZSTD_isError(size)) {
+                throw std::runtime_error("couldn't zstd compress KTX2 level " + std::to_string(level));
+            }
+            supercompressed[level].resize(size);
+        }
+    }
+    auto get_level_data = [&](u32 level) -> std::span<const u8> {
+        return info.supercompression == Ktx2Supercompression::ZSTD ? std::span<const u8>{supercompressed[level]} : info.levels[level];
+    };
+
+    usize dfd_offset = sizeof(Header) + level_count * sizeof(LevelIndex);
+    // levels go smallest first like the spec asks for, aligned so the uncompressed ones can be copied from the mapping as they are
+    std::vector<LevelIndex> level_index(level_count);
+    usize offset = dfd_offset + descriptor.size();
+    for(u32 level = level_count; level-- > 0;) {
+        offset = info.supercompression == Ktx2Supercompression::NONE ? align_up(offset, STAGING_ALIGNMENT) : offset;
+        level_index[level] = { offset, get_level_data(level).size(), info.levels[level].size() };
+        offset += get_level_data(level).size();
+    }
+
+    Header header = {
+        .identifier = IDENTIFIER,
+        .vk_format = static_cast<u32>(info.format),
+        .type_size = 1,
+        .pixel_width = info.size_x,
+        .pixel_height = info.size_y,
+        .pixel_depth = 0,
+        .layer_count = 0,
+        .face_count = 1,
+        .level_count = level_count,
+        .supercompression_scheme = static_cast<u32>(info.supercompression),
+        .dfd_byte_offset = static_cast<u32>(dfd_offset),
+        .dfd_byte_length = static_cast<u32>(descriptor.size()),
+        .kvd_byte_offset = 0,
+        .kvd_byte_length = 0,
+        .sgd_byte_offset = 0,
+        .sgd_byte_length = 0,
+    };
+
+    std::vector<u8> contents(offset, 0);
+    std::memcpy(contents.data(), &header, sizeof(Header));
+    std::memcpy(contents.data() + sizeof(Header), level_index.data(), level_index.size() * sizeof(LevelIndex));
+    std::memcpy(contents.data() + dfd_offset, descriptor.data(), descriptor.size());
+    for(u32 level = 0; level < level_count; level++) {
+        std::span<const u8> data = get_level_data(level);
+        std::memcpy(contents.data() + level_index[level].byte_offset, data.data(), data.size());
+    }
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if(!stream) {
+        throw std::runtime_error("couldn't write KTX2 file: " + path.string());
+    }
+    stream.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size()));
+}
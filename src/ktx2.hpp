@@ -0,0 +1,61 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+enum class Ktx2Supercompression : u32 {
+    NONE = 0,
+    // needs a basis transcoder, not supported
+    BASIS_LZ = 1,
+    ZSTD = 2,
+    ZLIB = 3,
+};
+
+// one level as it sits in the file, data is still supercompressed when the file is
+struct Ktx2Level {
+    std::span<const u8> data = {};
+    usize uncompressed_size = 0;
+};
+
+// a mapped 2d KTX2 file without array layers or cube faces, the format comes straight from vkFormat which daxa::Format
+// shares its values with. throws std::runtime_error for anything it can't upload
+struct Ktx2File {
+    Ktx2File(const std::filesystem::path& path);
+
+    // every level padded to 16 bytes and packed back to back starting with level 0, what the staging copy needs
+    auto get_staging_size() const -> usize;
+    auto get_staging_offsets() const -> std::vector<usize>;
+    // writes level uncompressed into destination which has to hold uncompressed_size bytes
+    void read_level(u32 level, std::span<std::byte> destination) const;
+
+    std::unique_ptr<MappedFile> file = {};
+    daxa::Format format = daxa::Format::UNDEFINED;
+    u32 size_x = 0;
+    u32 size_y = 0;
+    Ktx2Supercompression supercompression = Ktx2Supercompression::NONE;
+    // level count 0 in the header, the file only has level 0 and the rest is up to the loader
+    bool generate_mips = false;
+    std::vector<Ktx2Level> levels = {};
+};
+
+struct Ktx2WriteInfo {
+    // R8G8B8A8 and the BC formats texture_compression emits, those are the ones a data format descriptor gets written for
+    daxa::Format format = daxa::Format::R8G8B8A8_SRGB;
+    u32 size_x = 0;
+    u32 size_y = 0;
+    // level 0 first
+    std::span<const std::span<const u8>> levels = {};
+    Ktx2Supercompression supercompression = Ktx2Supercompression::NONE;
+    i32 zstd_level = 9;
+};
+
+auto is_ktx2_path(const std::filesystem::path& path) -> bool;
+auto is_ktx2_data(std::span<const u8> bytes) -> bool;
+void write_ktx2(const std::filesystem::path& path, const Ktx2WriteInfo& info);
@@ -0,0 +1,74 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <stb_image.h>
+
+#include "../ktx2.hpp"
+#include "../mip_generator.hpp"
+#include "../texture_compression.hpp"
+
+// turns anything stb can decode into a KTX2 file with the whole mip chain, so loading it skips decoding and mip generation
+// usage: ktx2_export <input> <output.ktx2> [bc7|bc1|bc4|bc5|rgba8] [srgb|unorm] [zstd|none]
+auto main(i32 argc, char** argv) -> i32 {
+    if(argc < 3) {
+        std::cerr << "usage: ktx2_export <input> <output.ktx2> [bc7|bc1|bc4|bc5|rgba8] [srgb|unorm] [zstd|none]" << std::endl;
+        return 1;
+    }
+
+    std::string format_name = argc > 3 ? argv[3] : "bc7";
+    bool srgb = argc > 4 ? std::string(argv[4]) == "srgb" : true;
+    Ktx2Supercompression supercompression = (argc > 5 && std::string(argv[5]) == "none") ? Ktx2Supercompression::NONE : Ktx2Supercompression::ZSTD;
+
+    i32 width = 0, height = 0, channel_count = 0;
+    u8* data = stbi_load(argv[1], &width, &height, &channel_count, 4);
+    if(data == nullptr) {
+        std::cerr << "couldn't load " << argv[1] << std::endl;
+        return 1;
+    }
+    u32 size_x = static_cast<u32>(width);
+    u32 size_y = static_cast<u32>(height);
+    std::span<const u8> pixels = { data, static_cast<usize>(size_x) * size_y * 4 };
+
+    daxa::Format format = srgb ? daxa::Format::R8G8B8A8_SRGB : daxa::Format::R8G8B8A8_UNORM;
+    std::vector<u8> level_data = {};
+    std::vector<usize> offsets = {};
+    if(format_name == "rgba8") {
+        MipChain chain = generate_mip_chain(pixels, size_x, size_y, get_mip_level_count(size_x, size_y), { .srgb = srgb });
+        level_data = std::move(chain.data);
+        offsets = std::move(chain.offsets);
+    } else {
+        BlockFormat block_format = BlockFormat::BC7;
+        if(format_name == "bc1") { block_format = BlockFormat::BC1; }
+        else if(format_name == "bc4") { block_format = BlockFormat::BC4; }
+        else if(format_name == "bc5") { block_format = BlockFormat::BC5; }
+
+        CompressionStatistics statistics = {};
+        CompressedTexture compressed = compress_texture(pixels, size_x, size_y, block_format, srgb, std::thread::hardware_concurrency(), statistics);
+        statistics.print(argv[1]);
+        format = get_compressed_format(compressed.format, compressed.srgb);
+        level_data = std::move(compressed.data);
+        offsets = std::move(compressed.offsets);
+    }
+    stbi_image_free(data);
+
+    std::vector<std::span<const u8>> levels = {};
+    for(usize level = 0; level < offsets.size(); level++) {
+        usize end = level + 1 < offsets.size() ? offsets[level + 1] : level_data.size();
+        levels.push_back(std::span<const u8>{level_data}.subspan(offsets[level], end - offsets[level]));
+    }
+
+    write_ktx2(argv[2], {
+        .format = format,
+        .size_x = size_x,
+        .size_y = size_y,
+        .levels = levels,
+        .supercompression = supercompression,
+    });
+
+    std::cout << "wrote " << argv[2] << ": " << levels.size() << " levels, " << std::filesystem::file_size(argv[2]) << " bytes" << std::endl;
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "mapped_file.hpp"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        throw std::runtime_error("couldn't open file for mapping: " + path.string());
+    }
+
+    LARGE_INTEGER file_size = {};
+    GetFileSizeEx(file_handle, &file_size);
+    size = static_cast<usize>(file_size.QuadPart);
+    if(size == 0) {
+        return;
+    }
+
+    mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        file_handle = nullptr;
+        throw std::runtime_error("couldn't map file: " + path.string());
+    }
+
+    data = static_cast<const u8*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if(data == nullptr) {
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+        CloseHandle(file_handle);
+        file_handle = nullptr;
+        throw std::runtime_error("couldn't map file: " + path.string());
+    }
+#else
+    file_descriptor = open(path.c_str(), O_RDONLY);
+    if(file_descriptor < 0) {
+        throw std::runtime_error("couldn't open file for mapping: " + path.string());
+    }
+
+    struct stat file_stat = {};
+    fstat(file_descriptor, &file_stat);
+    size = static_cast<usize>(file_stat.st_size);
+    if(size == 0) {
+        return;
+    }
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    if(mapping == MAP_FAILED) {
+        close(file_descriptor);
+        file_descriptor = -1;
+        throw std::runtime_error("couldn't map file: " + path.string());
+    }
+
+    // the whole file is consumed front to back right after mapping it, advice values are not flags so they need
+    // a call each
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    madvise(mapping, size, MADV_WILLNEED);
+    data = static_cast<const u8*>(mapping);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+    if(data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if(mapping_handle != nullptr) {
+        CloseHandle(mapping_handle);
+    }
+    if(file_handle != nullptr) {
+        CloseHandle(file_handle);
+    }
+#else
+    if(data != nullptr) {
+        munmap(const_cast<u8*>(data), size);
+    }
+    if(file_descriptor >= 0) {
+        close(file_descriptor);
+    }
+#endif
+}
+
+auto MappedFile::get_data() const -> std::span<const u8> {
+    return std::span<const u8>{data, size};
+}
+
+void MappedFile::prefault() const {
+    // the smallest page size around, bigger pages just get touched a few times
+    constexpr usize PREFAULT_STRIDE = 4096;
+    const volatile u8* bytes = data;
+    u8 sum = 0;
+    for(usize offset = 0; offset < size; offset += PREFAULT_STRIDE) {
+        sum ^= bytes[offset];
+    }
+    static_cast<void>(sum);
+}
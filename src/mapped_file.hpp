@@ -0,0 +1,30 @@
+#pragma once
+
+#include <daxa/types.hpp>
+using namespace daxa::types;
+
+#include <filesystem>
+#include <span>
+
+struct MappedFile {
+    MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    auto get_data() const -> std::span<const u8>;
+    // reads a byte of every page, so the wait for the disk happens on the calling thread and not on whoever reads the
+    // data first
+    void prefault() const;
+
+    const u8* data = nullptr;
+    usize size = 0;
+
+#if defined(_WIN32)
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    i32 file_descriptor = -1;
+#endif
+};
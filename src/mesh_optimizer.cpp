@@ -0,0 +1,374 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+    constexpr u32 INVALID_INDEX = ~0u;
+
+    struct VertexHasher {
+        auto operator()(const Vertex& vertex) const -> usize {
+            // fnv-1a over the raw bytes, vertices only compare equal when they are bitwise identical
+            u64 hash = 14695981039346656037ull;
+            const u8* bytes = reinterpret_cast<const u8*>(&vertex);
+            for(usize i = 0; i < sizeof(Vertex); i++) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return static_cast<usize>(hash);
+        }
+    };
+
+    struct VertexEqual {
+        auto operator()(const Vertex& a, const Vertex& b) const -> bool {
+            return std::memcmp(&a, &b, sizeof(Vertex)) == 0;
+        }
+    };
+
+    struct Cluster {
+        u32 first_triangle = 0;
+        u32 triangle_count = 0;
+        f32 sort_key = 0.0f;
+    };
+
+    auto sub(f32vec3 a, f32vec3 b) -> f32vec3 {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    auto cross(f32vec3 a, f32vec3 b) -> f32vec3 {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    auto length(f32vec3 v) -> f32 {
+        return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    }
+}
+
+void VertexCacheStatistics::merge(const VertexCacheStatistics& other) {
+    triangle_count += other.triangle_count;
+    vertex_count += other.vertex_count;
+    cache_misses += other.cache_misses;
+}
+
+auto VertexCacheStatistics::get_acmr() const -> f32 {
+    return triangle_count > 0 ? static_cast<f32>(cache_misses) / static_cast<f32>(triangle_count) : 0.0f;
+}
+
+auto VertexCacheStatistics::get_atvr() const -> f32 {
+    return vertex_count > 0 ? static_cast<f32>(cache_misses) / static_cast<f32>(vertex_count) : 0.0f;
+}
+
+void MeshOptimizationStatistics::merge(const MeshOptimizationStatistics& other) {
+    before.merge(other.before);
+    after.merge(other.after);
+    duplicate_vertices += other.duplicate_vertices;
+    cluster_count += other.cluster_count;
+}
+
+void MeshOptimizationStatistics::print() const {
+    std::cout << "mesh optimization of " << before.triangle_count << " triangles"
+              << "\n  ACMR " << before.get_acmr() << " -> " << after.get_acmr()
+              << "\n  ATVR " << before.get_atvr() << " -> " << after.get_atvr()
+              << "\n  removed " << duplicate_vertices << " duplicate vertices, " << cluster_count << " overdraw clusters" << std::endl;
+}
+
+auto simulate_vertex_cache(std::span<const u32> indices, u32 vertex_count, u32 cache_size) -> VertexCacheStatistics {
+    VertexCacheStatistics statistics = {
+        .triangle_count = static_cast<u32>(indices.size() / 3),
+        .vertex_count = vertex_count,
+    };
+
+    // a vertex is in the fifo while less than cache_size other vertices have been pushed after it
+    std::vector<u32> timestamps(vertex_count, 0);
+    u32 time = cache_size + 1;
+    for(u32 index : indices) {
+        if(time - timestamps[index] > cache_size) {
+            timestamps[index] = time++;
+            statistics.cache_misses++;
+        }
+    }
+
+    return statistics;
+}
+
+auto remove_duplicate_vertices(std::span<const Vertex> vertices, std::span<u32> indices, std::vector<Vertex>& unique_vertices) -> u32 {
+    std::unordered_map<Vertex, u32, VertexHasher, VertexEqual> vertex_map = {};
+    vertex_map.reserve(vertices.size());
+    std::vector<u32> remap(vertices.size(), INVALID_INDEX);
+
+    unique_vertices.clear();
+    unique_vertices.reserve(vertices.size());
+
+    for(u32& index : indices) {
+        if(remap[index] == INVALID_INDEX) {
+            auto [iterator, inserted] = vertex_map.try_emplace(vertices[index], static_cast<u32>(unique_vertices.size()));
+            if(inserted) {
+                unique_vertices.push_back(vertices[index]);
+            }
+            remap[index] = iterator->second;
+        }
+        index = remap[index];
+    }
+
+    return static_cast<u32>(unique_vertices.size());
+}
+
+void optimize_vertex_cache(std::span<const u32> indices, u32 vertex_count, u32 cache_size, std::vector<u32>& optimized_indices, std::vector<u32>& cluster_offsets) {
+    u32 triangle_count = static_cast<u32>(indices.size() / 3);
+
+    // live triangle count and triangle adjacency of every vertex
+    std::vector<u32> live_triangles(vertex_count, 0);
+    for(u32 index : indices) {
+        live_triangles[index]++;
+    }
+
+    std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+    std::partial_sum(live_triangles.begin(), live_triangles.end(), adjacency_offsets.begin() + 1);
+
+    std::vector<u32> adjacency(indices.size());
+    {
+        std::vector<u32> fill = adjacency_offsets;
+        for(u32 triangle = 0; triangle < triangle_count; triangle++) {
+            for(u32 corner = 0; corner < 3; corner++) {
+                adjacency[fill[indices[triangle * 3 + corner]]++] = triangle;
+            }
+        }
+    }
+
+    std::vector<u32> cache_timestamps(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<u32> dead_end_stack = {};
+    dead_end_stack.reserve(indices.size());
+    std::vector<u32> candidates = {};
+
+    u32 time = cache_size + 1;
+    u32 input_cursor = 0;
+
+    auto skip_dead_end = [&]() -> u32 {
+        while(!dead_end_stack.empty()) {
+            u32 vertex = dead_end_stack.back();
+            dead_end_stack.pop_back();
+            if(live_triangles[vertex] > 0) {
+                return vertex;
+            }
+        }
+        while(input_cursor < vertex_count) {
+            if(live_triangles[input_cursor] > 0) {
+                return input_cursor;
+            }
+            input_cursor++;
+        }
+        return INVALID_INDEX;
+    };
+
+    optimized_indices.clear();
+    optimized_indices.reserve(triangle_count * 3);
+    cluster_offsets.clear();
+    cluster_offsets.push_back(0);
+
+    u32 fanning_vertex = skip_dead_end();
+    while(fanning_vertex != INVALID_INDEX) {
+        candidates.clear();
+
+        for(u32 a = adjacency_offsets[fanning_vertex]; a < adjacency_offsets[fanning_vertex + 1]; a++) {
+            u32 triangle = adjacency[a];
+            if(emitted[triangle]) {
+                continue;
+            }
+
+            for(u32 corner = 0; corner < 3; corner++) {
+                u32 vertex = indices[triangle * 3 + corner];
+                optimized_indices.push_back(vertex);
+                dead_end_stack.push_back(vertex);
+                candidates.push_back(vertex);
+                live_triangles[vertex]--;
+
+                if(time - cache_timestamps[vertex] > cache_size) {
+                    cache_timestamps[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // prefer the candidate that stays in the cache longest while still having triangles left
+        u32 next_vertex = INVALID_INDEX;
+        i32 best_priority = -1;
+        for(u32 vertex : candidates) {
+            if(live_triangles[vertex] == 0) {
+                continue;
+            }
+
+            i32 priority = 0;
+            if(time - cache_timestamps[vertex] + 2 * live_triangles[vertex] <= cache_size) {
+                priority = static_cast<i32>(time - cache_timestamps[vertex]);
+            }
+
+            if(priority > best_priority) {
+                best_priority = priority;
+                next_vertex = vertex;
+            }
+        }
+
+        if(next_vertex == INVALID_INDEX) {
+            next_vertex = skip_dead_end();
+            if(next_vertex != INVALID_INDEX) {
+                cluster_offsets.push_back(static_cast<u32>(optimized_indices.size() / 3));
+            }
+        }
+
+        fanning_vertex = next_vertex;
+    }
+}
+
+void optimize_overdraw(std::span<const Vertex> vertices, std::span<u32> indices, std::span<const u32> hard_cluster_offsets, u32 cache_size, f32 lambda, u32& cluster_count) {
+    u32 triangle_count = static_cast<u32>(indices.size() / 3);
+    if(triangle_count == 0) {
+        cluster_count = 0;
+        return;
+    }
+
+    // split hard clusters further wherever the cache is already warm enough that a restart costs little
+    std::vector<Cluster> clusters = {};
+    std::vector<u32> timestamps(vertices.size(), 0);
+    u32 time = cache_size + 1;
+
+    for(usize h = 0; h < hard_cluster_offsets.size(); h++) {
+        u32 begin = hard_cluster_offsets[h];
+        u32 end = h + 1 < hard_cluster_offsets.size() ? hard_cluster_offsets[h + 1] : triangle_count;
+
+        u32 hard_cluster_misses = 0;
+        time += cache_size + 1;
+        for(u32 index : indices.subspan(begin * 3, (end - begin) * 3)) {
+            if(time - timestamps[index] > cache_size) {
+                timestamps[index] = time++;
+                hard_cluster_misses++;
+            }
+        }
+        f32 threshold = static_cast<f32>(hard_cluster_misses) / static_cast<f32>(end - begin) * lambda;
+
+        u32 cluster_begin = begin;
+        u32 cluster_misses = 0;
+        time += cache_size + 1;
+
+        for(u32 triangle = begin; triangle < end; triangle++) {
+            for(u32 corner = 0; corner < 3; corner++) {
+                u32 vertex = indices[triangle * 3 + corner];
+                if(time - timestamps[vertex] > cache_size) {
+                    timestamps[vertex] = time++;
+                    cluster_misses++;
+                }
+            }
+
+            f32 cluster_acmr = static_cast<f32>(cluster_misses) / static_cast<f32>(triangle - cluster_begin + 1);
+            if(triangle + 1 < end && cluster_acmr <= threshold) {
+                clusters.push_back(Cluster { .first_triangle = cluster_begin, .triangle_count = triangle + 1 - cluster_begin });
+                cluster_begin = triangle + 1;
+                cluster_misses = 0;
+                time += cache_size + 1;
+            }
+        }
+
+        clusters.push_back(Cluster { .first_triangle = cluster_begin, .triangle_count = end - cluster_begin });
+    }
+
+    // area weighted centroid of the whole primitive and every cluster
+    f32vec3 mesh_centroid = { 0.0f, 0.0f, 0.0f };
+    f32 mesh_area = 0.0f;
+    std::vector<f32vec3> cluster_centroids(clusters.size());
+    std::vector<f32vec3> cluster_normals(clusters.size());
+
+    for(usize c = 0; c < clusters.size(); c++) {
+        f32vec3 centroid = { 0.0f, 0.0f, 0.0f };
+        f32vec3 normal = { 0.0f, 0.0f, 0.0f };
+        f32 area = 0.0f;
+
+        for(u32 triangle = clusters[c].first_triangle; triangle < clusters[c].first_triangle + clusters[c].triangle_count; triangle++) {
+            f32vec3 p0 = vertices[indices[triangle * 3 + 0]].position;
+            f32vec3 p1 = vertices[indices[triangle * 3 + 1]].position;
+            f32vec3 p2 = vertices[indices[triangle * 3 + 2]].position;
+
+            f32vec3 face_normal = cross(sub(p1, p0), sub(p2, p0));
+            f32 triangle_area = length(face_normal) * 0.5f;
+
+            centroid.x += (p0.x + p1.x + p2.x) / 3.0f * triangle_area;
+            centroid.y += (p0.y + p1.y + p2.y) / 3.0f * triangle_area;
+            centroid.z += (p0.z + p1.z + p2.z) / 3.0f * triangle_area;
+            normal = { normal.x + face_normal.x, normal.y + face_normal.y, normal.z + face_normal.z };
+            area += triangle_area;
+        }
+
+        mesh_centroid = { mesh_centroid.x + centroid.x, mesh_centroid.y + centroid.y, mesh_centroid.z + centroid.z };
+        mesh_area += area;
+
+        f32 inverse_area = area > 0.0f ? 1.0f / area : 0.0f;
+        f32 normal_length = length(normal);
+        f32 inverse_normal_length = normal_length > 0.0f ? 1.0f / normal_length : 0.0f;
+        cluster_centroids[c] = { centroid.x * inverse_area, centroid.y * inverse_area, centroid.z * inverse_area };
+        cluster_normals[c] = { normal.x * inverse_normal_length, normal.y * inverse_normal_length, normal.z * inverse_normal_length };
+    }
+
+    f32 inverse_mesh_area = mesh_area > 0.0f ? 1.0f / mesh_area : 0.0f;
+    mesh_centroid = { mesh_centroid.x * inverse_mesh_area, mesh_centroid.y * inverse_mesh_area, mesh_centroid.z * inverse_mesh_area };
+
+    // clusters facing away from the center are likely to occlude the rest, draw them first
+    for(usize c = 0; c < clusters.size(); c++) {
+        f32vec3 offset = sub(cluster_centroids[c], mesh_centroid);
+        clusters[c].sort_key = offset.x * cluster_normals[c].x + offset.y * cluster_normals[c].y + offset.z * cluster_normals[c].z;
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    std::vector<u32> sorted_indices = {};
+    sorted_indices.reserve(indices.size());
+    for(const auto& cluster : clusters) {
+        auto first = indices.begin() + cluster.first_triangle * 3;
+        sorted_indices.insert(sorted_indices.end(), first, first + cluster.triangle_count * 3);
+    }
+
+    std::copy(sorted_indices.begin(), sorted_indices.end(), indices.begin());
+    cluster_count = static_cast<u32>(clusters.size());
+}
+
+void optimize_vertex_fetch(std::span<const Vertex> vertices, std::span<u32> indices, std::vector<Vertex>& optimized_vertices) {
+    std::vector<u32> remap(vertices.size(), INVALID_INDEX);
+    optimized_vertices.clear();
+    optimized_vertices.reserve(vertices.size());
+
+    for(u32& index : indices) {
+        if(remap[index] == INVALID_INDEX) {
+            remap[index] = static_cast<u32>(optimized_vertices.size());
+            optimized_vertices.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+}
+
+auto optimize_mesh(std::span<const Vertex> vertices, std::span<const u32> indices, const MeshOptimizeInfo& info) -> OptimizedMesh {
+    OptimizedMesh result = {};
+    result.statistics.before = simulate_vertex_cache(indices, static_cast<u32>(vertices.size()), info.cache_size);
+
+    if(indices.size() % 3 != 0 || indices.empty()) {
+        result.vertices.assign(vertices.begin(), vertices.end());
+        result.indices.assign(indices.begin(), indices.end());
+        result.statistics.after = result.statistics.before;
+        return result;
+    }
+
+    std::vector<u32> deduplicated_indices(indices.begin(), indices.end());
+    std::vector<Vertex> unique_vertices = {};
+    u32 unique_vertex_count = remove_duplicate_vertices(vertices, deduplicated_indices, unique_vertices);
+    result.statistics.duplicate_vertices = static_cast<u32>(vertices.size()) - unique_vertex_count;
+
+    std::vector<u32> cluster_offsets = {};
+    optimize_vertex_cache(deduplicated_indices, unique_vertex_count, info.cache_size, result.indices, cluster_offsets);
+    optimize_overdraw(unique_vertices, result.indices, cluster_offsets, info.cache_size, info.overdraw_lambda, result.statistics.cluster_count);
+    optimize_vertex_fetch(unique_vertices, result.indices, result.vertices);
+
+    result.statistics.after = simulate_vertex_cache(result.indices, static_cast<u32>(result.vertices.size()), info.cache_size);
+    return result;
+}
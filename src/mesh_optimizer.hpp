@@ -0,0 +1,59 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include "common.inl"
+
+#include <span>
+#include <vector>
+
+struct MeshOptimizeInfo {
+    // post transform cache size that tipsify optimizes for and the simulator measures with
+    u32 cache_size = 16;
+    // clusters are split once their local ACMR drops below lambda times the ACMR of the whole primitive
+    f32 overdraw_lambda = 1.05f;
+};
+
+struct VertexCacheStatistics {
+    u32 triangle_count = 0;
+    u32 vertex_count = 0;
+    u32 cache_misses = 0;
+
+    void merge(const VertexCacheStatistics& other);
+    // average cache miss ratio, transformed vertices per triangle
+    auto get_acmr() const -> f32;
+    // average transform to vertex ratio, 1.0 means every vertex is transformed once
+    auto get_atvr() const -> f32;
+};
+
+struct MeshOptimizationStatistics {
+    VertexCacheStatistics before = {};
+    VertexCacheStatistics after = {};
+    u32 duplicate_vertices = 0;
+    u32 cluster_count = 0;
+
+    void merge(const MeshOptimizationStatistics& other);
+    void print() const;
+};
+
+struct OptimizedMesh {
+    std::vector<Vertex> vertices = {};
+    std::vector<u32> indices = {};
+    MeshOptimizationStatistics statistics = {};
+};
+
+// fifo cache simulation over a triangle list
+auto simulate_vertex_cache(std::span<const u32> indices, u32 vertex_count, u32 cache_size) -> VertexCacheStatistics;
+
+// merges bitwise identical vertices, returns the new vertex count and rewrites indices in place
+auto remove_duplicate_vertices(std::span<const Vertex> vertices, std::span<u32> indices, std::vector<Vertex>& unique_vertices) -> u32;
+// tipsify by Sander et al., writes the reordered triangles and the triangle offset of every cluster
+void optimize_vertex_cache(std::span<const u32> indices, u32 vertex_count, u32 cache_size, std::vector<u32>& optimized_indices, std::vector<u32>& cluster_offsets);
+// sorts the tipsify clusters by their occlusion potential so outward facing clusters are drawn first
+void optimize_overdraw(std::span<const Vertex> vertices, std::span<u32> indices, std::span<const u32> hard_cluster_offsets, u32 cache_size, f32 lambda, u32& cluster_count);
+// orders vertices by first use in the index buffer and drops unreferenced ones
+void optimize_vertex_fetch(std::span<const Vertex> vertices, std::span<u32> indices, std::vector<Vertex>& optimized_vertices);
+
+// runs all of the above on one primitive, indices are relative to the primitives first vertex
+auto optimize_mesh(std::span<const Vertex> vertices, std::span<const u32> indices, const MeshOptimizeInfo& info) -> OptimizedMesh;
@@ -0,0 +1,335 @@
+#include "mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    enum struct VertexKind : u8 {
+        MANIFOLD,
+        // on an open edge, may only collapse along that edge
+        BORDER,
+        // shares its position with another vertex or was asked to stay put
+        LOCKED,
+    };
+
+    struct Quadric {
+        f64 a00 = 0.0, a11 = 0.0, a22 = 0.0;
+        f64 a01 = 0.0, a02 = 0.0, a12 = 0.0;
+        f64 b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        f64 c = 0.0;
+        f64 weight = 0.0;
+
+        void add_plane(f64 nx, f64 ny, f64 nz, f64 d, f64 w) {
+            a00 += w * nx * nx; a11 += w * ny * ny; a22 += w * nz * nz;
+            a01 += w * nx * ny; a02 += w * nx * nz; a12 += w * ny * nz;
+            b0 += w * nx * d; b1 += w * ny * d; b2 += w * nz * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        void add(const Quadric& other) {
+            a00 += other.a00; a11 += other.a11; a22 += other.a22;
+            a01 += other.a01; a02 += other.a02; a12 += other.a12;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+        }
+
+        // weighted sum of squared distances to the planes
+        auto evaluate(const f32vec3& p) const -> f64 {
+            f64 x = p.x, y = p.y, z = p.z;
+            f64 result = a00 * x * x + a11 * y * y + a22 * z * z
+                + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2.0 * (b0 * x + b1 * y + b2 * z)
+                + c;
+            return std::max(result, 0.0);
+        }
+    };
+
+    struct Collapse {
+        u32 source;
+        u32 target;
+        f32 cost;
+    };
+
+    auto sub(f32vec3 a, f32vec3 b) -> f32vec3 {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    auto dot(f32vec3 a, f32vec3 b) -> f32 {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    auto cross(f32vec3 a, f32vec3 b) -> f32vec3 {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    auto edge_key(u32 a, u32 b) -> u64 {
+        return (static_cast<u64>(a) << 32) | b;
+    }
+
+    auto position_key(const f32vec3& position) -> u64 {
+        u32 bits[3] = {};
+        std::memcpy(bits, &position, sizeof(bits));
+        u64 hash = 14695981039346656037ull;
+        for(u32 value : bits) {
+            hash = (hash ^ value) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    auto is_degenerate(const u32* triangle) -> bool {
+        return triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2];
+    }
+}
+
+auto simplify_mesh(std::span<const Vertex> vertices, std::span<const u32> indices, u32 target_index_count, f32 target_error, const SimplifyInfo& info, f32& result_error) -> std::vector<u32> {
+    std::vector<u32> result(indices.begin(), indices.end());
+    result_error = 0.0f;
+
+    u32 vertex_count = static_cast<u32>(vertices.size());
+    if(result.size() <= target_index_count || vertex_count == 0) {
+        return result;
+    }
+
+    f32vec3 aabb_min = vertices[0].position;
+    f32vec3 aabb_max = aabb_min;
+    for(const auto& vertex : vertices) {
+        aabb_min = { std::min(aabb_min.x, vertex.position.x), std::min(aabb_min.y, vertex.position.y), std::min(aabb_min.z, vertex.position.z) };
+        aabb_max = { std::max(aabb_max.x, vertex.position.x), std::max(aabb_max.y, vertex.position.y), std::max(aabb_max.z, vertex.position.z) };
+    }
+    f32vec3 extent = sub(aabb_max, aabb_min);
+    f32 diagonal = std::sqrt(dot(extent, extent));
+    f32 normal_scale = info.normal_weight * diagonal;
+    f32 uv_scale = info.uv_weight * diagonal;
+
+    // vertices split on a seam share a position but not their attributes, moving one would tear the seam open
+    std::vector<VertexKind> kinds(vertex_count, VertexKind::MANIFOLD);
+    {
+        std::unordered_map<u64, u32> first_with_position = {};
+        first_with_position.reserve(vertex_count);
+        for(u32 v = 0; v < vertex_count; v++) {
+            auto [it, inserted] = first_with_position.try_emplace(position_key(vertices[v].position), v);
+            if(!inserted) {
+                kinds[v] = VertexKind::LOCKED;
+                kinds[it->second] = VertexKind::LOCKED;
+            }
+        }
+    }
+
+    std::unordered_set<u64> directed_edges = {};
+    directed_edges.reserve(result.size());
+    for(usize i = 0; i < result.size(); i += 3) {
+        for(u32 k = 0; k < 3; k++) {
+            directed_edges.insert(edge_key(result[i + k], result[i + (k + 1) % 3]));
+        }
+    }
+
+    // an edge without its reversed twin is on the border of the mesh
+    std::unordered_set<u64> border_edges = {};
+    std::vector<Quadric> quadrics(vertex_count);
+
+    for(usize i = 0; i < result.size(); i += 3) {
+        const u32* triangle = &result[i];
+        f32vec3 p0 = vertices[triangle[0]].position;
+        f32vec3 p1 = vertices[triangle[1]].position;
+        f32vec3 p2 = vertices[triangle[2]].position;
+
+        f32vec3 normal = cross(sub(p1, p0), sub(p2, p0));
+        f32 double_area = std::sqrt(dot(normal, normal));
+        if(double_area <= 0.0f) {
+            continue;
+        }
+        normal = { normal.x / double_area, normal.y / double_area, normal.z / double_area };
+
+        Quadric face = {};
+        face.add_plane(normal.x, normal.y, normal.z, -dot(normal, p0), double_area * 0.5);
+        for(u32 k = 0; k < 3; k++) {
+            quadrics[triangle[k]].add(face);
+        }
+
+        for(u32 k = 0; k < 3; k++) {
+            u32 a = triangle[k];
+            u32 b = triangle[(k + 1) % 3];
+            if(directed_edges.contains(edge_key(b, a))) {
+                continue;
+            }
+
+            border_edges.insert(edge_key(a, b));
+            if(kinds[a] == VertexKind::MANIFOLD) {
+                kinds[a] = info.lock_borders ? VertexKind::LOCKED : VertexKind::BORDER;
+            }
+            if(kinds[b] == VertexKind::MANIFOLD) {
+                kinds[b] = info.lock_borders ? VertexKind::LOCKED : VertexKind::BORDER;
+            }
+
+            // plane through the edge standing on the face keeps borders from shrinking inwards
+            f32vec3 edge = sub(vertices[b].position, vertices[a].position);
+            f32 edge_length_squared = dot(edge, edge);
+            f32vec3 border_normal = cross(edge, normal);
+            f32 border_normal_length = std::sqrt(dot(border_normal, border_normal));
+            if(border_normal_length <= 0.0f) {
+                continue;
+            }
+            border_normal = { border_normal.x / border_normal_length, border_normal.y / border_normal_length, border_normal.z / border_normal_length };
+
+            Quadric border = {};
+            border.add_plane(border_normal.x, border_normal.y, border_normal.z, -dot(border_normal, vertices[a].position), edge_length_squared * 10.0);
+            quadrics[a].add(border);
+            quadrics[b].add(border);
+        }
+    }
+
+    auto can_collapse = [&](u32 source, u32 target) -> bool {
+        switch(kinds[source]) {
+            case VertexKind::MANIFOLD: return true;
+            case VertexKind::BORDER: return border_edges.contains(edge_key(source, target)) || border_edges.contains(edge_key(target, source));
+            default: return false;
+        }
+    };
+
+    auto get_cost = [&](u32 source, u32 target) -> f32 {
+        const Vertex& s = vertices[source];
+        const Vertex& t = vertices[target];
+
+        Quadric quadric = quadrics[source];
+        quadric.add(quadrics[target]);
+        f64 distance_error = quadric.weight > 0.0 ? quadric.evaluate(t.position) / quadric.weight : 0.0;
+
+        f32vec3 normal_delta = sub(s.normal, t.normal);
+        f32 uv_delta_x = s.uv.x - t.uv.x;
+        f32 uv_delta_y = s.uv.y - t.uv.y;
+        f64 attribute_error = normal_scale * normal_scale * dot(normal_delta, normal_delta) + uv_scale * uv_scale * (uv_delta_x * uv_delta_x + uv_delta_y * uv_delta_y);
+
+        return static_cast<f32>(distance_error + attribute_error);
+    };
+
+    f32 max_cost = target_error * target_error;
+    f32 worst_cost = 0.0f;
+    u32 target_triangle_count = target_index_count / 3;
+
+    std::vector<u32> adjacency_offsets = {};
+    std::vector<u32> adjacency = {};
+    std::vector<Collapse> collapses = {};
+    std::vector<bool> touched(vertex_count);
+
+    while(result.size() / 3 > target_triangle_count) {
+        u32 triangle_count = static_cast<u32>(result.size() / 3);
+
+        adjacency_offsets.assign(vertex_count + 1, 0);
+        for(u32 index : result) {
+            adjacency_offsets[index + 1]++;
+        }
+        for(u32 v = 0; v < vertex_count; v++) {
+            adjacency_offsets[v + 1] += adjacency_offsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<u32> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for(u32 t = 0; t < triangle_count; t++) {
+                for(u32 k = 0; k < 3; k++) {
+                    adjacency[fill[result[t * 3 + k]]++] = t;
+                }
+            }
+        }
+
+        collapses.clear();
+        for(u32 t = 0; t < triangle_count; t++) {
+            for(u32 k = 0; k < 3; k++) {
+                u32 a = result[t * 3 + k];
+                u32 b = result[t * 3 + (k + 1) % 3];
+                if(can_collapse(a, b)) {
+                    collapses.push_back({ a, b, get_cost(a, b) });
+                }
+                if(can_collapse(b, a)) {
+                    collapses.push_back({ b, a, get_cost(b, a) });
+                }
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            if(a.cost != b.cost) { return a.cost < b.cost; }
+            if(a.source != b.source) { return a.source < b.source; }
+            return a.target < b.target;
+        });
+
+        // rejects collapses that would turn a remaining triangle around
+        auto flips = [&](u32 source, u32 target) -> bool {
+            for(u32 i = adjacency_offsets[source]; i < adjacency_offsets[source + 1]; i++) {
+                const u32* triangle = &result[adjacency[i] * 3];
+                if(is_degenerate(triangle) || triangle[0] == target || triangle[1] == target || triangle[2] == target) {
+                    continue;
+                }
+
+                f32vec3 p[3] = { vertices[triangle[0]].position, vertices[triangle[1]].position, vertices[triangle[2]].position };
+                f32vec3 before = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+                for(u32 k = 0; k < 3; k++) {
+                    if(triangle[k] == source) {
+                        p[k] = vertices[target].position;
+                    }
+                }
+                f32vec3 after = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+
+                if(dot(before, after) <= 0.25f * std::sqrt(dot(before, before) * dot(after, after))) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        std::fill(touched.begin(), touched.end(), false);
+        u32 remaining_triangles = triangle_count;
+        u32 applied = 0;
+
+        for(const Collapse& collapse : collapses) {
+            if(collapse.cost > max_cost || remaining_triangles <= target_triangle_count) {
+                break;
+            }
+            // every vertex moves at most once per pass so the quadrics and the flip test see up to date neighbourhoods
+            if(touched[collapse.source] || touched[collapse.target] || flips(collapse.source, collapse.target)) {
+                continue;
+            }
+
+            for(u32 i = adjacency_offsets[collapse.source]; i < adjacency_offsets[collapse.source + 1]; i++) {
+                u32* triangle = &result[adjacency[i] * 3];
+                if(is_degenerate(triangle)) {
+                    continue;
+                }
+                for(u32 k = 0; k < 3; k++) {
+                    if(triangle[k] == collapse.source) {
+                        triangle[k] = collapse.target;
+                    }
+                }
+                if(is_degenerate(triangle)) {
+                    remaining_triangles--;
+                }
+            }
+
+            quadrics[collapse.target].add(quadrics[collapse.source]);
+            touched[collapse.source] = true;
+            touched[collapse.target] = true;
+            worst_cost = std::max(worst_cost, collapse.cost);
+            applied++;
+        }
+
+        if(applied == 0) {
+            break;
+        }
+
+        usize write = 0;
+        for(usize read = 0; read < result.size(); read += 3) {
+            if(!is_degenerate(&result[read])) {
+                result[write++] = result[read];
+                result[write++] = result[read + 1];
+                result[write++] = result[read + 2];
+            }
+        }
+        result.resize(write);
+    }
+
+    result_error = std::sqrt(worst_cost);
+    return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include "common.inl"
+
+#include <span>
+#include <vector>
+
+struct SimplifyInfo {
+    // how far in model units a unit difference of the attribute counts, relative to the size of the mesh
+    f32 normal_weight = 0.01f;
+    f32 uv_weight = 0.01f;
+    // keep vertices on open edges in place instead of only sliding them along the border
+    bool lock_borders = false;
+};
+
+struct LodBuildInfo {
+    // including the full detail level
+    u32 max_lod_count = 6;
+    // every level aims for this fraction of the triangles of the previous one
+    f32 reduction = 0.5f;
+    u32 min_triangle_count = 32;
+    // largest error a level may introduce, relative to the diagonal of the primitive bounds
+    f32 max_error = 0.05f;
+    SimplifyInfo simplify_info = {};
+};
+
+// quadric error edge collapse that only ever moves vertices onto existing ones, so the result is a new index list for
+// the same vertices. vertices on uv or normal seams stay locked, error is the distance based error of the worst collapse
+// plus the attribute penalty, both in model units
+auto simplify_mesh(std::span<const Vertex> vertices, std::span<const u32> indices, u32 target_index_count, f32 target_error, const SimplifyInfo& info, f32& result_error) -> std::vector<u32>;
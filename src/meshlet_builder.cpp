@@ -0,0 +1,350 @@
+#include "meshlet_builder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+    constexpr u32 INVALID_INDEX = std::numeric_limits<u32>::max();
+
+    auto sub(f32vec3 a, f32vec3 b) -> f32vec3 {
+        return { a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    auto dot(f32vec3 a, f32vec3 b) -> f32 {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    auto cross(f32vec3 a, f32vec3 b) -> f32vec3 {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    auto normalize(f32vec3 v) -> f32vec3 {
+        f32 length = std::sqrt(dot(v, v));
+        if(length <= 1e-12f) {
+            return { 0.0f, 0.0f, 0.0f };
+        }
+        return { v.x / length, v.y / length, v.z / length };
+    }
+
+    auto pack_triangle(u32 a, u32 b, u32 c) -> u32 {
+        return a | (b << 8) | (c << 16);
+    }
+
+    auto unpack_triangle(u32 packed_triangle) -> std::array<u32, 3> {
+        return { packed_triangle & 0xff, (packed_triangle >> 8) & 0xff, (packed_triangle >> 16) & 0xff };
+    }
+
+    // smallest corner first so the same triangle compares equal no matter where the winding starts
+    auto canonical_triangle(u32 a, u32 b, u32 c) -> std::array<u32, 3> {
+        if(b < a && b < c) {
+            return { b, c, a };
+        }
+        if(c < a && c < b) {
+            return { c, a, b };
+        }
+        return { a, b, c };
+    }
+}
+
+void MeshletStatistics::merge(const MeshletStatistics& other) {
+    meshlet_count += other.meshlet_count;
+    triangle_count += other.triangle_count;
+    vertex_count += other.vertex_count;
+    unique_vertex_count += other.unique_vertex_count;
+}
+
+void MeshletStatistics::print() const {
+    f64 count = static_cast<f64>(std::max<u32>(meshlet_count, 1));
+    std::cout << "meshlets " << meshlet_count
+              << "\n  triangles per meshlet " << triangle_count / count
+              << "\n  vertices per meshlet " << vertex_count / count
+              << "\n  vertex duplication " << static_cast<f64>(vertex_count) / static_cast<f64>(std::max<u32>(unique_vertex_count, 1)) << std::endl;
+}
+
+auto build_meshlets(std::span<const Vertex> vertices, std::span<const u32> indices, const MeshletBuildInfo& info) -> MeshletData {
+    MeshletData data = {};
+    u32 vertex_count = static_cast<u32>(vertices.size());
+    u32 triangle_count = static_cast<u32>(indices.size() / 3);
+    u32 max_vertices = std::clamp(info.max_vertices, 3u, 256u);
+    u32 max_triangles = std::max(info.max_triangles, 1u);
+
+    if(triangle_count == 0) {
+        return data;
+    }
+
+    // vertex to triangle adjacency in compressed rows
+    std::vector<u32> adjacency_offsets(vertex_count + 1, 0);
+    for(u32 i = 0; i < triangle_count * 3; i++) {
+        adjacency_offsets[indices[i] + 1]++;
+    }
+    for(u32 v = 0; v < vertex_count; v++) {
+        adjacency_offsets[v + 1] += adjacency_offsets[v];
+    }
+
+    std::vector<u32> adjacency(triangle_count * 3);
+    {
+        std::vector<u32> fill = adjacency_offsets;
+        for(u32 t = 0; t < triangle_count; t++) {
+            for(u32 k = 0; k < 3; k++) {
+                adjacency[fill[indices[t * 3 + k]]++] = t;
+            }
+        }
+    }
+
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<u32> local_index(vertex_count, INVALID_INDEX);
+    std::vector<bool> referenced(vertex_count, false);
+    std::vector<u32> meshlet_vertices = {};
+    std::vector<u32> meshlet_triangles = {};
+    meshlet_vertices.reserve(max_vertices);
+    meshlet_triangles.reserve(max_triangles);
+
+    f32vec3 position_sum = { 0.0f, 0.0f, 0.0f };
+
+    auto get_centroid = [&](u32 triangle) -> f32vec3 {
+        const f32vec3& a = vertices[indices[triangle * 3 + 0]].position;
+        const f32vec3& b = vertices[indices[triangle * 3 + 1]].position;
+        const f32vec3& c = vertices[indices[triangle * 3 + 2]].position;
+        return { (a.x + b.x + c.x) / 3.0f, (a.y + b.y + c.y) / 3.0f, (a.z + b.z + c.z) / 3.0f };
+    };
+
+    auto get_new_vertex_count = [&](u32 triangle) -> u32 {
+        u32 a = indices[triangle * 3 + 0];
+        u32 b = indices[triangle * 3 + 1];
+        u32 c = indices[triangle * 3 + 2];
+        // degenerate triangles reference the same vertex more than once, dont count it twice
+        u32 count = local_index[a] == INVALID_INDEX ? 1 : 0;
+        count += (local_index[b] == INVALID_INDEX && b != a) ? 1 : 0;
+        count += (local_index[c] == INVALID_INDEX && c != a && c != b) ? 1 : 0;
+        return count;
+    };
+
+    auto flush = [&]() {
+        if(meshlet_triangles.empty()) {
+            return;
+        }
+
+        Meshlet meshlet = {
+            .vertex_offset = static_cast<u32>(data.vertices.size()),
+            .triangle_offset = static_cast<u32>(data.triangles.size()),
+            .vertex_count = static_cast<u32>(meshlet_vertices.size()),
+            .triangle_count = static_cast<u32>(meshlet_triangles.size()),
+            .primitive_index = 0,
+        };
+
+        data.vertices.insert(data.vertices.end(), meshlet_vertices.begin(), meshlet_vertices.end());
+        data.triangles.insert(data.triangles.end(), meshlet_triangles.begin(), meshlet_triangles.end());
+        data.meshlets.push_back(meshlet);
+        data.bounds.push_back(compute_meshlet_bounds(vertices, meshlet_vertices, meshlet_triangles));
+
+        data.statistics.triangle_count += meshlet.triangle_count;
+        data.statistics.vertex_count += meshlet.vertex_count;
+
+        for(u32 v : meshlet_vertices) {
+            local_index[v] = INVALID_INDEX;
+        }
+        meshlet_vertices.clear();
+        meshlet_triangles.clear();
+        position_sum = { 0.0f, 0.0f, 0.0f };
+    };
+
+    u32 seed = 0;
+    while(true) {
+        u32 next_triangle = INVALID_INDEX;
+
+        if(meshlet_triangles.empty()) {
+            while(seed < triangle_count && emitted[seed]) {
+                seed++;
+            }
+            if(seed == triangle_count) {
+                break;
+            }
+            next_triangle = seed;
+        } else {
+            // prefer the neighbour that adds the fewest vertices, then the one closest to the meshlet center so
+            // meshlets stay round instead of growing into strips, remaining ties go to the lowest triangle index
+            f32 inverse_count = 1.0f / static_cast<f32>(meshlet_vertices.size());
+            f32vec3 meshlet_center = { position_sum.x * inverse_count, position_sum.y * inverse_count, position_sum.z * inverse_count };
+            u32 best_score = INVALID_INDEX;
+            f32 best_distance = std::numeric_limits<f32>::max();
+            for(u32 v : meshlet_vertices) {
+                for(u32 i = adjacency_offsets[v]; i < adjacency_offsets[v + 1]; i++) {
+                    u32 triangle = adjacency[i];
+                    if(emitted[triangle]) {
+                        continue;
+                    }
+
+                    u32 score = get_new_vertex_count(triangle);
+                    if(meshlet_vertices.size() + score > max_vertices) {
+                        continue;
+                    }
+
+                    f32 distance = 0.0f;
+                    if(score > 0) {
+                        f32vec3 offset = sub(get_centroid(triangle), meshlet_center);
+                        distance = dot(offset, offset);
+                    }
+
+                    if(score < best_score || (score == best_score && (distance < best_distance || (distance == best_distance && triangle < next_triangle)))) {
+                        best_score = score;
+                        best_distance = distance;
+                        next_triangle = triangle;
+                    }
+                }
+            }
+
+            // nothing connected fits anymore, start over from the next unused triangle
+            if(next_triangle == INVALID_INDEX) {
+                flush();
+                continue;
+            }
+        }
+
+        std::array<u32, 3> corners = {};
+        for(u32 k = 0; k < 3; k++) {
+            u32 v = indices[next_triangle * 3 + k];
+            if(local_index[v] == INVALID_INDEX) {
+                local_index[v] = static_cast<u32>(meshlet_vertices.size());
+                meshlet_vertices.push_back(v);
+                position_sum = { position_sum.x + vertices[v].position.x, position_sum.y + vertices[v].position.y, position_sum.z + vertices[v].position.z };
+                if(!referenced[v]) {
+                    referenced[v] = true;
+                    data.statistics.unique_vertex_count++;
+                }
+            }
+            corners[k] = local_index[v];
+        }
+
+        meshlet_triangles.push_back(pack_triangle(corners[0], corners[1], corners[2]));
+        emitted[next_triangle] = true;
+
+        // once the vertices are full the search above only accepts triangles closing over existing vertices
+        if(meshlet_triangles.size() == max_triangles) {
+            flush();
+        }
+    }
+
+    flush();
+    data.statistics.meshlet_count = static_cast<u32>(data.meshlets.size());
+    return data;
+}
+
+auto compute_meshlet_bounds(std::span<const Vertex> vertices, std::span<const u32> meshlet_vertices, std::span<const u32> meshlet_triangles) -> MeshletBounds {
+    MeshletBounds bounds = {};
+    bounds.cone_cutoff = 1.0f;
+
+    if(meshlet_vertices.empty()) {
+        return bounds;
+    }
+
+    // sphere around the center of the aabb, not minimal but cheap and stable
+    f32vec3 aabb_min = vertices[meshlet_vertices[0]].position;
+    f32vec3 aabb_max = aabb_min;
+    for(u32 v : meshlet_vertices) {
+        const f32vec3& position = vertices[v].position;
+        aabb_min = { std::min(aabb_min.x, position.x), std::min(aabb_min.y, position.y), std::min(aabb_min.z, position.z) };
+        aabb_max = { std::max(aabb_max.x, position.x), std::max(aabb_max.y, position.y), std::max(aabb_max.z, position.z) };
+    }
+
+    f32vec3 center = { (aabb_min.x + aabb_max.x) * 0.5f, (aabb_min.y + aabb_max.y) * 0.5f, (aabb_min.z + aabb_max.z) * 0.5f };
+    f32 radius_squared = 0.0f;
+    for(u32 v : meshlet_vertices) {
+        f32vec3 offset = sub(vertices[v].position, center);
+        radius_squared = std::max(radius_squared, dot(offset, offset));
+    }
+
+    bounds.center = center;
+    bounds.radius = std::sqrt(radius_squared);
+    bounds.cone_apex = center;
+
+    // normal cone from the face normals, degenerate triangles dont contribute
+    std::vector<f32vec3> normals = {};
+    std::vector<f32vec3> corners = {};
+    normals.reserve(meshlet_triangles.size());
+    corners.reserve(meshlet_triangles.size());
+
+    f32vec3 normal_sum = { 0.0f, 0.0f, 0.0f };
+    for(u32 packed_triangle : meshlet_triangles) {
+        std::array<u32, 3> triangle = unpack_triangle(packed_triangle);
+        const f32vec3& a = vertices[meshlet_vertices[triangle[0]]].position;
+        const f32vec3& b = vertices[meshlet_vertices[triangle[1]]].position;
+        const f32vec3& c = vertices[meshlet_vertices[triangle[2]]].position;
+
+        f32vec3 normal = normalize(cross(sub(b, a), sub(c, a)));
+        if(dot(normal, normal) == 0.0f) {
+            continue;
+        }
+
+        normals.push_back(normal);
+        corners.push_back(a);
+        normal_sum = { normal_sum.x + normal.x, normal_sum.y + normal.y, normal_sum.z + normal.z };
+    }
+
+    f32vec3 axis = normalize(normal_sum);
+    if(normals.empty() || dot(axis, axis) == 0.0f) {
+        return bounds;
+    }
+
+    f32 min_dot = 1.0f;
+    for(const f32vec3& normal : normals) {
+        min_dot = std::min(min_dot, dot(normal, axis));
+    }
+
+    bounds.cone_axis = axis;
+
+    // the normals spread over (almost) a hemisphere, the apex would end up too far away to ever cull anything
+    if(min_dot <= 0.1f) {
+        return bounds;
+    }
+
+    // move the apex back along the axis until it lies behind every triangle plane
+    f32 max_t = 0.0f;
+    for(usize i = 0; i < normals.size(); i++) {
+        f32 distance = dot(sub(center, corners[i]), normals[i]);
+        f32 denominator = dot(axis, normals[i]);
+        max_t = std::max(max_t, distance / denominator);
+    }
+
+    bounds.cone_apex = { center.x - axis.x * max_t, center.y - axis.y * max_t, center.z - axis.z * max_t };
+    // sine of the cone half angle, the view vector has to be within 90 degrees minus that of the axis
+    bounds.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+    return bounds;
+}
+
+auto validate_meshlets(std::span<const u32> indices, const MeshletData& data, const MeshletBuildInfo& info) -> bool {
+    std::vector<std::array<u32, 3>> expected = {};
+    expected.reserve(indices.size() / 3);
+    for(usize i = 0; i + 2 < indices.size(); i += 3) {
+        expected.push_back(canonical_triangle(indices[i], indices[i + 1], indices[i + 2]));
+    }
+
+    std::vector<std::array<u32, 3>> found = {};
+    found.reserve(expected.size());
+    for(const auto& meshlet : data.meshlets) {
+        if(meshlet.vertex_count > info.max_vertices || meshlet.triangle_count > info.max_triangles) {
+            return false;
+        }
+        if(meshlet.vertex_offset + meshlet.vertex_count > data.vertices.size() || meshlet.triangle_offset + meshlet.triangle_count > data.triangles.size()) {
+            return false;
+        }
+
+        for(u32 t = 0; t < meshlet.triangle_count; t++) {
+            std::array<u32, 3> triangle = unpack_triangle(data.triangles[meshlet.triangle_offset + t]);
+            for(u32 k = 0; k < 3; k++) {
+                if(triangle[k] >= meshlet.vertex_count) {
+                    return false;
+                }
+                triangle[k] = data.vertices[meshlet.vertex_offset + triangle[k]];
+            }
+            found.push_back(canonical_triangle(triangle[0], triangle[1], triangle[2]));
+        }
+    }
+
+    // the same multiset of triangles means nothing got lost or emitted twice
+    std::sort(expected.begin(), expected.end());
+    std::sort(found.begin(), found.end());
+    return expected == found;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include "common.inl"
+
+#include <span>
+#include <vector>
+
+struct MeshletBuildInfo {
+    // limits that fit a mesh shader workgroup, triangles have to stay below 256 vertices for the 8 bit local indices
+    u32 max_vertices = 64;
+    u32 max_triangles = 124;
+};
+
+struct MeshletStatistics {
+    u32 meshlet_count = 0;
+    u32 triangle_count = 0;
+    // every vertex is counted once per meshlet that references it
+    u32 vertex_count = 0;
+    u32 unique_vertex_count = 0;
+
+    void merge(const MeshletStatistics& other);
+    void print() const;
+};
+
+// meshlets of one primitive, vertex indices are relative to the primitives first vertex and offsets are relative to these vectors
+struct MeshletData {
+    std::vector<Meshlet> meshlets = {};
+    std::vector<MeshletBounds> bounds = {};
+    std::vector<u32> vertices = {};
+    std::vector<u32> triangles = {};
+    MeshletStatistics statistics = {};
+};
+
+// greedy clustering that grows each meshlet over triangles sharing its vertices, the result only depends on the input
+auto build_meshlets(std::span<const Vertex> vertices, std::span<const u32> indices, const MeshletBuildInfo& info) -> MeshletData;
+// bounding sphere and normal cone of one meshlet, meshlet_vertices index into vertices
+auto compute_meshlet_bounds(std::span<const Vertex> vertices, std::span<const u32> meshlet_vertices, std::span<const u32> meshlet_triangles) -> MeshletBounds;
+// checks that every triangle of indices ends up in exactly one meshlet and no meshlet breaks the limits
+auto validate_meshlets(std::span<const u32> indices, const MeshletData& data, const MeshletBuildInfo& info) -> bool;
@@ -0,0 +1,78 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include <stb_image.h>
+
+#include "../texture.hpp"
+#include "../mip_generator.hpp"
+
+// builds the mip chain of one image with every cpu filter and with the gpu blit chain, cpu numbers exclude the upload
+auto main(i32 argc, char** argv) -> i32 {
+    u32 iterations = argc > 2 ? static_cast<u32>(std::stoul(argv[2])) : 10;
+
+    u32 size_x = 2048;
+    u32 size_y = 2048;
+    std::vector<u8> pixels = {};
+    if(argc > 1) {
+        i32 width = 0, height = 0, channels = 0;
+        u8* data = stbi_load(argv[1], &width, &height, &channels, 4);
+        if(data == nullptr) {
+            std::cerr << "couldn't load " << argv[1] << std::endl;
+            return 1;
+        }
+        size_x = static_cast<u32>(width);
+        size_y = static_cast<u32>(height);
+        pixels.assign(data, data + static_cast<usize>(size_x) * size_y * 4);
+        stbi_image_free(data);
+    } else {
+        std::mt19937 random(1337);
+        pixels.resize(static_cast<usize>(size_x) * size_y * 4);
+        for(u8& value : pixels) {
+            value = static_cast<u8>(random());
+        }
+    }
+
+    u32 mip_level_count = get_mip_level_count(size_x, size_y);
+    std::cout << size_x << "x" << size_y << ", " << mip_level_count << " levels" << std::endl;
+
+    auto time_ms = [&](auto&& function) {
+        auto start = std::chrono::steady_clock::now();
+        for(u32 i = 0; i < iterations; i++) {
+            function();
+        }
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() / static_cast<f64>(iterations);
+    };
+
+    for(MipFilter filter : { MipFilter::BOX, MipFilter::KAISER }) {
+        for(bool allow_simd : { true, false }) {
+            f64 ms = time_ms([&] {
+                generate_mip_chain(pixels, size_x, size_y, mip_level_count, { .filter = filter, .srgb = true, .allow_simd = allow_simd });
+            });
+            std::cout << "cpu " << (filter == MipFilter::BOX ? "box" : "kaiser") << (allow_simd ? " simd" : " scalar") << ": " << ms << " ms" << std::endl;
+        }
+    }
+
+    daxa::Instance instance = daxa::create_instance({});
+    daxa::Device device = instance.create_device({ .name = "benchmark device" });
+
+    // wall time from recording until the image is ready, that is what a loading thread waits for
+    auto run_upload = [&](const char* label, Texture::MipGeneration mip_generation) {
+        f64 ms = time_ms([&] {
+            UploadManager uploader(device, { .staging_size = pixels.size() * 2, .name = "mip benchmark uploader" });
+            Texture texture(device, uploader, size_x, size_y, pixels.data(), Texture::Type::SRGB, mip_generation);
+            uploader.flush().wait();
+        });
+        device.collect_garbage();
+        std::cout << label << ": " << ms << " ms" << std::endl;
+    };
+
+    run_upload("gpu blit + upload", Texture::MipGeneration::GPU_BLIT);
+    run_upload("cpu box + upload", Texture::MipGeneration::CPU_BOX);
+    run_upload("cpu kaiser + upload", Texture::MipGeneration::CPU_KAISER);
+
+    return 0;
+}
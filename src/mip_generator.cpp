@@ -0,0 +1,334 @@
+#include "mip_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+#if defined(__AVX2__)
+#define MIP_GENERATOR_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_GENERATOR_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr u32 KAISER_TAP_COUNT = 6;
+    // linear values get quantized to 16 bit before the lookup, fine enough that even the darkest srgb steps round correctly
+    constexpr u32 SRGB_ENCODE_TABLE_SIZE = 1 << 16;
+
+    using KaiserWeights = std::array<f32, KAISER_TAP_COUNT>;
+
+    auto srgb_to_linear(f32 value) -> f32 {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    auto linear_to_srgb(f32 value) -> f32 {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    struct ColorTables {
+        std::array<f32, 256> to_linear = {};
+        std::vector<u8> to_srgb = {};
+
+        ColorTables() {
+            for(u32 i = 0; i < 256; i++) {
+                to_linear[i] = srgb_to_linear(static_cast<f32>(i) / 255.0f);
+            }
+
+            to_srgb.resize(SRGB_ENCODE_TABLE_SIZE);
+            for(u32 i = 0; i < SRGB_ENCODE_TABLE_SIZE; i++) {
+                f32 linear = static_cast<f32>(i) / static_cast<f32>(SRGB_ENCODE_TABLE_SIZE - 1);
+                to_srgb[i] = static_cast<u8>(std::clamp(linear_to_srgb(linear) * 255.0f + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    };
+
+    auto get_color_tables() -> const ColorTables& {
+        static const ColorTables tables = {};
+        return tables;
+    }
+
+    auto bessel_i0(f32 x) -> f32 {
+        // power series, converges fast enough for the alphas a kaiser window uses
+        f32 sum = 1.0f;
+        f32 term = 1.0f;
+        for(u32 k = 1; k < 32; k++) {
+            f32 half_x_over_k = x / (2.0f * static_cast<f32>(k));
+            term *= half_x_over_k * half_x_over_k;
+            sum += term;
+            if(term < sum * 1e-8f) {
+                break;
+            }
+        }
+        return sum;
+    }
+
+    // taps sit at source texel centers -2.5 to 2.5 texels away from the center of the destination texel
+    auto get_kaiser_weights(f32 alpha) -> KaiserWeights {
+        KaiserWeights weights = {};
+        f32 sum = 0.0f;
+        for(u32 k = 0; k < KAISER_TAP_COUNT; k++) {
+            f32 distance = static_cast<f32>(k) - 2.5f;
+            f32 x = distance * 0.5f;
+            f32 sinc = std::sin(std::numbers::pi_v<f32> * x) / (std::numbers::pi_v<f32> * x);
+            f32 window_position = distance / 3.0f;
+            f32 window = bessel_i0(alpha * std::sqrt(std::max(0.0f, 1.0f - window_position * window_position))) / bessel_i0(alpha);
+            weights[k] = sinc * window;
+            sum += weights[k];
+        }
+        for(f32& weight : weights) {
+            weight /= sum;
+        }
+        return weights;
+    }
+
+    auto get_pixel(const f32* level, u32 size_x, u32 x, u32 y) -> const f32* {
+        return level + (static_cast<usize>(y) * size_x + x) * 4;
+    }
+
+    // rgb input gets an opaque alpha
+    void decode_level(std::span<const u8> pixels, u32 channel_count, std::vector<f32>& level, bool srgb) {
+        const ColorTables& tables = get_color_tables();
+        level.resize(pixels.size() / channel_count * 4);
+        for(usize i = 0, j = 0; i < level.size(); i += 4, j += channel_count) {
+            for(usize c = 0; c < 3; c++) {
+                level[i + c] = srgb ? tables.to_linear[pixels[j + c]] : static_cast<f32>(pixels[j + c]) * (1.0f / 255.0f);
+            }
+            level[i + 3] = channel_count == 4 ? static_cast<f32>(pixels[j + 3]) * (1.0f / 255.0f) : 1.0f;
+        }
+    }
+
+    void encode_level(const std::vector<f32>& level, u8* pixels, bool srgb, bool allow_simd) {
+        const ColorTables& tables = get_color_tables();
+        f32 color_scale = srgb ? static_cast<f32>(SRGB_ENCODE_TABLE_SIZE - 1) : 255.0f;
+        usize i = 0;
+
+        // the simd part only clamps, scales and rounds, the srgb lookup stays scalar
+        std::array<i32, 8> quantized = {};
+#if defined(MIP_GENERATOR_AVX2)
+        if(allow_simd) {
+            const __m256 scale = _mm256_setr_ps(color_scale, color_scale, color_scale, 255.0f, color_scale, color_scale, color_scale, 255.0f);
+            for(; i + 8 <= level.size(); i += 8) {
+                __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(&level[i]), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+                __m256i rounded = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, scale), _mm256_set1_ps(0.5f)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(quantized.data()), rounded);
+                for(usize c = 0; c < 8; c++) {
+                    pixels[i + c] = (srgb && (c & 3) != 3) ? tables.to_srgb[static_cast<usize>(quantized[c])] : static_cast<u8>(quantized[c]);
+                }
+            }
+        }
+#elif defined(MIP_GENERATOR_SSE)
+        if(allow_simd) {
+            const __m128 scale = _mm_setr_ps(color_scale, color_scale, color_scale, 255.0f);
+            for(; i + 4 <= level.size(); i += 4) {
+                __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&level[i]), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), _mm_set1_ps(0.5f)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(quantized.data()), rounded);
+                for(usize c = 0; c < 3; c++) {
+                    pixels[i + c] = srgb ? tables.to_srgb[static_cast<usize>(quantized[c])] : static_cast<u8>(quantized[c]);
+                }
+                pixels[i + 3] = static_cast<u8>(quantized[3]);
+            }
+        }
+#endif
+
+        for(; i < level.size(); i++) {
+            bool is_alpha = (i & 3) == 3;
+            f32 value = std::clamp(level[i], 0.0f, 1.0f);
+            auto rounded = static_cast<usize>(value * (is_alpha ? 255.0f : color_scale) + 0.5f);
+            pixels[i] = (srgb && !is_alpha) ? tables.to_srgb[rounded] : static_cast<u8>(rounded);
+        }
+    }
+
+    void box_downsample(const std::vector<f32>& src, u32 src_x, u32 src_y, std::vector<f32>& dst, u32 dst_x, u32 dst_y, bool allow_simd) {
+        dst.resize(static_cast<usize>(dst_x) * dst_y * 4);
+
+        for(u32 y = 0; y < dst_y; y++) {
+            u32 y0 = std::min(2 * y, src_y - 1);
+            u32 y1 = std::min(2 * y + 1, src_y - 1);
+            const f32* row0 = get_pixel(src.data(), src_x, 0, y0);
+            const f32* row1 = get_pixel(src.data(), src_x, 0, y1);
+            f32* out = dst.data() + static_cast<usize>(y) * dst_x * 4;
+            u32 x = 0;
+
+#if defined(MIP_GENERATOR_AVX2)
+            if(allow_simd) {
+                // two destination texels per iteration, the lanes get regrouped so each half holds one 2x1 pair
+                const __m256 quarter = _mm256_set1_ps(0.25f);
+                for(; x + 2 <= dst_x && 2 * x + 3 < src_x; x += 2) {
+                    __m256 a0 = _mm256_loadu_ps(row0 + 8 * x);
+                    __m256 b0 = _mm256_loadu_ps(row0 + 8 * x + 8);
+                    __m256 a1 = _mm256_loadu_ps(row1 + 8 * x);
+                    __m256 b1 = _mm256_loadu_ps(row1 + 8 * x + 8);
+                    __m256 top = _mm256_add_ps(_mm256_permute2f128_ps(a0, b0, 0x20), _mm256_permute2f128_ps(a0, b0, 0x31));
+                    __m256 bottom = _mm256_add_ps(_mm256_permute2f128_ps(a1, b1, 0x20), _mm256_permute2f128_ps(a1, b1, 0x31));
+                    _mm256_storeu_ps(out + 4 * x, _mm256_mul_ps(_mm256_add_ps(top, bottom), quarter));
+                }
+            }
+#elif defined(MIP_GENERATOR_SSE)
+            if(allow_simd) {
+                const __m128 quarter = _mm_set1_ps(0.25f);
+                for(; x < dst_x && 2 * x + 1 < src_x; x++) {
+                    __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + 8 * x), _mm_loadu_ps(row0 + 8 * x + 4));
+                    __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + 8 * x), _mm_loadu_ps(row1 + 8 * x + 4));
+                    _mm_storeu_ps(out + 4 * x, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+                }
+            }
+#endif
+
+            for(; x < dst_x; x++) {
+                u32 x0 = std::min(2 * x, src_x - 1);
+                u32 x1 = std::min(2 * x + 1, src_x - 1);
+                for(u32 c = 0; c < 4; c++) {
+                    out[4 * x + c] = (row0[4 * x0 + c] + row0[4 * x1 + c] + row1[4 * x0 + c] + row1[4 * x1 + c]) * 0.25f;
+                }
+            }
+        }
+    }
+
+    // separable, horizontal into scratch first and then vertical into dst, edges are clamped
+    void kaiser_downsample(const std::vector<f32>& src, u32 src_x, u32 src_y, std::vector<f32>& scratch, std::vector<f32>& dst, u32 dst_x, u32 dst_y, const KaiserWeights& weights, bool allow_simd) {
+        scratch.resize(static_cast<usize>(dst_x) * src_y * 4);
+        dst.resize(static_cast<usize>(dst_x) * dst_y * 4);
+
+        auto clamp_tap = [](u32 center, u32 k, u32 size) -> u32 {
+            i32 index = static_cast<i32>(2 * center + k) - 2;
+            return static_cast<u32>(std::clamp(index, 0, static_cast<i32>(size) - 1));
+        };
+
+        for(u32 y = 0; y < src_y; y++) {
+            const f32* row = get_pixel(src.data(), src_x, 0, y);
+            f32* out = scratch.data() + static_cast<usize>(y) * dst_x * 4;
+            u32 x = 0;
+
+#if defined(MIP_GENERATOR_SSE) || defined(MIP_GENERATOR_AVX2)
+            if(allow_simd) {
+                // texels that need clamping go through the scalar loop below
+                u32 first_interior = 1;
+                u32 end_interior = src_x >= 4 ? (src_x - 4) / 2 + 1 : 0;
+                for(; x < std::min(first_interior, dst_x); x++) {
+                    for(u32 c = 0; c < 4; c++) {
+                        f32 sum = 0.0f;
+                        for(u32 k = 0; k < KAISER_TAP_COUNT; k++) {
+                            sum += weights[k] * row[4 * clamp_tap(x, k, src_x) + c];
+                        }
+                        out[4 * x + c] = sum;
+                    }
+                }
+                for(; x < std::min(end_interior, dst_x); x++) {
+                    const f32* taps = row + 4 * (2 * x - 2);
+                    __m128 sum = _mm_mul_ps(_mm_loadu_ps(taps), _mm_set1_ps(weights[0]));
+                    for(u32 k = 1; k < KAISER_TAP_COUNT; k++) {
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(taps + 4 * k), _mm_set1_ps(weights[k])));
+                    }
+                    _mm_storeu_ps(out + 4 * x, sum);
+                }
+            }
+#endif
+
+            for(; x < dst_x; x++) {
+                for(u32 c = 0; c < 4; c++) {
+                    f32 sum = 0.0f;
+                    for(u32 k = 0; k < KAISER_TAP_COUNT; k++) {
+                        sum += weights[k] * row[4 * clamp_tap(x, k, src_x) + c];
+                    }
+                    out[4 * x + c] = sum;
+                }
+            }
+        }
+
+        usize row_size = static_cast<usize>(dst_x) * 4;
+        for(u32 y = 0; y < dst_y; y++) {
+            std::array<const f32*, KAISER_TAP_COUNT> rows = {};
+            for(u32 k = 0; k < KAISER_TAP_COUNT; k++) {
+                rows[k] = scratch.data() + clamp_tap(y, k, src_y) * row_size;
+            }
+            f32* out = dst.data() + y * row_size;
+            usize i = 0;
+
+#if defined(MIP_GENERATOR_AVX2)
+            if(allow_simd) {
+                for(; i + 8 <= row_size; i += 8) {
+                    __m256 sum = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i), _mm256_set1_ps(weights[0]));
+                    for(u32 k = 1; k < KAISER_TAP_COUNT; k++) {
+                        sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(weights[k])));
+                    }
+                    _mm256_storeu_ps(out + i, sum);
+                }
+            }
+#elif defined(MIP_GENERATOR_SSE)
+            if(allow_simd) {
+                for(; i + 4 <= row_size; i += 4) {
+                    __m128 sum = _mm_mul_ps(_mm_loadu_ps(rows[0] + i), _mm_set1_ps(weights[0]));
+                    for(u32 k = 1; k < KAISER_TAP_COUNT; k++) {
+                        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(weights[k])));
+                    }
+                    _mm_storeu_ps(out + i, sum);
+                }
+            }
+#endif
+
+            for(; i < row_size; i++) {
+                f32 sum = 0.0f;
+                for(u32 k = 0; k < KAISER_TAP_COUNT; k++) {
+                    sum += weights[k] * rows[k][i];
+                }
+                out[i] = sum;
+            }
+        }
+    }
+}
+
+auto get_mip_level_count(u32 size_x, u32 size_y) -> u32 {
+    return static_cast<u32>(std::floor(std::log2(std::max({ size_x, size_y, 1u })))) + 1;
+}
+
+auto get_mip_chain_offsets(u32 size_x, u32 size_y, u32 mip_level_count, usize& total_size) -> std::vector<usize> {
+    std::vector<usize> offsets = {};
+    total_size = 0;
+    for(u32 level = 0, x = size_x, y = size_y; level < mip_level_count; level++, x = std::max(1u, x / 2), y = std::max(1u, y / 2)) {
+        offsets.push_back(total_size);
+        total_size += static_cast<usize>(x) * y * 4;
+    }
+    return offsets;
+}
+
+auto generate_mip_chain(std::span<const u8> pixels, u32 size_x, u32 size_y, u32 mip_level_count, const MipGenerateInfo& info) -> MipChain {
+    MipChain chain = {};
+    usize total_size = 0;
+    chain.offsets = get_mip_chain_offsets(size_x, size_y, mip_level_count, total_size);
+    chain.data.resize(total_size);
+    std::copy(pixels.begin(), pixels.begin() + static_cast<std::ptrdiff_t>(static_cast<usize>(size_x) * size_y * 4), chain.data.begin());
+
+    generate_mip_levels(pixels, 4, size_x, size_y, chain.data, chain.offsets, info);
+    return chain;
+}
+
+void generate_mip_levels(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, std::span<u8> destination, std::span<const usize> offsets, const MipGenerateInfo& info) {
+    KaiserWeights weights = get_kaiser_weights(info.kaiser_alpha);
+    std::vector<f32> current = {};
+    std::vector<f32> next = {};
+    std::vector<f32> scratch = {};
+    decode_level(pixels.subspan(0, static_cast<usize>(size_x) * size_y * channel_count), channel_count, current, info.srgb);
+
+    u32 current_x = size_x;
+    u32 current_y = size_y;
+    for(u32 level = 1; level < offsets.size(); level++) {
+        u32 next_x = std::max(1u, current_x / 2);
+        u32 next_y = std::max(1u, current_y / 2);
+
+        if(info.filter == MipFilter::KAISER) {
+            kaiser_downsample(current, current_x, current_y, scratch, next, next_x, next_y, weights, info.allow_simd);
+        } else {
+            box_downsample(current, current_x, current_y, next, next_x, next_y, info.allow_simd);
+        }
+
+        encode_level(next, destination.data() + offsets[level], info.srgb, info.allow_simd);
+
+        std::swap(current, next);
+        current_x = next_x;
+        current_y = next_y;
+    }
+}
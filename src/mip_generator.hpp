@@ -0,0 +1,38 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <span>
+#include <vector>
+
+enum class MipFilter : u8 {
+    // average of the 2x2 texels under the smaller texel, same footprint as a linear blit
+    BOX = 0,
+    // 6 tap windowed sinc per axis, keeps more detail in the smaller levels at the cost of some ringing
+    KAISER = 1,
+};
+
+struct MipGenerateInfo {
+    MipFilter filter = MipFilter::BOX;
+    // rgb gets filtered in linear space and converted back, alpha is always linear
+    bool srgb = false;
+    f32 kaiser_alpha = 4.0f;
+    // the scalar path is only there as a reference and for cpus without SSE
+    bool allow_simd = true;
+};
+
+// RGBA8 levels packed back to back starting with the full size one
+struct MipChain {
+    std::vector<u8> data = {};
+    std::vector<usize> offsets = {};
+};
+
+auto get_mip_level_count(u32 size_x, u32 size_y) -> u32;
+// where every level of a tightly packed RGBA8 chain starts, total_size is the size of the whole chain
+auto get_mip_chain_offsets(u32 size_x, u32 size_y, u32 mip_level_count, usize& total_size) -> std::vector<usize>;
+// filters every level from the previous one in f32 so rounding doesnt add up over the chain, pixels is tightly packed RGBA8
+auto generate_mip_chain(std::span<const u8> pixels, u32 size_x, u32 size_y, u32 mip_level_count, const MipGenerateInfo& info = {}) -> MipChain;
+// writes levels 1 and up of the chain into destination at offsets and leaves level 0 to the caller, pixels can be RGB8 or RGBA8.
+// destination is only written in order, so it can be mapped staging memory that is slow to read
+void generate_mip_levels(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, std::span<u8> destination, std::span<const usize> offsets, const MipGenerateInfo& info = {});
@@ -8,457 +8,1534 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <filesystem>
-
-#include <stb_image.h>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <unordered_map>
 
 #include "threadpool.hpp"
+#include "model_cache.hpp"
+#include "camera.hpp"
+#include "mapped_file.hpp"
+#include "resource_budget.hpp"
+
+namespace {
+    // chunks parallel_for checks for idle threads in between, it only splits off more work when a thread is idle so these
+    // can be small enough to balance out a single big primitive
+    constexpr usize VERTEX_GRAIN_SIZE = 1 << 12;
+    constexpr usize INDEX_GRAIN_SIZE = 1 << 14;
+
+    struct AccessorView {
+        const u8* data = nullptr;
+        usize stride = 0;
+        usize count = 0;
+        fastgltf::ComponentType component_type = fastgltf::ComponentType::Float;
+        bool normalized = false;
+    };
 
-Model::Model(daxa::Device _device, const std::string_view& file_path) : device{_device} {
-    std::filesystem::path path(file_path.data());
+    struct PrimitiveLayout {
+        AccessorView positions = {};
+        AccessorView normals = {};
+        AccessorView uvs = {};
+        AccessorView tangents = {};
+        AccessorView indices = {};
+        u32 first_vertex = 0;
+        u32 first_index = 0;
+    };
 
-    if(!std::filesystem::exists(path)) {
-        throw std::runtime_error("couldnt not find model: " + path.string());
+    auto get_component_size(fastgltf::ComponentType component_type) -> usize {
+        switch(component_type) {
+            case fastgltf::ComponentType::Byte:
+            case fastgltf::ComponentType::UnsignedByte: return 1;
+            case fastgltf::ComponentType::Short:
+            case fastgltf::ComponentType::UnsignedShort: return 2;
+            case fastgltf::ComponentType::UnsignedInt:
+            case fastgltf::ComponentType::Float: return 4;
+            default: return 0;
+        }
     }
 
-    std::unique_ptr<fastgltf::glTF> gltf;
-    fastgltf::GltfDataBuffer data_buffer;
-    std::unique_ptr<fastgltf::Asset> asset;
+    auto get_component_count(fastgltf::AccessorType type) -> usize {
+        switch(type) {
+            case fastgltf::AccessorType::Scalar: return 1;
+            case fastgltf::AccessorType::Vec2: return 2;
+            case fastgltf::AccessorType::Vec3: return 3;
+            case fastgltf::AccessorType::Vec4: return 4;
+            default: return 0;
+        }
+    }
 
-    {
+    // LoadExternalBuffers swaps the uris of the buffers for their bytes, so the files behind them come out of a second
+    // parse of only the buffer list. the cache has to know them to notice when one of them changes
+    auto get_external_buffer_paths(const std::filesystem::path& path) -> std::vector<std::filesystem::path> {
         fastgltf::Parser parser(fastgltf::Extensions::KHR_mesh_quantization);
+        fastgltf::GltfDataBuffer data_buffer;
+        if (!data_buffer.loadFromFile(path)) {
+            return {};
+        }
 
-        constexpr auto gltfOptions = fastgltf::Options::DontRequireValidAssetMember | fastgltf::Options::AllowDouble | fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
-        data_buffer.loadFromFile(path);
+        constexpr auto options = fastgltf::Options::DontRequireValidAssetMember | fastgltf::Options::AllowDouble;
+        std::unique_ptr<fastgltf::glTF> gltf = path.extension() == ".glb" ? parser.loadBinaryGLTF(&data_buffer, path.parent_path(), options)
+                                                                           : parser.loadGLTF(&data_buffer, path.parent_path(), options);
+        if (gltf == nullptr || gltf->parse(fastgltf::Category::Buffers) != fastgltf::Error::None) {
+            return {};
+        }
 
-        if (path.extension() == ".gltf") {
-            gltf = parser.loadGLTF(&data_buffer, path.parent_path(), gltfOptions);
-        } else if (path.extension() == ".glb") {
-            gltf = parser.loadBinaryGLTF(&data_buffer, path.parent_path(), gltfOptions);
+        std::unique_ptr<fastgltf::Asset> asset = gltf->getParsedAsset();
+        std::vector<std::filesystem::path> paths = {};
+        for (auto& buffer : asset->buffers) {
+            std::visit(fastgltf::visitor {
+                [](auto& arg) {},
+                [&](fastgltf::sources::URI& uri) {
+                    paths.push_back(path.parent_path() / std::string(uri.uri.path().begin(), uri.uri.path().end()));
+                },
+            }, buffer.data);
         }
+        return paths;
+    }
 
-        if (parser.getError() != fastgltf::Error::None) {
-            std::cerr << "Failed to load glTF: " << fastgltf::to_underlying(parser.getError()) << std::endl;
-            
+    auto get_accessor_view(const fastgltf::Asset& asset, usize accessor_index) -> AccessorView {
+        auto& accessor = asset.accessors[accessor_index];
+        if (!accessor.bufferViewIndex.has_value()) {
+            return {};
         }
 
-        auto error = gltf->parse(fastgltf::Category::Scenes);
-        if (error != fastgltf::Error::None) {
-            std::cerr << "Failed to parse glTF: " << fastgltf::to_underlying(error) << std::endl;
-            
+        auto& view = asset.bufferViews[accessor.bufferViewIndex.value()];
+        auto* vector = std::get_if<fastgltf::sources::Vector>(&asset.buffers[view.bufferIndex].data);
+        if (vector == nullptr) {
+            return {};
         }
 
-        asset = gltf->getParsedAsset();
+        usize element_size = get_component_size(accessor.componentType) * get_component_count(accessor.type);
+        return AccessorView {
+            .data = vector->bytes.data() + view.byteOffset + accessor.byteOffset,
+            .stride = view.byteStride.has_value() ? static_cast<usize>(view.byteStride.value()) : element_size,
+            .count = accessor.count,
+            .component_type = accessor.componentType,
+            .normalized = accessor.normalized,
+        };
     }
 
-        auto get_image_type = [&](usize image_index) -> Texture::Type {
-        for(auto& material : asset->materials) {
-            if(material.pbrData.value().baseColorTexture.has_value()) {
-                u32 diffuseTextureIndex = material.pbrData.value().baseColorTexture.value().textureIndex;
-                auto& diffuseTexture = asset->textures[diffuseTextureIndex];
-                if (image_index == diffuseTexture.imageIndex.value()) {
-                    return Texture::Type::SRGB;
-                }
+    template <typename T>
+    auto to_float(T value, bool normalized) -> f32 {
+        if constexpr (std::is_floating_point_v<T>) {
+            return value;
+        } else if constexpr (std::is_signed_v<T>) {
+            return normalized ? std::max(static_cast<f32>(value) / static_cast<f32>(std::numeric_limits<T>::max()), -1.0f) : static_cast<f32>(value);
+        } else {
+            return normalized ? static_cast<f32>(value) / static_cast<f32>(std::numeric_limits<T>::max()) : static_cast<f32>(value);
+        }
+    }
+
+    template <typename T, usize N, typename F>
+    void read_elements(const AccessorView& view, usize begin, usize end, F&& write) {
+        const u8* element = view.data + begin * view.stride;
+        for (usize i = begin; i < end; i++, element += view.stride) {
+            T components[N];
+            std::memcpy(components, element, sizeof(components));
+
+            std::array<f32, N> values;
+            for (usize c = 0; c < N; c++) {
+                values[c] = to_float(components[c], view.normalized);
             }
+            write(i, values);
         }
-        
-        return Texture::Type::UNORM;
-    };
+    }
 
-    images.resize(asset->images.size());
-    std::vector<std::pair<Texture::PayLoad, u32>> textures;
-    textures.resize(asset->images.size());
-    ThreadPool pool(std::thread::hardware_concurrency());
+    // dispatches once per accessor so the per element loop is compiled for the concrete component type
+    template <usize N, typename F>
+    void read_accessor(const AccessorView& view, usize begin, usize end, F&& write) {
+        if (view.data == nullptr) {
+            return;
+        }
+
+        switch(view.component_type) {
+            case fastgltf::ComponentType::Float: read_elements<f32, N>(view, begin, end, write); break;
+            case fastgltf::ComponentType::UnsignedShort: read_elements<u16, N>(view, begin, end, write); break;
+            case fastgltf::ComponentType::Short: read_elements<i16, N>(view, begin, end, write); break;
+            case fastgltf::ComponentType::UnsignedByte: read_elements<u8, N>(view, begin, end, write); break;
+            case fastgltf::ComponentType::Byte: read_elements<i8, N>(view, begin, end, write); break;
+            default: break;
+        }
+    }
+
+    void extract_vertices(const PrimitiveLayout& layout, usize begin, usize end, Vertex* vertices) {
+        read_accessor<3>(layout.positions, begin, end, [&](usize i, const std::array<f32, 3>& v) {
+            vertices[i].position = { v[0], v[1], v[2] };
+        });
+        read_accessor<3>(layout.normals, begin, end, [&](usize i, const std::array<f32, 3>& v) {
+            vertices[i].normal = { v[0], v[1], v[2] };
+        });
+        read_accessor<2>(layout.uvs, begin, end, [&](usize i, const std::array<f32, 2>& v) {
+            vertices[i].uv = { v[0], v[1] };
+        });
+        read_accessor<4>(layout.tangents, begin, end, [&](usize i, const std::array<f32, 4>& v) {
+            vertices[i].tangent = { v[0], v[1], v[2], v[3] };
+        });
+    }
+
+    void compute_bounds(std::span<const Vertex> vertices, Primitive& primitive) {
+        if (primitive.vertex_count == 0) {
+            return;
+        }
+
+        f32vec3 aabb_min = vertices[primitive.first_vertex].position;
+        f32vec3 aabb_max = aabb_min;
+        for (u32 i = primitive.first_vertex + 1; i < primitive.first_vertex + primitive.vertex_count; i++) {
+            const f32vec3& position = vertices[i].position;
+            aabb_min = { std::min(aabb_min.x, position.x), std::min(aabb_min.y, position.y), std::min(aabb_min.z, position.z) };
+            aabb_max = { std::max(aabb_max.x, position.x), std::max(aabb_max.y, position.y), std::max(aabb_max.z, position.z) };
+        }
+
+        primitive.aabb_min = aabb_min;
+        primitive.aabb_max = aabb_max;
+
+        f32vec3 center = { (aabb_min.x + aabb_max.x) * 0.5f, (aabb_min.y + aabb_max.y) * 0.5f, (aabb_min.z + aabb_max.z) * 0.5f };
+        f32 radius_squared = 0.0f;
+        for (u32 i = primitive.first_vertex; i < primitive.first_vertex + primitive.vertex_count; i++) {
+            const f32vec3& position = vertices[i].position;
+            f32vec3 offset = { position.x - center.x, position.y - center.y, position.z - center.z };
+            radius_squared = std::max(radius_squared, offset.x * offset.x + offset.y * offset.y + offset.z * offset.z);
+        }
+        primitive.bounding_radius = std::sqrt(radius_squared);
+    }
 
-    auto process_image = [&](fastgltf::Image& image, u32 index) {
-        Texture::PayLoad tex;
-        std::visit(fastgltf::visitor {
-            [](auto& arg) {},
-            [&](fastgltf::sources::URI& image_path) {
-               tex = Texture::load_texture(device, path.parent_path().string() + '/' + std::string(image_path.uri.path().begin(), image_path.uri.path().end()), get_image_type(index));
-            },
-
-            [&](fastgltf::sources::Vector& vector) {
-                i32 width = 0, height = 0, nrChannels = 0;
-                unsigned char *data = nullptr;
-                data = stbi_load_from_memory(vector.bytes.data(), static_cast<i32>(vector.bytes.size()), &width, &height, &nrChannels, 0);
-                if(!data) {
-                    throw std::runtime_error("wtf");
+    // optimizes every indexed primitive on its own and packs the results back into contiguous streams
+    auto optimize_primitives(ThreadPool& pool, std::vector<Vertex>& vertices, std::vector<u32>& indices, std::vector<Primitive>& primitives, const MeshOptimizeInfo& info) -> MeshOptimizationStatistics {
+        std::vector<OptimizedMesh> optimized_meshes(primitives.size());
+        TaskCounter optimized = {};
+        pool.push_tasks(primitives.size(), [&](usize i) {
+            if (primitives[i].index_count == 0) {
+                return;
+            }
+
+            const Primitive& primitive = primitives[i];
+            optimized_meshes[i] = optimize_mesh(
+                std::span<const Vertex>{vertices}.subspan(primitive.first_vertex, primitive.vertex_count),
+                std::span<const u32>{indices}.subspan(primitive.first_index, primitive.index_count),
+                info);
+        }, optimized);
+
+        pool.wait_for(optimized);
+
+        std::vector<Primitive> optimized_primitives = primitives;
+        u32 vertex_offset = 0;
+        u32 index_offset = 0;
+        for (usize i = 0; i < primitives.size(); i++) {
+            Primitive& primitive = optimized_primitives[i];
+            if (primitive.index_count > 0) {
+                primitive.vertex_count = static_cast<u32>(optimized_meshes[i].vertices.size());
+                primitive.index_count = static_cast<u32>(optimized_meshes[i].indices.size());
+            }
+            primitive.first_vertex = vertex_offset;
+            primitive.first_index = index_offset;
+            vertex_offset += primitive.vertex_count;
+            index_offset += primitive.index_count;
+        }
+
+        std::vector<Vertex> optimized_vertices(vertex_offset);
+        std::vector<u32> optimized_indices(index_offset);
+        MeshOptimizationStatistics statistics = {};
+
+        for (usize i = 0; i < primitives.size(); i++) {
+            const Primitive& source = primitives[i];
+            const Primitive& destination = optimized_primitives[i];
+
+            if (source.index_count == 0) {
+                std::copy_n(vertices.begin() + source.first_vertex, source.vertex_count, optimized_vertices.begin() + destination.first_vertex);
+                continue;
+            }
+
+            const OptimizedMesh& mesh = optimized_meshes[i];
+            std::copy(mesh.vertices.begin(), mesh.vertices.end(), optimized_vertices.begin() + destination.first_vertex);
+            std::copy(mesh.indices.begin(), mesh.indices.end(), optimized_indices.begin() + destination.first_index);
+            statistics.merge(mesh.statistics);
+        }
+
+        vertices = std::move(optimized_vertices);
+        indices = std::move(optimized_indices);
+        primitives = std::move(optimized_primitives);
+        return statistics;
+    }
+
+    // builds the lod chain of every primitive in parallel, the simplified indices are appended behind all full detail ones
+    void generate_primitive_lods(ThreadPool& pool, std::span<const Vertex> vertices, std::vector<u32>& indices, std::vector<Primitive>& primitives, const ModelLoadInfo& load_info, std::vector<PrimitiveLod>& lods) {
+        const LodBuildInfo& info = load_info.lod_build_info;
+        std::vector<std::vector<std::pair<std::vector<u32>, f32>>> primitive_levels(primitives.size());
+
+        TaskCounter simplified = {};
+        pool.push_tasks(primitives.size(), [&](usize i) {
+            if (primitives[i].index_count == 0) {
+                return;
+            }
+
+            const Primitive& primitive = primitives[i];
+            std::span<const Vertex> primitive_vertices = vertices.subspan(primitive.first_vertex, primitive.vertex_count);
+            std::span<const u32> primitive_indices = std::span<const u32>{indices}.subspan(primitive.first_index, primitive.index_count);
+
+            f32vec3 extent = { primitive.aabb_max.x - primitive.aabb_min.x, primitive.aabb_max.y - primitive.aabb_min.y, primitive.aabb_max.z - primitive.aabb_min.z };
+            f32 target_error = info.max_error * std::sqrt(extent.x * extent.x + extent.y * extent.y + extent.z * extent.z);
+
+            // every level starts from the full detail mesh so the error is measured against the original surface
+            u32 previous_index_count = primitive.index_count;
+            f32 previous_error = 0.0f;
+            for (u32 level = 1; level < info.max_lod_count; level++) {
+                u32 target_index_count = static_cast<u32>(static_cast<f32>(previous_index_count / 3) * info.reduction) * 3;
+                if (target_index_count / 3 < info.min_triangle_count) {
+                    break;
                 }
 
-                // utter garbage thanks to RGB formats are no supported
-                unsigned char* buffer = nullptr;
-                u64 buffer_size;
-
-                if (nrChannels == 3) {
-                    buffer_size = width * height * 4;
-                    std::vector<unsigned char> image_data(buffer_size, 255);
-
-                    buffer = (unsigned char*)image_data.data();
-                    unsigned char* rgba = buffer;
-                    unsigned char* rgb = data;
-                    for (usize i = 0; i < width * height; ++i) {
-                        std::memcpy(rgba, rgb, sizeof(unsigned char) * 3);
-                        rgba += 4;
-                        rgb += 3;
-                    }
+                f32 error = 0.0f;
+                std::vector<u32> level_indices = simplify_mesh(primitive_vertices, primitive_indices, target_index_count, target_error, info.simplify_info, error);
 
-                    tex = Texture::load_texture(device, width, height, buffer, get_image_type(index));
+                // simplification got stuck on locked vertices or the error bound, more levels wont help
+                if (static_cast<f32>(level_indices.size()) > static_cast<f32>(previous_index_count) * 0.9f) {
+                    break;
                 }
-                else {
-                    buffer = data;
-                    buffer_size = width * height * 4;
-                    tex = Texture::load_texture(device, width, height, buffer, get_image_type(index));
+
+                if (load_info.optimize_meshes) {
+                    std::vector<u32> optimized_indices = {};
+                    std::vector<u32> cluster_offsets = {};
+                    optimize_vertex_cache(level_indices, primitive.vertex_count, load_info.mesh_optimize_info.cache_size, optimized_indices, cluster_offsets);
+                    level_indices = std::move(optimized_indices);
                 }
 
-                stbi_image_free(data);
-            },
-
-            [&](fastgltf::sources::BufferView& view) {
-                auto& buffer_view = asset->bufferViews[view.bufferViewIndex];
-                auto& buffer = asset->buffers[buffer_view.bufferIndex];
-
-                std::visit(fastgltf::visitor {
-                    [](auto& arg) {},
-                    [&](fastgltf::sources::Vector& vector) {
-                        i32 width = 0, height = 0, nrChannels = 0;
-                        unsigned char *data = nullptr;
-                        data = stbi_load_from_memory(vector.bytes.data(), static_cast<i32>(vector.bytes.size()), &width, &height, &nrChannels, 0);
-                        if(!data) {
-                            throw std::runtime_error("wtf");
-                        }
+                previous_index_count = static_cast<u32>(level_indices.size());
+                previous_error = std::max(previous_error, error);
+                primitive_levels[i].emplace_back(std::move(level_indices), previous_error);
+            }
+        }, simplified);
+
+        pool.wait_for(simplified);
+
+        for (usize i = 0; i < primitives.size(); i++) {
+            Primitive& primitive = primitives[i];
+            primitive.first_lod = static_cast<u32>(lods.size());
+            lods.push_back(PrimitiveLod {
+                .first_index = primitive.first_index,
+                .index_count = primitive.index_count,
+                .error = 0.0f,
+            });
+
+            for (const auto& [level_indices, error] : primitive_levels[i]) {
+                lods.push_back(PrimitiveLod {
+                    .first_index = static_cast<u32>(indices.size()),
+                    .index_count = static_cast<u32>(level_indices.size()),
+                    .error = error,
+                });
+                indices.insert(indices.end(), level_indices.begin(), level_indices.end());
+            }
 
-                        // utter garbage thanks to RGB formats are no supported
-                        unsigned char* buffer;
-                        u64 buffer_size;
-
-                        if (nrChannels == 3) {
-                            buffer_size = width * height * 4;
-                            std::vector<unsigned char> image_data(buffer_size, 255);
-
-                            buffer = (unsigned char*)image_data.data();
-                            unsigned char* rgba = buffer;
-                            unsigned char* rgb = data;
-                            for (usize i = 0; i < width * height; ++i) {
-                                std::memcpy(rgba, rgb, sizeof(unsigned char) * 3);
-                                rgba += 4;
-                                rgb += 3;
-                            }
-                        }
-                        else {
-                            buffer = data;
-                            buffer_size = width * height * 4;
-                        }
+            primitive.lod_count = static_cast<u32>(lods.size()) - primitive.first_lod;
+        }
+    }
 
-                        tex = Texture::load_texture(device, width, height, buffer, get_image_type(index));
-                        stbi_image_free(data);
-                    }
-                }, buffer.data);
-            },
-        }, image.data);
-   
-        textures[index] = std::pair{std::move(tex), index};
+    struct MeshletStreams {
+        std::vector<Meshlet> meshlets = {};
+        std::vector<MeshletBounds> bounds = {};
+        std::vector<u32> vertices = {};
+        std::vector<u32> triangles = {};
     };
 
-    auto texture_timer = std::chrono::system_clock::now();
-    for (u32 i = 0; i < asset->images.size(); i++) {
-        auto& image = asset->images[i];
-        pool.push_task(process_image, image, i);
-    }
+    // builds the meshlets of every primitive in parallel and concatenates them in primitive order so the output is deterministic
+    auto build_primitive_meshlets(ThreadPool& pool, std::span<const Vertex> vertices, std::span<const u32> indices, std::vector<Primitive>& primitives, const MeshletBuildInfo& info, MeshletStreams& streams) -> MeshletStatistics {
+        std::vector<MeshletData> primitive_meshlets(primitives.size());
+        TaskCounter built = {};
+        pool.push_tasks(primitives.size(), [&](usize i) {
+            if (primitives[i].index_count == 0) {
+                return;
+            }
 
-    pool.wait_for_tasks();
+            const Primitive& primitive = primitives[i];
+            primitive_meshlets[i] = build_meshlets(
+                vertices.subspan(primitive.first_vertex, primitive.vertex_count),
+                indices.subspan(primitive.first_index, primitive.index_count),
+                info);
+        }, built);
+
+        pool.wait_for(built);
+
+        MeshletStatistics statistics = {};
+        for (usize i = 0; i < primitives.size(); i++) {
+            Primitive& primitive = primitives[i];
+            const MeshletData& data = primitive_meshlets[i];
+            u32 vertex_offset = static_cast<u32>(streams.vertices.size());
+            u32 triangle_offset = static_cast<u32>(streams.triangles.size());
+
+            primitive.first_meshlet = static_cast<u32>(streams.meshlets.size());
+            primitive.meshlet_count = static_cast<u32>(data.meshlets.size());
+
+            for (Meshlet meshlet : data.meshlets) {
+                meshlet.vertex_offset += vertex_offset;
+                meshlet.triangle_offset += triangle_offset;
+                meshlet.primitive_index = static_cast<u32>(i);
+                streams.meshlets.push_back(meshlet);
+            }
 
-    for(auto& tex : textures) {
-        device.submit_commands({
-            .command_lists = {std::move(tex.first.command_list)},
-        });
+            // meshlet vertices point straight into the model wide vertex buffer
+            for (u32 vertex : data.vertices) {
+                streams.vertices.push_back(primitive.first_vertex + vertex);
+            }
 
-        images[tex.second] = std::move(tex.first.texture);
+            streams.bounds.insert(streams.bounds.end(), data.bounds.begin(), data.bounds.end());
+            streams.triangles.insert(streams.triangles.end(), data.triangles.begin(), data.triangles.end());
+            statistics.merge(data.statistics);
+        }
+
+        return statistics;
     }
 
-    device.wait_idle();
+    template <typename T>
+    void widen_indices(ThreadPool& pool, const AccessorView& view, u32* indices) {
+        pool.parallel_for(0, view.count, INDEX_GRAIN_SIZE, [&](usize begin, usize end) {
+            const u8* element = view.data + begin * view.stride;
+            for (usize i = begin; i < end; i++, element += view.stride) {
+                T index;
+                std::memcpy(&index, element, sizeof(T));
+                indices[i] = static_cast<u32>(index);
+            }
+        });
+    }
 
-    null_texture = std::make_unique<Texture>(device, "assets/white.png", Texture::Type::SRGB);
+    // with a streamer only the coarse levels go up now, ktx2 files bring their own levels and always stay fully resident
+    auto create_texture(daxa::Device device, UploadManager& uploader, TextureStreamer* streamer, ThreadPool* pool, const ImageSource& source) -> std::unique_ptr<Texture> {
+        if(!source.path.empty() && is_ktx2_path(source.path)) {
+            return std::make_unique<Texture>(device, uploader, source.path, source.type);
+        }
 
-    std::vector<Material> materials = {};
-    materials.reserve(asset->materials.size());
+        // rgb images stay rgb until they get expanded into the staging memory
+        DecodedImage image = !source.bytes.empty() ? Texture::load_pixels(source.bytes, pool) : Texture::load_pixels(source.path, pool);
+        std::span<const u8> pixels = { image.pixels.get(), image.get_size() };
+        if(streamer != nullptr && source.two_channel_normal) {
+            NormalMapError error = {};
+            std::unique_ptr<Texture> texture = std::make_unique<Texture>(device, *streamer, create_normal_map_streaming_source(pixels, image.channel_count, image.size_x, image.size_y, error));
+            texture->normal_map_error = error;
+            return texture;
+        }
+        if(streamer != nullptr) {
+            return std::make_unique<Texture>(device, *streamer, create_streaming_source(pixels, image.channel_count, image.size_x, image.size_y, source.type == Texture::Type::SRGB, pool));
+        }
+        Texture::Type type = source.two_channel_normal ? Texture::Type::NORMAL_XY : source.type;
+        return std::make_unique<Texture>(device, uploader, image.size_x, image.size_y, image.pixels.get(), image.channel_count, type, Texture::MipGeneration::CPU_BOX);
+    }
 
-    for(auto& material : asset->materials) {
-        Material mat = {};
+    // fnv-1a over 64 bit words with an extra shift so the high bits reach the bottom, equal hashes still get compared byte by byte
+    auto hash_bytes(std::span<const u8> bytes) -> u64 {
+        u64 hash = 14695981039346656037ull ^ bytes.size();
+        usize i = 0;
+        for (; i + sizeof(u64) <= bytes.size(); i += sizeof(u64)) {
+            u64 word;
+            std::memcpy(&word, bytes.data() + i, sizeof(u64));
+            hash = (hash ^ word) * 1099511628211ull;
+            hash ^= hash >> 29;
+        }
+        for (; i < bytes.size(); i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
 
-        if(material.pbrData.value().baseColorTexture.has_value()) {
-            u32 texture_index = material.pbrData.value().baseColorTexture.value().textureIndex;
-            u32 image_index = asset->textures[texture_index].imageIndex.value();
-            mat.albedo_image = images[image_index]->get_texture_id();
-            mat.has_albedo_image = 1;
-        } else {
-            mat.albedo_image = null_texture->get_texture_id();
-            mat.has_albedo_image = 0;
+    // the cache is keyed by the encoded bytes, so an edited image next to the model misses and gets encoded again
+    auto create_compressed_texture(daxa::Device device, UploadManager& uploader, TextureStreamer* streamer, ThreadPool* pool, const ImageSource& source, CompressionStatistics& statistics) -> std::unique_ptr<Texture> {
+        std::unique_ptr<MappedFile> file = {};
+        std::span<const u8> encoded = source.bytes;
+        if(encoded.empty() && !source.path.empty()) {
+            file = std::make_unique<MappedFile>(source.path);
+            encoded = file->get_data();
         }
 
-        if(material.pbrData.value().metallicRoughnessTexture.has_value()) {
-            u32 texture_index = material.pbrData.value().metallicRoughnessTexture.value().textureIndex;
-            u32 image_index = asset->textures[texture_index].imageIndex.value();
-            mat.mettalic_roughness_image = images[image_index]->get_texture_id();
-            mat.has_mettalic_roughness_image = 1;
-        } else {
-            mat.mettalic_roughness_image = null_texture->get_texture_id();
-            mat.has_mettalic_roughness_image = 0;
+        auto start = std::chrono::steady_clock::now();
+        u64 source_hash = hash_bytes(encoded);
+        bool srgb = source.type == Texture::Type::SRGB;
+
+        auto create = [&](CompressedTexture compressed) -> std::unique_ptr<Texture> {
+            NormalMapError normal_map_error = compressed.normal_map_error;
+            std::unique_ptr<Texture> texture = {};
+            if(streamer != nullptr) {
+                texture = std::make_unique<Texture>(device, *streamer, create_streaming_source(std::move(compressed)));
+            } else {
+                texture = std::make_unique<Texture>(device, uploader, compressed);
+            }
+            texture->normal_map_error = normal_map_error;
+            return texture;
+        };
+
+        if(std::optional<CompressedTexture> cached = TextureCache::load(source_hash, source.block_format, srgb)) {
+            statistics = {
+                .format = cached->format,
+                .cache_hit = true,
+                .time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                .compressed_bytes = cached->data.size(),
+            };
+            for(u32 level = 0; level < cached->offsets.size(); level++) {
+                statistics.uncompressed_bytes += static_cast<usize>(std::max(1u, cached->size_x >> level)) * std::max(1u, cached->size_y >> level) * 4;
+            }
+            return create(std::move(cached.value()));
         }
 
-        if(material.normalTexture.has_value()) {
-            u32 texture_index = material.normalTexture.value().textureIndex;
-            u32 image_index = asset->textures[texture_index].imageIndex.value();
-            mat.normal_image = images[image_index]->get_texture_id();
-            mat.has_normal_image = 1;
-        } else {
-            mat.normal_image = null_texture->get_texture_id();
-            mat.has_normal_image = 0;
+        DecodedImage image = {};
+        try {
+            image = decode_image(encoded, { .channel_count = 4, .pool = pool });
+        } catch(const std::runtime_error& error) {
+            throw std::runtime_error("Textures couldn't be decoded: " + (source.path.empty() ? std::string("embedded image") : source.path) + ", " + error.what());
         }
 
-        if(material.occlusionTexture.has_value()) {
-            u32 texture_index = material.occlusionTexture.value().textureIndex;
-            u32 image_index = asset->textures[texture_index].imageIndex.value();
-            mat.occlusion_image = images[image_index]->get_texture_id();
-            mat.has_occlusion_image = 1;
+        // already running on a loader thread next to the other images, so the encoder stays on this one. normal maps get
+        // the same renormalized RG chain as the uncompressed ones
+        std::span<const u8> pixels = { image.pixels.get(), image.get_size() };
+        CompressedTexture compressed = {};
+        if(source.two_channel_normal) {
+            compressed = compress_normal_map(pixels, 4, image.size_x, image.size_y, 1, statistics);
         } else {
-            mat.occlusion_image = null_texture->get_texture_id();
-            mat.has_occlusion_image = 0;
+            compressed = compress_texture(pixels, image.size_x, image.size_y, source.block_format, srgb, 1, statistics);
         }
 
-        if(material.emissiveTexture.has_value()) {
-            u32 texture_index = material.emissiveTexture.value().textureIndex;
-            u32 image_index = asset->textures[texture_index].imageIndex.value();
-            mat.emissive_image = images[image_index]->get_texture_id();
-            mat.has_emissive_image = 1;
-        } else {
-            mat.emissive_image = null_texture->get_texture_id();
-            mat.has_emissive_image = 0;
+        TextureCache::store(source_hash, source.block_format, srgb, compressed);
+        return create(std::move(compressed));
+    }
+
+    // ktx2 files only get read and zstd inflated into staging memory, nothing in there needs a worker
+    auto get_image_lane(const ImageSource& source) -> TaskLane {
+        return !source.path.empty() && is_ktx2_path(source.path) ? TaskLane::IO : TaskLane::NORMAL;
+    }
+
+    auto get_normal_map_error(std::span<const std::unique_ptr<Texture>> images) -> NormalMapError {
+        NormalMapError error = {};
+        for(const auto& image : images) {
+            error.merge(image->normal_map_error);
         }
+        return error;
+    }
 
-        materials.push_back(mat);
+    enum ImageUsage : u32 { USAGE_COLOR = 1, USAGE_NORMAL = 2, USAGE_OCCLUSION = 4, USAGE_OTHER = 8 };
+
+    // every material slot an image ends up in, one bit per ImageUsage
+    auto get_image_usages(usize image_count, std::span<const MaterialInfo> materials) -> std::vector<u32> {
+        std::vector<u32> usages(image_count, 0);
+        auto mark = [&](i32 image_index, u32 usage) {
+            if(image_index >= 0 && static_cast<usize>(image_index) < usages.size()) {
+                usages[static_cast<usize>(image_index)] |= usage;
+            }
+        };
+        for(const auto& material : materials) {
+            mark(material.albedo_image, USAGE_COLOR);
+            mark(material.emissive_image, USAGE_COLOR);
+            mark(material.normal_image, USAGE_NORMAL);
+            mark(material.occlusion_image, USAGE_OCCLUSION);
+            mark(material.mettalic_roughness_image, USAGE_OTHER);
+        }
+        return usages;
     }
 
-    {
-        daxa::BufferId staging_material_buffer = device.create_buffer({
-            .size = static_cast<u32>(materials.size() * sizeof(Material)),
-            .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
-        });
+    // an image that is also used as color would lose its blue channel, so only the ones normalTexture alone points at
+    void select_two_channel_normals(std::span<ImageSource> sources, std::span<const MaterialInfo> materials) {
+        std::vector<u32> usages = get_image_usages(sources.size(), materials);
+        for(usize i = 0; i < sources.size(); i++) {
+            sources[i].two_channel_normal = usages[i] == USAGE_NORMAL;
+        }
+    }
 
-        material_buffer = device.create_buffer({
-            .size = static_cast<u32>(materials.size() * sizeof(Material)),
-            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
-        });
+    // color goes to BC7 (or BC1), images only used as normal or occlusion maps keep the channels those need
+    void select_block_formats(std::span<ImageSource> sources, std::span<const MaterialInfo> materials, const ModelLoadInfo& load_info) {
+        std::vector<u32> usages = get_image_usages(sources.size(), materials);
+        for(usize i = 0; i < sources.size(); i++) {
+            // KTX2 files come with their format and mips already
+            sources[i].compress = sources[i].path.empty() || !is_ktx2_path(sources[i].path);
+            if(sources[i].two_channel_normal) {
+                sources[i].block_format = BlockFormat::BC5;
+            } else if(usages[i] == USAGE_OCCLUSION) {
+                sources[i].block_format = BlockFormat::BC4;
+            } else if(usages[i] == USAGE_COLOR && load_info.prefer_bc1) {
+                sources[i].block_format = BlockFormat::BC1;
+            } else {
+                sources[i].block_format = BlockFormat::BC7;
+            }
+        }
+    }
 
-        auto cmd_list = device.create_command_list({
-            .name = "cmd_list",
-        });
+    struct ImageDeduplication {
+        std::vector<ImageSource> sources = {};
+        // the mapped and prefaulted file of every source that has one, the loader decodes straight out of them
+        std::vector<std::unique_ptr<MappedFile>> files = {};
+        // glTF image index to index into sources
+        std::vector<u32> remap = {};
+        usize duplicate_bytes = 0;
+    };
 
-        auto buffer_ptr = device.get_host_address_as<Material>(staging_material_buffer);
-        std::memcpy(buffer_ptr, materials.data(), materials.size() * sizeof(Material));
+    // the same file behind different uris or the same embedded bytes in several buffer views become one image,
+    // the first occurence wins so the result doesnt depend on the hashing threads
+    auto deduplicate_images(ThreadPool& pool, std::span<const ImageSource> sources) -> ImageDeduplication {
+        std::vector<std::unique_ptr<MappedFile>> files(sources.size());
+        std::vector<std::span<const u8>> contents(sources.size());
+        std::vector<u64> hashes(sources.size());
+        TaskCounter hashed(sources.size());
+        auto hash = [&](usize i) {
+            // missing files only match themselves, they throw once the decoder gets to them
+            hashes[i] = contents[i].empty() && !sources[i].path.empty() ? std::hash<std::string>{}(sources[i].path) : hash_bytes(contents[i]);
+            pool.count_down(hashed);
+        };
+
+        // faulting in a file is what waits on the disk, that happens on the io lane and every file gets hashed on the
+        // workers as soon as it is in
+        for (usize i = 0; i < sources.size(); i++) {
+            if (sources[i].path.empty()) {
+                contents[i] = sources[i].bytes;
+                pool.push_task([&hash, i] { hash(i); });
+                continue;
+            }
 
-        cmd_list.pipeline_barrier({
-            .src_access = daxa::AccessConsts::HOST_WRITE,
-            .dst_access = daxa::AccessConsts::TRANSFER_READ,
-        });
+            pool.push_task_to(TaskLane::IO, [&, i] {
+                try {
+                    if (std::filesystem::exists(sources[i].path)) {
+                        files[i] = std::make_unique<MappedFile>(sources[i].path);
+                        files[i]->prefault();
+                        contents[i] = files[i]->get_data();
+                    }
+                } catch (...) {
+                    // whatever went wrong the image still has to be hashed or the wait for hashed never returns
+                    files[i].reset();
+                    contents[i] = {};
+                }
+                pool.push_task([&hash, i] { hash(i); });
+            });
+        }
+        pool.wait_for(hashed);
 
-        cmd_list.copy_buffer_to_buffer({
-            .src_buffer = staging_material_buffer,
-            .dst_buffer = material_buffer,
-            .size = static_cast<u32>(materials.size() * sizeof(Material)),
-        });
+        auto is_same = [&](usize a, usize b) {
+            if (sources[a].type != sources[b].type || contents[a].size() != contents[b].size()) {
+                return false;
+            }
+            if (contents[a].empty()) {
+                return sources[a].path == sources[b].path;
+            }
+            return std::memcmp(contents[a].data(), contents[b].data(), contents[a].size()) == 0;
+        };
+
+        ImageDeduplication result = {};
+        result.remap.resize(sources.size());
+        std::vector<usize> first_occurences = {};
+        std::unordered_map<u64, std::vector<u32>> unique_by_hash = {};
+
+        for (usize i = 0; i < sources.size(); i++) {
+            std::vector<u32>& candidates = unique_by_hash[hashes[i]];
+            auto match = std::find_if(candidates.begin(), candidates.end(), [&](u32 unique_index) { return is_same(first_occurences[unique_index], i); });
+            if (match != candidates.end()) {
+                result.remap[i] = *match;
+                result.duplicate_bytes += contents[i].size();
+                continue;
+            }
 
-        cmd_list.complete();
-        device.submit_commands({
-            .command_lists = {std::move(cmd_list)}
-        });
+            u32 unique_index = static_cast<u32>(result.sources.size());
+            candidates.push_back(unique_index);
+            first_occurences.push_back(i);
+            result.sources.push_back(sources[i]);
+            result.files.push_back(std::move(files[i]));
+            result.remap[i] = unique_index;
+        }
 
-        device.wait_idle();
-        device.destroy_buffer(staging_material_buffer);
+        return result;
     }
 
+    struct MaterialDeduplication {
+        std::vector<MaterialInfo> materials = {};
+        // glTF material index to index into materials
+        std::vector<u32> remap = {};
+    };
+
+    // image slots have to point at the deduplicated images already, otherwise materials sharing a file through different uris wont match
+    auto deduplicate_materials(std::span<const MaterialInfo> materials, std::span<const u32> image_remap) -> MaterialDeduplication {
+        auto remap_image = [&](i32 image_index) -> i32 {
+            return image_index < 0 ? image_index : static_cast<i32>(image_remap[static_cast<usize>(image_index)]);
+        };
+
+        MaterialDeduplication result = {};
+        result.remap.reserve(materials.size());
+        std::map<std::array<i32, 5>, u32> unique_materials = {};
+
+        for (const MaterialInfo& material : materials) {
+            MaterialInfo remapped = {
+                .albedo_image = remap_image(material.albedo_image),
+                .mettalic_roughness_image = remap_image(material.mettalic_roughness_image),
+                .normal_image = remap_image(material.normal_image),
+                .occlusion_image = remap_image(material.occlusion_image),
+                .emissive_image = remap_image(material.emissive_image),
+            };
+
+            std::array<i32, 5> key = { remapped.albedo_image, remapped.mettalic_roughness_image, remapped.normal_image, remapped.occlusion_image, remapped.emissive_image };
+            auto [it, inserted] = unique_materials.try_emplace(key, static_cast<u32>(result.materials.size()));
+            if (inserted) {
+                result.materials.push_back(remapped);
+            }
+            result.remap.push_back(it->second);
+        }
+
+        return result;
+    }
+
+    void extract_indices(ThreadPool& pool, const AccessorView& view, u32* indices) {
+        if (view.data == nullptr) {
+            return;
+        }
+
+        switch(view.component_type) {
+            case fastgltf::ComponentType::UnsignedInt: widen_indices<u32>(pool, view, indices); break;
+            case fastgltf::ComponentType::UnsignedShort: widen_indices<u16>(pool, view, indices); break;
+            case fastgltf::ComponentType::UnsignedByte: widen_indices<u8>(pool, view, indices); break;
+            default: break;
+        }
+    }
+}
+
+Model::Model(daxa::Device _device, const std::string_view& file_path, const ModelLoadInfo& load_info) : device{_device}, packed_vertices{load_info.packed_vertices} {
+    auto load_timer = std::chrono::steady_clock::now();
+    std::filesystem::path path(file_path.data());
+
+    if(!std::filesystem::exists(path)) {
+        throw std::runtime_error("couldnt not find model: " + path.string());
+    }
+
+    std::unique_ptr<fastgltf::glTF> gltf;
+    fastgltf::GltfDataBuffer data_buffer;
+    std::unique_ptr<fastgltf::Asset> asset;
+
     std::vector<Vertex> vertices = {};
     std::vector<u32> indices = {};
+    std::vector<MaterialInfo> parsed_materials = {};
+    std::vector<ImageSource> image_sources = {};
+    MeshletStreams meshlet_streams = {};
+    std::vector<PrimitiveLayout> layouts = {};
 
-    for (auto & scene : asset->scenes) {
-        for (usize i = 0; i < scene.nodeIndices.size(); i++) {
-            auto& node = asset->nodes[i];
-            u32 vertex_offset = 0;
-            u32 index_offset = 0;
-
-            for (auto& primitive : asset->meshes[node.meshIndex.value()].primitives) {
-                u32 vertex_count = 0;
-                u32 index_count = 0;
-
-                const f32* positionBuffer = nullptr;
-                const f32* normalBuffer = nullptr;
-                const f32* texCoordsBuffer = nullptr;
-                const f32* tangentsBuffer = nullptr;
-
-                if (primitive.attributes.find("POSITION") != primitive.attributes.end()) {
-                    auto& accessor = asset->accessors[primitive.attributes.find("POSITION")->second];
-                    auto& view = asset->bufferViews[accessor.bufferViewIndex.value()];
-                    positionBuffer = reinterpret_cast<const f32*>(&(std::get<fastgltf::sources::Vector>(asset->buffers[view.bufferIndex].data).bytes[accessor.byteOffset + view.byteOffset]));
-                    vertex_count = accessor.count;
-                }
+    ThreadPool pool(std::thread::hardware_concurrency());
 
-                if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-                    auto& accessor = asset->accessors[primitive.attributes.find("NORMAL")->second];
-                    auto& view = asset->bufferViews[accessor.bufferViewIndex.value()];
-                    normalBuffer = reinterpret_cast<const f32*>(&(std::get<fastgltf::sources::Vector>(asset->buffers[view.bufferIndex].data).bytes[accessor.byteOffset + view.byteOffset]));
-                }
+    ModelCache::Key cache_key = ModelCache::get_key(load_info);
+    std::unique_ptr<ModelCache> cache = ModelCache::load(path, cache_key);
+    ModelCache::Contents contents = {};
+
+    if(cache) {
+        contents = cache->contents;
+        primitives.assign(contents.primitives.begin(), contents.primitives.end());
+        lods.assign(contents.lods.begin(), contents.lods.end());
+        meshlets.assign(contents.meshlets.begin(), contents.meshlets.end());
+        meshlet_bounds.assign(contents.meshlet_bounds.begin(), contents.meshlet_bounds.end());
+        statistics.cache_hit = true;
+    } else {
+        {
+            fastgltf::Parser parser(fastgltf::Extensions::KHR_mesh_quantization);
 
-                if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-                    auto& accessor = asset->accessors[primitive.attributes.find("TEXCOORD_0")->second];
-                    auto& view = asset->bufferViews[accessor.bufferViewIndex.value()];
-                    texCoordsBuffer = reinterpret_cast<const f32*>(&(std::get<fastgltf::sources::Vector>(asset->buffers[view.bufferIndex].data).bytes[accessor.byteOffset + view.byteOffset]));
-                }
+            constexpr auto gltfOptions = fastgltf::Options::DontRequireValidAssetMember | fastgltf::Options::AllowDouble | fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
+            data_buffer.loadFromFile(path);
+
+            if (path.extension() == ".gltf") {
+                gltf = parser.loadGLTF(&data_buffer, path.parent_path(), gltfOptions);
+            } else if (path.extension() == ".glb") {
+                gltf = parser.loadBinaryGLTF(&data_buffer, path.parent_path(), gltfOptions);
+            }
+
+            if (parser.getError() != fastgltf::Error::None) {
+                std::cerr << "Failed to load glTF: " << fastgltf::to_underlying(parser.getError()) << std::endl;
+                
+            }
+
+            auto error = gltf->parse(fastgltf::Category::Scenes);
+            if (error != fastgltf::Error::None) {
+                std::cerr << "Failed to parse glTF: " << fastgltf::to_underlying(error) << std::endl;
+                
+            }
 
-                if (primitive.attributes.find("TANGENT") != primitive.attributes.end()) {
-                    auto& accessor = asset->accessors[primitive.attributes.find("TANGENT")->second];
-                    auto& view = asset->bufferViews[accessor.bufferViewIndex.value()];
-                    tangentsBuffer = reinterpret_cast<const f32*>(&(std::get<fastgltf::sources::Vector>(asset->buffers[view.bufferIndex].data).bytes[accessor.byteOffset + view.byteOffset]));
+            asset = gltf->getParsedAsset();
+        }
+
+        auto get_image_type = [&](usize image_index) -> Texture::Type {
+            for(auto& material : asset->materials) {
+                if(material.pbrData.value().baseColorTexture.has_value()) {
+                    u32 diffuseTextureIndex = material.pbrData.value().baseColorTexture.value().textureIndex;
+                    auto& diffuseTexture = asset->textures[diffuseTextureIndex];
+                    if (image_index == diffuseTexture.imageIndex.value()) {
+                        return Texture::Type::SRGB;
+                    }
                 }
+            }
+            
+            return Texture::Type::UNORM;
+        };
+
+        image_sources.resize(asset->images.size());
+        for (usize i = 0; i < asset->images.size(); i++) {
+            ImageSource& source = image_sources[i];
+            source.type = get_image_type(i);
+
+            std::visit(fastgltf::visitor {
+                [](auto& arg) {},
+                [&](fastgltf::sources::URI& image_path) {
+                    source.path = path.parent_path().string() + '/' + std::string(image_path.uri.path().begin(), image_path.uri.path().end());
+                },
+
+                [&](fastgltf::sources::Vector& vector) {
+                    source.bytes = std::span<const u8>{vector.bytes.data(), vector.bytes.size()};
+                },
+
+                [&](fastgltf::sources::BufferView& view) {
+                    auto& buffer_view = asset->bufferViews[view.bufferViewIndex];
+                    auto& buffer = asset->buffers[buffer_view.bufferIndex];
+
+                    std::visit(fastgltf::visitor {
+                        [](auto& arg) {},
+                        [&](fastgltf::sources::Vector& vector) {
+                            source.bytes = std::span<const u8>{vector.bytes.data() + buffer_view.byteOffset, buffer_view.byteLength};
+                        }
+                    }, buffer.data);
+                },
+            }, asset->images[i].data);
+        }
+
+        auto get_image_index = [&](const auto& texture_info) -> i32 {
+            return static_cast<i32>(asset->textures[texture_info.textureIndex].imageIndex.value());
+        };
+
+        parsed_materials.reserve(asset->materials.size());
+        for(auto& material : asset->materials) {
+            MaterialInfo info = {};
+
+            if(material.pbrData.value().baseColorTexture.has_value()) {
+                info.albedo_image = get_image_index(material.pbrData.value().baseColorTexture.value());
+            }
+
+            if(material.pbrData.value().metallicRoughnessTexture.has_value()) {
+                info.mettalic_roughness_image = get_image_index(material.pbrData.value().metallicRoughnessTexture.value());
+            }
+
+            if(material.normalTexture.has_value()) {
+                info.normal_image = get_image_index(material.normalTexture.value());
+            }
+
+            if(material.occlusionTexture.has_value()) {
+                info.occlusion_image = get_image_index(material.occlusionTexture.value());
+            }
+
+            if(material.emissiveTexture.has_value()) {
+                info.emissive_image = get_image_index(material.emissiveTexture.value());
+            }
+
+            parsed_materials.push_back(info);
+        }
 
-                for (size_t v = 0; v < vertex_count; v++) {
-                    glm::vec3 temp_position = glm::make_vec3(&positionBuffer[v * 3]);
-                    glm::vec3 temp_normal = glm::make_vec3(&normalBuffer[v * 3]);
-                    glm::vec2 temp_uv = texCoordsBuffer ? glm::make_vec2(&texCoordsBuffer[v * 2]) : glm::vec2(0.0f);
-                    glm::vec4 temp_tangent = tangentsBuffer ? glm::make_vec4(&tangentsBuffer[v * 4]) : glm::vec4(0.0f);
-                    Vertex vertex{
-                        .position = {temp_position.x, temp_position.y, temp_position.z},
-                        .normal = {temp_normal.x, temp_normal.y, temp_normal.z},
-                        .uv = {temp_uv.x, temp_uv.y},
-                        .tangent = {temp_tangent.x, temp_tangent.y, temp_tangent.z, temp_tangent.w}
-                    };
-
-                    vertices.push_back(vertex);
+        // glTF draws primitives without a material with the default one, that is a material without any textures. it only
+        // gets added when something uses it, so the material indices of the file stay what they are
+        u32 default_material_index = std::numeric_limits<u32>::max();
+        auto get_material_index = [&](const auto& primitive) -> u32 {
+            if (primitive.materialIndex.has_value()) {
+                return static_cast<u32>(primitive.materialIndex.value());
+            }
+            if (default_material_index == std::numeric_limits<u32>::max()) {
+                default_material_index = static_cast<u32>(parsed_materials.size());
+                parsed_materials.push_back(MaterialInfo{});
+            }
+            return default_material_index;
+        };
+
+        // first pass, resolve every accessor once and hand out exact vertex and index ranges
+        u32 vertex_offset = 0;
+        u32 index_offset = 0;
+
+        for (auto & scene : asset->scenes) {
+            for (usize node_index : scene.nodeIndices) {
+                auto& node = asset->nodes[node_index];
+                if (!node.meshIndex.has_value()) {
+                    continue;
                 }
 
-                {
-                    auto& accessor = asset->accessors[primitive.indicesAccessor.value()];
-                    auto& bufferView = asset->bufferViews[accessor.bufferViewIndex.value()];
-                    auto& buffer = asset->buffers[bufferView.bufferIndex];
-
-                    index_count = accessor.count;
-
-                    switch(accessor.componentType) {
-                        case fastgltf::ComponentType::UnsignedInt: {
-                            const uint32_t * buf = reinterpret_cast<const uint32_t *>(&std::get<fastgltf::sources::Vector>(buffer.data).bytes[accessor.byteOffset + bufferView.byteOffset]);
-                            indices.reserve((indices.size() + accessor.count) * sizeof(uint32_t));
-                            for (size_t index = 0; index < accessor.count; index++) {
-                                indices.push_back(buf[index]);
-                            }
-                            break;
-                        }
-                        case fastgltf::ComponentType::UnsignedShort: {
-                            const uint16_t * buf = reinterpret_cast<const uint16_t *>(&std::get<fastgltf::sources::Vector>(buffer.data).bytes[accessor.byteOffset + bufferView.byteOffset]);
-                            indices.reserve((indices.size() + accessor.count) * sizeof(uint16_t));
-                            for (size_t index = 0; index < accessor.count; index++) {
-                                indices.push_back(buf[index]);
-                            }
-                            break;
-                        }
-                        case fastgltf::ComponentType::UnsignedByte: {
-                            const uint8_t * buf = reinterpret_cast<const uint8_t *>(&std::get<fastgltf::sources::Vector>(buffer.data).bytes[accessor.byteOffset + bufferView.byteOffset]);
-                            indices.reserve((indices.size() + accessor.count) * sizeof(uint8_t));
-                            for (size_t index = 0; index < accessor.count; index++) {
-                                indices.push_back(buf[index]);
-                            }
-                            break;
+                for (auto& primitive : asset->meshes[node.meshIndex.value()].primitives) {
+                    PrimitiveLayout layout = {};
+
+                    for (auto& [name, accessor_index] : primitive.attributes) {
+                        if (name == "POSITION") {
+                            layout.positions = get_accessor_view(*asset, accessor_index);
+                        } else if (name == "NORMAL") {
+                            layout.normals = get_accessor_view(*asset, accessor_index);
+                        } else if (name == "TEXCOORD_0") {
+                            layout.uvs = get_accessor_view(*asset, accessor_index);
+                        } else if (name == "TANGENT") {
+                            layout.tangents = get_accessor_view(*asset, accessor_index);
                         }
                     }
-                }
 
-                Primitive temp_primitive {
-                    .first_index = index_offset,
-                    .first_vertex = vertex_offset,
-                    .index_count = index_count,
-                    .vertex_count = vertex_count,
-                    .material_index = static_cast<u32>(primitive.materialIndex.value()) 
-                };
+                    if (primitive.indicesAccessor.has_value()) {
+                        layout.indices = get_accessor_view(*asset, primitive.indicesAccessor.value());
+                    }
+
+                    u32 vertex_count = static_cast<u32>(layout.positions.count);
+                    u32 index_count = static_cast<u32>(layout.indices.count);
+
+                    layout.first_vertex = vertex_offset;
+                    layout.first_index = index_offset;
+                    layouts.push_back(layout);
 
-                primitives.push_back(temp_primitive);
+                    primitives.push_back(Primitive {
+                        .first_index = index_offset,
+                        .first_vertex = vertex_offset,
+                        .index_count = index_count,
+                        .vertex_count = vertex_count,
+                        .material_index = get_material_index(primitive)
+                    });
 
-                vertex_offset += vertex_count;
-                index_offset += index_count;
+                    vertex_offset += vertex_count;
+                    index_offset += index_count;
+                }
             }
         }
+
+        // the second pass runs as the first geometry job, every primitive writes into its own slice of these
+        vertices.resize(vertex_offset);
+        indices.resize(index_offset);
     }
 
-    vertex_buffer = device.create_buffer(daxa::BufferInfo{
-        .size = static_cast<u32>(sizeof(Vertex) * vertices.size()),
-        .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
-        .name = "vertex buffer",
-    });
+    // images and materials are known without any geometry, so they are sorted out up front and the rest runs as jobs
+    std::span<const ImageSource> source_images = cache ? contents.images : std::span<const ImageSource>{image_sources};
+    std::span<const MaterialInfo> source_materials = cache ? contents.materials : std::span<const MaterialInfo>{parsed_materials};
+    ImageDeduplication image_deduplication = deduplicate_images(pool, source_images);
+    MaterialDeduplication material_deduplication = deduplicate_materials(source_materials, image_deduplication.remap);
+
+    statistics.deduplication = {
+        .image_count = static_cast<u32>(source_images.size()),
+        .unique_image_count = static_cast<u32>(image_deduplication.sources.size()),
+        .duplicate_image_bytes = image_deduplication.duplicate_bytes,
+        .material_count = static_cast<u32>(source_materials.size()),
+        .unique_material_count = static_cast<u32>(material_deduplication.materials.size()),
+    };
+    std::vector<ImageSource>& image_table = image_deduplication.sources;
+    if(load_info.two_channel_normals) {
+        select_two_channel_normals(image_table, material_deduplication.materials);
+    }
+    if(load_info.compress_textures) {
+        select_block_formats(image_table, material_deduplication.materials, load_info);
+        statistics.compression.resize(image_table.size());
+    }
+    // decode_pool splits big images into strips next to the other images that are decoding
+    auto load_image = [this](const ImageSource& source, u32 image_index, ThreadPool* decode_pool) {
+        return source.compress ? create_compressed_texture(device, *uploader, texture_streamer.get(), decode_pool, source, statistics.compression[image_index]) : create_texture(device, *uploader, texture_streamer.get(), decode_pool, source);
+    };
+
+    // every texture and buffer of the model is recorded into the same staging ring and submitted in a few batches
+    uploader = std::make_unique<UploadManager>(device, UploadManagerInfo{ .name = "model uploader" });
+    if(load_info.stream_mips) {
+        texture_streamer = std::make_unique<TextureStreamer>(device, *uploader, load_info.texture_streaming_info);
+    }
+
+    images.resize(image_table.size());
+    image_resident.assign(image_table.size(), 0);
+    material_infos = std::move(material_deduplication.materials);
+    null_texture = std::make_unique<Texture>(device, *uploader, "assets/white.png", Texture::Type::SRGB);
 
-    index_buffer = device.create_buffer(daxa::BufferInfo{
-        .size = static_cast<u32>(sizeof(u32) * indices.size()),
+    // every entry starts out on the null texture and gets patched once its image is loaded, while streaming by update
+    texture_table.assign(images.size() + 1, MaterialTexture{ .texture = null_texture->get_texture_id(), .layer = MATERIAL_NO_LAYER });
+    texture_table_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, {
+        .size = static_cast<u32>(texture_table.size() * sizeof(MaterialTexture)),
         .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
-        .name = "index buffer",
+        .name = "texture table buffer",
     });
+    std::vector<Material> materials(material_infos.size());
+
+    if(load_info.stream_textures) {
+        streaming_start = std::chrono::steady_clock::now();
+
+        // the sources point into the parsed glTF or the mapped cache which are gone once the constructor returns
+        streaming_sources = image_table;
+        streaming_bytes.resize(streaming_sources.size());
+        for (usize i = 0; i < streaming_sources.size(); i++) {
+            if (!streaming_sources[i].bytes.empty()) {
+                streaming_bytes[i].assign(streaming_sources[i].bytes.begin(), streaming_sources[i].bytes.end());
+                streaming_sources[i].bytes = streaming_bytes[i];
+            }
+        }
 
-    {
-        auto cmd_list = device.create_command_list({
-            .name = "cmd_list",
-        });
+        streaming_pool = std::make_unique<ThreadPool>(std::thread::hardware_concurrency());
+        for (u32 i = 0; i < streaming_sources.size(); i++) {
+            streaming_pool->push_task_to(get_image_lane(streaming_sources[i]), [this, load_image, i] {
+                images[i] = load_image(streaming_sources[i], i, streaming_pool.get());
+                const std::scoped_lock lock(streaming_mutex);
+                decoded_images.push_back(i);
+            });
+        }
+    }
+
+    JobGraph graph = {};
+
+    // geometry is a single chain, every stage needs all of the one before. the stages spread over the pool themselves
+    std::vector<JobId> geometry_jobs = {};
+    auto add_geometry_job = [&](std::string name, std::function<void()> job) {
+        JobId id = graph.add(std::move(name), std::move(job));
+        if(!geometry_jobs.empty()) {
+            graph.depend(id, geometry_jobs.back());
+        }
+        geometry_jobs.push_back(id);
+    };
 
-        auto vertex_staging_buffer = device.create_buffer({
-            .size = static_cast<u32>(sizeof(Vertex) * vertices.size()),
-            .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
-            .name = "staging vertex buffer",
+    if(!cache) {
+        add_geometry_job("extract geometry", [&] {
+            // primitives spread over the pool and the big ones split up their vertices and indices again
+            pool.parallel_for(0, layouts.size(), 1, [&](usize first, usize last) {
+                for (usize i = first; i < last; i++) {
+                    const PrimitiveLayout& layout = layouts[i];
+                    pool.parallel_for(0, layout.positions.count, VERTEX_GRAIN_SIZE, [&](usize begin, usize end) {
+                        extract_vertices(layout, begin, end, vertices.data() + layout.first_vertex);
+                    });
+                    extract_indices(pool, layout.indices, indices.data() + layout.first_index);
+                }
+            });
         });
 
-        cmd_list.destroy_buffer_deferred(vertex_staging_buffer);
+        if (load_info.optimize_meshes) {
+            add_geometry_job("optimize meshes", [&] {
+                statistics.mesh_optimization = optimize_primitives(pool, vertices, indices, primitives, load_info.mesh_optimize_info);
+            });
+        }
 
-        auto index_staging_buffer = device.create_buffer({
-            .size = static_cast<u32>(sizeof(u32) * indices.size()),
-            .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
-            .name = "staging index buffer",
+        add_geometry_job("compute bounds", [&] {
+            TaskCounter bounded = {};
+            pool.push_tasks(primitives.size(), [&](usize i) {
+                compute_bounds(vertices, primitives[i]);
+            }, bounded);
+            pool.wait_for(bounded);
         });
-        
-        cmd_list.destroy_buffer_deferred(index_staging_buffer);
 
-        {
-            auto buffer_ptr = device.get_host_address_as<Vertex>(vertex_staging_buffer);
-            std::memcpy(buffer_ptr, vertices.data(), vertices.size() * sizeof(Vertex));
+        if (load_info.generate_lods) {
+            add_geometry_job("generate lods", [&] {
+                auto lod_timer = std::chrono::steady_clock::now();
+                generate_primitive_lods(pool, vertices, indices, primitives, load_info, lods);
+                statistics.lod_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - lod_timer).count();
+                statistics.lod_count = static_cast<u32>(lods.size() - primitives.size());
+            });
         }
 
-        {
-            auto buffer_ptr = device.get_host_address_as<Vertex>(index_staging_buffer);
-            std::memcpy(buffer_ptr, indices.data(), indices.size() * sizeof(u32));
+        if (load_info.build_meshlets) {
+            add_geometry_job("build meshlets", [&] {
+                statistics.meshlets = build_primitive_meshlets(pool, vertices, indices, primitives, load_info.meshlet_build_info, meshlet_streams);
+                meshlets = meshlet_streams.meshlets;
+                meshlet_bounds = meshlet_streams.bounds;
+            });
         }
 
-        cmd_list.pipeline_barrier({
-            .src_access = daxa::AccessConsts::HOST_WRITE,
-            .dst_access = daxa::AccessConsts::TRANSFER_READ,
+        add_geometry_job("store cache", [&] {
+            contents = ModelCache::Contents {
+                .vertices = vertices,
+                .indices = indices,
+                .primitives = primitives,
+                .materials = parsed_materials,
+                .images = image_sources,
+                .meshlets = meshlet_streams.meshlets,
+                .meshlet_bounds = meshlet_streams.bounds,
+                .meshlet_vertices = meshlet_streams.vertices,
+                .meshlet_triangles = meshlet_streams.triangles,
+                .lods = lods,
+            };
+
+            ModelCache::store(path, cache_key, get_external_buffer_paths(path), contents);
+        });
+    }
+
+    std::vector<PackedVertex> packed_vertex_data = {};
+    if(packed_vertices) {
+        add_geometry_job("pack vertices", [&] {
+            packed_vertex_data.resize(contents.vertices.size());
+            std::vector<QuantizationError> quantization_errors(contents.primitives.size());
+
+            TaskCounter packed = {};
+            pool.push_tasks(contents.primitives.size(), [&](usize i) {
+                quantization_errors[i] = pack_primitive_vertices(contents.vertices, contents.primitives[i], packed_vertex_data);
+            }, packed);
+            pool.wait_for(packed);
+
+            for(const auto& error : quantization_errors) {
+                statistics.quantization_error.merge(error);
+            }
+        });
+    }
+
+    // streamed images arent part of the graph, they keep going on streaming_pool after the constructor returns
+    std::vector<JobId> image_jobs = {};
+    if(!streaming_pool) {
+        for (u32 i = 0; i < image_table.size(); i++) {
+            image_jobs.push_back(graph.add("image " + std::to_string(i), [&, i] {
+                // decoded straight out of the mapping dedupe faulted in
+                ImageSource source = image_table[i];
+                if (image_deduplication.files[i]) {
+                    source.bytes = image_deduplication.files[i]->get_data();
+                }
+                images[i] = load_image(source, i, &pool);
+                image_deduplication.files[i].reset();
+                image_resident[i] = 1;
+                texture_table[i + 1] = get_material_texture(i);
+            }, get_image_lane(image_table[i])));
+        }
+    }
+
+    // streamed textures swap their images and the ones still decoding arent there yet, so only loaded images get packed
+    std::optional<JobId> pack_job = {};
+    if(load_info.pack_small_textures && !streaming_pool) {
+        pack_job = graph.add("pack textures", [&] {
+            std::vector<TextureArrayCandidate> candidates = {};
+            candidates.reserve(images.size());
+            for(const auto& image : images) {
+                const daxa::ImageInfo& info = device.info_image(image->image_id);
+                candidates.push_back({
+                    .format = info.format,
+                    .size_x = info.size.x,
+                    .size_y = info.size.y,
+                    .mip_level_count = info.mip_level_count,
+                    .packable = image->streamer == nullptr,
+                });
+            }
+
+            TextureArrayPacking packing = pack_texture_arrays(candidates, load_info.texture_array_packing_info);
+            for(const TextureArrayLayout& layout : packing.arrays) {
+                std::vector<Texture*> layers = {};
+                for(u32 image_index : layout.images) {
+                    layers.push_back(images[image_index].get());
+                }
+                texture_arrays.push_back(std::make_unique<Texture>(device, *uploader, layers));
+            }
+            image_placements = std::move(packing.placements);
+            for(u32 i = 0; i < images.size(); i++) {
+                texture_table[i + 1] = get_material_texture(i);
+            }
+            statistics.texture_arrays = packing.statistics;
         });
+        graph.depend(*pack_job, image_jobs);
+    }
+
+    // a material only holds texture table indices and the table address, neither waits on an image or on the packing,
+    // those only change what the table entries point at
+    std::vector<JobId> material_jobs = {};
+    for(u32 i = 0; i < material_infos.size(); i++) {
+        material_jobs.push_back(graph.add("material " + std::to_string(i), [&, i] {
+            materials[i] = get_material(i);
+        }));
+    }
+
+    JobId upload_job = graph.add("upload", [&] {
+        for (auto& primitive : primitives) {
+            if (primitive.material_index < material_deduplication.remap.size()) {
+                primitive.material_index = material_deduplication.remap[primitive.material_index];
+            }
+        }
+
+        std::span<const std::byte> vertex_data = packed_vertices ? std::as_bytes(std::span<const PackedVertex>{packed_vertex_data}) : std::as_bytes(contents.vertices);
 
-        cmd_list.copy_buffer_to_buffer({
-            .src_buffer = vertex_staging_buffer,
-            .dst_buffer = vertex_buffer,
-            .size = static_cast<u32>(sizeof(Vertex) * vertices.size()),
+        material_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, {
+            .size = static_cast<u32>(materials.size() * sizeof(Material)),
+            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+            .name = "material buffer",
         });
 
-        cmd_list.copy_buffer_to_buffer({
-            .src_buffer = index_staging_buffer,
-            .dst_buffer = index_buffer,
-            .size = static_cast<u32>(sizeof(u32) * indices.size()),
+        vertex_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, daxa::BufferInfo{
+            .size = static_cast<u32>(vertex_data.size_bytes()),
+            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+            .name = "vertex buffer",
         });
 
-        cmd_list.pipeline_barrier({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::VERTEX_SHADER_READ,
+        index_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, daxa::BufferInfo{
+            .size = static_cast<u32>(contents.indices.size_bytes()),
+            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+            .name = "index buffer",
         });
-        cmd_list.complete();
-        device.submit_commands({
-            .command_lists = {std::move(cmd_list)},
+
+        primitive_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo{
+            .size = static_cast<u32>(sizeof(Primitive) * primitives.size()),
+            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+            .name = "primitive buffer",
         });
+
+        uploader->upload_buffer({ .buffer = texture_table_buffer, .data = std::as_bytes(std::span<const MaterialTexture>{texture_table}) });
+        uploader->upload_buffer({ .buffer = material_buffer, .data = std::as_bytes(std::span<const Material>{materials}) });
+        uploader->upload_buffer({ .buffer = vertex_buffer, .data = vertex_data });
+        uploader->upload_buffer({ .buffer = index_buffer, .data = std::as_bytes(contents.indices) });
+        uploader->upload_buffer({ .buffer = primitive_buffer, .data = std::as_bytes(std::span<const Primitive>{primitives}) });
+
+        if (!contents.meshlets.empty()) {
+            auto upload = [&](std::span<const std::byte> data, const std::string& name) -> daxa::BufferId {
+                daxa::BufferId buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, daxa::BufferInfo{
+                    .size = static_cast<u32>(data.size_bytes()),
+                    .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+                    .name = name,
+                });
+
+                uploader->upload_buffer({ .buffer = buffer, .data = data });
+                return buffer;
+            };
+
+            meshlet_buffer = upload(std::as_bytes(contents.meshlets), "meshlet buffer");
+            meshlet_bounds_buffer = upload(std::as_bytes(contents.meshlet_bounds), "meshlet bounds buffer");
+            meshlet_vertex_buffer = upload(std::as_bytes(contents.meshlet_vertices), "meshlet vertex buffer");
+            meshlet_triangle_buffer = upload(std::as_bytes(contents.meshlet_triangles), "meshlet triangle buffer");
+        }
+
+        if(load_info.evictable_geometry) {
+            auto keep = [&](daxa::BufferId& buffer, const std::string& name, std::span<const std::byte> data) {
+                geometry_buffers.push_back({ .buffer = &buffer, .name = name, .data = std::vector<std::byte>(data.begin(), data.end()) });
+            };
+
+            keep(vertex_buffer, "vertex buffer", vertex_data);
+            keep(index_buffer, "index buffer", std::as_bytes(contents.indices));
+            if (!contents.meshlets.empty()) {
+                keep(meshlet_buffer, "meshlet buffer", std::as_bytes(contents.meshlets));
+                keep(meshlet_bounds_buffer, "meshlet bounds buffer", std::as_bytes(contents.meshlet_bounds));
+                keep(meshlet_vertex_buffer, "meshlet vertex buffer", std::as_bytes(contents.meshlet_vertices));
+                keep(meshlet_triangle_buffer, "meshlet triangle buffer", std::as_bytes(contents.meshlet_triangles));
+            }
+
+            budget_evictor = ResourceBudget::get().add_evictor(ResourceCategory::GEOMETRY, [this] { return last_used_frame; }, [this](usize) { return evict_geometry(); });
+        }
+
+        // one wait for the whole model instead of one per texture
+        uploader->flush().wait();
+        statistics.upload = uploader->get_statistics();
+    });
+    if(!geometry_jobs.empty()) {
+        graph.depend(upload_job, geometry_jobs.back());
+    }
+    graph.depend(upload_job, image_jobs);
+    if(pack_job) {
+        graph.depend(upload_job, *pack_job);
+    }
+    graph.depend(upload_job, material_jobs);
+
+    f64 graph_start_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - load_timer).count();
+    graph.run(pool);
+    statistics.jobs = graph.get_statistics();
+    for(usize i = 0; i < TASK_LANE_COUNT; i++) {
+        statistics.lanes[i] = pool.get_lane_statistics(static_cast<TaskLane>(i));
+    }
+    statistics.geometry_time_ms = graph_start_ms + (geometry_jobs.empty() ? 0.0 : graph.get_end_ms(geometry_jobs.back()));
+    if(!streaming_pool) {
+        for(JobId job : image_jobs) {
+            statistics.texture_time_ms = std::max(statistics.texture_time_ms, graph.get_end_ms(job));
+        }
+        statistics.normal_maps = get_normal_map_error(images);
+        resident_image_count = static_cast<u32>(images.size());
     }
+
+    // the arrays have their own copy by now
+    for(u32 i = 0; i < image_placements.size(); i++) {
+        if(image_placements[i].array != TextureArrayPlacement::NO_ARRAY) {
+            images[i].reset();
+        }
+    }
+
+    // the streamer keeps recording mip uploads into it for as long as the model lives, evicted geometry comes back through it
+    if(!streaming_pool && !texture_streamer && geometry_buffers.empty()) {
+        uploader.reset();
+    }
+
+    culling_bounds = make_culling_bounds(primitives);
+
+    statistics.total_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - load_timer).count();
 }
 
 Model::~Model() {
-    this->device.destroy_buffer(vertex_buffer);
-    this->device.destroy_buffer(index_buffer);
-    this->device.destroy_buffer(material_buffer);
-}
\ No newline at end of file
+    if(!geometry_buffers.empty()) {
+        ResourceBudget::get().remove_evictor(budget_evictor);
+    }
+
+    // decoding threads write into images and record into the uploader, both have to be quiet before anything goes away
+    if(streaming_pool) {
+        // an image that failed to load only matters to wait_for_textures, nobody is left to tell here
+        try {
+            streaming_pool->wait_for_tasks();
+        } catch(...) {
+        }
+        streaming_pool.reset();
+    }
+    uploader.reset();
+
+    ResourceBudget::get().destroy_buffer(this->device, vertex_buffer);
+    ResourceBudget::get().destroy_buffer(this->device, index_buffer);
+    ResourceBudget::get().destroy_buffer(this->device, material_buffer);
+    ResourceBudget::get().destroy_buffer(this->device, texture_table_buffer);
+    ResourceBudget::get().destroy_buffer(this->device, primitive_buffer);
+
+    if(!meshlets.empty()) {
+        ResourceBudget::get().destroy_buffer(this->device, meshlet_buffer);
+        ResourceBudget::get().destroy_buffer(this->device, meshlet_bounds_buffer);
+        ResourceBudget::get().destroy_buffer(this->device, meshlet_vertex_buffer);
+        ResourceBudget::get().destroy_buffer(this->device, meshlet_triangle_buffer);
+    }
+}
+
+void Model::cull(const glm::mat4& clip_matrix, VisibleList& visible) const {
+    cull_frustum(extract_frustum_planes(clip_matrix), culling_bounds, visible);
+    if(!visible.primitive_indices.empty()) {
+        last_used_frame = ResourceBudget::get().get_frame();
+    }
+
+    // the bounds never leave the cpu, so an evicted model still notices when it is seen again and update brings it back
+    if(!geometry_resident) {
+        visible.clear();
+    }
+}
+
+auto Model::evict_geometry() -> usize {
+    // seen last frame means it is probably still on screen, dropping it would only bring it right back
+    if(!geometry_resident || geometry_upload.has_value() || last_used_frame + 1 >= ResourceBudget::get().get_frame()) {
+        return 0;
+    }
+
+    usize freed = 0;
+    for(GeometryBuffer& geometry : geometry_buffers) {
+        freed += geometry.data.size();
+        ResourceBudget::get().destroy_buffer(device, *geometry.buffer);
+        *geometry.buffer = {};
+    }
+    geometry_resident = false;
+    return freed;
+}
+
+void Model::restore_geometry() {
+    if(geometry_upload.has_value() && geometry_upload->is_ready()) {
+        geometry_resident = true;
+        geometry_upload.reset();
+    }
+    if(geometry_resident || geometry_upload.has_value()) {
+        return;
+    }
+
+    usize size = 0;
+    for(const GeometryBuffer& geometry : geometry_buffers) {
+        size += geometry.data.size();
+    }
+    if(last_used_frame + 1 < ResourceBudget::get().get_frame() || !ResourceBudget::get().fits(size)) {
+        return;
+    }
+
+    for(GeometryBuffer& geometry : geometry_buffers) {
+        *geometry.buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, daxa::BufferInfo{
+            .size = static_cast<u32>(geometry.data.size()),
+            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+            .name = geometry.name,
+        });
+        uploader->upload_buffer({ .buffer = *geometry.buffer, .data = geometry.data });
+    }
+    geometry_upload = uploader->flush();
+}
+
+auto Model::select_lod(const Primitive& primitive, const Camera3D& camera, const glm::mat4& model_matrix, f32 viewport_height, f32 error_threshold) const -> PrimitiveLod {
+    if (primitive.lod_count <= 1) {
+        return PrimitiveLod {
+            .first_index = primitive.first_index,
+            .index_count = primitive.index_count,
+            .error = 0.0f,
+        };
+    }
+
+    glm::vec3 aabb_min = { primitive.aabb_min.x, primitive.aabb_min.y, primitive.aabb_min.z };
+    glm::vec3 aabb_max = { primitive.aabb_max.x, primitive.aabb_max.y, primitive.aabb_max.z };
+    f32 scale = std::max({ glm::length(glm::vec3(model_matrix[0])), glm::length(glm::vec3(model_matrix[1])), glm::length(glm::vec3(model_matrix[2])) });
+
+    glm::vec3 center = glm::vec3(model_matrix * glm::vec4((aabb_min + aabb_max) * 0.5f, 1.0f));
+    f32 radius = primitive.bounding_radius * scale;
+    glm::vec3 camera_position = glm::vec3(glm::inverse(camera.view_mat)[3]);
+
+    // distance to the closest point of the bounding sphere, inside of it everything has to be full detail anyway
+    f32 distance = std::max(glm::length(center - camera_position) - radius, camera.near_clip);
+    f32 pixels_per_unit = viewport_height / (2.0f * std::tan(glm::radians(camera.fov) * 0.5f) * distance);
+
+    for (u32 level = primitive.lod_count - 1; level > 0; level--) {
+        const PrimitiveLod& lod = lods[primitive.first_lod + level];
+        if (lod.error * scale * pixels_per_unit <= error_threshold) {
+            return lod;
+        }
+    }
+
+    return lods[primitive.first_lod];
+}
+
+void DeduplicationStatistics::print() const {
+    std::cout << "deduplicated " << image_count - unique_image_count << "/" << image_count << " images (" << static_cast<f64>(duplicate_image_bytes) / (1024.0 * 1024.0) << " MiB encoded), "
+              << material_count - unique_material_count << "/" << material_count << " materials" << std::endl;
+}
+
+void Model::LoadStatistics::print() const {
+    std::cout << "loaded in " << total_time_ms << " ms, geometry " << geometry_time_ms << " ms, textures " << texture_time_ms << " ms, cache " << (cache_hit ? "hit" : "miss") << std::endl;
+    if(mesh_optimization.before.triangle_count != 0) {
+        mesh_optimization.print();
+    }
+    if(lod_count != 0) {
+        std::cout << "generated " << lod_count << " lods in " << lod_time_ms << " ms" << std::endl;
+    }
+    if(meshlets.meshlet_count != 0) {
+        meshlets.print();
+    }
+    if(quantization_error.vertex_count != 0) {
+        quantization_error.print();
+    }
+    if(texture_arrays.image_count != 0) {
+        texture_arrays.print();
+    }
+    upload.print();
+    deduplication.print();
+
+    if(!compression.empty()) {
+        usize uncompressed_bytes = 0;
+        usize compressed_bytes = 0;
+        f64 time_ms = 0.0;
+        u32 cache_hits = 0;
+        for(usize i = 0; i < compression.size(); i++) {
+            compression[i].print("image " + std::to_string(i));
+            uncompressed_bytes += compression[i].uncompressed_bytes;
+            compressed_bytes += compression[i].compressed_bytes;
+            time_ms += compression[i].time_ms;
+            cache_hits += compression[i].cache_hit ? 1 : 0;
+        }
+        std::cout << "compressed " << compression.size() << " textures (" << cache_hits << " from cache) in " << time_ms << " ms of loader time, "
+                  << static_cast<f64>(uncompressed_bytes) / (1024.0 * 1024.0) << " -> " << static_cast<f64>(compressed_bytes) / (1024.0 * 1024.0) << " MiB, saved "
+                  << static_cast<f64>(uncompressed_bytes - std::min(uncompressed_bytes, compressed_bytes)) / (1024.0 * 1024.0) << " MiB" << std::endl;
+    }
+    if(normal_maps.texel_count != 0) {
+        normal_maps.print();
+    }
+
+    if(jobs.job_count != 0) {
+        jobs.print();
+    }
+    const char* names[] = { "high", "normal", "io" };
+    std::cout << "loader lanes:";
+    for(usize i = 0; i < lanes.size(); i++) {
+        std::cout << " " << names[i] << " " << lanes[i].completed << " tasks " << lanes[i].utilization * 100.0 << "% of " << lanes[i].thread_count << " threads" << (i + 1 < lanes.size() ? "," : "");
+    }
+    std::cout << std::endl;
+}
+
+auto Model::LoadProgress::get_fraction() const -> f32 {
+    return texture_count == 0 ? 1.0f : static_cast<f32>(resident_texture_count) / static_cast<f32>(texture_count);
+}
+
+auto Model::LoadProgress::is_complete() const -> bool {
+    return resident_texture_count == texture_count;
+}
+
+auto Model::get_material(u32 material_index) const -> Material {
+    const MaterialInfo& info = material_infos[material_index];
+    Material material = { .textures = device.get_device_address(texture_table_buffer) };
+
+    std::array<i32, MATERIAL_SLOT_COUNT> slots = { info.albedo_image, info.mettalic_roughness_image, info.normal_image, info.occlusion_image, info.emissive_image };
+    for(u32 slot = 0; slot < MATERIAL_SLOT_COUNT; slot++) {
+        if(slots[slot] >= 0) {
+            material.texture_indices[slot] = static_cast<u32>(slots[slot]) + 1;
+            material.flags |= 1u << slot;
+        } else {
+            material.texture_indices[slot] = 0;
+        }
+    }
+    return material;
+}
+
+auto Model::get_material_texture(u32 image_index) const -> MaterialTexture {
+    if(image_resident[image_index] == 0) {
+        return MaterialTexture{ .texture = null_texture->get_texture_id(), .layer = MATERIAL_NO_LAYER };
+    }
+
+    if(image_index < image_placements.size() && image_placements[image_index].array != TextureArrayPlacement::NO_ARRAY) {
+        const TextureArrayPlacement& placement = image_placements[image_index];
+        return MaterialTexture{ .texture = texture_arrays[placement.array]->get_texture_id(), .layer = placement.layer };
+    }
+    return MaterialTexture{ .texture = images[image_index]->get_texture_id(), .layer = MATERIAL_NO_LAYER };
+}
+
+void Model::update() {
+    if(!geometry_buffers.empty()) {
+        restore_geometry();
+    }
+
+    if(!streaming_pool && !texture_streamer) {
+        return;
+    }
+
+    // images that became resident or got a new image from the streamer, their texture table entries need new texture ids
+    std::vector<u32> changed_images = {};
+    bool completed = false;
+    if(streaming_pool) {
+        {
+            const std::scoped_lock lock(streaming_mutex);
+            for(u32 image_index : decoded_images) {
+                pending_images.push_back({ image_index, images[image_index]->upload });
+            }
+            decoded_images.clear();
+        }
+
+        // uploads recorded by the decoding threads sit in the open batch until someone submits it
+        uploader->flush();
+
+        std::erase_if(pending_images, [&](const std::pair<u32, UploadFuture>& pending) {
+            if(!pending.second.is_ready()) {
+                return false;
+            }
+            changed_images.push_back(pending.first);
+            return true;
+        });
+
+        for(u32 image_index : changed_images) {
+            image_resident[image_index] = 1;
+        }
+        resident_image_count += static_cast<u32>(changed_images.size());
+        completed = !changed_images.empty() && get_progress().is_complete();
+    }
+
+    if(texture_streamer) {
+        std::vector<Texture*> swapped = texture_streamer->update();
+        for(u32 image_index = 0; image_index < images.size() && !swapped.empty(); image_index++) {
+            // images that arent resident yet get their current id once they are
+            if(image_resident[image_index] != 0 && std::find(swapped.begin(), swapped.end(), images[image_index].get()) != swapped.end()) {
+                changed_images.push_back(image_index);
+            }
+        }
+    }
+
+    if(changed_images.empty()) {
+        return;
+    }
+
+    // the materials only hold table indices, so one entry per image is all that changes no matter how many use it
+    for(u32 image_index : changed_images) {
+        MaterialTexture& entry = texture_table[image_index + 1];
+        entry = get_material_texture(image_index);
+        uploader->upload_buffer({
+            .buffer = texture_table_buffer,
+            .offset = (image_index + 1) * sizeof(MaterialTexture),
+            .data = std::as_bytes(std::span<const MaterialTexture>{&entry, 1}),
+        });
+    }
+
+    // the replaced images can go once no table entry points at them anymore
+    UploadFuture patched = uploader->flush();
+    if(texture_streamer) {
+        texture_streamer->retire_replaced(patched);
+    }
+
+    if(completed) {
+        statistics.texture_time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - streaming_start).count();
+        statistics.upload = uploader->get_statistics();
+        statistics.normal_maps = get_normal_map_error(images);
+    }
+}
+
+auto Model::get_progress() const -> LoadProgress {
+    return LoadProgress {
+        .texture_count = static_cast<u32>(images.size()),
+        .resident_texture_count = resident_image_count,
+    };
+}
+
+void Model::wait_for_textures() {
+    if(!streaming_pool) {
+        return;
+    }
+
+    streaming_pool->wait_for_tasks();
+    uploader->flush().wait();
+    update();
+    uploader->flush().wait();
+}
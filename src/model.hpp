@@ -6,17 +6,218 @@ using namespace daxa::types;
 #include "common.inl"
 
 #include "texture.hpp"
+#include "vertex_quantization.hpp"
+#include "mesh_optimizer.hpp"
+#include "meshlet_builder.hpp"
+#include "mesh_simplifier.hpp"
+#include "frustum_culling.hpp"
+#include "texture_array_packing.hpp"
+#include "job_graph.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <span>
+
+struct Camera3D;
+class ThreadPool;
+
+// image slots of a glTF material, -1 when the material doesnt use the slot
+struct MaterialInfo {
+    i32 albedo_image = -1;
+    i32 mettalic_roughness_image = -1;
+    i32 normal_image = -1;
+    i32 occlusion_image = -1;
+    i32 emissive_image = -1;
+};
+
+// where the encoded pixels of a glTF image come from, either a file next to the model or embedded bytes
+struct ImageSource {
+    std::string path = {};
+    std::span<const u8> bytes = {};
+    Texture::Type type = Texture::Type::UNORM;
+    // picked from the material slots the image ends up in when the model is loaded with compress_textures
+    bool compress = false;
+    BlockFormat block_format = BlockFormat::BC7;
+    // only ever used through normalTexture and the model is loaded with two_channel_normals, goes to RG8 or BC5
+    bool two_channel_normal = false;
+};
+
+// images are compared by their encoded contents and color space, materials by the image slots they end up with
+struct DeduplicationStatistics {
+    u32 image_count = 0;
+    u32 unique_image_count = 0;
+    // encoded bytes that dont get decoded and uploaded a second time
+    usize duplicate_image_bytes = 0;
+    u32 material_count = 0;
+    u32 unique_material_count = 0;
+
+    void print() const;
+};
+
+// one level of detail of a primitive, indices are relative to the primitives first vertex like the full detail ones.
+// error is how far the simplified surface may be from the original in model units
+struct PrimitiveLod {
+    u32 first_index = 0;
+    u32 index_count = 0;
+    f32 error = 0.0f;
+};
+
+struct ModelLoadInfo {
+    // upload PackedVertex instead of Vertex, shaders have to be compiled with PACKED_VERTICES=1
+    bool packed_vertices = false;
+    // deduplicate vertices and reorder triangles and vertices for the post transform cache, overdraw and fetch locality
+    bool optimize_meshes = false;
+    MeshOptimizeInfo mesh_optimize_info = {};
+    // split every indexed primitive into meshlets and upload them next to the vertex and index buffers
+    bool build_meshlets = false;
+    MeshletBuildInfo meshlet_build_info = {};
+    // simplified index lists per primitive, appended behind the full detail indices in the index buffer
+    bool generate_lods = false;
+    LodBuildInfo lod_build_info = {};
+    // return as soon as the geometry is uploaded, textures keep decoding in the background and get patched into the
+    // material buffer by update while the null texture stands in for them
+    bool stream_textures = false;
+    // encode images to BC7 (color), BC4 (occlusion only) or BC5 (normals, with two_channel_normals) and keep the blocks in
+    // cache/textures, the first load of a model pays for the encoder
+    bool compress_textures = false;
+    // opaque color images go to BC1 instead of BC7, half the size for a visible loss in quality
+    bool prefer_bc1 = false;
+    // images only used as normal maps keep x and y, RG8 or BC5 with compress_textures. only for shaders that rebuild z
+    // with unpack_normal, the others would read 0 out of the blue channel
+    bool two_channel_normals = false;
+    // textures start out with only their coarse levels and the finer ones get streamed in by update when the shaders
+    // sample them, ktx2 files stay fully resident. the cpu keeps every level of every texture around for this
+    bool stream_mips = false;
+    TextureStreamingInfo texture_streaming_info = {};
+    // keeps a cpu copy of the vertex, index and meshlet buffers so the ResourceBudget can drop them once the model went
+    // unseen for a frame. cull returns nothing until update brought them back, so only for samples that draw through cull
+    bool evictable_geometry = false;
+    // copies small textures that share format, size and level count into the layers of shared array images once they
+    // are loaded, fewer image views for the materials to point at. not with stream_textures and never for streamed mips
+    bool pack_small_textures = false;
+    TextureArrayPackingInfo texture_array_packing_info = {};
+};
 
 struct Model {
-    Model(daxa::Device _device, const std::string_view& file_path);
+    struct LoadProgress {
+        u32 texture_count = 0;
+        u32 resident_texture_count = 0;
+
+        auto get_fraction() const -> f32;
+        auto is_complete() const -> bool;
+    };
+
+    struct LoadStatistics {
+        bool cache_hit = false;
+        f64 geometry_time_ms = 0.0;
+        f64 texture_time_ms = 0.0;
+        f64 total_time_ms = 0.0;
+        QuantizationError quantization_error = {};
+        MeshOptimizationStatistics mesh_optimization = {};
+        MeshletStatistics meshlets = {};
+        // lods on top of the full detail ones
+        u32 lod_count = 0;
+        f64 lod_time_ms = 0.0;
+        UploadStatistics upload = {};
+        DeduplicationStatistics deduplication = {};
+        // one per image when compress_textures is set
+        std::vector<CompressionStatistics> compression = {};
+        // RG8 normal maps only, BC5 ones are in compression
+        NormalMapError normal_maps = {};
+        TextureArrayPackingStatistics texture_arrays = {};
+        // the loader runs as a job graph, this is where its wall time went
+        JobGraphStatistics jobs = {};
+        // of the loaders pool, HIGH NORMAL and IO
+        std::array<TaskLaneStatistics, TASK_LANE_COUNT> lanes = {};
+
+        // the loader itself doesnt print anything but errors, this is everything above for the samples that want it.
+        // compression is labeled by image index
+        void print() const;
+    };
+
+    Model(daxa::Device _device, const std::string_view& file_path, const ModelLoadInfo& load_info = {});
     ~Model();
 
+    // picks up streamed textures and mips that finished uploading and patches their texture table entries, call once per frame
+    void update();
+    auto get_progress() const -> LoadProgress;
+    // blocks until every streamed texture is resident
+    void wait_for_textures();
+
+    // fills visible with the primitives inside the frustum of clip_matrix, pass the model view projection or light matrix
+    // the primitives are drawn with so the test runs in model space
+    void cull(const glm::mat4& clip_matrix, VisibleList& visible) const;
+
+    // coarsest level whose error projects to at most error_threshold pixels, the full detail range when there are no lods
+    auto select_lod(const Primitive& primitive, const Camera3D& camera, const glm::mat4& model_matrix, f32 viewport_height, f32 error_threshold = 1.0f) const -> PrimitiveLod;
+
     daxa::Device device = {};
     daxa::BufferId vertex_buffer = {};
     daxa::BufferId index_buffer = {};
     daxa::BufferId material_buffer = {};
+    // MaterialTexture entries the materials index into, the null texture comes first and image i sits at i + 1
+    daxa::BufferId texture_table_buffer = {};
+    daxa::BufferId primitive_buffer = {};
+    // only created when meshlets were built, Primitive::first_meshlet and meshlet_count index meshlet_buffer
+    daxa::BufferId meshlet_buffer = {};
+    daxa::BufferId meshlet_bounds_buffer = {};
+    daxa::BufferId meshlet_vertex_buffer = {};
+    daxa::BufferId meshlet_triangle_buffer = {};
+    bool packed_vertices = false;
 
+    // only with stream_mips, declared ahead of the textures so it outlives them
+    std::unique_ptr<TextureStreamer> texture_streamer = {};
     std::unique_ptr<Texture> null_texture = {};
+    // images that got packed into one of texture_arrays are gone once the constructor returns
     std::vector<std::unique_ptr<Texture>> images = {};
+    std::vector<std::unique_ptr<Texture>> texture_arrays = {};
     std::vector<Primitive> primitives = {};
+    std::vector<Meshlet> meshlets = {};
+    std::vector<MeshletBounds> meshlet_bounds = {};
+    // Primitive::first_lod and lod_count index this, level 0 is the full detail range
+    std::vector<PrimitiveLod> lods = {};
+    // bounds of primitives in structure of arrays form for cull
+    CullingBounds culling_bounds = {};
+
+    LoadStatistics statistics = {};
+
+private:
+    struct GeometryBuffer {
+        daxa::BufferId* buffer;
+        std::string name;
+        std::vector<std::byte> data;
+    };
+
+    auto get_material(u32 material_index) const -> Material;
+    auto get_material_texture(u32 image_index) const -> MaterialTexture;
+    auto evict_geometry() -> usize;
+    void restore_geometry();
+
+    std::vector<MaterialInfo> material_infos = {};
+    // empty unless pack_small_textures was set
+    std::vector<TextureArrayPlacement> image_placements = {};
+    std::vector<MaterialTexture> texture_table = {};
+    std::vector<u8> image_resident = {};
+    u32 resident_image_count = 0;
+
+    std::unique_ptr<UploadManager> uploader = {};
+    std::unique_ptr<ThreadPool> streaming_pool = {};
+    std::vector<ImageSource> streaming_sources = {};
+    std::vector<std::vector<u8>> streaming_bytes = {};
+    std::chrono::steady_clock::time_point streaming_start = {};
+
+    std::mutex streaming_mutex = {};
+    std::vector<u32> decoded_images = {};
+    std::vector<std::pair<u32, UploadFuture>> pending_images = {};
+
+    // only with evictable_geometry, last_used_frame is the ResourceBudget frame cull last found something visible in
+    std::vector<GeometryBuffer> geometry_buffers = {};
+    bool geometry_resident = true;
+    std::optional<UploadFuture> geometry_upload = {};
+    mutable u64 last_used_frame = 0;
+    u32 budget_evictor = 0;
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <filesystem>
+#include <thread>
+
+#include "../model.hpp"
+#include "../model_cache.hpp"
+#include "../texture_compression.hpp"
+#include "../sampler_cache.hpp"
+
+// loads a model without opening a window, first with an empty mesh cache and then warm from it
+auto main(i32 argc, char** argv) -> i32 {
+    std::string_view model_path = argc > 1 ? argv[1] : "assets/Sponza/glTF/Sponza.gltf";
+    u32 warm_iterations = argc > 2 ? static_cast<u32>(std::stoul(argv[2])) : 5;
+
+    daxa::Instance instance = daxa::create_instance({});
+    daxa::Device device = instance.create_device({ .name = "benchmark device" });
+
+    // the detailed statistics only for the loads that had to build everything, the warm ones repeat them
+    auto load = [&](const char* label, bool print_details) -> Model::LoadStatistics {
+        Model::LoadStatistics statistics = {};
+        {
+            Model model(device, model_path);
+            device.wait_idle();
+            statistics = model.statistics;
+        }
+        device.collect_garbage();
+
+        std::cout << label << ": total " << statistics.total_time_ms << " ms, geometry " << statistics.geometry_time_ms << " ms, textures " << statistics.texture_time_ms << " ms, cache " << (statistics.cache_hit ? "hit" : "miss")
+                  << ", " << statistics.upload.batch_count << " upload batches, peak staging " << static_cast<f64>(statistics.upload.peak_staging_bytes) / (1024.0 * 1024.0) << " MiB" << std::endl;
+        if(print_details) {
+            statistics.print();
+        }
+        return statistics;
+    };
+
+    std::error_code error;
+    std::filesystem::remove(ModelCache::get_cache_path(std::filesystem::path(model_path), ModelCache::get_flags({})), error);
+
+    Model::LoadStatistics cold = load("cold", true);
+
+    f64 warm_geometry_time_ms = 0.0;
+    f64 warm_total_time_ms = 0.0;
+    for(u32 i = 0; i < warm_iterations; i++) {
+        Model::LoadStatistics warm = load("warm", false);
+        warm_geometry_time_ms += warm.geometry_time_ms;
+        warm_total_time_ms += warm.total_time_ms;
+    }
+
+    if(warm_iterations > 0) {
+        warm_geometry_time_ms /= static_cast<f64>(warm_iterations);
+        warm_total_time_ms /= static_cast<f64>(warm_iterations);
+        std::cout << "geometry speedup: " << cold.geometry_time_ms / warm_geometry_time_ms << "x, total speedup: " << cold.total_time_ms / warm_total_time_ms << "x" << std::endl;
+    }
+
+    // every texture of every load above went through the cache, all of them should have ended up on one sampler
+    SamplerCache::get().get_statistics().print();
+
+    // block compression once with an empty texture cache and once reading from it
+    {
+        std::filesystem::remove_all(std::filesystem::path("cache") / "textures", error);
+
+        auto load_compressed = [&](const char* label) {
+            Model::LoadStatistics statistics = {};
+            {
+                Model model(device, model_path, ModelLoadInfo { .compress_textures = true });
+                device.wait_idle();
+                statistics = model.statistics;
+            }
+            device.collect_garbage();
+            statistics.print();
+
+            f64 psnr_sum = 0.0;
+            u32 psnr_count = 0;
+            for(const CompressionStatistics& texture : statistics.compression) {
+                if(!texture.cache_hit && std::isfinite(texture.psnr)) {
+                    psnr_sum += texture.psnr;
+                    psnr_count++;
+                }
+            }
+            std::cout << label << ": textures " << statistics.texture_time_ms << " ms, total " << statistics.total_time_ms << " ms";
+            if(psnr_count > 0) {
+                std::cout << ", mean psnr " << psnr_sum / static_cast<f64>(psnr_count) << " dB";
+            }
+            std::cout << std::endl;
+        };
+
+        load_compressed("compressed cold");
+        load_compressed("compressed warm");
+    }
+
+    // time to first frame with streamed textures, then how the textures trickle in
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed_ms = [&] { return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+        Model model(device, model_path, ModelLoadInfo { .stream_textures = true });
+        std::cout << "streaming: geometry ready after " << elapsed_ms() << " ms" << std::endl;
+
+        u32 reported = 0;
+        while(!model.get_progress().is_complete()) {
+            model.update();
+            Model::LoadProgress progress = model.get_progress();
+            if(progress.resident_texture_count != reported) {
+                reported = progress.resident_texture_count;
+                std::cout << "  " << elapsed_ms() << " ms: " << progress.resident_texture_count << "/" << progress.texture_count << " textures resident" << std::endl;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::cout << "streaming: all textures resident after " << elapsed_ms() << " ms" << std::endl;
+        device.wait_idle();
+    }
+    device.collect_garbage();
+
+    return 0;
+}
@@ -0,0 +1,291 @@
+#include "model_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    constexpr usize SECTION_ALIGNMENT = 16;
+
+    struct Section {
+        u64 offset;
+        u64 count;
+    };
+
+    struct Header {
+        u32 magic;
+        u32 version;
+        u32 flags;
+        u64 parameter_hash;
+        i64 source_write_time;
+        Section source_path;
+        Section dependencies;
+        Section vertices;
+        Section indices;
+        Section primitives;
+        Section materials;
+        Section images;
+        Section meshlets;
+        Section meshlet_bounds;
+        Section meshlet_vertices;
+        Section meshlet_triangles;
+        Section lods;
+    };
+
+    struct ImageEntry {
+        u32 type;
+        u32 embedded;
+        Section data;
+    };
+
+    struct DependencyEntry {
+        Section path;
+        i64 write_time;
+    };
+
+    // fnv-1a over the parameter values one by one, stable between runs unlike std::hash and blind to struct padding
+    struct ParameterHasher {
+        u64 hash = 0xcbf29ce484222325ull;
+
+        template <typename T>
+        void add(T value) {
+            u8 bytes[sizeof(T)] = {};
+            std::memcpy(bytes, &value, sizeof(T));
+            for(u8 byte : bytes) {
+                hash = (hash ^ byte) * 0x100000001b3ull;
+            }
+        }
+    };
+
+    auto get_absolute_path(const std::filesystem::path& source_path) -> std::string {
+        std::error_code error;
+        std::filesystem::path absolute_path = std::filesystem::weakly_canonical(source_path, error);
+        return error ? source_path.generic_string() : absolute_path.generic_string();
+    }
+
+    auto get_source_write_time(const std::filesystem::path& source_path) -> i64 {
+        std::error_code error;
+        auto write_time = std::filesystem::last_write_time(source_path, error);
+        return error ? 0 : static_cast<i64>(write_time.time_since_epoch().count());
+    }
+
+    template <typename T>
+    auto get_section(std::span<const u8> file, const Section& section) -> std::span<const T> {
+        if(section.offset % alignof(T) != 0 || section.offset > file.size() || section.count > (file.size() - section.offset) / sizeof(T)) {
+            return {};
+        }
+        return std::span<const T>{reinterpret_cast<const T*>(file.data() + section.offset), static_cast<usize>(section.count)};
+    }
+
+    template <typename T>
+    auto is_valid_section(std::span<const u8> file, const Section& section) -> bool {
+        return section.count == 0 || get_section<T>(file, section).size() == section.count;
+    }
+}
+
+auto ModelCache::get_key(const ModelLoadInfo& load_info) -> Key {
+    Key key = {};
+    ParameterHasher hasher = {};
+    if(load_info.optimize_meshes) {
+        key.flags |= OPTIMIZED_MESHES;
+        hasher.add(load_info.mesh_optimize_info.cache_size);
+        hasher.add(load_info.mesh_optimize_info.overdraw_lambda);
+    }
+    if(load_info.build_meshlets) {
+        key.flags |= MESHLETS;
+        hasher.add(load_info.meshlet_build_info.max_vertices);
+        hasher.add(load_info.meshlet_build_info.max_triangles);
+    }
+    if(load_info.generate_lods) {
+        key.flags |= LODS;
+        const LodBuildInfo& lod_info = load_info.lod_build_info;
+        hasher.add(lod_info.max_lod_count);
+        hasher.add(lod_info.reduction);
+        hasher.add(lod_info.min_triangle_count);
+        hasher.add(lod_info.max_error);
+        hasher.add(lod_info.simplify_info.normal_weight);
+        hasher.add(lod_info.simplify_info.uv_weight);
+        hasher.add(lod_info.simplify_info.lock_borders);
+    }
+    key.parameter_hash = hasher.hash;
+    return key;
+}
+
+auto ModelCache::get_cache_path(const std::filesystem::path& source_path, const Key& key) -> std::filesystem::path {
+    usize path_hash = std::hash<std::string>{}(get_absolute_path(source_path));
+    char hash_string[17] = {};
+    std::snprintf(hash_string, sizeof(hash_string), "%016llx", static_cast<unsigned long long>(path_hash));
+    char parameter_string[17] = {};
+    std::snprintf(parameter_string, sizeof(parameter_string), "%016llx", static_cast<unsigned long long>(key.parameter_hash));
+
+    return std::filesystem::path("cache") / "models" / (source_path.stem().string() + "_" + hash_string + "_" + std::to_string(key.flags) + "_" + parameter_string + ".bin");
+}
+
+auto ModelCache::load(const std::filesystem::path& source_path, const Key& key) -> std::unique_ptr<ModelCache> {
+    std::filesystem::path cache_path = get_cache_path(source_path, key);
+    if(!std::filesystem::exists(cache_path)) {
+        return nullptr;
+    }
+
+    auto cache = std::make_unique<ModelCache>();
+    try {
+        cache->file = std::make_unique<MappedFile>(cache_path);
+    } catch(const std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+        return nullptr;
+    }
+
+    std::span<const u8> file = cache->file->get_data();
+    if(file.size() < sizeof(Header)) {
+        return nullptr;
+    }
+
+    Header header = {};
+    std::memcpy(&header, file.data(), sizeof(Header));
+    if(header.magic != MAGIC || header.version != VERSION || header.flags != key.flags || header.parameter_hash != key.parameter_hash ||
+       header.source_write_time != get_source_write_time(source_path)) {
+        return nullptr;
+    }
+
+    if(!is_valid_section<char>(file, header.source_path) || !is_valid_section<DependencyEntry>(file, header.dependencies) ||
+       !is_valid_section<Vertex>(file, header.vertices) ||
+       !is_valid_section<u32>(file, header.indices) || !is_valid_section<Primitive>(file, header.primitives) ||
+       !is_valid_section<MaterialInfo>(file, header.materials) || !is_valid_section<ImageEntry>(file, header.images) ||
+       !is_valid_section<Meshlet>(file, header.meshlets) || !is_valid_section<MeshletBounds>(file, header.meshlet_bounds) ||
+       !is_valid_section<u32>(file, header.meshlet_vertices) || !is_valid_section<u32>(file, header.meshlet_triangles) ||
+       !is_valid_section<PrimitiveLod>(file, header.lods)) {
+        return nullptr;
+    }
+
+    std::span<const char> cached_path = get_section<char>(file, header.source_path);
+    if(std::string_view{cached_path.data(), cached_path.size()} != get_absolute_path(source_path)) {
+        return nullptr;
+    }
+
+    for(const auto& dependency : get_section<DependencyEntry>(file, header.dependencies)) {
+        std::span<const char> dependency_path = get_section<char>(file, dependency.path);
+        if(dependency_path.size() != dependency.path.count) {
+            return nullptr;
+        }
+        if(get_source_write_time(std::string(dependency_path.data(), dependency_path.size())) != dependency.write_time) {
+            return nullptr;
+        }
+    }
+
+    std::span<const ImageEntry> image_entries = get_section<ImageEntry>(file, header.images);
+    cache->images.reserve(image_entries.size());
+    for(const auto& entry : image_entries) {
+        std::span<const u8> data = get_section<u8>(file, entry.data);
+        if(data.size() != entry.data.count) {
+            return nullptr;
+        }
+
+        ImageSource image = {};
+        image.type = static_cast<Texture::Type>(entry.type);
+        if(entry.embedded != 0) {
+            image.bytes = data;
+        } else {
+            image.path = std::string(reinterpret_cast<const char*>(data.data()), data.size());
+        }
+        cache->images.push_back(std::move(image));
+    }
+
+    cache->contents = Contents {
+        .vertices = get_section<Vertex>(file, header.vertices),
+        .indices = get_section<u32>(file, header.indices),
+        .primitives = get_section<Primitive>(file, header.primitives),
+        .materials = get_section<MaterialInfo>(file, header.materials),
+        .images = cache->images,
+        .meshlets = get_section<Meshlet>(file, header.meshlets),
+        .meshlet_bounds = get_section<MeshletBounds>(file, header.meshlet_bounds),
+        .meshlet_vertices = get_section<u32>(file, header.meshlet_vertices),
+        .meshlet_triangles = get_section<u32>(file, header.meshlet_triangles),
+        .lods = get_section<PrimitiveLod>(file, header.lods),
+    };
+
+    return cache;
+}
+
+void ModelCache::store(const std::filesystem::path& source_path, const Key& key, std::span<const std::filesystem::path> dependencies, const Contents& contents) {
+    std::vector<u8> file(sizeof(Header), 0);
+
+    auto append = [&](const void* data, usize size, usize count) -> Section {
+        file.resize((file.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT, 0);
+        Section section = { .offset = file.size(), .count = count };
+        file.insert(file.end(), static_cast<const u8*>(data), static_cast<const u8*>(data) + size);
+        return section;
+    };
+
+    std::string absolute_path = get_absolute_path(source_path);
+
+    Header header = {
+        .magic = MAGIC,
+        .version = VERSION,
+        .flags = key.flags,
+        .parameter_hash = key.parameter_hash,
+        .source_write_time = get_source_write_time(source_path),
+    };
+    header.source_path = append(absolute_path.data(), absolute_path.size(), absolute_path.size());
+
+    std::vector<DependencyEntry> dependency_entries = {};
+    dependency_entries.reserve(dependencies.size());
+    for(const auto& dependency : dependencies) {
+        std::string dependency_path = get_absolute_path(dependency);
+        dependency_entries.push_back(DependencyEntry {
+            .path = append(dependency_path.data(), dependency_path.size(), dependency_path.size()),
+            .write_time = get_source_write_time(dependency),
+        });
+    }
+    header.dependencies = append(dependency_entries.data(), dependency_entries.size() * sizeof(DependencyEntry), dependency_entries.size());
+    header.vertices = append(contents.vertices.data(), contents.vertices.size_bytes(), contents.vertices.size());
+    header.indices = append(contents.indices.data(), contents.indices.size_bytes(), contents.indices.size());
+    header.primitives = append(contents.primitives.data(), contents.primitives.size_bytes(), contents.primitives.size());
+    header.materials = append(contents.materials.data(), contents.materials.size_bytes(), contents.materials.size());
+    header.meshlets = append(contents.meshlets.data(), contents.meshlets.size_bytes(), contents.meshlets.size());
+    header.meshlet_bounds = append(contents.meshlet_bounds.data(), contents.meshlet_bounds.size_bytes(), contents.meshlet_bounds.size());
+    header.meshlet_vertices = append(contents.meshlet_vertices.data(), contents.meshlet_vertices.size_bytes(), contents.meshlet_vertices.size());
+    header.meshlet_triangles = append(contents.meshlet_triangles.data(), contents.meshlet_triangles.size_bytes(), contents.meshlet_triangles.size());
+    header.lods = append(contents.lods.data(), contents.lods.size_bytes(), contents.lods.size());
+
+    std::vector<ImageEntry> image_entries = {};
+    image_entries.reserve(contents.images.size());
+    for(const auto& image : contents.images) {
+        ImageEntry entry = {
+            .type = static_cast<u32>(image.type),
+            .embedded = image.path.empty() ? 1u : 0u,
+        };
+        if(entry.embedded != 0) {
+            entry.data = append(image.bytes.data(), image.bytes.size(), image.bytes.size());
+        } else {
+            entry.data = append(image.path.data(), image.path.size(), image.path.size());
+        }
+        image_entries.push_back(entry);
+    }
+    header.images = append(image_entries.data(), image_entries.size() * sizeof(ImageEntry), image_entries.size());
+
+    std::memcpy(file.data(), &header, sizeof(Header));
+
+    std::filesystem::path cache_path = get_cache_path(source_path, key);
+    std::filesystem::path temp_path = cache_path;
+    temp_path += ".tmp";
+
+    std::error_code error;
+    std::filesystem::create_directories(cache_path.parent_path(), error);
+
+    {
+        std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+        if(!stream) {
+            std::cerr << "couldn't write model cache: " << temp_path.string() << std::endl;
+            return;
+        }
+        stream.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+    }
+
+    // rename so a crash while writing never leaves a half written cache behind
+    std::filesystem::rename(temp_path, cache_path, error);
+    if(error) {
+        std::cerr << "couldn't write model cache: " << cache_path.string() << std::endl;
+        std::filesystem::remove(temp_path, error);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "model.hpp"
+#include "mapped_file.hpp"
+
+#include <filesystem>
+
+// flattened geometry, material and image tables of a glTF file so warm starts dont have to parse it again
+struct ModelCache {
+    static constexpr u32 MAGIC = 0x48534d47; // "GMSH"
+    static constexpr u32 VERSION = 9;
+
+    // load options that change the cached contents, every combination gets its own cache file
+    static constexpr u32 OPTIMIZED_MESHES = 1 << 0;
+    static constexpr u32 MESHLETS = 1 << 1;
+    static constexpr u32 LODS = 1 << 2;
+
+    // everything besides the source files that decides what ends up in the cache
+    struct Key {
+        u32 flags = 0;
+        // of the build parameters of the passes in flags, a different MeshOptimizeInfo, MeshletBuildInfo or LodBuildInfo
+        // gets its own cache file as well
+        u64 parameter_hash = 0;
+    };
+
+    struct Contents {
+        std::span<const Vertex> vertices = {};
+        std::span<const u32> indices = {};
+        std::span<const Primitive> primitives = {};
+        std::span<const MaterialInfo> materials = {};
+        std::span<const ImageSource> images = {};
+        std::span<const Meshlet> meshlets = {};
+        std::span<const MeshletBounds> meshlet_bounds = {};
+        std::span<const u32> meshlet_vertices = {};
+        std::span<const u32> meshlet_triangles = {};
+        std::span<const PrimitiveLod> lods = {};
+    };
+
+    static auto get_key(const ModelLoadInfo& load_info) -> Key;
+    static auto get_cache_path(const std::filesystem::path& source_path, const Key& key) -> std::filesystem::path;
+    // returns nullptr when there is no cache for the source or it is out of date
+    static auto load(const std::filesystem::path& source_path, const Key& key) -> std::unique_ptr<ModelCache>;
+    // dependencies are the other files the contents came from, like external glTF buffers. the cache goes out of date
+    // when one of them is written to, the same as with the source
+    static void store(const std::filesystem::path& source_path, const Key& key, std::span<const std::filesystem::path> dependencies, const Contents& contents);
+
+    std::unique_ptr<MappedFile> file = {};
+    std::vector<ImageSource> images = {};
+    Contents contents = {};
+};
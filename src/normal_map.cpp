@@ -0,0 +1,109 @@
+#include "normal_map.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    auto normalize(f32vec3 v) -> f32vec3 {
+        f32 length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        if(length <= 1e-12f) {
+            return { 0.0f, 0.0f, 1.0f };
+        }
+        return { v.x / length, v.y / length, v.z / length };
+    }
+
+    auto unpack_unorm(u8 value) -> f32 {
+        return static_cast<f32>(value) / 255.0f * 2.0f - 1.0f;
+    }
+
+    auto pack_unorm(f32 value) -> u8 {
+        return static_cast<u8>(std::clamp(std::round((value * 0.5f + 0.5f) * 255.0f), 0.0f, 255.0f));
+    }
+
+    auto get_angle(f32vec3 a, f32vec3 b) -> f32 {
+        f32 cosine = std::clamp(a.x * b.x + a.y * b.y + a.z * b.z, -1.0f, 1.0f);
+        return std::acos(cosine) * (180.0f / 3.14159265358979f);
+    }
+}
+
+void NormalMapError::merge(const NormalMapError& other) {
+    texel_count += other.texel_count;
+    max_angle_error = std::max(max_angle_error, other.max_angle_error);
+    sum_angle_error += other.sum_angle_error;
+}
+
+void NormalMapError::print() const {
+    f64 count = static_cast<f64>(std::max<usize>(texel_count, 1));
+    std::cout << "two channel normals over " << texel_count << " texels: error max " << max_angle_error << " deg mean " << sum_angle_error / count << " deg" << std::endl;
+}
+
+auto reconstruct_normal(f32 x, f32 y) -> f32vec3 {
+    return { x, y, std::sqrt(std::max(1.0f - x * x - y * y, 0.0f)) };
+}
+
+auto get_normal_map_offsets(u32 size_x, u32 size_y, u32 mip_level_count, usize& total_size) -> std::vector<usize> {
+    std::vector<usize> offsets = {};
+    total_size = 0;
+    for(u32 level = 0; level < mip_level_count; level++) {
+        offsets.push_back(total_size);
+        total_size += static_cast<usize>(std::max(1u, size_x >> level)) * std::max(1u, size_y >> level) * 2;
+    }
+    return offsets;
+}
+
+auto pack_normal_map(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, std::span<u8> destination, std::span<const usize> offsets) -> NormalMapError {
+    NormalMapError error = {};
+    std::vector<f32vec3> level = {};
+    level.reserve(static_cast<usize>(size_x) * size_y);
+
+    u8* output = destination.data() + offsets[0];
+    for(usize i = 0; i < static_cast<usize>(size_x) * size_y; i++) {
+        const u8* texel = pixels.data() + i * channel_count;
+        f32vec3 normal = normalize({ unpack_unorm(texel[0]), unpack_unorm(texel[1]), unpack_unorm(texel[2]) });
+        level.push_back(normal);
+
+        // what the shader gets back is the 8 bit x and y, not the exact ones
+        output[i * 2 + 0] = texel[0];
+        output[i * 2 + 1] = texel[1];
+        f32 angle = get_angle(normal, reconstruct_normal(unpack_unorm(texel[0]), unpack_unorm(texel[1])));
+        error.max_angle_error = std::max(error.max_angle_error, angle);
+        error.sum_angle_error += angle;
+    }
+    error.texel_count = level.size();
+
+    u32 level_size_x = size_x;
+    u32 level_size_y = size_y;
+    std::vector<f32vec3> next = {};
+    for(usize mip = 1; mip < offsets.size(); mip++) {
+        u32 next_size_x = std::max(1u, level_size_x >> 1);
+        u32 next_size_y = std::max(1u, level_size_y >> 1);
+        next.resize(static_cast<usize>(next_size_x) * next_size_y);
+        output = destination.data() + offsets[mip];
+
+        // odd sizes drop the last row or column like the box filter of the color chains does
+        for(u32 y = 0; y < next_size_y; y++) {
+            for(u32 x = 0; x < next_size_x; x++) {
+                u32 x0 = std::min(x * 2, level_size_x - 1);
+                u32 x1 = std::min(x * 2 + 1, level_size_x - 1);
+                u32 y0 = std::min(y * 2, level_size_y - 1);
+                u32 y1 = std::min(y * 2 + 1, level_size_y - 1);
+                f32vec3 a = level[static_cast<usize>(y0) * level_size_x + x0];
+                f32vec3 b = level[static_cast<usize>(y0) * level_size_x + x1];
+                f32vec3 c = level[static_cast<usize>(y1) * level_size_x + x0];
+                f32vec3 d = level[static_cast<usize>(y1) * level_size_x + x1];
+                f32vec3 normal = normalize({ a.x + b.x + c.x + d.x, a.y + b.y + c.y + d.y, a.z + b.z + c.z + d.z });
+
+                usize index = static_cast<usize>(y) * next_size_x + x;
+                next[index] = normal;
+                output[index * 2 + 0] = pack_unorm(normal.x);
+                output[index * 2 + 1] = pack_unorm(normal.y);
+            }
+        }
+
+        std::swap(level, next);
+        level_size_x = next_size_x;
+        level_size_y = next_size_y;
+    }
+    return error;
+}
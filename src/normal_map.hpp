@@ -0,0 +1,27 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <span>
+#include <vector>
+
+// angle between the normals of the source texels and what unpack_normal rebuilds out of their RG8 version, in degrees
+struct NormalMapError {
+    usize texel_count = 0;
+    f32 max_angle_error = 0.0f;
+    f64 sum_angle_error = 0.0;
+
+    void merge(const NormalMapError& other);
+    void print() const;
+};
+
+// the same math as unpack_normal in common.inl, x and y are already in -1 to 1
+auto reconstruct_normal(f32 x, f32 y) -> f32vec3;
+
+// where every level of a tightly packed RG8 chain starts, total_size is the size of the whole chain
+auto get_normal_map_offsets(u32 size_x, u32 size_y, u32 mip_level_count, usize& total_size) -> std::vector<usize>;
+// writes the whole chain as RG8 x and y into destination at offsets. pixels is an RGB8 or RGBA8 tangent space normal map,
+// the smaller levels average the unpacked normals and renormalize them so they dont flatten out towards the horizon.
+// destination is only written in order, so it can be mapped staging memory. returns the error of level 0
+auto pack_normal_map(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, std::span<u8> destination, std::span<const usize> offsets) -> NormalMapError;
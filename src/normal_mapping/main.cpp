@@ -12,6 +12,7 @@
 #include <imgui_impl_glfw.h>
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
 
 struct RenderTask {
     struct Uses {
@@ -145,7 +146,7 @@ struct NormalMappingApp : public App {
             .push_constant_size = sizeof(DrawPush),
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -160,15 +161,17 @@ struct NormalMappingApp : public App {
 
         camera.camera.resize(size_x, size_y);
 
-        model = std::make_unique<Model>(device, "assets/stone_wall/stone_wall.gltf");
+        model = std::make_unique<Model>(device, "assets/stone_wall/stone_wall.gltf", ModelLoadInfo {
+            .two_channel_normals = true,
+        });
 
-        camera_buffer = device.create_buffer(daxa::BufferInfo {
+        camera_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(CameraInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "camera buffer"
         });
 
-        object_buffer = device.create_buffer(daxa::BufferInfo {
+        object_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(ObjectInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "object buffer"
@@ -211,9 +214,9 @@ struct NormalMappingApp : public App {
     }
 
     ~NormalMappingApp() {
-        device.destroy_image(depth_image);
-        device.destroy_buffer(camera_buffer);
-        device.destroy_buffer(object_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_buffer(device, camera_buffer);
+        ResourceBudget::get().destroy_buffer(device, object_buffer);
     }
 
     void render() {
@@ -324,8 +327,8 @@ struct NormalMappingApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -38,11 +38,11 @@ layout(location = 4) in f32vec3 in_bittangent;
 layout(location = 0) out f32vec4 out_color;
 
 void main() {
-    f32vec3 color = sample_texture(MATERIAL.albedo_image, in_uv).rgb;
+    f32vec3 color = sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb;
 
 #if USE_NORMAL_MAPPING == 1
 #if USE_DERIVATIVES == 1
-    f32vec3 tangent_normal = sample_texture(MATERIAL.normal_image, in_uv).xyz * 2.0 - 1.0;
+    f32vec3 tangent_normal = unpack_normal(sample_material(MATERIAL, MATERIAL_NORMAL, in_uv).xy);
 
     f32vec3 Q1  = dFdx(in_position);
     f32vec3 Q2  = dFdy(in_position);
@@ -57,7 +57,7 @@ void main() {
 
     f32vec3 normal = normalize(TBN * tangent_normal);
 #else
-    f32vec3 tangent_normal = sample_texture(MATERIAL.normal_image, in_uv).xyz * 2.0 - 1.0;
+    f32vec3 tangent_normal = unpack_normal(sample_material(MATERIAL, MATERIAL_NORMAL, in_uv).xy);
 
     f32vec3 T = normalize(in_tangent);
     f32vec3 B = normalize(in_bittangent);
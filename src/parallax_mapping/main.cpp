@@ -12,6 +12,7 @@
 #include <imgui_impl_glfw.h>
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
 
 struct RenderTask {
     struct Uses {
@@ -165,7 +166,7 @@ struct ParallaxMappingApp : public App {
             .push_constant_size = sizeof(DrawPush),
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -179,16 +180,18 @@ struct ParallaxMappingApp : public App {
 
         camera.camera.resize(size_x, size_y);
 
-        model = std::make_unique<Model>(device, "assets/parallax_cube/parallax_cube.gltf");
+        model = std::make_unique<Model>(device, "assets/parallax_cube/parallax_cube.gltf", ModelLoadInfo {
+            .two_channel_normals = true,
+        });
         heightmap_texture = std::make_unique<Texture>(device, "assets/parallax_cube/parallax_cube_heightmap.png", Texture::Type::UNORM);
         
-        camera_buffer = device.create_buffer(daxa::BufferInfo {
+        camera_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(CameraInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "camera buffer"
         });
 
-        object_buffer = device.create_buffer(daxa::BufferInfo {
+        object_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(ObjectInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "object buffer"
@@ -235,9 +238,9 @@ struct ParallaxMappingApp : public App {
     }
 
     ~ParallaxMappingApp() {
-        device.destroy_image(depth_image);
-        device.destroy_buffer(camera_buffer);
-        device.destroy_buffer(object_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_buffer(device, camera_buffer);
+        ResourceBudget::get().destroy_buffer(device, object_buffer);
     }
 
     void render() {
@@ -289,12 +292,16 @@ struct ParallaxMappingApp : public App {
             
             if(ImGui::Combo("model", &model_index, models.data(), static_cast<u32>(models.size()), static_cast<u32>(models.size()))) {
                 if(model_index == 0) {
-                    model = std::make_unique<Model>(device, "assets/parallax_cube/parallax_cube.gltf");
+                    model = std::make_unique<Model>(device, "assets/parallax_cube/parallax_cube.gltf", ModelLoadInfo {
+                        .two_channel_normals = true,
+                    });
                     heightmap_texture = std::make_unique<Texture>(device, "assets/parallax_cube/parallax_cube_heightmap.png", Texture::Type::UNORM);
                 }
 
                 if(model_index == 1) {
-                    model = std::make_unique<Model>(device, "assets/brick_wall/brick_wall.gltf");
+                    model = std::make_unique<Model>(device, "assets/brick_wall/brick_wall.gltf", ModelLoadInfo {
+                        .two_channel_normals = true,
+                    });
                     heightmap_texture = std::make_unique<Texture>(device, "assets/brick_wall/brick_wall_heightmap.png", Texture::Type::UNORM);
                 }
             }
@@ -344,8 +351,8 @@ struct ParallaxMappingApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -148,7 +148,7 @@ f32vec2 contact_refinement_parallax_mapping(f32vec2 uv, f32vec3 view_direction)
 void main() {
     f32vec2 uv = in_uv;
 #if MAPPING_MODE == 0
-    out_color = f32vec4(sample_texture(MATERIAL.albedo_image, uv).rgb, 1.0);
+    out_color = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, uv).rgb, 1.0);
 #else
     f32vec3 tangent_view_direction = normalize(in_tangent_camera_position - in_tangent_frag_position);
 #endif
@@ -168,9 +168,9 @@ void main() {
 #if MAPPING_MODE != 0
     if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) { discard; }
 
-    f32vec3 color = sample_texture(MATERIAL.albedo_image, uv).rgb;
+    f32vec3 color = sample_material(MATERIAL, MATERIAL_ALBEDO, uv).rgb;
 
-    f32vec3 tangent_normal = sample_texture(MATERIAL.normal_image, uv).xyz * 2.0 - 1.0;
+    f32vec3 tangent_normal = unpack_normal(sample_material(MATERIAL, MATERIAL_NORMAL, uv).xy);
     f32vec3 normal = normalize(tangent_normal);
 
     f32vec3 light_direction = normalize(in_tangent_light_position - in_tangent_frag_position);
@@ -140,7 +140,7 @@ f32 shadow_pcss(daxa_ImageViewId shadow_image, daxa_SamplerId shadow_sampler, f3
 
 void main() {
 
-    f32vec3 color = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0).rgb;
+    f32vec3 color = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0).rgb;
     color *= push.shadow_intensity;
     f32 bias = deref(push.light_buffer).bias;
 
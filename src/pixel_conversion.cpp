@@ -0,0 +1,60 @@
+#include "pixel_conversion.hpp"
+#include "threadpool.hpp"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#define PIXEL_CONVERSION_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#define PIXEL_CONVERSION_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+namespace {
+    // 256 KiB of rgba per chunk, a lot more than what a split costs and small enough for the first split to come early
+    constexpr usize PIXEL_GRAIN_SIZE = 1 << 16;
+}
+
+void expand_rgb_to_rgba(const u8* rgb, u8* rgba, usize pixel_count, bool allow_simd) {
+    usize i = 0;
+
+    // every load reads 16 bytes for 4 pixels worth 12, the loops stop early enough to never read past the end
+#if defined(PIXEL_CONVERSION_AVX2)
+    if(allow_simd) {
+        const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i alpha = _mm256_set1_epi32(static_cast<i32>(0xFF000000));
+        for(; i + 10 <= pixel_count; i += 8) {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3 + 12));
+            __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+        }
+    }
+#elif defined(PIXEL_CONVERSION_SSSE3)
+    if(allow_simd) {
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<i32>(0xFF000000));
+        for(; i + 6 <= pixel_count; i += 4) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+        }
+    }
+#endif
+
+    for(; i < pixel_count; i++) {
+        std::memcpy(rgba + i * 4, rgb + i * 3, 3);
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+void expand_rgb_to_rgba(ThreadPool* pool, const u8* rgb, u8* rgba, usize pixel_count) {
+    if(pool == nullptr) {
+        expand_rgb_to_rgba(rgb, rgba, pixel_count);
+        return;
+    }
+
+    pool->parallel_for(0, pixel_count, PIXEL_GRAIN_SIZE, [&](usize begin, usize end) {
+        expand_rgb_to_rgba(rgb + begin * 3, rgba + begin * 4, end - begin);
+    });
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+class ThreadPool;
+
+// RGB8 to RGBA8 with an opaque alpha, rgba is only written in order so it can point into mapped staging memory
+void expand_rgb_to_rgba(const u8* rgb, u8* rgba, usize pixel_count, bool allow_simd = true);
+// the same with the pixels split over pool with parallel_for, each chunk still writes in order. runs right here without one
+void expand_rgb_to_rgba(ThreadPool* pool, const u8* rgb, u8* rgba, usize pixel_count);
@@ -10,6 +10,8 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 
 #include <daxa/utils/imgui.hpp>
 #include <imgui.h>
@@ -265,7 +267,7 @@ struct ReflectiveShadowApp : public App {
             .name = "shadow pipeline"
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -278,7 +280,7 @@ struct ReflectiveShadowApp : public App {
             .name = "task depth image"
         }};
 
-        shadow_depth = device.create_image({
+        shadow_depth = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { 1024, 1024, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -290,7 +292,7 @@ struct ReflectiveShadowApp : public App {
             .name = "task shadow depth image"
         }};
 
-        shadow_normal = device.create_image({
+        shadow_normal = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::R16G16B16A16_SFLOAT,
             .size = { 1024, 1024, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -302,7 +304,7 @@ struct ReflectiveShadowApp : public App {
             .name = "task shadow normal image"
         }};
 
-        shadow_flux = device.create_image({
+        shadow_flux = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = swapchain.get_format(),
             .size = { 1024, 1024, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -314,7 +316,7 @@ struct ReflectiveShadowApp : public App {
             .name = "task shadow flux image"
         }};
 
-        shadow_sampler = device.create_sampler(daxa::SamplerInfo {
+        shadow_sampler = SamplerCache::get().acquire(device, daxa::SamplerInfo {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -332,7 +334,7 @@ struct ReflectiveShadowApp : public App {
             .enable_unnormalized_coordinates = false,
         });
 
-        image_sampler = device.create_sampler(daxa::SamplerInfo {
+        image_sampler = SamplerCache::get().acquire(device, daxa::SamplerInfo {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -350,13 +352,13 @@ struct ReflectiveShadowApp : public App {
             .enable_unnormalized_coordinates = false,
         });
 
-        model_buffer = device.create_buffer(daxa::BufferInfo {
+        model_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(ModelInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "model buffer"
         });
 
-        light_buffer = device.create_buffer(daxa::BufferInfo {
+        light_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(LightInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "light buffer"
@@ -426,14 +428,14 @@ struct ReflectiveShadowApp : public App {
     }
 
     ~ReflectiveShadowApp() {
-        device.destroy_image(depth_image);
-        device.destroy_image(shadow_depth);
-        device.destroy_image(shadow_normal);
-        device.destroy_image(shadow_flux);
-        device.destroy_sampler(shadow_sampler);
-        device.destroy_sampler(image_sampler);
-        device.destroy_buffer(light_buffer);
-        device.destroy_buffer(model_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_image(device, shadow_depth);
+        ResourceBudget::get().destroy_image(device, shadow_normal);
+        ResourceBudget::get().destroy_image(device, shadow_flux);
+        SamplerCache::get().release(device, shadow_sampler);
+        SamplerCache::get().release(device, image_sampler);
+        ResourceBudget::get().destroy_buffer(device, light_buffer);
+        ResourceBudget::get().destroy_buffer(device, model_buffer);
     }
 
     void render() {
@@ -545,8 +547,8 @@ struct ReflectiveShadowApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
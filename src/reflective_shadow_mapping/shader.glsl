@@ -89,7 +89,7 @@ void main() {
     f32vec4 shadow_coord = in_position_shadow / in_position_shadow.w;
     shadow_coord.xy = shadow_coord.xy * 0.5 + 0.5;
 
-    f32vec3 albedo = sample_texture(MATERIAL.albedo_image, in_uv).rgb;
+    f32vec3 albedo = sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb;
     f32vec3 ambient = f32vec3(push.shadow_intensity);
 
 #if USE_PCF == 0
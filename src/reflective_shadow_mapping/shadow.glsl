@@ -25,7 +25,7 @@ layout(location = 1) out f32vec4 out_flux;
 
 void main() {
     out_normal = f32vec4(normalize(in_normal), 1.0);
-    out_flux = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb * max(0.0, dot(out_normal.rgb, -deref(push.light_buffer).light_direction)), 1.0);
+    out_flux = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb * max(0.0, dot(out_normal.rgb, -deref(push.light_buffer).light_direction)), 1.0);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "resource_budget.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace {
+    // bytes per texel, or per 4x4 block for the block compressed formats
+    auto get_format_size(daxa::Format format, bool& block_compressed) -> usize {
+        block_compressed = false;
+        switch(format) {
+            case daxa::Format::R8_UNORM: return 1;
+            case daxa::Format::R8G8_UNORM: return 2;
+            case daxa::Format::R16G16_UNORM: return 4;
+            case daxa::Format::R16G16B16A16_SFLOAT: return 8;
+            case daxa::Format::R32G32B32A32_SFLOAT: return 16;
+            case daxa::Format::D32_SFLOAT: return 4;
+            case daxa::Format::BC1_RGB_UNORM_BLOCK:
+            case daxa::Format::BC1_RGB_SRGB_BLOCK:
+            case daxa::Format::BC4_UNORM_BLOCK:
+                block_compressed = true;
+                return 8;
+            case daxa::Format::BC5_UNORM_BLOCK:
+            case daxa::Format::BC7_UNORM_BLOCK:
+            case daxa::Format::BC7_SRGB_BLOCK:
+                block_compressed = true;
+                return 16;
+            // RGBA8, BGRA8 swapchain formats and the rest of the 32 bit ones
+            default: return 4;
+        }
+    }
+
+    auto to_mib(usize bytes) -> f64 {
+        return static_cast<f64>(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+auto get_resource_category_name(ResourceCategory category) -> const char* {
+    switch(category) {
+        case ResourceCategory::TEXTURE: return "texture";
+        case ResourceCategory::GEOMETRY: return "geometry";
+        case ResourceCategory::STAGING: return "staging";
+        case ResourceCategory::RENDER_TARGET: return "render_target";
+        case ResourceCategory::OTHER: return "other";
+    }
+    return "unknown";
+}
+
+auto get_image_memory_size(const daxa::ImageInfo& info) -> usize {
+    bool block_compressed = false;
+    usize format_size = get_format_size(info.format, block_compressed);
+
+    usize size = 0;
+    for(u32 level = 0; level < std::max(info.mip_level_count, 1u); level++) {
+        usize x = std::max(1u, info.size.x >> level);
+        usize y = std::max(1u, info.size.y >> level);
+        usize z = std::max(1u, info.size.z >> level);
+        if(block_compressed) {
+            x = (x + 3) / 4;
+            y = (y + 3) / 4;
+        }
+        size += x * y * z * format_size;
+    }
+    return size * std::max(info.array_layer_count, 1u) * std::max(info.sample_count, 1u);
+}
+
+auto ResourceBudgetStatistics::get_total_bytes() const -> usize {
+    usize total = 0;
+    for(usize category_bytes : bytes) {
+        total += category_bytes;
+    }
+    return total;
+}
+
+void ResourceBudgetStatistics::print() const {
+    std::cout << "device memory: " << to_mib(get_total_bytes()) << " MiB";
+    if(budget_bytes != 0) {
+        std::cout << " of a " << to_mib(budget_bytes) << " MiB budget";
+    }
+    std::cout << ", peak " << to_mib(peak_bytes) << " MiB";
+    for(u32 category = 0; category < RESOURCE_CATEGORY_COUNT; category++) {
+        std::cout << "\n  " << get_resource_category_name(static_cast<ResourceCategory>(category)) << " " << to_mib(bytes[category]) << " MiB in " << allocations[category] << " allocations";
+    }
+    std::cout << "\n  " << texture_evictions << " texture evictions " << mesh_evictions << " mesh evictions, " << to_mib(evicted_bytes) << " MiB evicted, " << frames_over_budget << " frames over budget" << std::endl;
+}
+
+auto ResourceBudgetStatistics::to_json() const -> std::string {
+    std::ostringstream json = {};
+    json << "{\"budget_bytes\":" << budget_bytes << ",\"total_bytes\":" << get_total_bytes() << ",\"peak_bytes\":" << peak_bytes << ",\"categories\":{";
+    for(u32 category = 0; category < RESOURCE_CATEGORY_COUNT; category++) {
+        json << (category == 0 ? "" : ",") << "\"" << get_resource_category_name(static_cast<ResourceCategory>(category)) << "\":{\"bytes\":" << bytes[category] << ",\"allocations\":" << allocations[category] << "}";
+    }
+    json << "},\"frames_over_budget\":" << frames_over_budget << ",\"texture_evictions\":" << texture_evictions << ",\"mesh_evictions\":" << mesh_evictions << ",\"evicted_bytes\":" << evicted_bytes << "}";
+    return json.str();
+}
+
+auto ResourceBudget::get() -> ResourceBudget& {
+    static ResourceBudget budget = {};
+    return budget;
+}
+
+void ResourceBudget::set_budget(usize bytes) {
+    const std::scoped_lock lock(mutex);
+    statistics.budget_bytes = bytes;
+}
+
+auto ResourceBudget::fits(usize bytes) const -> bool {
+    const std::scoped_lock lock(mutex);
+    return statistics.budget_bytes == 0 || statistics.get_total_bytes() + bytes <= statistics.budget_bytes;
+}
+
+auto ResourceBudget::get_available() const -> usize {
+    const std::scoped_lock lock(mutex);
+    if(statistics.budget_bytes == 0) {
+        return std::numeric_limits<usize>::max();
+    }
+    return statistics.budget_bytes - std::min(statistics.budget_bytes, statistics.get_total_bytes());
+}
+
+auto ResourceBudget::create_buffer(daxa::Device& device, ResourceCategory category, const daxa::BufferInfo& info) -> daxa::BufferId {
+    daxa::BufferId buffer = device.create_buffer(info);
+    add_allocation({ .buffer = buffer, .image = {}, .category = category, .size = static_cast<usize>(info.size), .releasing = false });
+    return buffer;
+}
+
+auto ResourceBudget::create_image(daxa::Device& device, ResourceCategory category, const daxa::ImageInfo& info) -> daxa::ImageId {
+    daxa::ImageId image = device.create_image(info);
+    add_allocation({ .buffer = {}, .image = image, .category = category, .size = get_image_memory_size(info), .releasing = false });
+    return image;
+}
+
+void ResourceBudget::destroy_buffer(daxa::Device& device, daxa::BufferId buffer) {
+    if(buffer.is_empty()) {
+        return;
+    }
+
+    {
+        const std::scoped_lock lock(mutex);
+        auto iterator = std::find_if(allocations.begin(), allocations.end(), [&](const Allocation& allocation) { return allocation.image.is_empty() && allocation.buffer == buffer; });
+        if(iterator != allocations.end()) {
+            if(iterator->releasing) {
+                releasing_bytes -= std::min(releasing_bytes, iterator->size);
+            }
+            statistics.bytes[static_cast<u32>(iterator->category)] -= iterator->size;
+            statistics.allocations[static_cast<u32>(iterator->category)]--;
+            *iterator = allocations.back();
+            allocations.pop_back();
+        }
+    }
+    device.destroy_buffer(buffer);
+}
+
+void ResourceBudget::destroy_image(daxa::Device& device, daxa::ImageId image) {
+    if(image.is_empty()) {
+        return;
+    }
+
+    {
+        const std::scoped_lock lock(mutex);
+        auto iterator = std::find_if(allocations.begin(), allocations.end(), [&](const Allocation& allocation) { return allocation.buffer.is_empty() && allocation.image == image; });
+        if(iterator != allocations.end()) {
+            if(iterator->releasing) {
+                releasing_bytes -= std::min(releasing_bytes, iterator->size);
+            }
+            statistics.bytes[static_cast<u32>(iterator->category)] -= iterator->size;
+            statistics.allocations[static_cast<u32>(iterator->category)]--;
+            *iterator = allocations.back();
+            allocations.pop_back();
+        }
+    }
+    device.destroy_image(image);
+}
+
+void ResourceBudget::mark_releasing(daxa::ImageId image) {
+    const std::scoped_lock lock(mutex);
+    auto iterator = std::find_if(allocations.begin(), allocations.end(), [&](const Allocation& allocation) { return allocation.buffer.is_empty() && allocation.image == image; });
+    if(iterator != allocations.end() && !iterator->releasing) {
+        iterator->releasing = true;
+        releasing_bytes += iterator->size;
+    }
+}
+
+auto ResourceBudget::add_evictor(ResourceCategory category, LastUsedFunction last_used, EvictFunction evict) -> u32 {
+    const std::scoped_lock lock(mutex);
+    u32 id = next_evictor_id++;
+    evictors.push_back({ .id = id, .category = category, .last_used = std::move(last_used), .evict = std::move(evict) });
+    return id;
+}
+
+void ResourceBudget::remove_evictor(u32 id) {
+    const std::scoped_lock lock(mutex);
+    std::erase_if(evictors, [&](const Evictor& evictor) { return evictor.id == id; });
+}
+
+void ResourceBudget::update() {
+    std::vector<Evictor> candidates = {};
+    usize needed = 0;
+    {
+        const std::scoped_lock lock(mutex);
+        frame++;
+        usize total = statistics.get_total_bytes();
+        if(statistics.budget_bytes == 0 || total <= statistics.budget_bytes) {
+            return;
+        }
+        statistics.frames_over_budget++;
+
+        // evicted textures only shrink once their smaller image is swapped in, without this every frame in between would
+        // evict again and the meshes would go too
+        if(total - std::min(total, releasing_bytes) <= statistics.budget_bytes) {
+            return;
+        }
+        needed = total - releasing_bytes - statistics.budget_bytes;
+        candidates = evictors;
+    }
+
+    // the evictors destroy through this again, so they run without the lock
+    std::sort(candidates.begin(), candidates.end(), [](const Evictor& a, const Evictor& b) {
+        bool a_texture = a.category == ResourceCategory::TEXTURE;
+        bool b_texture = b.category == ResourceCategory::TEXTURE;
+        return a_texture != b_texture ? a_texture : a.last_used() < b.last_used();
+    });
+
+    usize freed = 0;
+    for(Evictor& evictor : candidates) {
+        if(freed >= needed) {
+            break;
+        }
+
+        usize bytes = evictor.evict(needed - freed);
+        if(bytes == 0) {
+            continue;
+        }
+        freed += bytes;
+
+        const std::scoped_lock lock(mutex);
+        statistics.evicted_bytes += bytes;
+        if(evictor.category == ResourceCategory::TEXTURE) {
+            statistics.texture_evictions++;
+        } else {
+            statistics.mesh_evictions++;
+        }
+    }
+}
+
+auto ResourceBudget::get_frame() const -> u64 {
+    const std::scoped_lock lock(mutex);
+    return frame;
+}
+
+auto ResourceBudget::get_statistics() const -> ResourceBudgetStatistics {
+    const std::scoped_lock lock(mutex);
+    return statistics;
+}
+
+void ResourceBudget::draw_imgui() const {
+    ResourceBudgetStatistics current = get_statistics();
+    usize total = current.get_total_bytes();
+
+    ImGui::Begin("Device Memory");
+    if(current.budget_bytes != 0) {
+        f32 fraction = static_cast<f32>(static_cast<f64>(total) / static_cast<f64>(current.budget_bytes));
+        std::string label = std::to_string(static_cast<u32>(to_mib(total))) + " / " + std::to_string(static_cast<u32>(to_mib(current.budget_bytes))) + " MiB";
+        ImGui::ProgressBar(std::min(fraction, 1.0f), ImVec2(-1.0f, 0.0f), label.c_str());
+    } else {
+        ImGui::Text("%.1f MiB, no budget", to_mib(total));
+    }
+    ImGui::Text("peak %.1f MiB", to_mib(current.peak_bytes));
+    for(u32 category = 0; category < RESOURCE_CATEGORY_COUNT; category++) {
+        ImGui::Text("%s: %.1f MiB in %u allocations", get_resource_category_name(static_cast<ResourceCategory>(category)), to_mib(current.bytes[category]), current.allocations[category]);
+    }
+    ImGui::Text("evictions: %llu texture %llu mesh, %.1f MiB", static_cast<unsigned long long>(current.texture_evictions), static_cast<unsigned long long>(current.mesh_evictions), to_mib(current.evicted_bytes));
+    ImGui::Text("frames over budget: %llu", static_cast<unsigned long long>(current.frames_over_budget));
+    ImGui::End();
+}
+
+void ResourceBudget::dump(const std::filesystem::path& path) const {
+    std::ofstream file(path);
+    if(!file) {
+        throw std::runtime_error("couldn't write resource budget dump to " + path.string());
+    }
+    file << get_statistics().to_json() << std::endl;
+}
+
+void ResourceBudget::add_allocation(const Allocation& allocation) {
+    const std::scoped_lock lock(mutex);
+    allocations.push_back(allocation);
+    statistics.bytes[static_cast<u32>(allocation.category)] += allocation.size;
+    statistics.allocations[static_cast<u32>(allocation.category)]++;
+    statistics.peak_bytes = std::max(statistics.peak_bytes, statistics.get_total_bytes());
+}
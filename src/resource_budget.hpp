@@ -0,0 +1,117 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <array>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class ResourceCategory : u8 {
+    // model textures, streamed or not
+    TEXTURE = 0,
+    // vertex, index and meshlet buffers
+    GEOMETRY = 1,
+    // upload rings and their oversized buffers
+    STAGING = 2,
+    // images the samples render into, shadow maps included
+    RENDER_TARGET = 3,
+    // material and primitive tables, uniforms, light lists and whatever else the samples allocate
+    OTHER = 4,
+};
+
+inline constexpr u32 RESOURCE_CATEGORY_COUNT = 5;
+
+auto get_resource_category_name(ResourceCategory category) -> const char*;
+// what the image takes with all of its levels, layers and samples. an estimate, the driver may pad and align on top of it
+auto get_image_memory_size(const daxa::ImageInfo& info) -> usize;
+
+struct ResourceBudgetStatistics {
+    // 0 when there is no budget
+    usize budget_bytes = 0;
+    std::array<usize, RESOURCE_CATEGORY_COUNT> bytes = {};
+    std::array<u32, RESOURCE_CATEGORY_COUNT> allocations = {};
+    usize peak_bytes = 0;
+    u64 frames_over_budget = 0;
+    // evictor calls that gave memory back, one texture eviction can drop the mips of many textures at once
+    u64 texture_evictions = 0;
+    u64 mesh_evictions = 0;
+    usize evicted_bytes = 0;
+
+    auto get_total_bytes() const -> usize;
+    void print() const;
+    // one json object, meant for scripts that compare runs
+    auto to_json() const -> std::string;
+};
+
+// counts every buffer and image that goes through it per category and keeps the total under a budget by asking the
+// registered evictors to give memory back. texture mips go before whole meshes, both least recently used first.
+// one per process like the sampler cache, creating and destroying can happen from any thread but update, the evictors
+// and the panel belong to the render thread
+struct ResourceBudget {
+    // gets bytes to free at least, returns what it actually freed
+    using EvictFunction = std::function<usize(usize)>;
+    // the ResourceBudget frame the resources behind the evictor were last used in
+    using LastUsedFunction = std::function<u64()>;
+
+    static auto get() -> ResourceBudget&;
+
+    // 0 turns it off, nothing gets evicted then
+    void set_budget(usize bytes);
+    // whether bytes more still fit, streaming code asks before it grows anything
+    auto fits(usize bytes) const -> bool;
+    // what is left under the budget, the largest usize without one
+    auto get_available() const -> usize;
+
+    auto create_buffer(daxa::Device& device, ResourceCategory category, const daxa::BufferInfo& info) -> daxa::BufferId;
+    auto create_image(daxa::Device& device, ResourceCategory category, const daxa::ImageInfo& info) -> daxa::ImageId;
+    // empty ids are ignored like daxa does
+    void destroy_buffer(daxa::Device& device, daxa::BufferId buffer);
+    void destroy_image(daxa::Device& device, daxa::ImageId image);
+    // for evictors that only destroy an image some frames later, update counts it as gone from then on so those frames
+    // dont evict for it again
+    void mark_releasing(daxa::ImageId image);
+
+    // category is TEXTURE or GEOMETRY, the returned id removes it again
+    auto add_evictor(ResourceCategory category, LastUsedFunction last_used, EvictFunction evict) -> u32;
+    void remove_evictor(u32 id);
+
+    // starts the next frame and evicts until the total is back under the budget, call once per frame
+    void update();
+    auto get_frame() const -> u64;
+
+    auto get_statistics() const -> ResourceBudgetStatistics;
+    void draw_imgui() const;
+    void dump(const std::filesystem::path& path) const;
+
+private:
+    struct Allocation {
+        daxa::BufferId buffer;
+        daxa::ImageId image;
+        ResourceCategory category;
+        usize size;
+        // passed to mark_releasing, counted in releasing_bytes until destroyed
+        bool releasing;
+    };
+
+    struct Evictor {
+        u32 id;
+        ResourceCategory category;
+        LastUsedFunction last_used;
+        EvictFunction evict;
+    };
+
+    void add_allocation(const Allocation& allocation);
+
+    std::vector<Allocation> allocations = {};
+    std::vector<Evictor> evictors = {};
+    u32 next_evictor_id = 1;
+    u64 frame = 1;
+    // of the allocations marked releasing, evicted but not destroyed yet
+    usize releasing_bytes = 0;
+    ResourceBudgetStatistics statistics = {};
+    mutable std::mutex mutex = {};
+};
@@ -0,0 +1,79 @@
+#include "sampler_cache.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    auto is_same_sampler(const daxa::SamplerInfo& a, const daxa::SamplerInfo& b) -> bool {
+        return a.magnification_filter == b.magnification_filter &&
+               a.minification_filter == b.minification_filter &&
+               a.mipmap_filter == b.mipmap_filter &&
+               a.address_mode_u == b.address_mode_u &&
+               a.address_mode_v == b.address_mode_v &&
+               a.address_mode_w == b.address_mode_w &&
+               a.mip_lod_bias == b.mip_lod_bias &&
+               a.enable_anisotropy == b.enable_anisotropy &&
+               a.max_anisotropy == b.max_anisotropy &&
+               a.enable_compare == b.enable_compare &&
+               a.compare_op == b.compare_op &&
+               a.min_lod == b.min_lod &&
+               a.max_lod == b.max_lod &&
+               a.border_color == b.border_color &&
+               a.enable_unnormalized_coordinates == b.enable_unnormalized_coordinates;
+    }
+}
+
+void SamplerCacheStatistics::print() const {
+    std::cout << "sampler cache: " << live_samplers << " samplers for " << references << " references, " << hits << " hits " << misses << " misses" << std::endl;
+}
+
+auto SamplerCache::get() -> SamplerCache& {
+    static SamplerCache cache = {};
+    return cache;
+}
+
+auto SamplerCache::acquire(daxa::Device& device, const daxa::SamplerInfo& info) -> daxa::SamplerId {
+    std::lock_guard lock(mutex);
+    auto entry = std::find_if(entries.begin(), entries.end(), [&](const Entry& candidate) { return is_same_sampler(candidate.info, info); });
+    if(entry != entries.end()) {
+        entry->reference_count++;
+        statistics.hits++;
+        statistics.references++;
+        return entry->sampler;
+    }
+
+    entries.push_back(Entry {
+        .info = info,
+        .sampler = device.create_sampler(info),
+        .reference_count = 1,
+    });
+    statistics.misses++;
+    statistics.references++;
+    statistics.live_samplers++;
+    return entries.back().sampler;
+}
+
+void SamplerCache::release(daxa::Device& device, daxa::SamplerId sampler) {
+    if(sampler.is_empty()) {
+        return;
+    }
+
+    std::lock_guard lock(mutex);
+    auto entry = std::find_if(entries.begin(), entries.end(), [&](const Entry& candidate) { return candidate.sampler == sampler; });
+    if(entry == entries.end()) {
+        std::cerr << "released a sampler that didn't come from the sampler cache" << std::endl;
+        return;
+    }
+
+    statistics.references--;
+    if(--entry->reference_count == 0) {
+        device.destroy_sampler(entry->sampler);
+        entries.erase(entry);
+        statistics.live_samplers--;
+    }
+}
+
+auto SamplerCache::get_statistics() const -> SamplerCacheStatistics {
+    std::lock_guard lock(mutex);
+    return statistics;
+}
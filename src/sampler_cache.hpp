@@ -0,0 +1,40 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <mutex>
+#include <vector>
+
+struct SamplerCacheStatistics {
+    u64 hits = 0;
+    u64 misses = 0;
+    u32 live_samplers = 0;
+    u32 references = 0;
+
+    void print() const;
+};
+
+// one sampler per distinct SamplerInfo for the whole process, handed out with a reference count and destroyed with the
+// last release. the name doesnt take part in the comparison, the first one wins. assumes a single device, which is all
+// the samples ever create
+struct SamplerCache {
+    static auto get() -> SamplerCache&;
+
+    auto acquire(daxa::Device& device, const daxa::SamplerInfo& info) -> daxa::SamplerId;
+    void release(daxa::Device& device, daxa::SamplerId sampler);
+
+    auto get_statistics() const -> SamplerCacheStatistics;
+
+private:
+    struct Entry {
+        daxa::SamplerInfo info;
+        daxa::SamplerId sampler;
+        u32 reference_count;
+    };
+
+    // there are only ever a handful of distinct samplers, a linear search beats hashing the whole info
+    std::vector<Entry> entries = {};
+    SamplerCacheStatistics statistics = {};
+    mutable std::mutex mutex = {};
+};
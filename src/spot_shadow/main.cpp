@@ -10,6 +10,8 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 
 #include <daxa/utils/imgui.hpp>
 #include <imgui.h>
@@ -247,7 +249,7 @@ struct SpotShadowApp : public App {
             .name = "shadow pipeline"
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -260,7 +262,7 @@ struct SpotShadowApp : public App {
             .name = "task depth image"
         }};
 
-        shadow_image = device.create_image({
+        shadow_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = {1024, 1024, 1},
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -273,7 +275,7 @@ struct SpotShadowApp : public App {
             .name = "task shadow image"
         }};
 
-        shadow_sampler = device.create_sampler(daxa::SamplerInfo {
+        shadow_sampler = SamplerCache::get().acquire(device, daxa::SamplerInfo {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -291,7 +293,7 @@ struct SpotShadowApp : public App {
             .enable_unnormalized_coordinates = false,
         });
 
-        light_buffer = device.create_buffer(daxa::BufferInfo {
+        light_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(LightInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "light buffer"
@@ -300,7 +302,7 @@ struct SpotShadowApp : public App {
         camera.camera.resize(size_x, size_y);
 
 
-        daxa::BufferId sponza_buffer = device.create_buffer(daxa::BufferInfo {
+        daxa::BufferId sponza_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(ObjectInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "sponza buffer"
@@ -321,7 +323,7 @@ struct SpotShadowApp : public App {
             .object_buffer = sponza_buffer
         });
 
-        daxa::BufferId helmet_buffer = device.create_buffer(daxa::BufferInfo {
+        daxa::BufferId helmet_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(ObjectInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "helmet buffer"
@@ -392,13 +394,13 @@ struct SpotShadowApp : public App {
     }
 
     ~SpotShadowApp() {
-        device.destroy_image(depth_image);
-        device.destroy_image(shadow_image);
-        device.destroy_sampler(shadow_sampler);
-        device.destroy_buffer(light_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_image(device, shadow_image);
+        SamplerCache::get().release(device, shadow_sampler);
+        ResourceBudget::get().destroy_buffer(device, light_buffer);
 
         for(auto& m : models) {
-            device.destroy_buffer(m.object_buffer);
+            ResourceBudget::get().destroy_buffer(device, m.object_buffer);
         }
     }
 
@@ -498,8 +500,8 @@ struct SpotShadowApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
@@ -56,7 +56,7 @@ f32 shadow_pcf(daxa_ImageViewId shadow_image, daxa_SamplerId shadow_sampler, f32
 
 void main() {
 
-    f32vec3 color = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0).rgb;
+    f32vec3 color = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0).rgb;
     color *= 0.1;
 #if USE_PCF == 0
     f32 shadow = max(calculate_shadow(deref(push.light_buffer).shadow_image, deref(push.light_buffer).shadow_sampler, in_position_shadow / in_position_shadow.w, f32vec2(0.0, 0.0), push.bias), push.shadow_intensity);
@@ -26,7 +26,7 @@ layout(location = 0) out f32vec4 out_albedo;
 layout(location = 1) out f32vec4 out_normal;
 
 void main() {
-    out_albedo = f32vec4(sample_texture(MATERIAL.albedo_image, in_uv).rgb, 1.0);
+    out_albedo = f32vec4(sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb, 1.0);
     out_normal = f32vec4(normalize(in_normal), 1.0);
 }
 
@@ -13,6 +13,8 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 
 struct GBufferGatherTask {
     struct Uses {
@@ -346,7 +348,7 @@ struct SSAOApp : public App {
             .name = "ssao_blur_pipeline"
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -359,7 +361,7 @@ struct SSAOApp : public App {
             .name = "task depth image"
         }};
 
-        albedo_image = device.create_image({
+        albedo_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = swapchain.get_format(),
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -372,7 +374,7 @@ struct SSAOApp : public App {
             .name = "task albedo image"
         }};
 
-        normal_image = device.create_image({
+        normal_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::R16G16B16A16_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -385,7 +387,7 @@ struct SSAOApp : public App {
             .name = "task normal image"
         }};
 
-        ssao_image = device.create_image({
+        ssao_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::R8_UNORM,
             .size = { static_cast<u32>(static_cast<f32>(size_x) * scale), static_cast<u32>(static_cast<f32>(size_y) * scale), 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -398,7 +400,7 @@ struct SSAOApp : public App {
             .name = "task ssao image"
         }};
 
-        ssao_blur_image = device.create_image({
+        ssao_blur_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::R8_UNORM,
             .size = { static_cast<u32>(static_cast<f32>(size_x) * scale), static_cast<u32>(static_cast<f32>(size_y) * scale), 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -411,7 +413,7 @@ struct SSAOApp : public App {
             .name = "task ssao blur image"
         }};
 
-        sampler_id = device.create_sampler({
+        sampler_id = SamplerCache::get().acquire(device, {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -428,13 +430,13 @@ struct SSAOApp : public App {
             .enable_unnormalized_coordinates = false,
         });
 
-        camera_buffer = device.create_buffer({
+        camera_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, {
             .size = sizeof(CameraInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "camera info buffer"
         });
 
-        object_buffer = device.create_buffer({
+        object_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, {
             .size = sizeof(ObjectInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "object info buffer"
@@ -530,14 +532,14 @@ struct SSAOApp : public App {
     }
 
     ~SSAOApp() {
-        device.destroy_image(depth_image);
-        device.destroy_image(albedo_image);
-        device.destroy_image(normal_image);
-        device.destroy_image(ssao_image);
-        device.destroy_image(ssao_blur_image);
-        device.destroy_sampler(sampler_id);
-        device.destroy_buffer(camera_buffer);
-        device.destroy_buffer(object_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_image(device, albedo_image);
+        ResourceBudget::get().destroy_image(device, normal_image);
+        ResourceBudget::get().destroy_image(device, ssao_image);
+        ResourceBudget::get().destroy_image(device, ssao_blur_image);
+        SamplerCache::get().release(device, sampler_id);
+        ResourceBudget::get().destroy_buffer(device, camera_buffer);
+        ResourceBudget::get().destroy_buffer(device, object_buffer);
     }
 
     void render() {
@@ -672,8 +674,8 @@ struct SSAOApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -681,8 +683,8 @@ struct SSAOApp : public App {
             });
             task_depth_image.set_images({.images = std::span{&depth_image, 1}});
 
-            device.destroy_image(albedo_image);
-            albedo_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, albedo_image);
+            albedo_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = swapchain.get_format(),
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -690,8 +692,8 @@ struct SSAOApp : public App {
             });
             task_albedo_image.set_images({.images = std::span{&albedo_image, 1}});
 
-            device.destroy_image(normal_image);
-            normal_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, normal_image);
+            normal_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::R16G16B16A16_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -699,8 +701,8 @@ struct SSAOApp : public App {
             });
             task_normal_image.set_images({.images = std::span{&normal_image, 1}});
             
-            device.destroy_image(ssao_image);
-            ssao_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, ssao_image);
+            ssao_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::R8_UNORM,
                 .size = { static_cast<u32>(static_cast<f32>(size_x) * scale), static_cast<u32>(static_cast<f32>(size_y) * scale), 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -708,8 +710,8 @@ struct SSAOApp : public App {
             });
             task_ssao_image.set_images({.images = std::span{&ssao_image, 1}});
 
-            device.destroy_image(ssao_blur_image);
-            ssao_blur_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, ssao_blur_image);
+            ssao_blur_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::R8_UNORM,
                 .size = { static_cast<u32>(static_cast<f32>(size_x) * scale), static_cast<u32>(static_cast<f32>(size_y) * scale), 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -1,359 +1,157 @@
 #include "texture.hpp"
+#include "mip_generator.hpp"
+#include "pixel_conversion.hpp"
+#include "sampler_cache.hpp"
+#include "resource_budget.hpp"
 
-#include <stb_image.h>
+#include "mapped_file.hpp"
 
 #include <cstring>
 #include <cmath>
 
 Texture::Texture() {}
 
-Texture::Texture(daxa::Device device, u32 size_x, u32 size_y, unsigned char* data, Type type) : device{device} {
-    u32 mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(size_x, size_y)))) + 1;
-
-    this->image_id = device.create_image({
-        .dimensions = 2,
-        .format = (type == Type::UNORM) ? daxa::Format::R8G8B8A8_UNORM : daxa::Format::R8G8B8A8_SRGB,
-        .size = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 },
-        .mip_level_count = mip_levels,
-        .array_layer_count = 1,
-        .sample_count = 1,
-        .usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::TRANSFER_DST | daxa::ImageUsageFlagBits::TRANSFER_SRC,
-        .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY
-    });
-
-    this->sampler_id = device.create_sampler({
-        .magnification_filter = daxa::Filter::LINEAR,
-        .minification_filter = daxa::Filter::LINEAR,
-        .mipmap_filter = daxa::Filter::LINEAR,
-        .address_mode_u = daxa::SamplerAddressMode::REPEAT,
-        .address_mode_v = daxa::SamplerAddressMode::REPEAT,
-        .address_mode_w = daxa::SamplerAddressMode::REPEAT,
-        .mip_lod_bias = 0.0f,
-        .enable_anisotropy = true,
-        .max_anisotropy = 16.0f,
-        .enable_compare = false,
-        .compare_op = daxa::CompareOp::ALWAYS,
-        .min_lod = 0.0f,
-        .max_lod = static_cast<f32>(mip_levels),
-        .enable_unnormalized_coordinates = false,
-    });
+auto Texture::load_pixels(const std::string& path, ThreadPool* pool) -> DecodedImage {
+    std::unique_ptr<MappedFile> file = {};
+    try {
+        file = std::make_unique<MappedFile>(path);
+    } catch(const std::runtime_error&) {
+        throw std::runtime_error("Textures couldn't be found with path: " + path);
+    }
 
-    daxa::BufferId staging_buffer = device.create_buffer({
-        .size = static_cast<u32>(size_x * size_y * sizeof(u8) * 4),
-        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
-        .name = "staging buffer"
-    });
+    try {
+        return decode_image(file->get_data(), { .pool = pool });
+    } catch(const std::runtime_error& error) {
+        throw std::runtime_error("Textures couldn't be decoded: " + path + ", " + error.what());
+    }
+}
 
-    auto buffer_ptr = device.get_host_address_as<u8>(staging_buffer);
-    std::memcpy(buffer_ptr, data, size_x * size_y * sizeof(u8) * 4);
-
-    daxa::CommandList cmd_list = device.create_command_list({.name = "upload command list"});
-
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::UNDEFINED,
-        .dst_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = 0,
-            .level_count = mip_levels,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
-    });
+auto Texture::load_pixels(std::span<const u8> bytes, ThreadPool* pool) -> DecodedImage {
+    try {
+        return decode_image(bytes, { .pool = pool });
+    } catch(const std::runtime_error& error) {
+        throw std::runtime_error(std::string("Textures couldn't be decoded from memory: ") + error.what());
+    }
+}
 
-    cmd_list.copy_buffer_to_image({
-        .buffer = staging_buffer,
-        .buffer_offset = 0,
-        .image = image_id,
-        .image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .mip_level = 0,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_offset = { 0, 0, 0 },
-        .image_extent = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 }
-    });
+Texture::Texture(daxa::Device device, u32 size_x, u32 size_y, unsigned char* data, Type type, MipGeneration mip_generation) : device{device} {
+    {
+        UploadManager uploader(device, { .staging_size = static_cast<usize>(size_x * size_y) * sizeof(u8) * 4 * 2, .name = "texture uploader" });
+        create(uploader, size_x, size_y, data, 4, type, mip_generation);
+    }
 
-    cmd_list.pipeline_barrier({
-        .src_access = daxa::AccessConsts::HOST_WRITE,
-        .dst_access = daxa::AccessConsts::TRANSFER_READ,
-    });
+    upload = {};
+}
 
-    auto image_info = device.info_image(image_id);
+Texture::Texture(daxa::Device device, const std::string& path, Type type, MipGeneration mip_generation) : device{device} {
+    if(is_ktx2_path(path)) {
+        Ktx2File file(path);
+        {
+            UploadManager uploader(device, { .staging_size = file.get_staging_size(), .name = "texture uploader" });
+            create(uploader, file);
+        }
+        upload = {};
+        return;
+    }
 
-    std::array<i32, 3> mip_size = {
-        static_cast<i32>(image_info.size.x),
-        static_cast<i32>(image_info.size.y),
-        static_cast<i32>(image_info.size.z),
-    };
+    DecodedImage image = load_pixels(path);
 
-    for(u32 i = 1; i < image_info.mip_level_count; i++) {
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-
-        std::array<i32, 3> next_mip_size = {
-            std::max<i32>(1, mip_size[0] / 2),
-            std::max<i32>(1, mip_size[1] / 2),
-            std::max<i32>(1, mip_size[2] / 2),
-        };
-
-        cmd_list.blit_image_to_image({
-            .src_image = image_id,
-            .src_image_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_image = image_id,
-            .dst_image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .src_slice = {
-                .mip_level = i - 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .src_offsets = {{{0, 0, 0}, {mip_size[0], mip_size[1], mip_size[2]}}},
-            .dst_slice = {
-                .mip_level = i,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .dst_offsets = {{{0, 0, 0}, {next_mip_size[0], next_mip_size[1], next_mip_size[2]}}},
-            .filter = daxa::Filter::LINEAR,
-        });
-
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-        
-        mip_size = next_mip_size;
+    {
+        UploadManager uploader(device, { .staging_size = static_cast<usize>(image.size_x * image.size_y) * sizeof(u8) * 4 * 2, .name = "texture uploader" });
+        create(uploader, image.size_x, image.size_y, image.pixels.get(), image.channel_count, type, mip_generation);
     }
 
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = image_info.mip_level_count - 1,
-            .level_count = 1,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
-    });
+    upload = {};
+}
 
-    cmd_list.complete();
+Texture::Texture(daxa::Device device, UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, Type type, MipGeneration mip_generation) : device{device} {
+    create(uploader, size_x, size_y, data, 4, type, mip_generation);
+}
 
-    device.submit_commands({
-        .command_lists = {std::move(cmd_list)},
-    });
-    device.wait_idle();
-    device.destroy_buffer(staging_buffer);
+Texture::Texture(daxa::Device device, UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, u32 channel_count, Type type, MipGeneration mip_generation) : device{device} {
+    create(uploader, size_x, size_y, data, channel_count, type, mip_generation);
 }
 
-Texture::Texture(daxa::Device device, const std::string& path, Type type) : device{device} {
-    i32 size_x = 0;
-    i32 size_y = 0;
-    i32 num_channels = 0;
-    u8* data = stbi_load(path.c_str(), &size_x, &size_y, &num_channels, 4);
-    if(data == nullptr) {
-        throw std::runtime_error("Textures couldn't be found with path: " + path);
+Texture::Texture(daxa::Device device, UploadManager& uploader, const std::string& path, Type type, MipGeneration mip_generation) : device{device} {
+    if(is_ktx2_path(path)) {
+        create(uploader, Ktx2File(path));
+        return;
     }
 
-    u32 mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(size_x, size_y)))) + 1;
+    // the pixels are copied into the staging ring while recording, so they can go right away
+    DecodedImage image = load_pixels(path);
+    create(uploader, image.size_x, image.size_y, image.pixels.get(), image.channel_count, type, mip_generation);
+}
+
+Texture::Texture(daxa::Device device, UploadManager& uploader, const CompressedTexture& compressed) : device{device} {
+    u32 mip_levels = static_cast<u32>(compressed.offsets.size());
 
-    this->image_id = device.create_image({
+    this->image_id = ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, {
         .dimensions = 2,
-        .format = (type == Type::UNORM) ? daxa::Format::R8G8B8A8_UNORM : daxa::Format::R8G8B8A8_SRGB,
-        .size = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 },
+        .format = get_compressed_format(compressed.format, compressed.srgb),
+        .size = { compressed.size_x, compressed.size_y, 1 },
         .mip_level_count = mip_levels,
         .array_layer_count = 1,
         .sample_count = 1,
+        // TRANSFER_SRC so the model can copy it into a texture array
         .usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::TRANSFER_DST | daxa::ImageUsageFlagBits::TRANSFER_SRC,
         .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY
     });
 
-    this->sampler_id = device.create_sampler({
-        .magnification_filter = daxa::Filter::LINEAR,
-        .minification_filter = daxa::Filter::LINEAR,
-        .mipmap_filter = daxa::Filter::LINEAR,
-        .address_mode_u = daxa::SamplerAddressMode::REPEAT,
-        .address_mode_v = daxa::SamplerAddressMode::REPEAT,
-        .address_mode_w = daxa::SamplerAddressMode::REPEAT,
-        .mip_lod_bias = 0.0f,
-        .enable_anisotropy = true,
-        .max_anisotropy = 16.0f,
-        .enable_compare = false,
-        .compare_op = daxa::CompareOp::ALWAYS,
-        .min_lod = 0.0f,
-        .max_lod = static_cast<f32>(mip_levels),
-        .enable_unnormalized_coordinates = false,
-    });
-
-    daxa::BufferId staging_buffer = device.create_buffer({
-        .size = static_cast<u32>(size_x * size_y * sizeof(u8) * 4),
-        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
-        .name = "staging buffer"
-    });
-
-    auto buffer_ptr = device.get_host_address_as<u8>(staging_buffer);
-    std::memcpy(buffer_ptr, data, size_x * size_y * sizeof(u8) * 4);
-
-    stbi_image_free(data);
-
-    daxa::CommandList cmd_list = device.create_command_list({.name = "upload command buffer"});
-
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::UNDEFINED,
-        .dst_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = 0,
-            .level_count = mip_levels,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
-    });
+    create_sampler();
 
-    cmd_list.copy_buffer_to_image({
-        .buffer = staging_buffer,
-        .buffer_offset = 0,
+    this->upload = uploader.upload_image({
         .image = image_id,
-        .image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .mip_level = 0,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_offset = { 0, 0, 0 },
-        .image_extent = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 }
-    });
-
-    cmd_list.pipeline_barrier({
-        .src_access = daxa::AccessConsts::HOST_WRITE,
-        .dst_access = daxa::AccessConsts::TRANSFER_READ,
+        .size_x = compressed.size_x,
+        .size_y = compressed.size_y,
+        .data = std::as_bytes(std::span<const u8>{compressed.data}),
+        .generate_mips = false,
+        .mip_offsets = compressed.offsets,
     });
+}
 
-    auto image_info = device.info_image(image_id);
-
-    std::array<i32, 3> mip_size = {
-        static_cast<i32>(image_info.size.x),
-        static_cast<i32>(image_info.size.y),
-        static_cast<i32>(image_info.size.z),
-    };
-
-    for(u32 i = 1; i < image_info.mip_level_count; i++) {
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-
-        std::array<i32, 3> next_mip_size = {
-            std::max<i32>(1, mip_size[0] / 2),
-            std::max<i32>(1, mip_size[1] / 2),
-            std::max<i32>(1, mip_size[2] / 2),
-        };
-
-        cmd_list.blit_image_to_image({
-            .src_image = image_id,
-            .src_image_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_image = image_id,
-            .dst_image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .src_slice = {
-                .mip_level = i - 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .src_offsets = {{{0, 0, 0}, {mip_size[0], mip_size[1], mip_size[2]}}},
-            .dst_slice = {
-                .mip_level = i,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .dst_offsets = {{{0, 0, 0}, {next_mip_size[0], next_mip_size[1], next_mip_size[2]}}},
-            .filter = daxa::Filter::LINEAR,
-        });
-
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-        
-        mip_size = next_mip_size;
+Texture::Texture(daxa::Device device, TextureStreamer& streamer, StreamingSource source) : device{device} {
+    create_sampler();
+    try {
+        streamer.add(*this, std::move(source));
+    } catch(...) {
+        SamplerCache::get().release(device, sampler_id);
+        throw;
     }
+}
 
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = image_info.mip_level_count - 1,
-            .level_count = 1,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
-    });
+Texture::Texture(daxa::Device device, UploadManager& uploader, std::span<Texture* const> layers) : device{device} {
+    daxa::ImageInfo info = this->device.info_image(layers.front()->image_id);
+    info.array_layer_count = static_cast<u32>(layers.size());
+    info.usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::TRANSFER_DST;
+    info.allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY;
+    info.name = "texture array";
+    this->image_id = ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, info);
 
-    cmd_list.complete();
+    create_sampler();
 
-    device.submit_commands({
-        .command_lists = {std::move(cmd_list)},
-    });
-    device.wait_idle();
-    device.destroy_buffer(staging_buffer);
+    for(u32 layer = 0; layer < layers.size(); layer++) {
+        this->upload = uploader.copy_image_to_layer({ .src_image = layers[layer]->image_id, .dst_image = image_id, .dst_layer = layer });
+    }
 }
 
 Texture::~Texture() {
-    device.destroy_image(this->image_id);
-    device.destroy_sampler(this->sampler_id);
+    if(streamer != nullptr) {
+        streamer->remove(*this);
+    }
+    ResourceBudget::get().destroy_image(device, this->image_id);
+    SamplerCache::get().release(device, this->sampler_id);
 }
 
-auto Texture::load_texture(daxa::Device device, u32 size_x, u32 size_y, unsigned char *data, Type type) -> Texture::PayLoad {
-    u32 mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(size_x, size_y)))) + 1;
+void Texture::create(UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, u32 channel_count, Type type, MipGeneration mip_generation) {
+    if(type == Type::NORMAL_XY) {
+        create_normal_map(uploader, size_x, size_y, data, channel_count);
+        return;
+    }
+
+    u32 mip_levels = get_mip_level_count(size_x, size_y);
 
-    daxa::ImageId image_id = device.create_image({
+    this->image_id = ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, {
         .dimensions = 2,
         .format = (type == Type::UNORM) ? daxa::Format::R8G8B8A8_UNORM : daxa::Format::R8G8B8A8_SRGB,
         .size = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 },
@@ -364,181 +162,131 @@ auto Texture::load_texture(daxa::Device device, u32 size_x, u32 size_y, unsigned
         .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY
     });
 
-    daxa::SamplerId sampler_id = device.create_sampler({
-        .magnification_filter = daxa::Filter::LINEAR,
-        .minification_filter = daxa::Filter::LINEAR,
-        .mipmap_filter = daxa::Filter::LINEAR,
-        .address_mode_u = daxa::SamplerAddressMode::REPEAT,
-        .address_mode_v = daxa::SamplerAddressMode::REPEAT,
-        .address_mode_w = daxa::SamplerAddressMode::REPEAT,
-        .mip_lod_bias = 0.0f,
-        .enable_anisotropy = true,
-        .max_anisotropy = 16.0f,
-        .enable_compare = false,
-        .compare_op = daxa::CompareOp::ALWAYS,
-        .min_lod = 0.0f,
-        .max_lod = static_cast<f32>(mip_levels),
-        .enable_unnormalized_coordinates = false,
-    });
+    create_sampler();
 
-    daxa::BufferId staging_buffer = device.create_buffer({
-        .size = static_cast<u32>(size_x * size_y * sizeof(u8) * 4),
-        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
-        .name = "staging buffer"
-    });
+    usize pixel_count = static_cast<usize>(size_x) * size_y;
+    usize chain_size = pixel_count * 4;
+    std::vector<usize> offsets = {};
+    if(mip_generation != MipGeneration::GPU_BLIT) {
+        offsets = get_mip_chain_offsets(size_x, size_y, mip_levels, chain_size);
+    }
 
-    auto buffer_ptr = device.get_host_address_as<u8>(staging_buffer);
-    std::memcpy(buffer_ptr, data, size_x * size_y * sizeof(u8) * 4);
-
-    daxa::CommandList cmd_list = device.create_command_list({.name = "upload command list"});
-
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::UNDEFINED,
-        .dst_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = 0,
-            .level_count = mip_levels,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
-    });
+    // level 0 and the cpu generated levels are written right into the staging memory, nothing in between holds a copy.
+    // the reservation is pinned while the mips get filtered, long enough that it shouldn't be done from the render thread.
+    // nothing in here may wait on a pool either, a foreign task the wait runs could block in reserve behind this reservation
+    StagingReservation staging = uploader.reserve(chain_size);
+    u8* destination = reinterpret_cast<u8*>(staging.memory.data());
+    try {
+        if(channel_count == 3) {
+            expand_rgb_to_rgba(data, destination, pixel_count);
+        } else {
+            std::memcpy(destination, data, pixel_count * 4);
+        }
+
+        if(mip_generation != MipGeneration::GPU_BLIT) {
+            generate_mip_levels({ data, pixel_count * channel_count }, channel_count, size_x, size_y, { destination, chain_size }, offsets, {
+                .filter = (mip_generation == MipGeneration::CPU_KAISER) ? MipFilter::KAISER : MipFilter::BOX,
+                .srgb = type == Type::SRGB,
+            });
+        }
+    } catch(...) {
+        uploader.release(staging);
+        ResourceBudget::get().destroy_image(device, image_id);
+        SamplerCache::get().release(device, sampler_id);
+        throw;
+    }
 
-    cmd_list.copy_buffer_to_image({
-        .buffer = staging_buffer,
-        .buffer_offset = 0,
+    this->upload = uploader.upload_image({
         .image = image_id,
-        .image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .mip_level = 0,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_offset = { 0, 0, 0 },
-        .image_extent = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 }
-    });
-
-    cmd_list.pipeline_barrier({
-        .src_access = daxa::AccessConsts::HOST_WRITE,
-        .dst_access = daxa::AccessConsts::TRANSFER_READ,
-    });
+        .size_x = size_x,
+        .size_y = size_y,
+        .generate_mips = mip_generation == MipGeneration::GPU_BLIT,
+        .mip_offsets = offsets,
+    }, staging);
+}
 
-    auto image_info = device.info_image(image_id);
+// half the memory of RGBA8, the chain gets written straight into staging like the color one
+void Texture::create_normal_map(UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, u32 channel_count) {
+    u32 mip_levels = get_mip_level_count(size_x, size_y);
 
-    std::array<i32, 3> mip_size = {
-        static_cast<i32>(image_info.size.x),
-        static_cast<i32>(image_info.size.y),
-        static_cast<i32>(image_info.size.z),
-    };
-
-    for(u32 i = 1; i < image_info.mip_level_count; i++) {
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-
-        std::array<i32, 3> next_mip_size = {
-            std::max<i32>(1, mip_size[0] / 2),
-            std::max<i32>(1, mip_size[1] / 2),
-            std::max<i32>(1, mip_size[2] / 2),
-        };
-
-        cmd_list.blit_image_to_image({
-            .src_image = image_id,
-            .src_image_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_image = image_id,
-            .dst_image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .src_slice = {
-                .mip_level = i - 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .src_offsets = {{{0, 0, 0}, {mip_size[0], mip_size[1], mip_size[2]}}},
-            .dst_slice = {
-                .mip_level = i,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .dst_offsets = {{{0, 0, 0}, {next_mip_size[0], next_mip_size[1], next_mip_size[2]}}},
-            .filter = daxa::Filter::LINEAR,
-        });
-
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-        
-        mip_size = next_mip_size;
-    }
-
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = image_info.mip_level_count - 1,
-            .level_count = 1,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
+    this->image_id = ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, {
+        .dimensions = 2,
+        .format = daxa::Format::R8G8_UNORM,
+        .size = { size_x, size_y, 1 },
+        .mip_level_count = mip_levels,
+        .array_layer_count = 1,
+        .sample_count = 1,
+        .usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::TRANSFER_DST | daxa::ImageUsageFlagBits::TRANSFER_SRC,
+        .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY
     });
 
-    cmd_list.destroy_buffer_deferred(staging_buffer);
-    cmd_list.complete();
-
-    auto tex = std::make_unique<Texture>();
-    tex->device = device;
-    tex->image_id = image_id;
-    tex->sampler_id = sampler_id;
+    create_sampler();
+
+    usize chain_size = 0;
+    std::vector<usize> offsets = get_normal_map_offsets(size_x, size_y, mip_levels, chain_size);
+    StagingReservation staging = uploader.reserve(chain_size);
+    try {
+        normal_map_error = pack_normal_map({ data, static_cast<usize>(size_x) * size_y * channel_count }, channel_count, size_x, size_y, { reinterpret_cast<u8*>(staging.memory.data()), chain_size }, offsets);
+    } catch(...) {
+        uploader.release(staging);
+        ResourceBudget::get().destroy_image(device, image_id);
+        SamplerCache::get().release(device, sampler_id);
+        throw;
+    }
 
-    return Texture::PayLoad{std::move(tex), cmd_list};
+    this->upload = uploader.upload_image({
+        .image = image_id,
+        .size_x = size_x,
+        .size_y = size_y,
+        .generate_mips = false,
+        .mip_offsets = offsets,
+    }, staging);
 }
 
-auto Texture::load_texture(daxa::Device device, const std::string& file_path, Type type) -> PayLoad {
-    i32 size_x = 0;
-    i32 size_y = 0;
-    i32 num_channels = 0;
-    u8* data = stbi_load(file_path.c_str(), &size_x, &size_y, &num_channels, 4);
-    if(data == nullptr) {
-        throw std::runtime_error("Textures couldn't be found with path: " + file_path);
-    }
-
-    u32 mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(size_x, size_y)))) + 1;
+// every level gets decompressed or copied out of the mapping right into staging memory, nothing is decoded
+void Texture::create(UploadManager& uploader, const Ktx2File& file) {
+    u32 mip_levels = file.generate_mips ? get_mip_level_count(file.size_x, file.size_y) : static_cast<u32>(file.levels.size());
 
-    daxa::ImageId image_id = device.create_image({
+    this->image_id = ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, {
         .dimensions = 2,
-        .format = (type == Type::UNORM) ? daxa::Format::R8G8B8A8_UNORM : daxa::Format::R8G8B8A8_SRGB,
-        .size = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 },
+        .format = file.format,
+        .size = { file.size_x, file.size_y, 1 },
         .mip_level_count = mip_levels,
         .array_layer_count = 1,
         .sample_count = 1,
+        // TRANSFER_SRC for the mip blits and so the model can copy it into a texture array
         .usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::TRANSFER_DST | daxa::ImageUsageFlagBits::TRANSFER_SRC,
         .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY
     });
 
-    daxa::SamplerId sampler_id = device.create_sampler({
+    create_sampler();
+
+    std::vector<usize> offsets = file.get_staging_offsets();
+    StagingReservation staging = uploader.reserve(file.get_staging_size());
+    try {
+        for(u32 level = 0; level < file.levels.size(); level++) {
+            file.read_level(level, staging.memory.subspan(offsets[level]));
+        }
+    } catch(...) {
+        uploader.release(staging);
+        ResourceBudget::get().destroy_image(device, image_id);
+        SamplerCache::get().release(device, sampler_id);
+        throw;
+    }
+
+    // without stored levels the rest of the chain gets blitted, which only works for formats that can be blitted
+    this->upload = uploader.upload_image({
+        .image = image_id,
+        .size_x = file.size_x,
+        .size_y = file.size_y,
+        .generate_mips = file.generate_mips,
+        .mip_offsets = file.generate_mips ? std::span<const usize>{} : std::span<const usize>{offsets},
+    }, staging);
+}
+
+// the lod range is left open so every texture shares one sampler, the image view already limits it to its own mips
+void Texture::create_sampler() {
+    this->sampler_id = SamplerCache::get().acquire(device, {
         .magnification_filter = daxa::Filter::LINEAR,
         .minification_filter = daxa::Filter::LINEAR,
         .mipmap_filter = daxa::Filter::LINEAR,
@@ -551,145 +299,21 @@ auto Texture::load_texture(daxa::Device device, const std::string& file_path, Ty
         .enable_compare = false,
         .compare_op = daxa::CompareOp::ALWAYS,
         .min_lod = 0.0f,
-        .max_lod = static_cast<f32>(mip_levels),
+        .max_lod = 1000.0f,
         .enable_unnormalized_coordinates = false,
     });
+}
 
-    daxa::BufferId staging_buffer = device.create_buffer({
-        .size = static_cast<u32>(size_x * size_y * sizeof(u8) * 4),
-        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
-        .name = "staging buffer"
-    });
-
-    auto buffer_ptr = device.get_host_address_as<u8>(staging_buffer);
-    std::memcpy(buffer_ptr, data, size_x * size_y * sizeof(u8) * 4);
-
-    daxa::CommandList cmd_list = device.create_command_list({.name = "upload command list"});
-
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::UNDEFINED,
-        .dst_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = 0,
-            .level_count = mip_levels,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
-    });
-
-    cmd_list.copy_buffer_to_image({
-        .buffer = staging_buffer,
-        .buffer_offset = 0,
-        .image = image_id,
-        .image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .image_slice = {
-            .mip_level = 0,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_offset = { 0, 0, 0 },
-        .image_extent = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 }
-    });
-
-    cmd_list.pipeline_barrier({
-        .src_access = daxa::AccessConsts::HOST_WRITE,
-        .dst_access = daxa::AccessConsts::TRANSFER_READ,
-    });
-
-    auto image_info = device.info_image(image_id);
-
-    std::array<i32, 3> mip_size = {
-        static_cast<i32>(image_info.size.x),
-        static_cast<i32>(image_info.size.y),
-        static_cast<i32>(image_info.size.z),
-    };
-
-    for(u32 i = 1; i < image_info.mip_level_count; i++) {
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-
-        std::array<i32, 3> next_mip_size = {
-            std::max<i32>(1, mip_size[0] / 2),
-            std::max<i32>(1, mip_size[1] / 2),
-            std::max<i32>(1, mip_size[2] / 2),
-        };
-
-        cmd_list.blit_image_to_image({
-            .src_image = image_id,
-            .src_image_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_image = image_id,
-            .dst_image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-            .src_slice = {
-                .mip_level = i - 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .src_offsets = {{{0, 0, 0}, {mip_size[0], mip_size[1], mip_size[2]}}},
-            .dst_slice = {
-                .mip_level = i,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .dst_offsets = {{{0, 0, 0}, {next_mip_size[0], next_mip_size[1], next_mip_size[2]}}},
-            .filter = daxa::Filter::LINEAR,
-        });
-
-        cmd_list.pipeline_barrier_image_transition({
-            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
-            .dst_access = daxa::AccessConsts::BLIT_READ,
-            .src_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
-            .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-            .image_slice = {
-                .base_mip_level = i - 1,
-                .level_count = 1,
-                .base_array_layer = 0,
-                .layer_count = 1,
-            },
-            .image_id = image_id,
-        });
-        
-        mip_size = next_mip_size;
+auto Texture::get_texture_id() -> TextureId {
+    if(streamer == nullptr) {
+        return TextureId { .image_id = image_id.default_view(), .sampler_id = sampler_id };
     }
 
-    cmd_list.pipeline_barrier_image_transition({
-        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
-        .dst_access = daxa::AccessConsts::READ_WRITE,
-        .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
-        .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
-        .image_slice = {
-            .base_mip_level = image_info.mip_level_count - 1,
-            .level_count = 1,
-            .base_array_layer = 0,
-            .layer_count = 1,
-        },
-        .image_id = image_id,
-    });
-
-    cmd_list.destroy_buffer_deferred(staging_buffer);
-    cmd_list.complete();
-
-    auto tex = std::make_unique<Texture>();
-    tex->device = device;
-    tex->image_id = image_id;
-    tex->sampler_id = sampler_id;
-
-    return Texture::PayLoad{std::move(tex), cmd_list};
+    return TextureId {
+        .image_id = image_id.default_view(),
+        .sampler_id = sampler_id,
+        .feedback = streamer->get_feedback_address(*this),
+        .first_mip = first_mip,
+        .streamed = 1,
+    };
 }
-
-auto Texture::get_texture_id() -> TextureId {
-    return TextureId { .image_id = image_id.default_view(), .sampler_id = sampler_id };
-}
\ No newline at end of file
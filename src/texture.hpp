@@ -4,30 +4,74 @@
 using namespace daxa::types;
 
 #include <memory>
+#include <span>
 #include "common.inl"
+#include "upload_manager.hpp"
+#include "texture_compression.hpp"
+#include "ktx2.hpp"
+#include "texture_streaming.hpp"
+#include "image_decoder.hpp"
+#include "normal_map.hpp"
 
 struct Texture {
     enum class Type : u8 {
         UNORM = 0,
-        SRGB = 1
+        SRGB = 1,
+        // tangent space normal map that only keeps x and y as RG8, shaders rebuild z with unpack_normal. the mips always
+        // come from the renormalizing filter of pack_normal_map
+        NORMAL_XY = 2,
     };
 
-    struct PayLoad {
-        std::unique_ptr<Texture> texture;
-        daxa::CommandList command_list;
+    // the cpu filters run on the thread that creates the texture and upload the whole chain at once,
+    // the blit runs on the gpu and filters srgb images in srgb space
+    enum class MipGeneration : u8 {
+        CPU_BOX = 0,
+        CPU_KAISER = 1,
+        GPU_BLIT = 2,
     };
 
     Texture();
-    Texture(daxa::Device device, u32 size_x, u32 size_y, unsigned char* data, Type type);
-    Texture(daxa::Device device, const std::string& path, Type type);
+    // upload right away and wait for it
+    Texture(daxa::Device device, u32 size_x, u32 size_y, unsigned char* data, Type type, MipGeneration mip_generation = MipGeneration::CPU_BOX);
+    // .ktx2 files take their format and mips from the file, type and mip_generation only apply to the ones stb decodes
+    Texture(daxa::Device device, const std::string& path, Type type, MipGeneration mip_generation = MipGeneration::CPU_BOX);
+    // only record the upload into the batch of uploader, the image is ready once upload resolves
+    Texture(daxa::Device device, UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, Type type, MipGeneration mip_generation = MipGeneration::CPU_BOX);
+    // data is RGB8 or RGBA8, rgb gets expanded on the calling thread while it is written into staging memory
+    Texture(daxa::Device device, UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, u32 channel_count, Type type, MipGeneration mip_generation = MipGeneration::CPU_BOX);
+    Texture(daxa::Device device, UploadManager& uploader, const std::string& path, Type type, MipGeneration mip_generation = MipGeneration::CPU_BOX);
+    // block compressed chain that already has all of its levels
+    Texture(daxa::Device device, UploadManager& uploader, const CompressedTexture& compressed);
+    // starts out with only the coarse levels, streamer swaps in images with more of them as sample_texture asks for them
+    Texture(daxa::Device device, TextureStreamer& streamer, StreamingSource source);
+    // one array image with a layer per texture of layers, they all have to match in format, size and level count. the
+    // copies only get recorded, the layers can go once upload resolves
+    Texture(daxa::Device device, UploadManager& uploader, std::span<Texture* const> layers);
     ~Texture();
 
-    static auto load_texture(daxa::Device device, u32 size_x, u32 size_y, unsigned char* data, Type type) -> PayLoad;
-    static auto load_texture(daxa::Device device, const std::string& file_path, Type type) -> PayLoad;
-
     auto get_texture_id() -> TextureId;
 
+    // decode with whatever decoder the signature picks, rgb images stay at 3 channels and everything else turns into 4.
+    // large images get split into strips across pool when the decoder can do that
+    static auto load_pixels(const std::string& path, ThreadPool* pool = nullptr) -> DecodedImage;
+    static auto load_pixels(std::span<const u8> bytes, ThreadPool* pool = nullptr) -> DecodedImage;
+
     daxa::Device device;
     daxa::ImageId image_id;
     daxa::SamplerId sampler_id;
-};
\ No newline at end of file
+    UploadFuture upload = {};
+
+    // set by TextureStreamer::add, image_id only holds the levels from first_mip on
+    TextureStreamer* streamer = nullptr;
+    u32 streaming_slot = 0;
+    u32 first_mip = 0;
+
+    // only filled for NORMAL_XY, what dropping z costs
+    NormalMapError normal_map_error = {};
+
+private:
+    void create(UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, u32 channel_count, Type type, MipGeneration mip_generation = MipGeneration::CPU_BOX);
+    void create(UploadManager& uploader, const Ktx2File& file);
+    void create_normal_map(UploadManager& uploader, u32 size_x, u32 size_y, const unsigned char* data, u32 channel_count);
+    void create_sampler();
+};
@@ -0,0 +1,114 @@
+#include "texture_array_packing.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+
+namespace {
+    auto get_key(const TextureArrayCandidate& candidate) {
+        return std::make_tuple(static_cast<u32>(candidate.format), candidate.size_x, candidate.size_y, candidate.mip_level_count);
+    }
+
+    auto is_eligible(const TextureArrayCandidate& candidate, const TextureArrayPackingInfo& info) -> bool {
+        return candidate.packable && candidate.size_x != 0 && candidate.size_y != 0 && candidate.size_x <= info.max_size && candidate.size_y <= info.max_size;
+    }
+}
+
+auto TextureArrayPackingStatistics::get_view_count() const -> u32 {
+    return image_count - packed_image_count + array_count;
+}
+
+void TextureArrayPackingStatistics::print() const {
+    std::cout << "packed " << packed_image_count << "/" << image_count << " textures into " << array_count << " arrays, "
+              << get_view_count() << " image views instead of " << image_count << std::endl;
+}
+
+auto pack_texture_arrays(std::span<const TextureArrayCandidate> candidates, const TextureArrayPackingInfo& info) -> TextureArrayPacking {
+    TextureArrayPacking packing = {};
+    packing.placements.resize(candidates.size());
+    packing.statistics.image_count = static_cast<u32>(candidates.size());
+
+    std::vector<u32> order = {};
+    for(u32 i = 0; i < candidates.size(); i++) {
+        if(is_eligible(candidates[i], info)) {
+            order.push_back(i);
+        }
+    }
+    // the index as the last key makes it a total order, equal keys cant end up in whatever order the sort likes
+    std::sort(order.begin(), order.end(), [&](u32 a, u32 b) {
+        return std::make_tuple(get_key(candidates[a]), a) < std::make_tuple(get_key(candidates[b]), b);
+    });
+
+    u32 max_layer_count = std::max(info.max_layer_count, 1u);
+    u32 min_layer_count = std::max(info.min_layer_count, 1u);
+    usize group_start = 0;
+    while(group_start < order.size()) {
+        usize group_end = group_start + 1;
+        while(group_end < order.size() && get_key(candidates[order[group_end]]) == get_key(candidates[order[group_start]])) {
+            group_end++;
+        }
+
+        for(usize chunk_start = group_start; chunk_start < group_end; chunk_start += max_layer_count) {
+            usize chunk_end = std::min<usize>(chunk_start + max_layer_count, group_end);
+            if(chunk_end - chunk_start < min_layer_count) {
+                continue;
+            }
+
+            const TextureArrayCandidate& first = candidates[order[chunk_start]];
+            TextureArrayLayout layout = {
+                .format = first.format,
+                .size_x = first.size_x,
+                .size_y = first.size_y,
+                .mip_level_count = first.mip_level_count,
+            };
+            u32 array_index = static_cast<u32>(packing.arrays.size());
+            for(usize i = chunk_start; i < chunk_end; i++) {
+                packing.placements[order[i]] = { .array = array_index, .layer = static_cast<u32>(layout.images.size()) };
+                layout.images.push_back(order[i]);
+            }
+            packing.statistics.packed_image_count += static_cast<u32>(layout.images.size());
+            packing.arrays.push_back(std::move(layout));
+        }
+        group_start = group_end;
+    }
+
+    packing.statistics.array_count = static_cast<u32>(packing.arrays.size());
+    return packing;
+}
+
+auto validate_texture_array_packing(std::span<const TextureArrayCandidate> candidates, const TextureArrayPacking& packing, const TextureArrayPackingInfo& info) -> bool {
+    if(packing.placements.size() != candidates.size()) {
+        return false;
+    }
+
+    std::vector<u32> seen(candidates.size(), 0);
+    for(u32 array_index = 0; array_index < packing.arrays.size(); array_index++) {
+        const TextureArrayLayout& layout = packing.arrays[array_index];
+        if(layout.images.size() < std::max(info.min_layer_count, 1u) || layout.images.size() > std::max(info.max_layer_count, 1u)) {
+            return false;
+        }
+
+        for(u32 layer = 0; layer < layout.images.size(); layer++) {
+            u32 image_index = layout.images[layer];
+            if(image_index >= candidates.size()) {
+                return false;
+            }
+
+            const TextureArrayCandidate& candidate = candidates[image_index];
+            bool matches = candidate.format == layout.format && candidate.size_x == layout.size_x && candidate.size_y == layout.size_y && candidate.mip_level_count == layout.mip_level_count;
+            const TextureArrayPlacement& placement = packing.placements[image_index];
+            if(!matches || !is_eligible(candidate, info) || placement.array != array_index || placement.layer != layer) {
+                return false;
+            }
+            seen[image_index]++;
+        }
+    }
+
+    for(u32 i = 0; i < candidates.size(); i++) {
+        bool placed = packing.placements[i].array != TextureArrayPlacement::NO_ARRAY;
+        if(seen[i] != (placed ? 1u : 0u)) {
+            return false;
+        }
+    }
+    return true;
+}
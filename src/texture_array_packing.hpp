@@ -0,0 +1,66 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <limits>
+#include <span>
+#include <vector>
+
+struct TextureArrayPackingInfo {
+    // only images with both sides at most this go into arrays, the big ones keep their own image
+    u32 max_size = 512;
+    // the least every device supports, bigger groups get split into several arrays
+    u32 max_layer_count = 256;
+    // smaller groups stay as they are, a single layer array would need a view type of its own
+    u32 min_layer_count = 2;
+};
+
+// what an image looks like to the packer, images can only share an array when all of it matches
+struct TextureArrayCandidate {
+    daxa::Format format = daxa::Format::R8G8B8A8_SRGB;
+    u32 size_x = 0;
+    u32 size_y = 0;
+    u32 mip_level_count = 1;
+    // streamed images swap their image and cant live in a layer
+    bool packable = true;
+};
+
+struct TextureArrayPackingStatistics {
+    u32 image_count = 0;
+    u32 packed_image_count = 0;
+    u32 array_count = 0;
+
+    // image views the materials point at afterwards, the arrays count once
+    auto get_view_count() const -> u32;
+    void print() const;
+};
+
+// one array image, layer i gets the candidate images[i]
+struct TextureArrayLayout {
+    daxa::Format format = daxa::Format::R8G8B8A8_SRGB;
+    u32 size_x = 0;
+    u32 size_y = 0;
+    u32 mip_level_count = 1;
+    std::vector<u32> images = {};
+};
+
+struct TextureArrayPlacement {
+    static constexpr u32 NO_ARRAY = std::numeric_limits<u32>::max();
+
+    u32 array = NO_ARRAY;
+    u32 layer = 0;
+};
+
+struct TextureArrayPacking {
+    std::vector<TextureArrayLayout> arrays = {};
+    // one per candidate, NO_ARRAY for the ones that keep their own image
+    std::vector<TextureArrayPlacement> placements = {};
+    TextureArrayPackingStatistics statistics = {};
+};
+
+// groups candidates by format, size and level count. groups are ordered by that key and layers by candidate index,
+// so the result only depends on the input and never on the order images finished loading in
+auto pack_texture_arrays(std::span<const TextureArrayCandidate> candidates, const TextureArrayPackingInfo& info = {}) -> TextureArrayPacking;
+// checks that every packed candidate sits in exactly one layer of an array that matches it and no array breaks the limits
+auto validate_texture_array_packing(std::span<const TextureArrayCandidate> candidates, const TextureArrayPacking& packing, const TextureArrayPackingInfo& info = {}) -> bool;
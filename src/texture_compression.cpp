@@ -0,0 +1,796 @@
+#include "texture_compression.hpp"
+#include "mip_generator.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+namespace {
+    using Block = std::array<std::array<f32, 4>, 16>;
+
+    constexpr std::array<u32, 16> BC7_WEIGHTS_4 = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // 4x4 texels starting at block_x, block_y, reads past the edge repeat the last texel
+    auto load_block(std::span<const u8> rgba, u32 size_x, u32 size_y, u32 block_x, u32 block_y) -> Block {
+        Block block = {};
+        for(u32 y = 0; y < 4; y++) {
+            for(u32 x = 0; x < 4; x++) {
+                u32 pixel_x = std::min(block_x * 4 + x, size_x - 1);
+                u32 pixel_y = std::min(block_y * 4 + y, size_y - 1);
+                const u8* pixel = &rgba[(static_cast<usize>(pixel_y) * size_x + pixel_x) * 4];
+                block[y * 4 + x] = { static_cast<f32>(pixel[0]), static_cast<f32>(pixel[1]), static_cast<f32>(pixel[2]), static_cast<f32>(pixel[3]) };
+            }
+        }
+        return block;
+    }
+
+    // principal axis of the first channel_count channels by power iteration, good enough to pick endpoints along
+    auto get_principal_axis(const Block& block, u32 channel_count, std::array<f32, 4>& mean) -> std::array<f32, 4> {
+        mean = {};
+        for(const auto& pixel : block) {
+            for(u32 c = 0; c < channel_count; c++) {
+                mean[c] += pixel[c] / 16.0f;
+            }
+        }
+
+        std::array<std::array<f32, 4>, 4> covariance = {};
+        for(const auto& pixel : block) {
+            for(u32 i = 0; i < channel_count; i++) {
+                for(u32 j = 0; j < channel_count; j++) {
+                    covariance[i][j] += (pixel[i] - mean[i]) * (pixel[j] - mean[j]);
+                }
+            }
+        }
+
+        std::array<f32, 4> axis = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for(u32 iteration = 0; iteration < 8; iteration++) {
+            std::array<f32, 4> next = {};
+            f32 length = 0.0f;
+            for(u32 i = 0; i < channel_count; i++) {
+                for(u32 j = 0; j < channel_count; j++) {
+                    next[i] += covariance[i][j] * axis[j];
+                }
+                length = std::max(length, std::abs(next[i]));
+            }
+            if(length <= 1e-6f) {
+                break;
+            }
+            for(u32 i = 0; i < channel_count; i++) {
+                axis[i] = next[i] / length;
+            }
+        }
+        return axis;
+    }
+
+    auto get_endpoints_along_axis(const Block& block, u32 channel_count, std::array<f32, 4>& e0, std::array<f32, 4>& e1) {
+        std::array<f32, 4> mean = {};
+        std::array<f32, 4> axis = get_principal_axis(block, channel_count, mean);
+
+        f32 axis_length_squared = 0.0f;
+        for(u32 c = 0; c < channel_count; c++) {
+            axis_length_squared += axis[c] * axis[c];
+        }
+        axis_length_squared = std::max(axis_length_squared, 1e-12f);
+
+        f32 t_min = std::numeric_limits<f32>::max();
+        f32 t_max = std::numeric_limits<f32>::lowest();
+        for(const auto& pixel : block) {
+            f32 t = 0.0f;
+            for(u32 c = 0; c < channel_count; c++) {
+                t += (pixel[c] - mean[c]) * axis[c];
+            }
+            t /= axis_length_squared;
+            t_min = std::min(t_min, t);
+            t_max = std::max(t_max, t);
+        }
+
+        for(u32 c = 0; c < channel_count; c++) {
+            e0[c] = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+            e1[c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+        }
+    }
+
+    // fits both endpoints to the chosen indices, weights are how much of e1 every texel takes
+    auto fit_endpoints(const Block& block, u32 channel_count, std::span<const f32> weights, std::array<f32, 4>& e0, std::array<f32, 4>& e1) -> bool {
+        f32 aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        std::array<f32, 4> ax = {}, bx = {};
+        for(u32 i = 0; i < 16; i++) {
+            f32 b = weights[i];
+            f32 a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for(u32 c = 0; c < channel_count; c++) {
+                ax[c] += a * block[i][c];
+                bx[c] += b * block[i][c];
+            }
+        }
+
+        f32 determinant = aa * bb - ab * ab;
+        if(std::abs(determinant) < 1e-6f) {
+            return false;
+        }
+
+        for(u32 c = 0; c < channel_count; c++) {
+            e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+            e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    struct BitWriter {
+        std::array<u8, 16> bytes = {};
+        u32 position = 0;
+
+        void write(u32 value, u32 bit_count) {
+            for(u32 i = 0; i < bit_count; i++, position++) {
+                bytes[position / 8] |= static_cast<u8>(((value >> i) & 1) << (position % 8));
+            }
+        }
+    };
+
+    struct BitReader {
+        const u8* bytes = nullptr;
+        u32 position = 0;
+
+        auto read(u32 bit_count) -> u32 {
+            u32 value = 0;
+            for(u32 i = 0; i < bit_count; i++, position++) {
+                value |= static_cast<u32>((bytes[position / 8] >> (position % 8)) & 1) << i;
+            }
+            return value;
+        }
+    };
+
+    auto pack_565(const std::array<f32, 4>& color) -> u16 {
+        u32 r = static_cast<u32>(std::lround(color[0] * 31.0f / 255.0f));
+        u32 g = static_cast<u32>(std::lround(color[1] * 63.0f / 255.0f));
+        u32 b = static_cast<u32>(std::lround(color[2] * 31.0f / 255.0f));
+        return static_cast<u16>((r << 11) | (g << 5) | b);
+    }
+
+    auto unpack_565(u16 packed) -> std::array<f32, 4> {
+        u32 r = (packed >> 11) & 31;
+        u32 g = (packed >> 5) & 63;
+        u32 b = packed & 31;
+        return { static_cast<f32>((r << 3) | (r >> 2)), static_cast<f32>((g << 2) | (g >> 4)), static_cast<f32>((b << 3) | (b >> 2)), 255.0f };
+    }
+
+    auto get_bc1_palette(u16 c0, u16 c1) -> std::array<std::array<f32, 4>, 4> {
+        std::array<f32, 4> a = unpack_565(c0);
+        std::array<f32, 4> b = unpack_565(c1);
+        std::array<std::array<f32, 4>, 4> palette = { a, b, {}, {} };
+        for(u32 c = 0; c < 3; c++) {
+            if(c0 > c1) {
+                palette[2][c] = std::floor((2.0f * a[c] + b[c]) / 3.0f);
+                palette[3][c] = std::floor((a[c] + 2.0f * b[c]) / 3.0f);
+            } else {
+                palette[2][c] = std::floor((a[c] + b[c]) / 2.0f);
+                palette[3][c] = 0.0f;
+            }
+        }
+        palette[2][3] = 255.0f;
+        palette[3][3] = c0 > c1 ? 255.0f : 0.0f;
+        return palette;
+    }
+
+    auto encode_bc1_indices(const Block& block, u16 c0, u16 c1, u32& indices) -> f32 {
+        auto palette = get_bc1_palette(c0, c1);
+        // the transparent entry of the 3 color mode is never picked, the images here are opaque
+        u32 usable = c0 > c1 ? 4 : 3;
+        f32 total_error = 0.0f;
+        indices = 0;
+        for(u32 i = 0; i < 16; i++) {
+            f32 best_error = std::numeric_limits<f32>::max();
+            u32 best_index = 0;
+            for(u32 p = 0; p < usable; p++) {
+                f32 error = 0.0f;
+                for(u32 c = 0; c < 3; c++) {
+                    f32 difference = block[i][c] - palette[p][c];
+                    error += difference * difference;
+                }
+                if(error < best_error) {
+                    best_error = error;
+                    best_index = p;
+                }
+            }
+            indices |= best_index << (2 * i);
+            total_error += best_error;
+        }
+        return total_error;
+    }
+
+    void encode_bc1(const Block& block, u8* output) {
+        std::array<f32, 4> e0 = {}, e1 = {};
+        get_endpoints_along_axis(block, 3, e0, e1);
+
+        auto order = [](u16& c0, u16& c1) {
+            if(c0 < c1) {
+                std::swap(c0, c1);
+            }
+        };
+
+        u16 c0 = pack_565(e1);
+        u16 c1 = pack_565(e0);
+        order(c0, c1);
+        u32 indices = 0;
+        f32 error = encode_bc1_indices(block, c0, c1, indices);
+
+        // one least squares pass over the chosen indices
+        if(c0 != c1) {
+            constexpr std::array<f32, 4> INDEX_WEIGHTS = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            std::array<f32, 16> weights = {};
+            for(u32 i = 0; i < 16; i++) {
+                weights[i] = INDEX_WEIGHTS[(indices >> (2 * i)) & 3];
+            }
+            std::array<f32, 4> fitted0 = {}, fitted1 = {};
+            if(fit_endpoints(block, 3, weights, fitted0, fitted1)) {
+                u16 refined0 = pack_565(fitted0);
+                u16 refined1 = pack_565(fitted1);
+                order(refined0, refined1);
+                u32 refined_indices = 0;
+                f32 refined_error = encode_bc1_indices(block, refined0, refined1, refined_indices);
+                if(refined_error < error) {
+                    c0 = refined0;
+                    c1 = refined1;
+                    indices = refined_indices;
+                }
+            }
+        }
+
+        std::memcpy(output, &c0, sizeof(u16));
+        std::memcpy(output + 2, &c1, sizeof(u16));
+        std::memcpy(output + 4, &indices, sizeof(u32));
+    }
+
+    auto get_bc4_palette(u8 a0, u8 a1) -> std::array<f32, 8> {
+        std::array<f32, 8> palette = { static_cast<f32>(a0), static_cast<f32>(a1) };
+        if(a0 > a1) {
+            for(u32 i = 2; i < 8; i++) {
+                palette[i] = std::floor((static_cast<f32>(8 - i) * a0 + static_cast<f32>(i - 1) * a1) / 7.0f + 0.5f);
+            }
+        } else {
+            for(u32 i = 2; i < 6; i++) {
+                palette[i] = std::floor((static_cast<f32>(6 - i) * a0 + static_cast<f32>(i - 1) * a1) / 5.0f + 0.5f);
+            }
+            palette[6] = 0.0f;
+            palette[7] = 255.0f;
+        }
+        return palette;
+    }
+
+    void encode_bc4(const Block& block, u32 channel, u8* output) {
+        f32 min_value = 255.0f;
+        f32 max_value = 0.0f;
+        for(const auto& pixel : block) {
+            min_value = std::min(min_value, pixel[channel]);
+            max_value = std::max(max_value, pixel[channel]);
+        }
+
+        u8 a0 = static_cast<u8>(max_value);
+        u8 a1 = static_cast<u8>(min_value);
+        auto palette = get_bc4_palette(a0, a1);
+
+        u64 indices = 0;
+        for(u32 i = 0; i < 16; i++) {
+            u32 best_index = 0;
+            f32 best_error = std::numeric_limits<f32>::max();
+            for(u32 p = 0; p < 8; p++) {
+                f32 error = std::abs(block[i][channel] - palette[p]);
+                if(error < best_error) {
+                    best_error = error;
+                    best_index = p;
+                }
+            }
+            indices |= static_cast<u64>(best_index) << (3 * i);
+        }
+
+        output[0] = a0;
+        output[1] = a1;
+        for(u32 i = 0; i < 6; i++) {
+            output[2 + i] = static_cast<u8>(indices >> (8 * i));
+        }
+    }
+
+    struct Bc7Endpoints {
+        std::array<u32, 4> e0 = {};
+        std::array<u32, 4> e1 = {};
+        u32 p0 = 0;
+        u32 p1 = 0;
+    };
+
+    auto get_bc7_endpoint(const std::array<u32, 4>& quantized, u32 p_bit, u32 channel) -> u32 {
+        return (quantized[channel] << 1) | p_bit;
+    }
+
+    auto quantize_bc7_endpoint(const std::array<f32, 4>& endpoint, u32 p_bit) -> std::array<u32, 4> {
+        std::array<u32, 4> quantized = {};
+        for(u32 c = 0; c < 4; c++) {
+            quantized[c] = static_cast<u32>(std::clamp(std::lround((endpoint[c] - static_cast<f32>(p_bit)) / 2.0f), 0l, 127l));
+        }
+        return quantized;
+    }
+
+    auto encode_bc7_indices(const Block& block, const Bc7Endpoints& endpoints, std::array<u32, 16>& indices) -> f32 {
+        std::array<std::array<f32, 4>, 16> palette = {};
+        for(u32 p = 0; p < 16; p++) {
+            for(u32 c = 0; c < 4; c++) {
+                u32 a = get_bc7_endpoint(endpoints.e0, endpoints.p0, c);
+                u32 b = get_bc7_endpoint(endpoints.e1, endpoints.p1, c);
+                palette[p][c] = static_cast<f32>(((64 - BC7_WEIGHTS_4[p]) * a + BC7_WEIGHTS_4[p] * b + 32) >> 6);
+            }
+        }
+
+        f32 total_error = 0.0f;
+        for(u32 i = 0; i < 16; i++) {
+            f32 best_error = std::numeric_limits<f32>::max();
+            for(u32 p = 0; p < 16; p++) {
+                f32 error = 0.0f;
+                for(u32 c = 0; c < 4; c++) {
+                    f32 difference = block[i][c] - palette[p][c];
+                    error += difference * difference;
+                }
+                if(error < best_error) {
+                    best_error = error;
+                    indices[i] = p;
+                }
+            }
+            total_error += best_error;
+        }
+        return total_error;
+    }
+
+    // tries every p bit combination for the endpoints and keeps the one with the lowest error
+    auto quantize_bc7_endpoints(const Block& block, const std::array<f32, 4>& e0, const std::array<f32, 4>& e1, Bc7Endpoints& best, std::array<u32, 16>& best_indices) -> f32 {
+        f32 best_error = std::numeric_limits<f32>::max();
+        for(u32 p0 = 0; p0 < 2; p0++) {
+            for(u32 p1 = 0; p1 < 2; p1++) {
+                Bc7Endpoints endpoints = { quantize_bc7_endpoint(e0, p0), quantize_bc7_endpoint(e1, p1), p0, p1 };
+                std::array<u32, 16> indices = {};
+                f32 error = encode_bc7_indices(block, endpoints, indices);
+                if(error < best_error) {
+                    best_error = error;
+                    best = endpoints;
+                    best_indices = indices;
+                }
+            }
+        }
+        return best_error;
+    }
+
+    void encode_bc7(const Block& block, u8* output) {
+        std::array<f32, 4> e0 = {}, e1 = {};
+        get_endpoints_along_axis(block, 4, e0, e1);
+
+        Bc7Endpoints endpoints = {};
+        std::array<u32, 16> indices = {};
+        f32 error = quantize_bc7_endpoints(block, e0, e1, endpoints, indices);
+
+        std::array<f32, 16> weights = {};
+        for(u32 i = 0; i < 16; i++) {
+            weights[i] = static_cast<f32>(BC7_WEIGHTS_4[indices[i]]) / 64.0f;
+        }
+        std::array<f32, 4> fitted0 = {}, fitted1 = {};
+        if(error > 0.0f && fit_endpoints(block, 4, weights, fitted0, fitted1)) {
+            Bc7Endpoints refined = {};
+            std::array<u32, 16> refined_indices = {};
+            if(quantize_bc7_endpoints(block, fitted0, fitted1, refined, refined_indices) < error) {
+                endpoints = refined;
+                indices = refined_indices;
+            }
+        }
+
+        // the anchor index only stores 3 bits, flip the endpoints when its top bit is set
+        if(indices[0] >= 8) {
+            std::swap(endpoints.e0, endpoints.e1);
+            std::swap(endpoints.p0, endpoints.p1);
+            for(u32& index : indices) {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter writer = {};
+        writer.write(1 << 6, 7);
+        for(u32 c = 0; c < 4; c++) {
+            writer.write(endpoints.e0[c], 7);
+            writer.write(endpoints.e1[c], 7);
+        }
+        writer.write(endpoints.p0, 1);
+        writer.write(endpoints.p1, 1);
+        writer.write(indices[0], 3);
+        for(u32 i = 1; i < 16; i++) {
+            writer.write(indices[i], 4);
+        }
+        std::memcpy(output, writer.bytes.data(), writer.bytes.size());
+    }
+
+    void decode_block(const u8* input, BlockFormat format, std::array<std::array<u8, 4>, 16>& pixels) {
+        switch(format) {
+            case BlockFormat::BC1: {
+                u16 c0, c1;
+                u32 indices;
+                std::memcpy(&c0, input, sizeof(u16));
+                std::memcpy(&c1, input + 2, sizeof(u16));
+                std::memcpy(&indices, input + 4, sizeof(u32));
+                auto palette = get_bc1_palette(c0, c1);
+                for(u32 i = 0; i < 16; i++) {
+                    const auto& color = palette[(indices >> (2 * i)) & 3];
+                    pixels[i] = { static_cast<u8>(color[0]), static_cast<u8>(color[1]), static_cast<u8>(color[2]), static_cast<u8>(color[3]) };
+                }
+                break;
+            }
+            case BlockFormat::BC4:
+            case BlockFormat::BC5: {
+                u32 channel_count = format == BlockFormat::BC4 ? 1 : 2;
+                for(u32 i = 0; i < 16; i++) {
+                    pixels[i] = { 0, 0, 0, 255 };
+                }
+                for(u32 c = 0; c < channel_count; c++) {
+                    const u8* channel = input + 8 * c;
+                    auto palette = get_bc4_palette(channel[0], channel[1]);
+                    u64 indices = 0;
+                    for(u32 i = 0; i < 6; i++) {
+                        indices |= static_cast<u64>(channel[2 + i]) << (8 * i);
+                    }
+                    for(u32 i = 0; i < 16; i++) {
+                        pixels[i][c] = static_cast<u8>(palette[(indices >> (3 * i)) & 7]);
+                    }
+                }
+                break;
+            }
+            case BlockFormat::BC7: {
+                BitReader reader = { input };
+                if(reader.read(7) != (1 << 6)) {
+                    pixels.fill({ 255, 0, 255, 255 });
+                    break;
+                }
+                std::array<u32, 4> e0 = {}, e1 = {};
+                for(u32 c = 0; c < 4; c++) {
+                    e0[c] = reader.read(7);
+                    e1[c] = reader.read(7);
+                }
+                u32 p0 = reader.read(1);
+                u32 p1 = reader.read(1);
+                for(u32 i = 0; i < 16; i++) {
+                    u32 weight = BC7_WEIGHTS_4[reader.read(i == 0 ? 3 : 4)];
+                    for(u32 c = 0; c < 4; c++) {
+                        pixels[i][c] = static_cast<u8>(((64 - weight) * ((e0[c] << 1) | p0) + weight * ((e1[c] << 1) | p1) + 32) >> 6);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    auto get_channel_count(BlockFormat format) -> u32 {
+        switch(format) {
+            case BlockFormat::BC1: return 3;
+            case BlockFormat::BC4: return 1;
+            case BlockFormat::BC5: return 2;
+            case BlockFormat::BC7: return 4;
+        }
+        return 4;
+    }
+
+    auto get_absolute_level_size(u32 size, u32 level) -> u32 {
+        return std::max(1u, size >> level);
+    }
+
+    auto get_compressed_size(u32 size_x, u32 size_y, BlockFormat format) -> usize {
+        return static_cast<usize>((size_x + 3) / 4) * ((size_y + 3) / 4) * get_block_size(format);
+    }
+
+    struct CacheHeader {
+        u32 magic;
+        u32 version;
+        u32 format;
+        u32 srgb;
+        u32 size_x;
+        u32 size_y;
+        u32 level_count;
+        u32 padding;
+        // the normal map error comes back with a cache hit too
+        u64 normal_texel_count;
+        f64 normal_sum_angle_error;
+        f32 normal_max_angle_error;
+        u32 normal_padding;
+    };
+}
+
+void CompressionStatistics::print(const std::string& name) const {
+    std::cout << name << ": " << get_block_format_name(format) << (cache_hit ? " (cached)" : "") << " in " << time_ms << " ms, "
+              << static_cast<f64>(uncompressed_bytes) / (1024.0 * 1024.0) << " -> " << static_cast<f64>(compressed_bytes) / (1024.0 * 1024.0) << " MiB, psnr " << psnr << " dB" << std::endl;
+}
+
+auto get_block_size(BlockFormat format) -> usize {
+    return (format == BlockFormat::BC1 || format == BlockFormat::BC4) ? 8 : 16;
+}
+
+auto get_block_format_name(BlockFormat format) -> const char* {
+    switch(format) {
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC4: return "BC4";
+        case BlockFormat::BC5: return "BC5";
+        case BlockFormat::BC7: return "BC7";
+    }
+    return "unknown";
+}
+
+auto get_compressed_format(BlockFormat format, bool srgb) -> daxa::Format {
+    switch(format) {
+        case BlockFormat::BC1: return srgb ? daxa::Format::BC1_RGB_SRGB_BLOCK : daxa::Format::BC1_RGB_UNORM_BLOCK;
+        case BlockFormat::BC4: return daxa::Format::BC4_UNORM_BLOCK;
+        case BlockFormat::BC5: return daxa::Format::BC5_UNORM_BLOCK;
+        case BlockFormat::BC7: return srgb ? daxa::Format::BC7_SRGB_BLOCK : daxa::Format::BC7_UNORM_BLOCK;
+    }
+    return daxa::Format::UNDEFINED;
+}
+
+auto compress_image(std::span<const u8> rgba, u32 size_x, u32 size_y, BlockFormat format, u32 thread_count) -> std::vector<u8> {
+    u32 blocks_x = (size_x + 3) / 4;
+    u32 blocks_y = (size_y + 3) / 4;
+    usize block_size = get_block_size(format);
+    std::vector<u8> blocks(static_cast<usize>(blocks_x) * blocks_y * block_size);
+
+    std::atomic<u32> next_row = 0;
+    auto worker = [&] {
+        for(u32 block_y = next_row++; block_y < blocks_y; block_y = next_row++) {
+            for(u32 block_x = 0; block_x < blocks_x; block_x++) {
+                Block block = load_block(rgba, size_x, size_y, block_x, block_y);
+                u8* output = &blocks[(static_cast<usize>(block_y) * blocks_x + block_x) * block_size];
+                switch(format) {
+                    case BlockFormat::BC1: encode_bc1(block, output); break;
+                    case BlockFormat::BC4: encode_bc4(block, 0, output); break;
+                    case BlockFormat::BC5: encode_bc4(block, 0, output); encode_bc4(block, 1, output + 8); break;
+                    case BlockFormat::BC7: encode_bc7(block, output); break;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads = {};
+    for(u32 i = 1; i < std::min(thread_count, blocks_y); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    return blocks;
+}
+
+auto decompress_image(std::span<const u8> blocks, u32 size_x, u32 size_y, BlockFormat format) -> std::vector<u8> {
+    u32 blocks_x = (size_x + 3) / 4;
+    u32 blocks_y = (size_y + 3) / 4;
+    usize block_size = get_block_size(format);
+    std::vector<u8> rgba(static_cast<usize>(size_x) * size_y * 4);
+
+    std::array<std::array<u8, 4>, 16> pixels = {};
+    for(u32 block_y = 0; block_y < blocks_y; block_y++) {
+        for(u32 block_x = 0; block_x < blocks_x; block_x++) {
+            decode_block(&blocks[(static_cast<usize>(block_y) * blocks_x + block_x) * block_size], format, pixels);
+            for(u32 y = 0; y < 4 && block_y * 4 + y < size_y; y++) {
+                for(u32 x = 0; x < 4 && block_x * 4 + x < size_x; x++) {
+                    std::memcpy(&rgba[((static_cast<usize>(block_y) * 4 + y) * size_x + block_x * 4 + x) * 4], pixels[y * 4 + x].data(), 4);
+                }
+            }
+        }
+    }
+    return rgba;
+}
+
+auto compute_psnr(std::span<const u8> reference, std::span<const u8> pixels, u32 channel_count) -> f64 {
+    f64 squared_error = 0.0;
+    usize sample_count = 0;
+    for(usize i = 0; i + 3 < std::min(reference.size(), pixels.size()); i += 4) {
+        for(u32 c = 0; c < channel_count; c++) {
+            f64 difference = static_cast<f64>(reference[i + c]) - static_cast<f64>(pixels[i + c]);
+            squared_error += difference * difference;
+        }
+        sample_count += channel_count;
+    }
+
+    if(squared_error == 0.0 || sample_count == 0) {
+        return std::numeric_limits<f64>::infinity();
+    }
+    return 10.0 * std::log10(255.0 * 255.0 / (squared_error / static_cast<f64>(sample_count)));
+}
+
+auto compress_texture(std::span<const u8> rgba, u32 size_x, u32 size_y, BlockFormat format, bool srgb, u32 thread_count, CompressionStatistics& statistics) -> CompressedTexture {
+    auto start = std::chrono::steady_clock::now();
+
+    if(format == BlockFormat::BC1) {
+        for(usize i = 3; i < rgba.size(); i += 4) {
+            if(rgba[i] != 255) {
+                format = BlockFormat::BC7;
+                break;
+            }
+        }
+    }
+
+    u32 mip_level_count = get_mip_level_count(size_x, size_y);
+    MipChain chain = generate_mip_chain(rgba, size_x, size_y, mip_level_count, { .srgb = srgb });
+
+    CompressedTexture texture = {
+        .format = format,
+        .srgb = srgb,
+        .size_x = size_x,
+        .size_y = size_y,
+    };
+
+    for(u32 level = 0; level < mip_level_count; level++) {
+        u32 level_x = get_absolute_level_size(size_x, level);
+        u32 level_y = get_absolute_level_size(size_y, level);
+        std::span<const u8> level_pixels = std::span<const u8>{chain.data}.subspan(chain.offsets[level], static_cast<usize>(level_x) * level_y * 4);
+
+        std::vector<u8> blocks = compress_image(level_pixels, level_x, level_y, format, thread_count);
+        texture.offsets.push_back(texture.data.size());
+        texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+    }
+
+    statistics.format = format;
+    statistics.time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    statistics.uncompressed_bytes = chain.data.size();
+    statistics.compressed_bytes = texture.data.size();
+    std::vector<u8> decoded = decompress_image(std::span<const u8>{texture.data}.subspan(0, get_compressed_size(size_x, size_y, format)), size_x, size_y, format);
+    statistics.psnr = compute_psnr(rgba, decoded, get_channel_count(format));
+
+    return texture;
+}
+
+auto compress_normal_map(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, u32 thread_count, CompressionStatistics& statistics) -> CompressedTexture {
+    auto start = std::chrono::steady_clock::now();
+
+    u32 mip_level_count = get_mip_level_count(size_x, size_y);
+    usize chain_size = 0;
+    std::vector<usize> rg_offsets = get_normal_map_offsets(size_x, size_y, mip_level_count, chain_size);
+    std::vector<u8> rg(chain_size);
+
+    CompressedTexture texture = {
+        .format = BlockFormat::BC5,
+        .srgb = false,
+        .size_x = size_x,
+        .size_y = size_y,
+    };
+    texture.normal_map_error = pack_normal_map(pixels, channel_count, size_x, size_y, rg, rg_offsets);
+
+    // the encoder reads RGBA, blue and alpha are never looked at by BC5
+    std::vector<u8> level_0_rgba = {};
+    usize uncompressed_bytes = 0;
+    for(u32 level = 0; level < mip_level_count; level++) {
+        u32 level_x = get_absolute_level_size(size_x, level);
+        u32 level_y = get_absolute_level_size(size_y, level);
+        usize texel_count = static_cast<usize>(level_x) * level_y;
+
+        std::vector<u8> rgba(texel_count * 4, 0);
+        for(usize i = 0; i < texel_count; i++) {
+            rgba[i * 4 + 0] = rg[rg_offsets[level] + i * 2 + 0];
+            rgba[i * 4 + 1] = rg[rg_offsets[level] + i * 2 + 1];
+            rgba[i * 4 + 3] = 255;
+        }
+
+        std::vector<u8> blocks = compress_image(rgba, level_x, level_y, BlockFormat::BC5, thread_count);
+        texture.offsets.push_back(texture.data.size());
+        texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+        uncompressed_bytes += rgba.size();
+        if(level == 0) {
+            level_0_rgba = std::move(rgba);
+        }
+    }
+
+    statistics.format = BlockFormat::BC5;
+    statistics.time_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    statistics.uncompressed_bytes = uncompressed_bytes;
+    statistics.compressed_bytes = texture.data.size();
+    std::vector<u8> decoded = decompress_image(std::span<const u8>{texture.data}.subspan(0, get_compressed_size(size_x, size_y, BlockFormat::BC5)), size_x, size_y, BlockFormat::BC5);
+    statistics.psnr = compute_psnr(level_0_rgba, decoded, 2);
+
+    return texture;
+}
+
+auto TextureCache::get_cache_path(u64 source_hash, BlockFormat format, bool srgb) -> std::filesystem::path {
+    char hash_string[17] = {};
+    std::snprintf(hash_string, sizeof(hash_string), "%016llx", static_cast<unsigned long long>(source_hash));
+    return std::filesystem::path("cache") / "textures" / (std::string(hash_string) + "_" + get_block_format_name(format) + (srgb ? "_srgb" : "") + ".bin");
+}
+
+auto TextureCache::load(u64 source_hash, BlockFormat format, bool srgb) -> std::optional<CompressedTexture> {
+    std::filesystem::path cache_path = get_cache_path(source_hash, format, srgb);
+    if(!std::filesystem::exists(cache_path)) {
+        return std::nullopt;
+    }
+
+    std::unique_ptr<MappedFile> file = {};
+    try {
+        file = std::make_unique<MappedFile>(cache_path);
+    } catch(const std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+        return std::nullopt;
+    }
+
+    std::span<const u8> bytes = file->get_data();
+    CacheHeader header = {};
+    if(bytes.size() < sizeof(CacheHeader)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(CacheHeader));
+    if(header.magic != MAGIC || header.version != VERSION || header.format > static_cast<u32>(BlockFormat::BC7) || header.level_count == 0 || header.level_count > 32) {
+        return std::nullopt;
+    }
+
+    // the actual format can differ from the requested one, BC1 turns into BC7 for images with alpha
+    CompressedTexture texture = {
+        .format = static_cast<BlockFormat>(header.format),
+        .srgb = header.srgb != 0,
+        .size_x = header.size_x,
+        .size_y = header.size_y,
+        .normal_map_error = {
+            .texel_count = static_cast<usize>(header.normal_texel_count),
+            .max_angle_error = header.normal_max_angle_error,
+            .sum_angle_error = header.normal_sum_angle_error,
+        },
+    };
+
+    usize expected_size = 0;
+    for(u32 level = 0; level < header.level_count; level++) {
+        texture.offsets.push_back(expected_size);
+        expected_size += get_compressed_size(get_absolute_level_size(header.size_x, level), get_absolute_level_size(header.size_y, level), texture.format);
+    }
+    if(bytes.size() != sizeof(CacheHeader) + expected_size) {
+        return std::nullopt;
+    }
+
+    texture.data.assign(bytes.begin() + sizeof(CacheHeader), bytes.end());
+    return texture;
+}
+
+void TextureCache::store(u64 source_hash, BlockFormat format, bool srgb, const CompressedTexture& texture) {
+    CacheHeader header = {
+        .magic = MAGIC,
+        .version = VERSION,
+        .format = static_cast<u32>(texture.format),
+        .srgb = texture.srgb ? 1u : 0u,
+        .size_x = texture.size_x,
+        .size_y = texture.size_y,
+        .level_count = static_cast<u32>(texture.offsets.size()),
+        .padding = 0,
+        .normal_texel_count = texture.normal_map_error.texel_count,
+        .normal_sum_angle_error = texture.normal_map_error.sum_angle_error,
+        .normal_max_angle_error = texture.normal_map_error.max_angle_error,
+        .normal_padding = 0,
+    };
+
+    std::filesystem::path cache_path = get_cache_path(source_hash, format, srgb);
+    std::filesystem::path temp_path = cache_path;
+    // several loader threads can compress the same image for different models at once
+    temp_path += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+    std::error_code error;
+    std::filesystem::create_directories(cache_path.parent_path(), error);
+
+    {
+        std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+        if(!stream) {
+            std::cerr << "couldn't write texture cache: " << temp_path.string() << std::endl;
+            return;
+        }
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+        stream.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+    }
+
+    std::filesystem::rename(temp_path, cache_path, error);
+    if(error) {
+        std::cerr << "couldn't write texture cache: " << cache_path.string() << std::endl;
+        std::filesystem::remove(temp_path, error);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include "normal_map.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+enum class BlockFormat : u8 {
+    // 4 bpp rgb, only used for opaque images
+    BC1 = 0,
+    // 4 bpp single channel from red
+    BC4 = 1,
+    // 8 bpp red and green, made for tangent space normals
+    BC5 = 2,
+    // 8 bpp rgba, the encoder only emits mode 6
+    BC7 = 3,
+};
+
+// all mip levels of one image, offsets point at the first block of every level
+struct CompressedTexture {
+    BlockFormat format = BlockFormat::BC7;
+    bool srgb = false;
+    u32 size_x = 0;
+    u32 size_y = 0;
+    std::vector<u8> data = {};
+    std::vector<usize> offsets = {};
+    // only filled by compress_normal_map, what dropping z cost on level 0
+    NormalMapError normal_map_error = {};
+};
+
+struct CompressionStatistics {
+    BlockFormat format = BlockFormat::BC7;
+    bool cache_hit = false;
+    f64 time_ms = 0.0;
+    usize uncompressed_bytes = 0;
+    usize compressed_bytes = 0;
+    // of mip 0 over the channels the format keeps, infinity when lossless
+    f64 psnr = 0.0;
+
+    void print(const std::string& name) const;
+};
+
+auto get_block_size(BlockFormat format) -> usize;
+auto get_block_format_name(BlockFormat format) -> const char*;
+auto get_compressed_format(BlockFormat format, bool srgb) -> daxa::Format;
+
+// rgba is tightly packed RGBA8, partial blocks at the edges repeat the last row and column.
+// blocks are handed out row by row to thread_count threads, callers already running on a pool should pass 1
+auto compress_image(std::span<const u8> rgba, u32 size_x, u32 size_y, BlockFormat format, u32 thread_count = 1) -> std::vector<u8>;
+// only understands what compress_image produces, used to measure the error
+auto decompress_image(std::span<const u8> blocks, u32 size_x, u32 size_y, BlockFormat format) -> std::vector<u8>;
+auto compute_psnr(std::span<const u8> reference, std::span<const u8> pixels, u32 channel_count) -> f64;
+
+// builds the mip chain with the cpu mip generator and compresses every level, BC1 falls back to BC7 when the image has alpha
+auto compress_texture(std::span<const u8> rgba, u32 size_x, u32 size_y, BlockFormat format, bool srgb, u32 thread_count, CompressionStatistics& statistics) -> CompressedTexture;
+// BC5 chain of an RGB8 or RGBA8 tangent space normal map. the levels come from pack_normal_map, so they get renormalized
+// like the uncompressed RG8 ones instead of box filtered, the psnr only covers what BC5 loses on top of that
+auto compress_normal_map(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, u32 thread_count, CompressionStatistics& statistics) -> CompressedTexture;
+
+// compressed textures on disk keyed by a hash of the encoded source image and the requested format
+struct TextureCache {
+    static constexpr u32 MAGIC = 0x43435442; // "BTCC"
+    static constexpr u32 VERSION = 2;
+
+    static auto get_cache_path(u64 source_hash, BlockFormat format, bool srgb) -> std::filesystem::path;
+    static auto load(u64 source_hash, BlockFormat format, bool srgb) -> std::optional<CompressedTexture>;
+    static void store(u64 source_hash, BlockFormat format, bool srgb, const CompressedTexture& texture);
+};
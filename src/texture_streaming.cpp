@@ -0,0 +1,375 @@
+#include "texture_streaming.hpp"
+#include "texture.hpp"
+#include "mip_generator.hpp"
+#include "pixel_conversion.hpp"
+#include "resource_budget.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+void TextureStreamingStatistics::print() const {
+    std::cout << "texture streaming: " << static_cast<f64>(resident_bytes) / (1024.0 * 1024.0) << "/" << static_cast<f64>(full_bytes) / (1024.0 * 1024.0)
+              << " MiB resident of a " << static_cast<f64>(budget_bytes) / (1024.0 * 1024.0) << " MiB budget, " << texture_count << " textures " << pending_count << " pending"
+              << "\n  " << upgrades << " upgrades " << evictions << " evictions, uploaded " << static_cast<f64>(uploaded_bytes) / (1024.0 * 1024.0) << " MiB" << std::endl;
+}
+
+auto create_streaming_source(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, bool srgb, ThreadPool* pool) -> StreamingSource {
+    std::vector<u8> rgba = {};
+    if(channel_count == 3) {
+        rgba.resize(static_cast<usize>(size_x) * size_y * 4);
+        expand_rgb_to_rgba(pool, pixels.data(), rgba.data(), static_cast<usize>(size_x) * size_y);
+        pixels = rgba;
+    }
+
+    MipChain chain = generate_mip_chain(pixels, size_x, size_y, get_mip_level_count(size_x, size_y), { .filter = MipFilter::BOX, .srgb = srgb });
+    return StreamingSource {
+        .format = srgb ? daxa::Format::R8G8B8A8_SRGB : daxa::Format::R8G8B8A8_UNORM,
+        .size_x = size_x,
+        .size_y = size_y,
+        .data = std::move(chain.data),
+        .offsets = std::move(chain.offsets),
+    };
+}
+
+auto create_streaming_source(CompressedTexture compressed) -> StreamingSource {
+    return StreamingSource {
+        .format = get_compressed_format(compressed.format, compressed.srgb),
+        .size_x = compressed.size_x,
+        .size_y = compressed.size_y,
+        .data = std::move(compressed.data),
+        .offsets = std::move(compressed.offsets),
+    };
+}
+
+auto create_normal_map_streaming_source(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, NormalMapError& error) -> StreamingSource {
+    StreamingSource source = {
+        .format = daxa::Format::R8G8_UNORM,
+        .size_x = size_x,
+        .size_y = size_y,
+    };
+    usize chain_size = 0;
+    source.offsets = get_normal_map_offsets(size_x, size_y, get_mip_level_count(size_x, size_y), chain_size);
+    source.data.resize(chain_size);
+    error = pack_normal_map(pixels, channel_count, size_x, size_y, source.data, source.offsets);
+    return source;
+}
+
+namespace {
+    auto create_image(daxa::Device& device, const StreamingSource& source, u32 first_mip) -> daxa::ImageId {
+        return ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, {
+            .dimensions = 2,
+            .format = source.format,
+            .size = { std::max(1u, source.size_x >> first_mip), std::max(1u, source.size_y >> first_mip), 1 },
+            .mip_level_count = static_cast<u32>(source.offsets.size()) - first_mip,
+            .array_layer_count = 1,
+            .sample_count = 1,
+            .usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::TRANSFER_DST,
+            .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+            .name = "streamed texture",
+        });
+    }
+
+    // levels first_mip and up become levels 0 and up of image, the uploader copies them out of source while recording
+    auto upload_levels(UploadManager& uploader, daxa::ImageId image, const StreamingSource& source, u32 first_mip) -> UploadFuture {
+        usize base = source.offsets[first_mip];
+        std::vector<usize> offsets = {};
+        for(u32 level = first_mip; level < source.offsets.size(); level++) {
+            offsets.push_back(source.offsets[level] - base);
+        }
+
+        return uploader.upload_image({
+            .image = image,
+            .size_x = std::max(1u, source.size_x >> first_mip),
+            .size_y = std::max(1u, source.size_y >> first_mip),
+            .data = std::as_bytes(std::span<const u8>{source.data}.subspan(base)),
+            .generate_mips = false,
+            .mip_offsets = offsets,
+        });
+    }
+}
+
+TextureStreamer::TextureStreamer(daxa::Device _device, UploadManager& _uploader, const TextureStreamingInfo& _info) : device{_device}, uploader{_uploader}, info{_info} {
+    // written by the shaders and read back every update, host visible so there is no copy in between
+    feedback_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, {
+        .size = static_cast<u32>(info.max_texture_count * sizeof(u32)),
+        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
+        .name = "texture feedback buffer",
+    });
+    feedback = device.get_host_address_as<u32>(feedback_buffer);
+    std::fill(feedback, feedback + info.max_texture_count, ~0u);
+
+    entries.resize(info.max_texture_count);
+    for(u32 slot = info.max_texture_count; slot > 0; slot--) {
+        free_slots.push_back(slot - 1);
+    }
+    statistics.budget_bytes = info.budget_bytes;
+
+    // every streamed texture counts as used by now, the evictor is sorted with the textures anyway
+    budget_evictor = ResourceBudget::get().add_evictor(ResourceCategory::TEXTURE, [] { return ~0ull; }, [this](usize needed) { return trim(needed); });
+}
+
+TextureStreamer::~TextureStreamer() {
+    ResourceBudget::get().remove_evictor(budget_evictor);
+    for(Entry& entry : entries) {
+        if(!entry.pending_image.is_empty()) {
+            ResourceBudget::get().destroy_image(device, entry.pending_image);
+        }
+    }
+    for(RetiredImage& retired : retired_images) {
+        ResourceBudget::get().destroy_image(device, retired.image);
+    }
+    ResourceBudget::get().destroy_buffer(device, feedback_buffer);
+}
+
+void TextureStreamer::add(Texture& texture, StreamingSource source) {
+    if(source.offsets.empty()) {
+        throw std::runtime_error("streamed textures need at least one level");
+    }
+
+    u32 mip_level_count = static_cast<u32>(source.offsets.size());
+    u32 tail_mip = 0;
+    while(tail_mip + 1 < mip_level_count && std::max(source.size_x >> tail_mip, source.size_y >> tail_mip) > info.resident_tail_size) {
+        tail_mip++;
+    }
+
+    u32 slot = 0;
+    {
+        const std::scoped_lock lock(mutex);
+        if(free_slots.empty()) {
+            throw std::runtime_error("texture streamer is out of feedback slots, raise max_texture_count");
+        }
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+
+    // the slot isnt visible to update yet, so the tail can be recorded without holding the lock
+    daxa::ImageId image = create_image(device, source, tail_mip);
+    UploadFuture upload = upload_levels(uploader, image, source, tail_mip);
+
+    const std::scoped_lock lock(mutex);
+    Entry& entry = entries[slot];
+    entry = Entry {
+        .texture = &texture,
+        .source = std::move(source),
+        .mip_level_count = mip_level_count,
+        .tail_mip = tail_mip,
+        .first_mip = tail_mip,
+        .desired_mip = tail_mip,
+        .last_used_update = 0,
+    };
+
+    texture.streamer = this;
+    texture.streaming_slot = slot;
+    texture.first_mip = tail_mip;
+    texture.image_id = image;
+    texture.upload = upload;
+
+    usize size = get_resident_size(entry, tail_mip);
+    statistics.texture_count++;
+    statistics.resident_bytes += size;
+    statistics.full_bytes += entry.source.data.size();
+    statistics.uploaded_bytes += size;
+}
+
+void TextureStreamer::remove(Texture& texture) {
+    const std::scoped_lock lock(mutex);
+    Entry& entry = entries[texture.streaming_slot];
+
+    // the copy into it may still sit in the open batch
+    // the image the pending one would have replaced goes away with the texture instead
+    if(!entry.pending_image.is_empty()) {
+        usize pending_size = get_resident_size(entry, entry.first_mip);
+        retired_images.push_back({ .image = entry.pending_image, .size = pending_size, .future = entry.pending_upload });
+        releasing_bytes = releasing_bytes + pending_size - std::min(releasing_bytes, get_resident_size(entry, texture.first_mip));
+    }
+
+    statistics.texture_count--;
+    statistics.resident_bytes -= get_resident_size(entry, entry.first_mip);
+    statistics.full_bytes -= entry.source.data.size();
+
+    entry = {};
+    feedback[texture.streaming_slot] = ~0u;
+    free_slots.push_back(texture.streaming_slot);
+    texture.streamer = nullptr;
+}
+
+auto TextureStreamer::get_feedback_address(const Texture& texture) const -> daxa::BufferDeviceAddress {
+    return device.get_device_address(feedback_buffer) + texture.streaming_slot * sizeof(u32);
+}
+
+auto TextureStreamer::update() -> std::vector<Texture*> {
+    const std::scoped_lock lock(mutex);
+    update_index++;
+    upload_bytes_left = info.upload_bytes_per_update;
+
+    std::erase_if(retired_images, [&](const RetiredImage& retired) {
+        if(!retired.future.has_value() || !retired.future->is_ready()) {
+            return false;
+        }
+        ResourceBudget::get().destroy_image(device, retired.image);
+        releasing_bytes -= std::min(releasing_bytes, retired.size);
+        return true;
+    });
+
+    std::vector<Texture*> changed = {};
+    std::vector<u32> candidates = {};
+    for(u32 slot = 0; slot < entries.size(); slot++) {
+        Entry& entry = entries[slot];
+        if(entry.texture == nullptr) {
+            continue;
+        }
+
+        if(!entry.pending_image.is_empty() && entry.pending_upload.is_ready()) {
+            retired_images.push_back({ .image = entry.texture->image_id, .size = get_resident_size(entry, entry.texture->first_mip) });
+            entry.texture->image_id = entry.pending_image;
+            entry.texture->first_mip = entry.first_mip;
+            entry.pending_image = {};
+            changed.push_back(entry.texture);
+        }
+
+        // frames in flight keep adding to it, a report that lands between the read and the reset comes back next frame
+        u32 desired_mip = feedback[slot];
+        if(desired_mip == ~0u) {
+            continue;
+        }
+        feedback[slot] = ~0u;
+        entry.desired_mip = std::min(desired_mip, entry.tail_mip);
+        entry.last_used_update = update_index;
+
+        if(entry.desired_mip < entry.first_mip && entry.pending_image.is_empty()) {
+            candidates.push_back(slot);
+        }
+    }
+
+    // the textures furthest away from what they get sampled at go first
+    std::sort(candidates.begin(), candidates.end(), [&](u32 a, u32 b) {
+        u32 gap_a = entries[a].first_mip - entries[a].desired_mip;
+        u32 gap_b = entries[b].first_mip - entries[b].desired_mip;
+        return gap_a != gap_b ? gap_a > gap_b : a < b;
+    });
+
+    usize evictable = get_evictable_size();
+    for(u32 slot : candidates) {
+        Entry& entry = entries[slot];
+
+        // the device wide budget only sees evicted memory once the replaced image is destroyed, counting that in already
+        // keeps a texture that waits for it from evicting again every update
+        usize streamer_room = info.budget_bytes - std::min(info.budget_bytes, statistics.resident_bytes);
+        usize device_room = ResourceBudget::get().get_available();
+        device_room += std::min(releasing_bytes, std::numeric_limits<usize>::max() - device_room);
+
+        // coarser than asked for rather than nothing when the budgets or the uploads of this frame cant take the whole
+        // request. the level is picked against what evicting could free, only then is anything evicted for it
+        u32 first_mip = entry.desired_mip;
+        usize growth = 0;
+        for(; first_mip < entry.first_mip; first_mip++) {
+            usize size = get_resident_size(entry, first_mip);
+            growth = size - get_resident_size(entry, entry.first_mip);
+            if(size <= upload_bytes_left && growth - std::min(growth, streamer_room) <= evictable && growth - std::min(growth, device_room) <= evictable) {
+                break;
+            }
+        }
+        if(first_mip == entry.first_mip) {
+            continue;
+        }
+
+        usize needed = std::max(growth - std::min(growth, streamer_room), growth - std::min(growth, device_room));
+        if(needed > 0) {
+            evictable -= std::min(evictable, evict(needed));
+        }
+
+        // the device wide budget has the final word, until what got evicted for it is destroyed the texture waits
+        if(statistics.resident_bytes + growth <= info.budget_bytes && ResourceBudget::get().fits(growth)) {
+            start_change(entry, first_mip);
+            statistics.upgrades++;
+        }
+    }
+
+    uploader.flush();
+    return changed;
+}
+
+void TextureStreamer::retire_replaced(UploadFuture future) {
+    const std::scoped_lock lock(mutex);
+    for(RetiredImage& retired : retired_images) {
+        if(!retired.future.has_value()) {
+            retired.future = future;
+        }
+    }
+}
+
+auto TextureStreamer::trim(usize needed) -> usize {
+    const std::scoped_lock lock(mutex);
+    return evict(needed);
+}
+
+auto TextureStreamer::get_statistics() const -> TextureStreamingStatistics {
+    const std::scoped_lock lock(mutex);
+    TextureStreamingStatistics result = statistics;
+    result.pending_count = static_cast<u32>(std::count_if(entries.begin(), entries.end(), [](const Entry& entry) { return !entry.pending_image.is_empty(); }));
+    return result;
+}
+
+auto TextureStreamer::get_resident_size(const Entry& entry, u32 first_mip) const -> usize {
+    return entry.source.data.size() - entry.source.offsets[first_mip];
+}
+
+// the budget is charged for the new image right away, the old one lives on until the swap and its retirement
+void TextureStreamer::start_change(Entry& entry, u32 first_mip) {
+    daxa::ImageId image = create_image(device, entry.source, first_mip);
+    entry.pending_upload = upload_levels(uploader, image, entry.source, first_mip);
+    entry.pending_image = image;
+
+    usize size = get_resident_size(entry, first_mip);
+    usize replaced_size = get_resident_size(entry, entry.first_mip);
+    statistics.resident_bytes = statistics.resident_bytes + size - replaced_size;
+    releasing_bytes += replaced_size;
+    statistics.uploaded_bytes += size;
+    upload_bytes_left -= std::min(size, upload_bytes_left);
+    entry.first_mip = first_mip;
+}
+
+// textures sampled by the feedback of this update are never victims, they would come right back
+auto TextureStreamer::is_evictable(const Entry& entry) const -> bool {
+    return entry.texture != nullptr && entry.last_used_update < update_index && entry.first_mip < entry.tail_mip && entry.pending_image.is_empty();
+}
+
+auto TextureStreamer::get_evictable_size() const -> usize {
+    usize size = 0;
+    for(const Entry& entry : entries) {
+        if(is_evictable(entry)) {
+            size += get_resident_size(entry, entry.first_mip) - get_resident_size(entry, entry.tail_mip);
+        }
+    }
+    return size;
+}
+
+auto TextureStreamer::evict(usize needed) -> usize {
+    std::vector<u32> victims = {};
+    for(u32 slot = 0; slot < entries.size(); slot++) {
+        if(is_evictable(entries[slot])) {
+            victims.push_back(slot);
+        }
+    }
+
+    std::sort(victims.begin(), victims.end(), [&](u32 a, u32 b) {
+        return entries[a].last_used_update != entries[b].last_used_update ? entries[a].last_used_update < entries[b].last_used_update : a < b;
+    });
+
+    usize freed = 0;
+    for(u32 slot : victims) {
+        if(freed >= needed) {
+            break;
+        }
+
+        Entry& entry = entries[slot];
+        freed += get_resident_size(entry, entry.first_mip) - get_resident_size(entry, entry.tail_mip);
+        // the image only gets destroyed once the tail replaced it and nothing points at it anymore
+        ResourceBudget::get().mark_releasing(entry.texture->image_id);
+        start_change(entry, entry.tail_mip);
+        statistics.evictions++;
+    }
+    return freed;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "upload_manager.hpp"
+#include "texture_compression.hpp"
+#include "normal_map.hpp"
+
+struct Texture;
+class ThreadPool;
+
+struct TextureStreamingInfo {
+    // device memory every streamed image may take together, the resident tails count towards it as well
+    usize budget_bytes = 256 * 1024 * 1024;
+    // levels up to this size stay resident for as long as the texture lives
+    u32 resident_tail_size = 64;
+    // one update records at most this much into the uploader, the rest waits for the next frames
+    usize upload_bytes_per_update = 32 * 1024 * 1024;
+    // slots of the feedback buffer, one per texture
+    u32 max_texture_count = 4096;
+};
+
+struct TextureStreamingStatistics {
+    u32 texture_count = 0;
+    u32 pending_count = 0;
+    usize resident_bytes = 0;
+    usize budget_bytes = 0;
+    // what every texture would take with its whole chain resident
+    usize full_bytes = 0;
+    u64 upgrades = 0;
+    u64 evictions = 0;
+    usize uploaded_bytes = 0;
+
+    void print() const;
+};
+
+// every level of an image in the layout UploadManager takes, the streamer keeps it on the cpu so any level can go up again
+struct StreamingSource {
+    daxa::Format format = daxa::Format::R8G8B8A8_SRGB;
+    u32 size_x = 0;
+    u32 size_y = 0;
+    std::vector<u8> data = {};
+    std::vector<usize> offsets = {};
+};
+
+// pixels is RGB8 or RGBA8, the chain gets filtered with the cpu box filter. rgb gets expanded over pool when there is one
+auto create_streaming_source(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, bool srgb, ThreadPool* pool = nullptr) -> StreamingSource;
+auto create_streaming_source(CompressedTexture compressed) -> StreamingSource;
+// RG8 chain of a tangent space normal map like Texture::Type::NORMAL_XY makes
+auto create_normal_map_streaming_source(std::span<const u8> pixels, u32 channel_count, u32 size_x, u32 size_y, NormalMapError& error) -> StreamingSource;
+
+// keeps the coarse tail of every registered texture resident and swaps in an image with more levels once sample_texture
+// reports that a finer mip got sampled. over budget the least recently sampled textures drop back to their tail.
+// there is no sparse binding, a change creates a new image starting at the new first level and uploads it from the cpu copy
+struct TextureStreamer {
+    TextureStreamer(daxa::Device device, UploadManager& uploader, const TextureStreamingInfo& info = {});
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    auto operator=(const TextureStreamer&) -> TextureStreamer& = delete;
+
+    // used by Texture, records the upload of the tail and points the texture at it. can be called from any thread
+    void add(Texture& texture, StreamingSource source);
+    void remove(Texture& texture);
+    auto get_feedback_address(const Texture& texture) const -> daxa::BufferDeviceAddress;
+
+    // reads the feedback written since the last call, swaps in images whose upload finished and records new ones.
+    // returns the textures that got a new image, their TextureId has to be written again wherever it is used
+    auto update() -> std::vector<Texture*>;
+    // the images replaced by update stay alive until future resolves, pass the upload of whatever got patched with the new ids
+    void retire_replaced(UploadFuture future);
+
+    // drops the least recently sampled textures to their tail until at least needed bytes are on their way out, for
+    // the ResourceBudget. returns what it dropped
+    auto trim(usize needed) -> usize;
+
+    auto get_statistics() const -> TextureStreamingStatistics;
+
+private:
+    struct Entry {
+        Texture* texture = nullptr;
+        StreamingSource source = {};
+        u32 mip_level_count = 0;
+        u32 tail_mip = 0;
+        // where the texture is headed, the image it currently samples can still start somewhere else while pending
+        u32 first_mip = 0;
+        u32 desired_mip = 0;
+        u64 last_used_update = 0;
+        daxa::ImageId pending_image = {};
+        UploadFuture pending_upload = {};
+    };
+
+    // future stays empty until retire_replaced hands out the upload that stops anything from pointing at image
+    struct RetiredImage {
+        daxa::ImageId image = {};
+        usize size = 0;
+        std::optional<UploadFuture> future = {};
+    };
+
+    auto get_resident_size(const Entry& entry, u32 first_mip) const -> usize;
+    void start_change(Entry& entry, u32 first_mip);
+    // textures that werent sampled in this update and have more than their tail resident
+    auto is_evictable(const Entry& entry) const -> bool;
+    // what evict could free at most right now
+    auto get_evictable_size() const -> usize;
+    // drops the least recently used textures to their tail until needed bytes are free or nothing is left to evict
+    auto evict(usize needed) -> usize;
+
+    daxa::Device device = {};
+    UploadManager& uploader;
+    TextureStreamingInfo info = {};
+
+    daxa::BufferId feedback_buffer = {};
+    u32* feedback = nullptr;
+
+    std::vector<Entry> entries = {};
+    std::vector<u32> free_slots = {};
+    std::vector<RetiredImage> retired_images = {};
+    // images that a pending change replaces or that sit in retired_images, already gone from resident_bytes but still
+    // counted by the ResourceBudget until they are destroyed
+    usize releasing_bytes = 0;
+    u64 update_index = 1;
+    usize upload_bytes_left = 0;
+
+    TextureStreamingStatistics statistics = {};
+    u32 budget_evictor = 0;
+    mutable std::mutex mutex = {};
+};
@@ -1,5 +1,7 @@
 
 #include "../app.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 
 #include <glm/glm.hpp>
 #include <stb_image.h>
@@ -121,7 +123,7 @@ struct TextureQuadApp : public App {
     daxa::TaskGraph render_task_graph = {};
 
     TextureQuadApp() : App("Texture Quad Example") {
-        vertex_buffer = device.create_buffer({
+        vertex_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, {
             .size = 4 * sizeof(Vertex),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "vertex buffer"
@@ -132,7 +134,7 @@ struct TextureQuadApp : public App {
             .name = "task vertex buffer",
         });
 
-        index_buffer = device.create_buffer({
+        index_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, {
             .size = 6 * sizeof(u32),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "index buffer"
@@ -172,13 +174,13 @@ struct TextureQuadApp : public App {
 
         u32 mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(size_x, size_y)))) + 1;
 
-        daxa::BufferId staging_texture_buffer = device.create_buffer({
+        daxa::BufferId staging_texture_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::STAGING, {
             .size = static_cast<u32>(size_x * size_y) * static_cast<u32>(4 * sizeof(u8)),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "staging texture buffer"
         });
 
-        image_id = device.create_image({
+        image_id = ResourceBudget::get().create_image(device, ResourceCategory::TEXTURE, {
             .dimensions = 2,
             .format = daxa::Format::R8G8B8A8_SRGB,
             .size = { static_cast<u32>(size_x), static_cast<u32>(size_y), 1 },
@@ -189,7 +191,7 @@ struct TextureQuadApp : public App {
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY
         });
 
-        sampler_id = device.create_sampler({
+        sampler_id = SamplerCache::get().acquire(device, {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -324,7 +326,7 @@ struct TextureQuadApp : public App {
             .command_lists = {std::move(cmd_list)},
         });
         device.wait_idle();
-        device.destroy_buffer(staging_texture_buffer);
+        ResourceBudget::get().destroy_buffer(device, staging_texture_buffer);
 
         stbi_image_free(data);
 
@@ -374,10 +376,10 @@ struct TextureQuadApp : public App {
     ~TextureQuadApp() {
         device.wait_idle();
         device.collect_garbage();
-        device.destroy_buffer(vertex_buffer);
-        device.destroy_buffer(index_buffer);
-        device.destroy_image(image_id);
-        device.destroy_sampler(sampler_id);
+        ResourceBudget::get().destroy_buffer(device, vertex_buffer);
+        ResourceBudget::get().destroy_buffer(device, index_buffer);
+        ResourceBudget::get().destroy_image(device, image_id);
+        SamplerCache::get().release(device, sampler_id);
     }
 
     void render() {
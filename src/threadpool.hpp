@@ -1,85 +1,676 @@
 #pragma once
 
-#include <atomic>            
-#include <chrono>            
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <exception>         
-#include <functional>        
-#include <future>            
-#include <iostream>          
-#include <memory>            
-#include <mutex>             
-#include <queue>             
-#include <thread>            
-#include <type_traits>       
-#include <utility>           
-#include <vector>   
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 using concurrency_t = std::invoke_result_t<decltype(std::thread::hardware_concurrency)>;
 
+// chase-lev deque (le, pop, cohen, zappa nardelli 2013). only the owning worker pushes and takes at the bottom, every
+// other worker steals from the top. the ring grows when it fills up, old rings stay alive until the deque goes away
+// because a thief might still be reading one
+template <typename T>
+class WorkStealingDeque {
+public:
+    WorkStealingDeque(const int64_t capacity = 256) {
+        this->rings.push_back(std::make_unique<Ring>(capacity));
+        this->ring.store(this->rings.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(T* item) {
+        const int64_t b = this->bottom.load(std::memory_order_relaxed);
+        const int64_t t = this->top.load(std::memory_order_acquire);
+        Ring* r = this->ring.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+            r = grow(r, b, t);
+        }
+        r->put(b, item);
+        this->bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // owner only, count items linked through their next pointers with a single release of bottom
+    void push_many(T* first, const size_t count) {
+        const int64_t b = this->bottom.load(std::memory_order_relaxed);
+        const int64_t t = this->top.load(std::memory_order_acquire);
+        Ring* r = this->ring.load(std::memory_order_relaxed);
+        while (b + static_cast<int64_t>(count) - t > r->capacity) {
+            r = grow(r, b, t);
+        }
+        T* item = first;
+        for (size_t i = 0; i < count; i++) {
+            r->put(b + static_cast<int64_t>(i), item);
+            item = item->next;
+        }
+        this->bottom.store(b + static_cast<int64_t>(count), std::memory_order_release);
+    }
+
+    // owner only, newest first so the owner stays on what is still in its cache
+    auto take() -> T* {
+        const int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+        Ring* r = this->ring.load(std::memory_order_relaxed);
+        this->bottom.store(b, std::memory_order_seq_cst);
+        int64_t t = this->top.load(std::memory_order_seq_cst);
+        if (t > b) {
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = r->get(b);
+        if (t == b) {
+            // last one, a thief might be after it as well
+            if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread, oldest first. nullptr when empty or when another thief won the race
+    auto steal() -> T* {
+        int64_t t = this->top.load(std::memory_order_seq_cst);
+        const int64_t b = this->bottom.load(std::memory_order_seq_cst);
+        if (t >= b) {
+            return nullptr;
+        }
+        Ring* r = this->ring.load(std::memory_order_acquire);
+        T* item = r->get(t);
+        if (!this->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    auto size() const -> size_t {
+        const int64_t b = this->bottom.load(std::memory_order_relaxed);
+        const int64_t t = this->top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    struct Ring {
+        Ring(const int64_t capacity_) : capacity(capacity_), mask(capacity_ - 1), items(std::make_unique<std::atomic<T*>[]>(static_cast<size_t>(capacity_))) {}
+
+        void put(const int64_t index, T* item) {
+            this->items[static_cast<size_t>(index & this->mask)].store(item, std::memory_order_relaxed);
+        }
+
+        auto get(const int64_t index) const -> T* {
+            return this->items[static_cast<size_t>(index & this->mask)].load(std::memory_order_relaxed);
+        }
+
+        int64_t capacity = 0;
+        int64_t mask = 0;
+        std::unique_ptr<std::atomic<T*>[]> items = nullptr;
+    };
+
+    auto grow(Ring* old_ring, const int64_t b, const int64_t t) -> Ring* {
+        this->rings.push_back(std::make_unique<Ring>(old_ring->capacity * 2));
+        Ring* new_ring = this->rings.back().get();
+        for (int64_t i = t; i < b; i++) {
+            new_ring->put(i, old_ring->get(i));
+        }
+        this->ring.store(new_ring, std::memory_order_release);
+        return new_ring;
+    }
+
+    alignas(64) std::atomic<int64_t> top = 0;
+    alignas(64) std::atomic<int64_t> bottom = 0;
+    std::atomic<Ring*> ring = nullptr;
+    std::vector<std::unique_ptr<Ring>> rings = {};
+};
+
+// bounded multi producer multi consumer ring (vyukov), where threads outside the pool drop their tasks
+template <typename T>
+class InjectionQueue {
+public:
+    InjectionQueue(const size_t capacity) : mask(capacity - 1), cells(std::make_unique<Cell[]>(capacity)) {
+        for (size_t i = 0; i < capacity; i++) {
+            this->cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // false when full
+    auto try_push(T* item) -> bool {
+        size_t position = this->enqueue_position.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &this->cells[position & this->mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (this->enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = this->enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // count items linked through their next pointers behind one claim of the enqueue position. false when they dont all
+    // fit, nothing got pushed then
+    auto try_push_many(T* first, const size_t count) -> bool {
+        if (count == 0 || count > this->mask + 1) {
+            return count == 0;
+        }
+        size_t position = this->enqueue_position.load(std::memory_order_relaxed);
+        while (true) {
+            // the last cell being free means the consumers already claimed everything in front of it
+            const size_t last = position + count - 1;
+            const size_t sequence = this->cells[last & this->mask].sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(last);
+            if (difference == 0) {
+                if (this->enqueue_position.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = this->enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        T* item = first;
+        for (size_t i = 0; i < count; i++) {
+            Cell& cell = this->cells[(position + i) & this->mask];
+            // claimed but maybe not handed back yet by its consumer, that is only ever a few instructions away
+            while (cell.sequence.load(std::memory_order_acquire) != position + i) {
+                std::this_thread::yield();
+            }
+            cell.item = item;
+            item = item->next;
+            cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // nullptr when empty
+    auto try_pop() -> T* {
+        size_t position = this->dequeue_position.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true) {
+            cell = &this->cells[position & this->mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (this->dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return nullptr;
+            } else {
+                position = this->dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+        T* item = cell->item;
+        cell->sequence.store(position + this->mask + 1, std::memory_order_release);
+        return item;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence = 0;
+        T* item = nullptr;
+    };
+
+    size_t mask = 0;
+    std::unique_ptr<Cell[]> cells = nullptr;
+    alignas(64) std::atomic<size_t> enqueue_position = 0;
+    alignas(64) std::atomic<size_t> dequeue_position = 0;
+};
+
+// move only void() callable that keeps anything up to INLINE_SIZE bytes inside itself, so the lambdas the pool gets
+// handed never touch the heap. bigger ones still work, they just get allocated
+class PoolTask {
+public:
+    static constexpr size_t INLINE_SIZE = 88;
+
+    PoolTask() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, PoolTask>>>
+    PoolTask(F&& function) {
+        emplace(std::forward<F>(function));
+    }
+
+    PoolTask(PoolTask&& other) noexcept {
+        move_from(other);
+    }
+
+    auto operator=(PoolTask&& other) noexcept -> PoolTask& {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    PoolTask(const PoolTask&) = delete;
+    auto operator=(const PoolTask&) -> PoolTask& = delete;
+
+    ~PoolTask() {
+        reset();
+    }
+
+    template <typename F>
+    void emplace(F&& function) {
+        using Function = std::decay_t<F>;
+        reset();
+        if constexpr (fits_inline<Function>) {
+            new (this->storage) Function(std::forward<F>(function));
+            this->operations = &inline_operations<Function>;
+        } else {
+            *reinterpret_cast<Function**>(this->storage) = new Function(std::forward<F>(function));
+            this->operations = &heap_operations<Function>;
+        }
+    }
+
+    void operator()() {
+        this->operations->invoke(this->storage);
+    }
+
+    explicit operator bool() const {
+        return this->operations != nullptr;
+    }
+
+    void reset() {
+        if (this->operations != nullptr) {
+            this->operations->destroy(this->storage);
+            this->operations = nullptr;
+        }
+    }
+
+private:
+    struct Operations {
+        void (*invoke)(void* storage);
+        // move constructs into to and destroys what is left in from
+        void (*move)(void* from, void* to);
+        void (*destroy)(void* storage);
+    };
+
+    template <typename F>
+    static constexpr bool fits_inline = sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    static constexpr Operations inline_operations = {
+        .invoke = [](void* storage) { (*std::launder(static_cast<F*>(storage)))(); },
+        .move = [](void* from, void* to) {
+            F* function = std::launder(static_cast<F*>(from));
+            new (to) F(std::move(*function));
+            function->~F();
+        },
+        .destroy = [](void* storage) { std::launder(static_cast<F*>(storage))->~F(); },
+    };
+
+    template <typename F>
+    static constexpr Operations heap_operations = {
+        .invoke = [](void* storage) { (**static_cast<F**>(storage))(); },
+        .move = [](void* from, void* to) { *static_cast<F**>(to) = *static_cast<F**>(from); },
+        .destroy = [](void* storage) { delete *static_cast<F**>(storage); },
+    };
+
+    void move_from(PoolTask& other) {
+        if (other.operations != nullptr) {
+            other.operations->move(other.storage, this->storage);
+            this->operations = other.operations;
+            other.operations = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE] = {};
+    const Operations* operations = nullptr;
+};
+
+// where the shared states of the promises behind ThreadPool::submit come from. blocks go back onto a free list per size
+// class instead of to the heap. futures can outlive the pool that made them, so this is one per process and never
+// destroyed, a future in a static could still hand its state back at exit
+class PromiseStatePool {
+public:
+    static auto get() -> PromiseStatePool& {
+        static PromiseStatePool* pool = new PromiseStatePool();
+        return *pool;
+    }
+
+    auto allocate(const size_t size) -> void* {
+        const size_t size_class = get_size_class(size);
+        if (size_class == SIZE_CLASS_COUNT) {
+            return ::operator new(size);
+        }
+        {
+            const std::scoped_lock lock(this->mutex);
+            if (FreeBlock* block = this->free_blocks[size_class]) {
+                this->free_blocks[size_class] = block->next;
+                return block;
+            }
+        }
+        return ::operator new(MIN_BLOCK_SIZE << size_class);
+    }
+
+    void deallocate(void* pointer, const size_t size) {
+        const size_t size_class = get_size_class(size);
+        if (size_class == SIZE_CLASS_COUNT) {
+            ::operator delete(pointer);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        const std::scoped_lock lock(this->mutex);
+        block->next = this->free_blocks[size_class];
+        this->free_blocks[size_class] = block;
+    }
+
+private:
+    // 64 to 512 bytes, a promise of anything up to a few hundred bytes lands in one of them
+    static constexpr size_t MIN_BLOCK_SIZE = 64;
+    static constexpr size_t SIZE_CLASS_COUNT = 4;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    PromiseStatePool() = default;
+
+    static auto get_size_class(const size_t size) -> size_t {
+        size_t size_class = 0;
+        while (size_class < SIZE_CLASS_COUNT && (MIN_BLOCK_SIZE << size_class) < size) {
+            size_class++;
+        }
+        return size_class;
+    }
+
+    FreeBlock* free_blocks[SIZE_CLASS_COUNT] = {};
+    std::mutex mutex = {};
+};
+
+template <typename T>
+struct PromiseStateAllocator {
+    using value_type = T;
+
+    PromiseStateAllocator() = default;
+    template <typename U>
+    PromiseStateAllocator(const PromiseStateAllocator<U>&) {}
+
+    auto allocate(const size_t count) -> T* {
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+        } else {
+            return static_cast<T*>(PromiseStatePool::get().allocate(count * sizeof(T)));
+        }
+    }
+
+    void deallocate(T* pointer, const size_t count) {
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(pointer, std::align_val_t(alignof(T)));
+        } else {
+            PromiseStatePool::get().deallocate(pointer, count * sizeof(T));
+        }
+    }
+
+    template <typename U>
+    auto operator==(const PromiseStateAllocator<U>&) const -> bool {
+        return true;
+    }
+};
+
+// how many of the tasks pushed with it havent finished yet, ThreadPool::wait_for waits for it to reach zero. jobs that
+// arent pool tasks can take part through add and ThreadPool::count_down. a task that throws still counts down, the first
+// exception one of them threw gets rethrown by wait_for
+class TaskCounter {
+public:
+    TaskCounter(const size_t count = 0) : remaining(count) {}
+
+    void add(const size_t count) {
+        this->remaining += count;
+    }
+
+    auto get_remaining() const -> size_t {
+        return this->remaining;
+    }
+
+private:
+    friend class ThreadPool;
+
+    std::atomic<size_t> remaining = 0;
+    std::exception_ptr exception = nullptr;
+    std::mutex exception_mutex = {};
+};
+
+// HIGH and NORMAL share the workers, a worker looking for a task takes any HIGH one before it looks at NORMAL ones. tasks
+// that already run dont get preempted. IO has threads of its own that only run IO tasks, so reads that block on the disk
+// dont hold up workers the cpu heavy tasks need, and the workers never pick up an IO task in turn
+enum class TaskLane : uint8_t {
+    HIGH = 0,
+    NORMAL = 1,
+    IO = 2,
+};
+
+inline constexpr size_t TASK_LANE_COUNT = 3;
+
+struct TaskLaneStatistics {
+    size_t queued = 0;
+    size_t running = 0;
+    size_t completed = 0;
+    // the workers for HIGH and NORMAL, the io threads for IO
+    uint32_t thread_count = 0;
+    // time spent in tasks of the lane over thread_count times the time since the pool started. HIGH and NORMAL share
+    // their threads, so together they are what the workers did. threads outside the pool that help in wait_for count as
+    // well, so this can go past 1
+    double utilization = 0.0;
+};
+
+// work stealing pool. tasks pushed from one of its own workers go to that workers deque, everything else goes through
+// the injection queue (and a locked overflow list once that is full, so pushing never blocks). idle workers take from
+// their own deque, then the injection queue, then steal from random other workers before they go to sleep. every cpu
+// lane has its own deques and queues, the IO lane only has the shared queue its threads take from.
+// tasks live in nodes the pool keeps around, together with PoolTask and the promise state pool a task that captures
+// less than PoolTask::INLINE_SIZE bytes doesnt allocate anything once the pool is warm
 class ThreadPool {
 public:
-    ThreadPool(const concurrency_t thread_count_ = 0) : thread_count(determine_thread_count(thread_count_)), threads(std::make_unique<std::thread[]>(determine_thread_count(thread_count_))) {
+    // power of two, past this many tasks from outside the pool take the overflow lock
+    static constexpr size_t INJECTION_CAPACITY = 4096;
+    // reads mostly wait on the disk, a couple of threads keep it busy without taking much from the workers
+    static constexpr concurrency_t DEFAULT_IO_THREAD_COUNT = 2;
+
+    ThreadPool(const concurrency_t thread_count_ = 0, const concurrency_t io_thread_count_ = 0) : thread_count(determine_thread_count(thread_count_)), threads(std::make_unique<std::thread[]>(determine_thread_count(thread_count_))), io_thread_count(determine_io_thread_count(io_thread_count_)), io_threads(std::make_unique<std::thread[]>(determine_io_thread_count(io_thread_count_))) {
         create_threads();
     }
 
+    // whatever is still queued was pushed while paused and never runs, like the tasks a paused pool always dropped.
+    // their nodes go away with node_blocks. exceptions nobody waited for with wait_for_tasks get dropped
     ~ThreadPool() {
-        wait_for_tasks();
+        wait_until_done();
         destroy_threads();
     }
 
+    // everything without a lane goes to NORMAL. a task that throws doesnt take its thread down, the first exception of
+    // the tasks without a counter gets rethrown by wait_for_tasks
     template <typename F, typename... A>
     void push_task(F&& task, A&&... args) {
-        std::function<void()> task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...);
-        {
-            const std::scoped_lock tasks_lock(this->tasks_mutex);
-            this->tasks.push(task_function);
+        push_task_to(TaskLane::NORMAL, std::forward<F>(task), std::forward<A>(args)...);
+    }
+
+    template <typename F, typename... A>
+    void push_task_to(const TaskLane lane, F&& task, A&&... args) {
+        if constexpr (sizeof...(A) == 0) {
+            enqueue(lane, std::forward<F>(task));
+        } else {
+            enqueue(lane, bind_arguments(std::forward<F>(task), std::forward<A>(args)...));
         }
-        this->tasks_total++;
-        this->task_available_cv.notify_one();
+    }
+
+    // count tasks that each get called with their index. task gets copied into every one of them, so capture by
+    // reference. the nodes come out of one lock and go into the queues with one claim
+    template <typename F>
+    void push_tasks(const size_t count, const F& task) {
+        push_tasks_to(TaskLane::NORMAL, count, task);
+    }
+
+    // the same with counter counting them down, wait_for(counter) then only waits for these
+    template <typename F>
+    void push_tasks(const size_t count, const F& task, TaskCounter& counter) {
+        push_tasks_to(TaskLane::NORMAL, count, task, counter);
+    }
+
+    template <typename F>
+    void push_tasks_to(const TaskLane lane, const size_t count, const F& task) {
+        push_counted_tasks(lane, count, task, nullptr);
+    }
+
+    template <typename F>
+    void push_tasks_to(const TaskLane lane, const size_t count, const F& task, TaskCounter& counter) {
+        counter.add(count);
+        push_counted_tasks(lane, count, task, &counter);
+    }
+
+    void count_down(TaskCounter& counter, const size_t count = 1) {
+        if (counter.remaining.fetch_sub(count) == count && this->waiting > 0) {
+            { const std::scoped_lock done_lock(this->done_mutex); }
+            this->task_done_cv.notify_all();
+        }
+    }
+
+    // blocks until counter reaches zero and runs HIGH and NORMAL tasks of the pool on the calling thread in the meantime,
+    // so unlike wait_for_tasks this is fine to call from inside a task. the pool must not be paused. rethrows the first
+    // exception a task of counter threw, every time it gets called
+    void wait_for(const TaskCounter& counter) {
+        Worker* worker = get_current_worker();
+        while (counter.remaining > 0) {
+            if (TaskNode* node = find_task(worker)) {
+                run_task(worker, node);
+                continue;
+            }
+            // nothing to help with, look again every now and then in case something shows up before the counter is done
+            std::unique_lock<std::mutex> done_lock(this->done_mutex);
+            this->waiting++;
+            this->task_done_cv.wait_for(done_lock, std::chrono::milliseconds(1), [&counter] { return counter.remaining == 0; });
+            this->waiting--;
+        }
+        // every task stored its exception before it counted down, nothing writes it anymore
+        if (counter.exception) {
+            std::rethrow_exception(counter.exception);
+        }
+    }
+
+    // body(chunk_begin, chunk_end) over [begin, end) in chunks of at most grain. lazy binary splitting (tzannes, caragea,
+    // barua, vishkin 2010): the calling thread works through the range a chunk at a time and only hands the upper half of
+    // what is left to the pool when everything it split off before got taken already, so a busy pool costs a check per
+    // chunk instead of a task per chunk and an idle one gets work within a chunk. the calling thread runs chunks itself and
+    // waits like wait_for, so this is fine inside a task. the pool must not be paused. once body throws no new chunks
+    // start and the first exception gets rethrown after the ones already running are done. the split off halves are
+    // NORMAL tasks
+    template <typename F>
+    void parallel_for(const size_t begin, const size_t end, const size_t grain, const F& body) {
+        ParallelLoop<NoResult> loop = {};
+        // split off ranges hold on to it until wait_for is done
+        const auto combine = [](NoResult, NoResult) { return NoResult{}; };
+        run_range(loop, begin, end, std::max<size_t>(grain, 1), body, combine);
+        wait_for(loop.counter);
+    }
+
+    // the same splitting, body(chunk_begin, chunk_end) returns what its chunk adds up to and combine(a, b) merges two of
+    // those. every range a thread ran keeps its own partial result and they get combined in the order of the range, so
+    // combine has to be associative but not commutative. floating point sums still depend on where the range got split
+    template <typename T, typename F, typename C>
+    auto parallel_reduce(const size_t begin, const size_t end, const size_t grain, T identity, const F& body, const C& combine) -> T {
+        ParallelLoop<T> loop = {};
+        run_range(loop, begin, end, std::max<size_t>(grain, 1), body, combine);
+        wait_for(loop.counter);
+
+        std::sort(loop.partials.begin(), loop.partials.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        T result = std::move(identity);
+        for (auto& partial : loop.partials) {
+            result = combine(std::move(result), std::move(partial.second));
+        }
+        return result;
     }
 
     template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
     auto submit(F&& task, A&&... args) -> std::future<R> {
-        std::function<R()> task_function = std::bind(std::forward<F>(task), std::forward<A>(args)...);
-        std::shared_ptr<std::promise<R>> task_promise = std::make_shared<std::promise<R>>();
-        push_task([task_function, task_promise] {
+        return submit_to(TaskLane::NORMAL, std::forward<F>(task), std::forward<A>(args)...);
+    }
+
+    template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
+    auto submit_to(const TaskLane lane, F&& task, A&&... args) -> std::future<R> {
+        std::promise<R> task_promise(std::allocator_arg, PromiseStateAllocator<R>{});
+        std::future<R> task_future = task_promise.get_future();
+        enqueue(lane, [task_function = bind_arguments(std::forward<F>(task), std::forward<A>(args)...), task_promise = std::move(task_promise)]() mutable {
             try {
                 if constexpr (std::is_void_v<R>) {
                     std::invoke(task_function);
-                    task_promise->set_value();
+                    task_promise.set_value();
                 } else {
-                    task_promise->set_value(std::invoke(task_function));
+                    task_promise.set_value(std::invoke(task_function));
                 }
             } catch (...) {
                 try {
-                    task_promise->set_exception(std::current_exception());
+                    task_promise.set_exception(std::current_exception());
                 } catch (...) {
-                    }
                 }
-            });
-        return task_promise->get_future();
+            }
+        });
+        return task_future;
     }
 
     auto get_tasks_queued() const -> size_t {
-        const std::scoped_lock tasks_lock(this->tasks_mutex);
-        return this->tasks.size();
+        return this->tasks_queued;
     }
 
     auto get_tasks_running() const -> size_t {
-        const std::scoped_lock tasks_lock(this->tasks_mutex);
-        return this->tasks_total - this->tasks.size();
+        const size_t total = this->tasks_total;
+        const size_t queued = this->tasks_queued;
+        return total - std::min(total, queued);
     }
 
     auto get_tasks_total() const -> size_t {
         return this->tasks_total;
     }
 
+    // how many tasks a worker took out of another workers deque so far
+    auto get_tasks_stolen() const -> size_t {
+        return this->tasks_stolen;
+    }
+
     auto get_thread_count() const -> concurrency_t
     {
         return this->thread_count;
     }
 
+    auto get_io_thread_count() const -> concurrency_t {
+        return this->io_thread_count;
+    }
+
+    auto get_lane_statistics(const TaskLane lane) const -> TaskLaneStatistics {
+        const LaneQueue& queue = this->lanes[static_cast<size_t>(lane)];
+        const concurrency_t lane_threads = lane == TaskLane::IO ? this->io_thread_count : this->thread_count;
+        const double elapsed_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start_time).count());
+        return TaskLaneStatistics {
+            .queued = queue.queued,
+            .running = queue.running,
+            .completed = queue.completed,
+            .thread_count = lane_threads,
+            .utilization = static_cast<double>(queue.busy_ns.load()) / std::max(elapsed_ns * lane_threads, 1.0),
+        };
+    }
+
     auto is_paused() const -> bool {
         return this->paused;
     }
@@ -89,41 +680,342 @@ public:
     }
 
     void unpause() {
-        this->paused = false;
+        {
+            const std::scoped_lock sleep_lock(this->sleep_mutex);
+            this->paused = false;
+        }
+        this->task_available_cv.notify_all();
+        this->io_available_cv.notify_all();
     }
 
+    // only call this from outside the pool, a worker waiting on its own pool would wait on itself. rethrows the first
+    // exception a task without a counter threw since the last call
     void wait_for_tasks() {
-        this->waiting = true;
-        std::unique_lock<std::mutex> tasks_lock(this->tasks_mutex);
-        this->task_done_cv.wait(tasks_lock, [this] { return (this->tasks_total == (this->paused ? this->tasks.size() : 0)); });
-        this->waiting = false;
+        wait_until_done();
+        std::exception_ptr task_exception = nullptr;
+        {
+            const std::scoped_lock exception_lock(this->exception_mutex);
+            std::swap(task_exception, this->exception);
+        }
+        if (task_exception) {
+            std::rethrow_exception(task_exception);
+        }
     }
 
-    void reset(const concurrency_t thread_count_ = 0) {
+    // exceptions of earlier tasks stay around for the next wait_for_tasks
+    void reset(const concurrency_t thread_count_ = 0, const concurrency_t io_thread_count_ = 0) {
         const bool was_paused = this->paused;
         this->paused = true;
-        wait_for_tasks();
+        wait_until_done();
         destroy_threads();
         this->thread_count = determine_thread_count(thread_count_);
         this->threads = std::make_unique<std::thread[]>(thread_count);
+        this->io_thread_count = determine_io_thread_count(io_thread_count_);
+        this->io_threads = std::make_unique<std::thread[]>(io_thread_count);
         this->paused = was_paused;
         create_threads();
     }
 
 private:
+    struct TaskNode {
+        PoolTask task = {};
+        TaskNode* next = nullptr;
+        // counted down once the task is done, whether it threw or not
+        TaskCounter* counter = nullptr;
+        TaskLane lane = TaskLane::NORMAL;
+    };
+
+    static constexpr size_t CPU_LANE_COUNT = 2;
+
+    struct alignas(64) Worker {
+        ThreadPool* pool = nullptr;
+        concurrency_t index = 0;
+        // one per cpu lane
+        WorkStealingDeque<TaskNode> deques[CPU_LANE_COUNT] = {};
+        uint32_t random_state = 1;
+        // nodes of tasks this worker ran, only it touches them
+        TaskNode* free_nodes = nullptr;
+        size_t free_node_count = 0;
+    };
+
+    // nodes come in blocks and move between the workers and the shared list in batches
+    static constexpr size_t NODE_BLOCK_SIZE = 64;
+    static constexpr size_t NODE_BATCH_SIZE = 32;
+
+    // the shared queue of a lane and what get_lane_statistics reports about it
+    struct LaneQueue {
+        InjectionQueue<TaskNode> injection = InjectionQueue<TaskNode>(INJECTION_CAPACITY);
+        TaskNode* overflow_head = nullptr;
+        TaskNode* overflow_tail = nullptr;
+        std::atomic<size_t> overflow_count = 0;
+        std::mutex overflow_mutex = {};
+
+        // wherever they sit, deques included
+        std::atomic<size_t> queued = 0;
+        std::atomic<size_t> running = 0;
+        std::atomic<size_t> completed = 0;
+        std::atomic<uint64_t> busy_ns = 0;
+    };
+
+    // what parallel_for reduces, it keeps run_range from storing partial results nobody asks for
+    struct NoResult {};
+
+    template <typename T>
+    struct ParallelLoop {
+        // one per range that got split off, the range the calling thread started with isnt a task. holds the first
+        // exception of the body as well
+        TaskCounter counter = {};
+        std::atomic<bool> failed = false;
+        // where each range started and what it added up to
+        std::vector<std::pair<size_t, T>> partials = {};
+        std::mutex mutex = {};
+    };
+
+    // what std::bind did without the std::function around it, the arguments are stored once and passed as lvalues
+    template <typename F, typename... A>
+    static auto bind_arguments(F&& task, A&&... args) {
+        return [function = std::forward<F>(task), arguments = std::make_tuple(std::forward<A>(args)...)]() mutable -> decltype(auto) {
+            return std::apply(function, arguments);
+        };
+    }
+
+    auto get_current_worker() const -> Worker* {
+        Worker* worker = current_worker;
+        return worker != nullptr && worker->pool == this ? worker : nullptr;
+    }
+
+    template <typename F>
+    void enqueue(const TaskLane lane, F&& function, TaskCounter* counter = nullptr) {
+        Worker* worker = get_current_worker();
+        TaskNode* node = acquire_nodes(worker, 1);
+        try {
+            node->task.emplace(std::forward<F>(function));
+        } catch (...) {
+            release_node(worker, node);
+            throw;
+        }
+        node->counter = counter;
+        node->lane = lane;
+        push_nodes(worker, node, 1, lane);
+    }
+
+    // counter was already added to, nullptr when the tasks dont have one
+    template <typename F>
+    void push_counted_tasks(const TaskLane lane, const size_t count, const F& task, TaskCounter* counter) {
+        if (count == 0) {
+            return;
+        }
+        Worker* worker = get_current_worker();
+        TaskNode* first = acquire_nodes(worker, count);
+        TaskNode* node = first;
+        for (size_t i = 0; i < count; i++) {
+            node->task.emplace([task, i] { task(i); });
+            node->counter = counter;
+            node->lane = lane;
+            node = node->next;
+        }
+        push_nodes(worker, first, count, lane);
+    }
+
+    // keeps the first one, for the counter or for wait_for_tasks when there is none
+    void store_exception(TaskCounter* counter, std::exception_ptr task_exception) {
+        std::mutex& mutex = counter != nullptr ? counter->exception_mutex : this->exception_mutex;
+        std::exception_ptr& first = counter != nullptr ? counter->exception : this->exception;
+        const std::scoped_lock exception_lock(mutex);
+        if (!first) {
+            first = std::move(task_exception);
+        }
+    }
+
+    void wait_until_done() {
+        std::unique_lock<std::mutex> done_lock(this->done_mutex);
+        this->waiting++;
+        this->task_done_cv.wait(done_lock, [this] { return (this->tasks_total == (this->paused ? this->tasks_queued.load() : 0)); });
+        this->waiting--;
+    }
+
+    void push_nodes(Worker* worker, TaskNode* first, const size_t count, const TaskLane lane) {
+        LaneQueue& queue = this->lanes[static_cast<size_t>(lane)];
+        // counted before the tasks are reachable, a worker that takes one right away cant push the counters below zero
+        this->tasks_total += count;
+        this->tasks_queued += count;
+        queue.queued += count;
+        if (worker != nullptr && lane != TaskLane::IO) {
+            worker->deques[static_cast<size_t>(lane)].push_many(first, count);
+        } else if (!queue.injection.try_push_many(first, count)) {
+            TaskNode* last = first;
+            for (size_t i = 1; i < count; i++) {
+                last = last->next;
+            }
+            push_overflow(queue, first, last, count);
+        }
+        wake(count, lane);
+    }
+
+    // last->next gets overwritten
+    static void push_overflow(LaneQueue& queue, TaskNode* first, TaskNode* last, const size_t count) {
+        const std::scoped_lock overflow_lock(queue.overflow_mutex);
+        last->next = nullptr;
+        if (queue.overflow_tail != nullptr) {
+            queue.overflow_tail->next = first;
+        } else {
+            queue.overflow_head = first;
+        }
+        queue.overflow_tail = last;
+        queue.overflow_count += count;
+    }
+
+    // nullptr when the lane has nothing in its shared queues
+    static auto pop_shared(LaneQueue& queue) -> TaskNode* {
+        if (TaskNode* node = queue.injection.try_pop()) {
+            return node;
+        }
+        if (queue.overflow_count > 0) {
+            const std::scoped_lock overflow_lock(queue.overflow_mutex);
+            if (TaskNode* node = queue.overflow_head) {
+                queue.overflow_head = node->next;
+                if (queue.overflow_head == nullptr) {
+                    queue.overflow_tail = nullptr;
+                }
+                queue.overflow_count--;
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    auto get_cpu_tasks_queued() const -> size_t {
+        return this->lanes[static_cast<size_t>(TaskLane::HIGH)].queued + this->lanes[static_cast<size_t>(TaskLane::NORMAL)].queued;
+    }
+
+    // a list of count nodes linked through next. workers use their own free nodes first, everyone else takes the lock
+    auto acquire_nodes(Worker* worker, const size_t count) -> TaskNode* {
+        TaskNode* first = nullptr;
+        size_t needed = count;
+        if (worker != nullptr) {
+            while (needed > 0 && worker->free_nodes != nullptr) {
+                TaskNode* node = worker->free_nodes;
+                worker->free_nodes = node->next;
+                worker->free_node_count--;
+                node->next = first;
+                first = node;
+                needed--;
+            }
+            if (needed == 0) {
+                return first;
+            }
+        }
+
+        const std::scoped_lock node_lock(this->node_mutex);
+        // a worker takes a whole batch so the next few pushes dont come back here
+        const size_t shared_count = worker != nullptr ? std::max(needed, NODE_BATCH_SIZE) : needed;
+        for (size_t i = 0; i < shared_count; i++) {
+            if (this->shared_free_nodes == nullptr) {
+                this->node_blocks.push_back(std::make_unique<TaskNode[]>(NODE_BLOCK_SIZE));
+                for (size_t j = 0; j < NODE_BLOCK_SIZE; j++) {
+                    this->node_blocks.back()[j].next = this->shared_free_nodes;
+                    this->shared_free_nodes = &this->node_blocks.back()[j];
+                }
+            }
+            TaskNode* node = this->shared_free_nodes;
+            this->shared_free_nodes = node->next;
+            if (i < needed) {
+                node->next = first;
+                first = node;
+            } else {
+                node->next = worker->free_nodes;
+                worker->free_nodes = node;
+                worker->free_node_count++;
+            }
+        }
+        return first;
+    }
+
+    void release_node(Worker* worker, TaskNode* node) {
+        node->task.reset();
+        node->counter = nullptr;
+        if (worker == nullptr) {
+            const std::scoped_lock node_lock(this->node_mutex);
+            node->next = this->shared_free_nodes;
+            this->shared_free_nodes = node;
+            return;
+        }
+
+        node->next = worker->free_nodes;
+        worker->free_nodes = node;
+        worker->free_node_count++;
+        // a worker that mostly runs tasks from outside the pool would pile up nodes the pushers then have to allocate
+        if (worker->free_node_count > 2 * NODE_BATCH_SIZE) {
+            const std::scoped_lock node_lock(this->node_mutex);
+            for (size_t i = 0; i < NODE_BATCH_SIZE; i++) {
+                TaskNode* free_node = worker->free_nodes;
+                worker->free_nodes = free_node->next;
+                free_node->next = this->shared_free_nodes;
+                this->shared_free_nodes = free_node;
+            }
+            worker->free_node_count -= NODE_BATCH_SIZE;
+        }
+    }
+
+    void wake(const size_t count, const TaskLane lane) {
+        std::atomic<uint32_t>& lane_sleeping = lane == TaskLane::IO ? this->io_sleeping : this->sleeping;
+        std::condition_variable& available_cv = lane == TaskLane::IO ? this->io_available_cv : this->task_available_cv;
+        if (lane_sleeping > 0) {
+            // a worker between checking for tasks and waiting holds sleep_mutex, taking it here means the notify cant
+            // land in that gap
+            { const std::scoped_lock sleep_lock(this->sleep_mutex); }
+            if (count > 1) {
+                available_cv.notify_all();
+            } else {
+                available_cv.notify_one();
+            }
+        }
+    }
+
     void create_threads() {
         this->running = true;
+        this->workers = std::make_unique<Worker[]>(this->thread_count);
+        for (concurrency_t i = 0; i < this->thread_count; i++) {
+            this->workers[i].pool = this;
+            this->workers[i].index = i;
+            this->workers[i].random_state = 0x9e3779b9u * (i + 1);
+        }
         for (concurrency_t i = 0; i < this->thread_count; i++) {
-            this->threads[i] = std::thread(&ThreadPool::worker, this);
+            this->threads[i] = std::thread(&ThreadPool::worker, this, i);
+        }
+        for (concurrency_t i = 0; i < this->io_thread_count; i++) {
+            this->io_threads[i] = std::thread(&ThreadPool::io_worker, this);
         }
     }
 
     void destroy_threads(){
-        this->running = false;
+        {
+            const std::scoped_lock sleep_lock(this->sleep_mutex);
+            this->running = false;
+        }
         this->task_available_cv.notify_all();
+        this->io_available_cv.notify_all();
         for (concurrency_t i = 0; i < this->thread_count; i++) {
             this->threads[i].join();
         }
+        for (concurrency_t i = 0; i < this->io_thread_count; i++) {
+            this->io_threads[i].join();
+        }
+        for (concurrency_t i = 0; i < this->thread_count; i++) {
+            Worker& worker = this->workers[i];
+            // tasks still sitting in a deque (the pool was paused) move to the overflow list so the next workers see them
+            for (size_t lane = 0; lane < CPU_LANE_COUNT; lane++) {
+                while (TaskNode* node = worker.deques[lane].take()) {
+                    push_overflow(this->lanes[lane], node, node, 1);
+                }
+            }
+            while (worker.free_nodes != nullptr) {
+                TaskNode* node = worker.free_nodes;
+                worker.free_nodes = node->next;
+                release_node(nullptr, node);
+            }
+        }
+        this->workers.reset();
     }
 
     auto determine_thread_count(const concurrency_t thread_count_) -> concurrency_t {
@@ -138,39 +1030,213 @@ private:
         }
     }
 
-    void worker() {
-        while (this->running) {
-            std::function<void()> task;
-            std::unique_lock<std::mutex> tasks_lock(this->tasks_mutex);
-            task_available_cv.wait(tasks_lock, [this] { return !this->tasks.empty() || !this->running; });
-            if (this->running && !this->paused) {
-                task = std::move(this->tasks.front());
-                this->tasks.pop();
-                tasks_lock.unlock();
-                task();
-                tasks_lock.lock();
-                this->tasks_total--;
-                if (this->waiting) {
-                    this->task_done_cv.notify_one();
+    // lazy binary splitting only splits again once nothing this thread split off is still waiting for a thief. threads
+    // outside the pool push into the shared queues, for them it is whether the workers took everything queued
+    auto should_split() const -> bool {
+        Worker* worker = get_current_worker();
+        if (worker != nullptr) {
+            return worker->deques[0].size() + worker->deques[1].size() == 0;
+        }
+        return get_cpu_tasks_queued() == 0;
+    }
+
+    template <typename T, typename F, typename C>
+    void run_range(ParallelLoop<T>& loop, size_t begin, size_t end, const size_t grain, const F& body, const C& combine) {
+        const size_t range_begin = begin;
+        std::optional<T> partial = {};
+        try {
+            while (begin < end && !loop.failed) {
+                if (end - begin > grain && should_split()) {
+                    const size_t middle = begin + (end - begin) / 2;
+                    loop.counter.add(1);
+                    try {
+                        enqueue(TaskLane::NORMAL, [this, &loop, middle, end, grain, &body, &combine] {
+                            run_range(loop, middle, end, grain, body, combine);
+                        }, &loop.counter);
+                    } catch (...) {
+                        count_down(loop.counter);
+                        throw;
+                    }
+                    end = middle;
+                    continue;
                 }
+
+                const size_t chunk_end = std::min(begin + grain, end);
+                if constexpr (std::is_same_v<T, NoResult>) {
+                    body(begin, chunk_end);
+                } else {
+                    T value = body(begin, chunk_end);
+                    partial = partial ? combine(std::move(*partial), std::move(value)) : std::move(value);
+                }
+                begin = chunk_end;
+            }
+        } catch (...) {
+            store_exception(&loop.counter, std::current_exception());
+            loop.failed = true;
+            return;
+        }
+
+        if (partial) {
+            const std::scoped_lock loop_lock(loop.mutex);
+            loop.partials.emplace_back(range_begin, std::move(*partial));
+        }
+    }
+
+    auto determine_io_thread_count(const concurrency_t io_thread_count_) -> concurrency_t {
+        return io_thread_count_ > 0 ? io_thread_count_ : DEFAULT_IO_THREAD_COUNT;
+    }
+
+    // self is nullptr for threads outside the pool, they only look at the shared queues and steal. every HIGH task
+    // anywhere comes before the NORMAL ones, a lane with nothing queued is skipped without looking
+    auto find_task(Worker* self) -> TaskNode* {
+        for (size_t lane = 0; lane < CPU_LANE_COUNT; lane++) {
+            if (this->lanes[lane].queued == 0) {
+                continue;
+            }
+            if (TaskNode* node = find_task(self, lane)) {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    auto find_task(Worker* self, const size_t lane) -> TaskNode* {
+        if (self != nullptr) {
+            if (TaskNode* node = self->deques[lane].take()) {
+                return node;
+            }
+        }
+        if (TaskNode* node = pop_shared(this->lanes[lane])) {
+            return node;
+        }
+        // a few random victims instead of walking them in order, so idle workers dont all pile onto worker 0
+        thread_local uint32_t outside_random_state = 0x2545f491u;
+        uint32_t& random_state = self != nullptr ? self->random_state : outside_random_state;
+        for (concurrency_t attempt = 0; attempt < 2 * this->thread_count; attempt++) {
+            random_state ^= random_state << 13;
+            random_state ^= random_state >> 17;
+            random_state ^= random_state << 5;
+            const concurrency_t victim = random_state % this->thread_count;
+            if (self != nullptr && victim == self->index) {
+                continue;
+            }
+            if (TaskNode* node = this->workers[victim].deques[lane].steal()) {
+                this->tasks_stolen++;
+                return node;
             }
         }
+        return nullptr;
+    }
+
+    void run_task(Worker* self, TaskNode* node) {
+        LaneQueue& queue = this->lanes[static_cast<size_t>(node->lane)];
+        this->tasks_queued--;
+        queue.queued--;
+        queue.running++;
+        TaskCounter* counter = node->counter;
+        const auto start = std::chrono::steady_clock::now();
+        // nothing a task throws gets past here, it would end the thread and with it the program
+        try {
+            node->task();
+        } catch (...) {
+            store_exception(counter, std::current_exception());
+        }
+        queue.busy_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        queue.running--;
+        queue.completed++;
+        release_node(self, node);
+        // counter can go away as soon as this reaches zero
+        if (counter != nullptr) {
+            count_down(*counter);
+        }
+        // only the last task (or any task while paused) can be what a waiter is waiting for, waking it up on every task
+        // would cost a context switch per task
+        const size_t remaining = --this->tasks_total;
+        if (this->waiting > 0 && (remaining == 0 || this->paused)) {
+            { const std::scoped_lock done_lock(this->done_mutex); }
+            this->task_done_cv.notify_all();
+        }
     }
 
+    void worker(const concurrency_t index) {
+        Worker& self = this->workers[index];
+        current_worker = &self;
+        uint32_t idle_rounds = 0;
+        while (this->running) {
+            TaskNode* node = this->paused ? nullptr : find_task(&self);
+            if (node != nullptr) {
+                run_task(&self, node);
+                idle_rounds = 0;
+                continue;
+            }
+
+            // a task that just got pushed usually shows up within a few rounds, sleeping right away costs a wake up
+            if (++idle_rounds < 64) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> sleep_lock(this->sleep_mutex);
+            this->sleeping++;
+            this->task_available_cv.wait(sleep_lock, [this] { return (get_cpu_tasks_queued() > 0 && !this->paused) || !this->running; });
+            this->sleeping--;
+            idle_rounds = 0;
+        }
+        current_worker = nullptr;
+    }
+
+    // io tasks block for a while anyway, so these go to sleep right away instead of spinning for the next one
+    void io_worker() {
+        LaneQueue& queue = this->lanes[static_cast<size_t>(TaskLane::IO)];
+        while (this->running) {
+            TaskNode* node = this->paused ? nullptr : pop_shared(queue);
+            if (node != nullptr) {
+                run_task(nullptr, node);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> sleep_lock(this->sleep_mutex);
+            this->io_sleeping++;
+            this->io_available_cv.wait(sleep_lock, [this, &queue] { return (queue.queued > 0 && !this->paused) || !this->running; });
+            this->io_sleeping--;
+        }
+    }
+
+    inline static thread_local Worker* current_worker = nullptr;
+
     std::atomic<bool> paused = false;
     std::atomic<bool> running = false;
-    std::atomic<bool> waiting = false;
+    std::atomic<uint32_t> waiting = 0;
+    std::atomic<uint32_t> sleeping = 0;
+    std::atomic<uint32_t> io_sleeping = 0;
 
     std::condition_variable task_available_cv = {};
+    std::condition_variable io_available_cv = {};
     std::condition_variable task_done_cv = {};
+    std::mutex sleep_mutex = {};
+    std::mutex done_mutex = {};
 
-    std::queue<std::function<void()>> tasks = {};
+    // the first one a task without a counter threw
+    std::exception_ptr exception = nullptr;
+    std::mutex exception_mutex = {};
 
-    std::atomic<size_t> tasks_total = 0;
+    // every node the pool ever made, declared before the queues so those are gone first
+    std::vector<std::unique_ptr<TaskNode[]>> node_blocks = {};
+    TaskNode* shared_free_nodes = nullptr;
+    std::mutex node_mutex = {};
 
-    mutable std::mutex tasks_mutex = {};
+    std::unique_ptr<Worker[]> workers = nullptr;
+    LaneQueue lanes[TASK_LANE_COUNT] = {};
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    std::atomic<size_t> tasks_total = 0;
+    std::atomic<size_t> tasks_queued = 0;
+    std::atomic<size_t> tasks_stolen = 0;
 
     concurrency_t thread_count = 0;
 
     std::unique_ptr<std::thread[]> threads = nullptr;
+
+    concurrency_t io_thread_count = 0;
+
+    std::unique_ptr<std::thread[]> io_threads = nullptr;
 };
@@ -0,0 +1,362 @@
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../threadpool.hpp"
+#include "../pixel_conversion.hpp"
+
+// every allocation of the process goes through here so the benchmark can tell how many a task costs
+namespace {
+    std::atomic<usize> allocation_count = 0;
+}
+
+auto operator new(usize size) -> void* {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if(void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, usize) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+    // what ThreadPool was before work stealing: one queue behind one mutex that every push and every worker goes through
+    struct MutexQueuePool {
+        MutexQueuePool(u32 thread_count) {
+            for(u32 i = 0; i < thread_count; i++) {
+                threads.emplace_back([this] { worker(); });
+            }
+        }
+
+        ~MutexQueuePool() {
+            wait_for_tasks();
+            {
+                std::scoped_lock lock(mutex);
+                running = false;
+            }
+            task_available_cv.notify_all();
+            for(auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        void push_task(std::function<void()> task) {
+            {
+                std::scoped_lock lock(mutex);
+                tasks.push(std::move(task));
+                tasks_total++;
+            }
+            task_available_cv.notify_one();
+        }
+
+        void wait_for_tasks() {
+            std::unique_lock lock(mutex);
+            task_done_cv.wait(lock, [this] { return tasks_total == 0; });
+        }
+
+        void worker() {
+            std::unique_lock lock(mutex);
+            while(true) {
+                task_available_cv.wait(lock, [this] { return !tasks.empty() || !running; });
+                if(!running) {
+                    return;
+                }
+                std::function<void()> task = std::move(tasks.front());
+                tasks.pop();
+                lock.unlock();
+                task();
+                lock.lock();
+                if(--tasks_total == 0) {
+                    task_done_cv.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::thread> threads = {};
+        std::queue<std::function<void()>> tasks = {};
+        usize tasks_total = 0;
+        bool running = true;
+        std::mutex mutex = {};
+        std::condition_variable task_available_cv = {};
+        std::condition_variable task_done_cv = {};
+    };
+
+    // spins instead of sleeping so a 1 us task really keeps a core busy for 1 us
+    void spin_for(std::chrono::nanoseconds duration) {
+        auto end = std::chrono::steady_clock::now() + duration;
+        while(std::chrono::steady_clock::now() < end) {}
+    }
+
+    // flat pushes every task from the main thread, so all of them go through the shared queue. nested pushes a task per
+    // thread that each push their share, which is where the deques of the work stealing pool come in
+    template <typename Pool>
+    auto run(u32 thread_count, std::chrono::nanoseconds task_duration, u32 task_count, bool nested) -> f64 {
+        Pool pool(thread_count);
+        std::atomic<u32> done = 0;
+        auto task = [&] {
+            spin_for(task_duration);
+            done++;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        if(nested) {
+            for(u32 i = 0; i < thread_count; i++) {
+                u32 count = task_count / thread_count + (i < task_count % thread_count ? 1 : 0);
+                pool.push_task([&pool, &task, count] {
+                    for(u32 j = 0; j < count; j++) {
+                        pool.push_task(task);
+                    }
+                });
+            }
+        } else {
+            for(u32 i = 0; i < task_count; i++) {
+                pool.push_task(task);
+            }
+        }
+        pool.wait_for_tasks();
+        f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if(done != task_count) {
+            throw std::runtime_error("benchmark lost tasks");
+        }
+        return ms;
+    }
+
+    // heap allocations per task once the pool is warm, the first round fills the node and promise state pools
+    template <typename Pool, typename Push>
+    auto count_allocations(u32 task_count, Push push) -> f64 {
+        Pool pool(2);
+        push(pool, task_count);
+        pool.wait_for_tasks();
+        usize before = allocation_count.load();
+        push(pool, task_count);
+        pool.wait_for_tasks();
+        return static_cast<f64>(allocation_count.load() - before) / task_count;
+    }
+
+    void print_allocations() {
+        constexpr u32 TASK_COUNT = 10000;
+        std::atomic<u32> done = 0;
+        auto task = [&done] { done++; };
+        std::cout << "allocations per task" << std::endl;
+        std::cout << "  mutex queue push_task: " << count_allocations<MutexQueuePool>(TASK_COUNT, [&](MutexQueuePool& pool, u32 count) {
+            for(u32 i = 0; i < count; i++) {
+                pool.push_task(task);
+            }
+        }) << std::endl;
+        std::cout << "  push_task: " << count_allocations<ThreadPool>(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            for(u32 i = 0; i < count; i++) {
+                pool.push_task(task);
+            }
+        }) << std::endl;
+        std::cout << "  push_task with arguments: " << count_allocations<ThreadPool>(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            for(u32 i = 0; i < count; i++) {
+                pool.push_task([&done](u32 a, u32 b) { done += a + b - 1; }, i, 1u);
+            }
+        }) << std::endl;
+        std::cout << "  push_task from a worker: " << count_allocations<ThreadPool>(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            pool.push_task([&pool, &task, count] {
+                for(u32 i = 0; i < count; i++) {
+                    pool.push_task(task);
+                }
+            });
+        }) << std::endl;
+        std::cout << "  push_tasks: " << count_allocations<ThreadPool>(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            pool.push_tasks(count, [&done](usize) { done++; });
+        }) << std::endl;
+        std::cout << "  submit: " << count_allocations<ThreadPool>(TASK_COUNT, [&](ThreadPool& pool, u32 count) {
+            std::vector<std::future<u32>> futures = {};
+            futures.reserve(count);
+            for(u32 i = 0; i < count; i++) {
+                futures.push_back(pool.submit([](u32 value) { return value * 2; }, i));
+            }
+            for(auto& future : futures) {
+                future.get();
+            }
+        }) << " (the futures vector is one of them)" << std::endl;
+    }
+
+    // 2 ms blocking reads next to 100 us of cpu work per task, once with the reads on the workers and once on the io lane.
+    // then how long a task waits behind a backlog of NORMAL ones when it is NORMAL itself and when it is HIGH
+    void print_lanes(u32 thread_count, f64 work_scale) {
+        const u32 read_count = std::max(static_cast<u32>(64.0 * work_scale), 8u);
+        const u32 cpu_count = std::max(static_cast<u32>(2000.0 * work_scale), 64u);
+        std::cout << "lanes, " << thread_count << " threads" << std::endl;
+        for(TaskLane read_lane : { TaskLane::NORMAL, TaskLane::IO }) {
+            ThreadPool pool(thread_count);
+            TaskCounter reads = {};
+            TaskCounter cpu = {};
+            auto start = std::chrono::steady_clock::now();
+            pool.push_tasks_to(read_lane, read_count, [](usize) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }, reads);
+            pool.push_tasks(cpu_count, [](usize) { spin_for(std::chrono::microseconds(100)); }, cpu);
+            pool.wait_for(cpu);
+            f64 cpu_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            pool.wait_for(reads);
+            f64 read_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            TaskLaneStatistics normal = pool.get_lane_statistics(TaskLane::NORMAL);
+            TaskLaneStatistics io = pool.get_lane_statistics(TaskLane::IO);
+            std::cout << "  " << read_count << " reads on the " << (read_lane == TaskLane::IO ? "io lane" : "workers") << " next to " << cpu_count << " cpu tasks: cpu tasks done after "
+                      << cpu_ms << " ms, reads after " << read_ms << " ms, workers " << normal.utilization * 100.0 << "% busy, io threads " << io.utilization * 100.0 << "% busy" << std::endl;
+        }
+
+        const u32 backlog = std::max(static_cast<u32>(20000.0 * work_scale), 64u);
+        for(TaskLane lane : { TaskLane::NORMAL, TaskLane::HIGH }) {
+            ThreadPool pool(thread_count);
+            pool.push_tasks(backlog, [](usize) { spin_for(std::chrono::microseconds(10)); });
+            auto start = std::chrono::steady_clock::now();
+            std::future<f64> started = pool.submit_to(lane, [start] { return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count(); });
+            f64 latency_ms = started.get();
+            std::cout << "  a " << (lane == TaskLane::HIGH ? "HIGH" : "NORMAL") << " task behind " << backlog << " NORMAL ones of 10 us starts after " << latency_ms << " ms" << std::endl;
+            pool.wait_for_tasks();
+        }
+    }
+
+    // best of a few runs, the first one also warms up the pool and the caches
+    template <typename F>
+    auto time_ms(F&& function) -> f64 {
+        f64 best = 0.0;
+        for(u32 i = 0; i < 5; i++) {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            best = i == 0 ? ms : std::min(best, ms);
+        }
+        return best;
+    }
+
+    // a task per chunk pushed up front, what the loops did before parallel_for
+    template <typename F>
+    void run_chunk_tasks(ThreadPool& pool, usize count, usize grain, const F& body) {
+        TaskCounter counter = {};
+        pool.push_tasks((count + grain - 1) / grain, [&](usize chunk) {
+            body(chunk * grain, std::min(chunk * grain + grain, count));
+        }, counter);
+        pool.wait_for(counter);
+    }
+
+    // rgb to rgba of an image is memory bound, the sum of square roots is a few flops per element. every grain size runs
+    // as a task per chunk and through parallel_for / parallel_reduce, against the plain loop on the calling thread
+    void print_parallel_loops(f64 work_scale, const std::vector<u32>& thread_counts) {
+        const usize pixel_count = std::max<usize>(static_cast<usize>(4096.0 * 4096.0 * work_scale), 1 << 16);
+        std::vector<u8> rgb(pixel_count * 3, 128);
+        std::vector<u8> rgba(pixel_count * 4);
+        const usize element_count = std::max<usize>(static_cast<usize>(16'000'000.0 * work_scale), 1 << 16);
+
+        auto expand = [&](usize begin, usize end) {
+            expand_rgb_to_rgba(rgb.data() + begin * 3, rgba.data() + begin * 4, end - begin);
+        };
+        auto sum_roots = [](usize begin, usize end) {
+            f64 sum = 0.0;
+            for(usize i = begin; i < end; i++) {
+                sum += std::sqrt(static_cast<f64>(i));
+            }
+            return sum;
+        };
+
+        f64 serial_expand_ms = time_ms([&] { expand(0, pixel_count); });
+        f64 serial_sum = 0.0;
+        f64 serial_sum_ms = time_ms([&] { serial_sum = sum_roots(0, element_count); });
+        std::cout << "parallel loops, rgb to rgba of " << pixel_count << " pixels serial " << serial_expand_ms << " ms, sum of " << element_count << " square roots serial "
+                  << serial_sum_ms << " ms" << std::endl;
+
+        const usize grains[] = { 256, 4096, 65536, 1 << 20 };
+        for(u32 thread_count : thread_counts) {
+            ThreadPool pool(thread_count);
+            for(usize grain : grains) {
+                f64 chunk_expand_ms = time_ms([&] { run_chunk_tasks(pool, pixel_count, grain, expand); });
+                f64 parallel_expand_ms = time_ms([&] { pool.parallel_for(0, pixel_count, grain, expand); });
+
+                std::vector<f64> partials((element_count + grain - 1) / grain);
+                f64 chunk_sum_ms = time_ms([&] {
+                    run_chunk_tasks(pool, element_count, grain, [&](usize begin, usize end) { partials[begin / grain] = sum_roots(begin, end); });
+                });
+                f64 sum = 0.0;
+                f64 parallel_sum_ms = time_ms([&] {
+                    sum = pool.parallel_reduce(0, element_count, grain, 0.0, sum_roots, [](f64 a, f64 b) { return a + b; });
+                });
+                if(std::abs(sum - serial_sum) > 1e-6 * serial_sum) {
+                    throw std::runtime_error("parallel_reduce got a different sum");
+                }
+
+                std::cout << "  grain " << grain << ", " << thread_count << " threads: rgb to rgba chunk tasks " << chunk_expand_ms << " ms (" << serial_expand_ms / chunk_expand_ms
+                          << "x), parallel_for " << parallel_expand_ms << " ms (" << serial_expand_ms / parallel_expand_ms << "x), square roots chunk tasks " << chunk_sum_ms
+                          << " ms (" << serial_sum_ms / chunk_sum_ms << "x), parallel_reduce " << parallel_sum_ms << " ms (" << serial_sum_ms / parallel_sum_ms << "x)" << std::endl;
+            }
+        }
+    }
+}
+
+// pushes empty tasks up to 1 ms ones through the old mutex queue and the work stealing pool with 1 to N threads and prints
+// the wall time, the time per task and the speed up over the old pool. every row is about the same amount of spinning so
+// the tiny tasks show the scheduling overhead and the big ones show scaling. --quick runs a tenth of the tasks.
+// before all of that it counts the heap allocations per task of the different ways to push one, and at the end it runs
+// two loops through parallel_for and parallel_reduce with different grain sizes against the serial loop, and what
+// the io lane and HIGH tasks do next to a busy pool
+auto main(i32 argc, char** argv) -> i32 {
+    f64 work_scale = 1.0;
+    for(i32 i = 1; i < argc; i++) {
+        if(std::string(argv[i]) == "--quick") {
+            work_scale = 0.1;
+        }
+    }
+
+    print_allocations();
+
+    std::vector<u32> thread_counts = {};
+    u32 max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for(u32 count = 1; count < max_threads; count *= 2) {
+        thread_counts.push_back(count);
+    }
+    thread_counts.push_back(max_threads);
+
+    const std::chrono::nanoseconds task_durations[] = {
+        std::chrono::nanoseconds(0),
+        std::chrono::microseconds(1),
+        std::chrono::microseconds(10),
+        std::chrono::microseconds(100),
+        std::chrono::microseconds(1000),
+    };
+
+    for(bool nested : { false, true }) {
+        std::cout << (nested ? "nested pushes" : "pushes from the main thread") << std::endl;
+        for(auto duration : task_durations) {
+            // 200 ms of spinning per row, empty tasks get as many as the 1 us ones
+            f64 duration_ns = static_cast<f64>(std::max<i64>(duration.count(), 1000));
+            u32 task_count = std::max(static_cast<u32>(200'000'000.0 * work_scale / duration_ns), 64u);
+            for(u32 thread_count : thread_counts) {
+                f64 mutex_ms = run<MutexQueuePool>(thread_count, duration, task_count, nested);
+                f64 stealing_ms = run<ThreadPool>(thread_count, duration, task_count, nested);
+                std::cout << "  " << duration.count() / 1000.0 << " us x " << task_count << ", " << thread_count << " threads: mutex queue " << mutex_ms << " ms ("
+                          << mutex_ms * 1e6 / task_count << " ns/task), work stealing " << stealing_ms << " ms (" << stealing_ms * 1e6 / task_count << " ns/task), "
+                          << mutex_ms / stealing_ms << "x" << std::endl;
+            }
+        }
+    }
+
+    print_parallel_loops(work_scale, thread_counts);
+    print_lanes(max_threads, work_scale);
+
+    return 0;
+}
@@ -8,6 +8,9 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
+#include "../threadpool.hpp"
 
 #include <random>
 
@@ -21,14 +24,14 @@ struct GeneratePointLightsTask {
     } uses = {};
 
     std::string_view name = "generate point light";
+    ThreadPool* pool = {};
 
     void callback(daxa::TaskInterface ti) {
         const glm::vec3 LIGHT_MIN_BOUNDS = glm::vec3(-120.0f, -20.0f, -120.0f);
         const glm::vec3 LIGHT_MAX_BOUNDS = glm::vec3(120.0f, 80.0f, 120.0f);
 
         std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(0, 1);
+        u32 seed = rd();
 
         auto random_position = [&](std::uniform_real_distribution<> dis, std::mt19937 gen) -> f32vec3 {
             f32vec3 position;
@@ -44,15 +47,22 @@ struct GeneratePointLightsTask {
         std::vector<PointLight> point_lights = {};
         point_lights.resize(NUM_LIGHTS);
 
-        for (i32 i = 0; i < NUM_LIGHTS; i++) {
-            PointLight &light = point_lights[i];        
-            light.position = random_position(dis, gen);
-            light.color = f32vec3{static_cast<f32>(dis(gen)), static_cast<f32>(dis(gen)), static_cast<f32>(dis(gen))};
-            light.radius = 8.0f;
-            // light.position = { 0.0f,0.0f, 0.0f };
-            // light.color = { 1.0f, 0.0f, 0.0f };
-            // light.radius = 30.0f;
-        }
+        // a generator per chunk, one shared one would need a lock around every light
+        pool->parallel_for(0, NUM_LIGHTS, 64, [&](usize begin, usize end) {
+            std::seed_seq chunk_seed = { seed, static_cast<u32>(begin) };
+            std::mt19937 gen(chunk_seed);
+            std::uniform_real_distribution<> dis(0, 1);
+
+            for (usize i = begin; i < end; i++) {
+                PointLight &light = point_lights[i];        
+                light.position = random_position(dis, gen);
+                light.color = f32vec3{static_cast<f32>(dis(gen)), static_cast<f32>(dis(gen)), static_cast<f32>(dis(gen))};
+                light.radius = 8.0f;
+                // light.position = { 0.0f,0.0f, 0.0f };
+                // light.color = { 1.0f, 0.0f, 0.0f };
+                // light.radius = 30.0f;
+            }
+        });
 
         daxa::CommandList cmd_list = ti.get_command_list();
         daxa::Device device = ti.get_device();
@@ -433,7 +443,7 @@ struct TiledForwardApp : public App {
             .format = swapchain.get_format(),
         });
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -445,7 +455,7 @@ struct TiledForwardApp : public App {
             .name = "task depth image"
         }};
 
-        camera_buffer = device.create_buffer(daxa::BufferInfo {
+        camera_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(CameraInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "camera buffer"
@@ -456,7 +466,7 @@ struct TiledForwardApp : public App {
             .name = "task camera buffer",
         });
 
-        object_buffer = device.create_buffer(daxa::BufferInfo {
+        object_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(ObjectInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "object buffer"
@@ -467,7 +477,7 @@ struct TiledForwardApp : public App {
             .name = "task object buffer",
         });
 
-        point_light_buffer = device.create_buffer(daxa::BufferInfo {
+        point_light_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(PointLight) * NUM_LIGHTS,
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "point light buffer"
@@ -484,7 +494,7 @@ struct TiledForwardApp : public App {
         work_groups_y = std::ceil(static_cast<f32>(size_y) / static_cast<f32>(TILE_SIZE));
         number_of_tiles = work_groups_x * work_groups_y;
 
-        frustums_buffer = device.create_buffer(daxa::BufferInfo {
+        frustums_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = static_cast<u32>(sizeof(Frustum) * number_of_tiles),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "frustums buffer"
@@ -495,7 +505,7 @@ struct TiledForwardApp : public App {
             .name = "task frustums buffer",
         });
 
-        point_light_index_buffer = device.create_buffer(daxa::BufferInfo {
+        point_light_index_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = static_cast<u32>(sizeof(u32) * NUM_LIGHTS * number_of_tiles),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "point light index buffer"
@@ -506,7 +516,7 @@ struct TiledForwardApp : public App {
             .name = "task point light index buffer",
         });
 
-        point_light_grid_buffer = device.create_buffer(daxa::BufferInfo {
+        point_light_grid_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = static_cast<u32>(sizeof(u32) * number_of_tiles),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "point light grid buffer"
@@ -524,10 +534,12 @@ struct TiledForwardApp : public App {
 
         upload_task_graph.use_persistent_buffer(task_point_light_buffer);
 
+        ThreadPool light_pool(std::thread::hardware_concurrency());
         upload_task_graph.add_task(GeneratePointLightsTask{
             .uses = {
                 .point_light_buffer = task_point_light_buffer,
             },
+            .pool = &light_pool,
         });
 
         upload_task_graph.submit({});
@@ -551,7 +563,8 @@ struct TiledForwardApp : public App {
         render_task_graph.use_persistent_buffer(task_point_light_index_buffer);
         render_task_graph.use_persistent_buffer(task_point_light_grid_buffer);
 
-        model = std::make_unique<Model>(device, "assets/Sponza/glTF/Sponza.gltf");
+        // draw with placeholder textures right away and let the real ones stream in
+        model = std::make_unique<Model>(device, "assets/Sponza/glTF/Sponza.gltf", ModelLoadInfo { .stream_textures = true });
 
         render_task_graph.add_task(UpdateBuffersTask {
             .uses = {
@@ -573,7 +586,7 @@ struct TiledForwardApp : public App {
             .work_groups_y = &work_groups_y
         });
 
-        depth_sampler = device.create_sampler({
+        depth_sampler = SamplerCache::get().acquire(device, {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -642,14 +655,14 @@ struct TiledForwardApp : public App {
     ~TiledForwardApp() {
         device.wait_idle();
         device.collect_garbage();
-        device.destroy_image(depth_image);
-        device.destroy_buffer(camera_buffer);
-        device.destroy_buffer(object_buffer);
-        device.destroy_buffer(frustums_buffer);
-        device.destroy_buffer(point_light_buffer);
-        device.destroy_buffer(point_light_index_buffer);
-        device.destroy_buffer(point_light_grid_buffer);
-        device.destroy_sampler(depth_sampler);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_buffer(device, camera_buffer);
+        ResourceBudget::get().destroy_buffer(device, object_buffer);
+        ResourceBudget::get().destroy_buffer(device, frustums_buffer);
+        ResourceBudget::get().destroy_buffer(device, point_light_buffer);
+        ResourceBudget::get().destroy_buffer(device, point_light_index_buffer);
+        ResourceBudget::get().destroy_buffer(device, point_light_grid_buffer);
+        SamplerCache::get().release(device, depth_sampler);
     }
 
     void render() {
@@ -667,10 +680,16 @@ struct TiledForwardApp : public App {
             last_frame = current_frame;
 
             camera.update(delta_time);
+            ResourceBudget::get().update();
+            model->update();
 
             ImGui_ImplGlfw_NewFrame();
             ImGui::NewFrame();
             ImGui::Begin("Tiled Forward Settings");
+            Model::LoadProgress progress = model->get_progress();
+            if(!progress.is_complete()) {
+                ImGui::ProgressBar(progress.get_fraction(), ImVec2(-1.0f, 0.0f), "streaming textures");
+            }
             if(ImGui::Checkbox("cull lights", &cull_lights)) {
                 daxa::ShaderDefine cull_lights_define = { .name = "CULL_LIGHTS", .value = "0" };
                 if(cull_lights) {
@@ -742,7 +761,13 @@ struct TiledForwardApp : public App {
                     .name = "depth prepass pipeline"
                 }).value();
             }
+            SamplerCacheStatistics sampler_statistics = SamplerCache::get().get_statistics();
+            ImGui::Text("samplers: %u for %u references, %llu hits %llu misses", sampler_statistics.live_samplers, sampler_statistics.references, static_cast<unsigned long long>(sampler_statistics.hits), static_cast<unsigned long long>(sampler_statistics.misses));
+            if(ImGui::Button("dump device memory")) {
+                ResourceBudget::get().dump("resource_budget.json");
+            }
             ImGui::End();
+            ResourceBudget::get().draw_imgui();
             ImGui::Render();
 
             glfwPollEvents();
@@ -757,8 +782,8 @@ struct TiledForwardApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -769,8 +794,8 @@ struct TiledForwardApp : public App {
             work_groups_y = (size_y + (size_y % TILE_SIZE)) / TILE_SIZE;
             number_of_tiles = work_groups_x * work_groups_y;
 
-            device.destroy_buffer(frustums_buffer);
-            frustums_buffer = device.create_buffer(daxa::BufferInfo {
+            ResourceBudget::get().destroy_buffer(device, frustums_buffer);
+            frustums_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
                 .size = static_cast<u32>(sizeof(Frustum) * number_of_tiles),
                 .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
                 .name = "frustums buffer"
@@ -26,7 +26,7 @@ layout(location = 2) in f32vec3 in_normal;
 layout(location = 0) out f32vec4 out_color;
 
 void main() {
-    f32vec3 color = sample_texture(MATERIAL.albedo_image, in_uv).rgb;
+    f32vec3 color = sample_material(MATERIAL, MATERIAL_ALBEDO, in_uv).rgb;
     color *= 0.1;
 
     f32vec3 camera_position = deref(push.camera_info).position;
@@ -1,4 +1,5 @@
 #include "../app.hpp"
+#include "../resource_budget.hpp"
 #include <glm/glm.hpp>
 
 #include "shared.inl"
@@ -78,7 +79,7 @@ struct TriangleApp : public App {
     daxa::TaskGraph render_task_graph = {};
 
     TriangleApp() : App("Triangle Example") {
-        vertex_buffer = device.create_buffer(daxa::BufferInfo {
+        vertex_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::GEOMETRY, daxa::BufferInfo {
             .size = 3 * sizeof(Vertex),
             .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
             .name = "vertex buffer"
@@ -147,7 +148,7 @@ struct TriangleApp : public App {
     ~TriangleApp() {
         device.wait_idle();
         device.collect_garbage();
-        device.destroy_buffer(vertex_buffer);
+        ResourceBudget::get().destroy_buffer(device, vertex_buffer);
     }
 
     void render() {
@@ -0,0 +1,483 @@
+#include "upload_manager.hpp"
+#include "resource_budget.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    // covers texel sizes and the optimal buffer copy offset alignment of every desktop gpu
+    constexpr usize STAGING_ALIGNMENT = 16;
+
+    auto align_up(usize value, usize alignment) -> usize {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+void UploadStatistics::print() const {
+    std::cout << "uploaded " << static_cast<f64>(uploaded_bytes) / (1024.0 * 1024.0) << " MiB in " << batch_count << " batches"
+              << "\n  buffer copies " << buffer_copies << " image copies " << image_copies
+              << "\n  peak staging " << static_cast<f64>(peak_staging_bytes) / (1024.0 * 1024.0) << " MiB, " << overflow_buffers << " oversized uploads" << std::endl;
+}
+
+auto UploadFuture::is_ready() const -> bool {
+    return manager == nullptr || manager->get_completed_value() >= timeline_value;
+}
+
+void UploadFuture::wait() const {
+    if(manager != nullptr) {
+        manager->wait(timeline_value);
+    }
+}
+
+UploadManager::UploadManager(daxa::Device _device, const UploadManagerInfo& info) : device{_device}, name{info.name}, staging_size{align_up(std::max<usize>(info.staging_size, STAGING_ALIGNMENT), STAGING_ALIGNMENT)} {
+    timeline = device.create_timeline_semaphore({
+        .initial_value = 0,
+        .name = name + " timeline",
+    });
+
+    staging_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::STAGING, {
+        .size = static_cast<u32>(staging_size),
+        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE,
+        .name = name + " staging ring",
+    });
+
+    staging_address = device.get_host_address_as<std::byte>(staging_buffer);
+}
+
+UploadManager::~UploadManager() {
+    wait(flush().timeline_value);
+    ResourceBudget::get().destroy_buffer(device, staging_buffer);
+}
+
+auto UploadManager::upload_buffer(const BufferUploadInfo& info) -> UploadFuture {
+    std::unique_lock lock(mutex);
+    if(info.data.empty()) {
+        return UploadFuture{ this, last_submitted_value };
+    }
+
+    StagingAllocation allocation = allocate(lock, info.data.size());
+    std::memcpy(allocation.host_address, info.data.data(), info.data.size());
+
+    get_command_list().copy_buffer_to_buffer({
+        .src_buffer = allocation.buffer,
+        .src_offset = allocation.offset,
+        .dst_buffer = info.buffer,
+        .dst_offset = info.offset,
+        .size = info.data.size(),
+    });
+
+    statistics.uploaded_bytes += info.data.size();
+    statistics.buffer_copies++;
+    return UploadFuture{ this, next_timeline_value };
+}
+
+auto UploadManager::upload_image(const ImageUploadInfo& info) -> UploadFuture {
+    std::unique_lock lock(mutex);
+    if(info.data.empty()) {
+        return UploadFuture{ this, last_submitted_value };
+    }
+
+    StagingAllocation allocation = allocate(lock, info.data.size());
+    std::memcpy(allocation.host_address, info.data.data(), info.data.size());
+    record_image_upload(info, allocation.buffer, allocation.offset, info.data.size());
+    return UploadFuture{ this, next_timeline_value };
+}
+
+auto UploadManager::reserve(usize size) -> StagingReservation {
+    std::unique_lock lock(mutex);
+    StagingAllocation allocation = allocate(lock, std::max<usize>(size, 1), true);
+    return StagingReservation {
+        .buffer = allocation.buffer,
+        .offset = allocation.offset,
+        .memory = { allocation.host_address, size },
+        .overflow = allocation.buffer != staging_buffer,
+    };
+}
+
+auto UploadManager::upload_image(const ImageUploadInfo& info, const StagingReservation& staging) -> UploadFuture {
+    std::unique_lock lock(mutex);
+    unpin_locked(staging);
+    if(!staging.memory.empty()) {
+        record_image_upload(info, staging.buffer, staging.offset, staging.memory.size());
+    }
+    return UploadFuture{ this, next_timeline_value };
+}
+
+void UploadManager::release(const StagingReservation& staging) {
+    std::unique_lock lock(mutex);
+    unpin_locked(staging);
+}
+
+auto UploadManager::copy_image_to_layer(const ImageLayerCopyInfo& info) -> UploadFuture {
+    std::unique_lock lock(mutex);
+    const daxa::ImageInfo& src_info = device.info_image(info.src_image);
+    daxa::CommandList& cmd_list = get_command_list();
+
+    cmd_list.pipeline_barrier_image_transition({
+        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
+        .dst_access = daxa::AccessConsts::TRANSFER_READ,
+        .src_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
+        .dst_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
+        .image_slice = {
+            .base_mip_level = 0,
+            .level_count = src_info.mip_level_count,
+            .base_array_layer = 0,
+            .layer_count = 1,
+        },
+        .image_id = info.src_image,
+    });
+    cmd_list.pipeline_barrier_image_transition({
+        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
+        .dst_access = daxa::AccessConsts::TRANSFER_WRITE,
+        .src_layout = daxa::ImageLayout::UNDEFINED,
+        .dst_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+        .image_slice = {
+            .base_mip_level = 0,
+            .level_count = src_info.mip_level_count,
+            .base_array_layer = info.dst_layer,
+            .layer_count = 1,
+        },
+        .image_id = info.dst_image,
+    });
+
+    for(u32 level = 0; level < src_info.mip_level_count; level++) {
+        cmd_list.copy_image_to_image({
+            .src_image = info.src_image,
+            .src_image_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
+            .dst_image = info.dst_image,
+            .dst_image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+            .src_slice = {
+                .mip_level = level,
+                .base_array_layer = 0,
+                .layer_count = 1,
+            },
+            .src_offset = { 0, 0, 0 },
+            .dst_slice = {
+                .mip_level = level,
+                .base_array_layer = info.dst_layer,
+                .layer_count = 1,
+            },
+            .dst_offset = { 0, 0, 0 },
+            .extent = { std::max(1u, src_info.size.x >> level), std::max(1u, src_info.size.y >> level), 1 },
+        });
+    }
+
+    cmd_list.pipeline_barrier_image_transition({
+        .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+        .dst_access = daxa::AccessConsts::READ_WRITE,
+        .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+        .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
+        .image_slice = {
+            .base_mip_level = 0,
+            .level_count = src_info.mip_level_count,
+            .base_array_layer = info.dst_layer,
+            .layer_count = 1,
+        },
+        .image_id = info.dst_image,
+    });
+
+    statistics.image_copies++;
+    return UploadFuture{ this, next_timeline_value };
+}
+
+void UploadManager::unpin_locked(const StagingReservation& staging) {
+    auto region = std::find_if(regions.begin(), regions.end(), [&](const StagingRegion& candidate) {
+        return candidate.timeline_value == PENDING_TIMELINE_VALUE && candidate.overflow == staging.overflow && (staging.overflow || candidate.offset == staging.offset);
+    });
+    if(region == regions.end()) {
+        throw std::runtime_error("staging reservation was already uploaded: " + name);
+    }
+
+    // from here on the region goes away with the batch like every other one, so that batch has to exist even when
+    // nothing gets recorded into it
+    region->timeline_value = next_timeline_value;
+    daxa::CommandList& cmd_list = get_command_list();
+    if(staging.overflow) {
+        cmd_list.destroy_buffer_deferred(staging.buffer);
+    }
+    reservation_recorded.notify_all();
+}
+
+void UploadManager::record_image_upload(const ImageUploadInfo& info, daxa::BufferId buffer, usize offset, usize size) {
+    u32 mip_level_count = device.info_image(info.image).mip_level_count;
+    daxa::CommandList& cmd_list = get_command_list();
+
+    cmd_list.pipeline_barrier_image_transition({
+        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
+        .dst_access = daxa::AccessConsts::READ_WRITE,
+        .src_layout = daxa::ImageLayout::UNDEFINED,
+        .dst_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+        .image_slice = {
+            .base_mip_level = 0,
+            .level_count = mip_level_count,
+            .base_array_layer = 0,
+            .layer_count = 1,
+        },
+        .image_id = info.image,
+    });
+
+    u32 copied_level_count = std::max<u32>(1, std::min<u32>(static_cast<u32>(info.mip_offsets.size()), mip_level_count));
+    for(u32 level = 0; level < copied_level_count; level++) {
+        cmd_list.copy_buffer_to_image({
+            .buffer = buffer,
+            .buffer_offset = offset + (info.mip_offsets.empty() ? 0 : info.mip_offsets[level]),
+            .image = info.image,
+            .image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+            .image_slice = {
+                .mip_level = level,
+                .base_array_layer = 0,
+                .layer_count = 1,
+            },
+            .image_offset = { 0, 0, 0 },
+            .image_extent = { std::max(1u, info.size_x >> level), std::max(1u, info.size_y >> level), 1 }
+        });
+    }
+
+    if(info.generate_mips && info.mip_offsets.empty() && mip_level_count > 1) {
+        record_mip_chain(cmd_list, info, mip_level_count);
+    } else {
+        cmd_list.pipeline_barrier_image_transition({
+            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+            .dst_access = daxa::AccessConsts::READ_WRITE,
+            .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+            .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
+            .image_slice = {
+                .base_mip_level = 0,
+                .level_count = mip_level_count,
+                .base_array_layer = 0,
+                .layer_count = 1,
+            },
+            .image_id = info.image,
+        });
+    }
+
+    statistics.uploaded_bytes += size;
+    statistics.image_copies++;
+}
+
+auto UploadManager::flush() -> UploadFuture {
+    std::lock_guard lock(mutex);
+    return UploadFuture{ this, flush_locked() };
+}
+
+void UploadManager::wait(u64 timeline_value) {
+    {
+        std::lock_guard lock(mutex);
+        // waiting on the open batch would never return
+        if(timeline_value > last_submitted_value) {
+            flush_locked();
+        }
+    }
+
+    timeline.wait_for_value(timeline_value);
+
+    std::lock_guard lock(mutex);
+    retire_completed();
+}
+
+auto UploadManager::get_completed_value() const -> u64 {
+    return timeline.value();
+}
+
+auto UploadManager::get_statistics() const -> UploadStatistics {
+    std::lock_guard lock(mutex);
+    return statistics;
+}
+
+auto UploadManager::allocate(std::unique_lock<std::mutex>& lock, usize size, bool pending) -> StagingAllocation {
+    usize aligned_size = align_up(size, STAGING_ALIGNMENT);
+    u64 timeline_value = pending ? PENDING_TIMELINE_VALUE : next_timeline_value;
+
+    if(aligned_size > staging_size) {
+        // lives for a single batch and goes through destroy_buffer_deferred, so the budget doesnt count it
+        daxa::BufferId buffer = device.create_buffer({
+            .size = static_cast<u32>(size),
+            .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE,
+            .name = name + " oversized staging buffer",
+        });
+        // a reserved buffer has to live until its copy is recorded, it gets queued for destruction then
+        if(!pending) {
+            get_command_list().destroy_buffer_deferred(buffer);
+        }
+
+        regions.push_back({ .offset = 0, .size = aligned_size, .timeline_value = timeline_value, .overflow = true });
+        staging_bytes_in_use += aligned_size;
+        statistics.peak_staging_bytes = std::max(statistics.peak_staging_bytes, staging_bytes_in_use);
+        statistics.overflow_buffers++;
+
+        return StagingAllocation{ buffer, 0, device.get_host_address_as<std::byte>(buffer) };
+    }
+
+    while(true) {
+        retire_completed();
+
+        if(std::optional<usize> offset = try_allocate_from_ring(aligned_size)) {
+            regions.push_back({ .offset = offset.value(), .size = aligned_size, .timeline_value = timeline_value, .overflow = false });
+            ring_head = offset.value() + aligned_size;
+            staging_bytes_in_use += aligned_size;
+            statistics.peak_staging_bytes = std::max(statistics.peak_staging_bytes, staging_bytes_in_use);
+
+            return StagingAllocation{ staging_buffer, offset.value(), staging_address + offset.value() };
+        }
+
+        // the oldest region still gets written by another thread, nothing can be retired before it is recorded
+        if(regions.front().timeline_value == PENDING_TIMELINE_VALUE) {
+            reservation_recorded.wait(lock);
+            continue;
+        }
+
+        // the ring is full of work that is still in flight, submit it if it is ours and wait for the oldest batch
+        if(regions.front().timeline_value > last_submitted_value) {
+            flush_locked();
+        }
+        timeline.wait_for_value(regions.front().timeline_value);
+    }
+}
+
+auto UploadManager::try_allocate_from_ring(usize size) -> std::optional<usize> {
+    auto oldest = std::find_if(regions.begin(), regions.end(), [](const StagingRegion& region) { return !region.overflow; });
+    if(oldest == regions.end()) {
+        ring_head = 0;
+        return size <= staging_size ? std::optional<usize>{0} : std::nullopt;
+    }
+
+    // used space runs from the oldest live region to the head, possibly wrapping around the end
+    usize tail = oldest->offset;
+    if(ring_head > tail) {
+        if(staging_size - ring_head >= size) {
+            return ring_head;
+        }
+        if(tail > size) {
+            return 0;
+        }
+        return std::nullopt;
+    }
+
+    if(tail - ring_head > size) {
+        return ring_head;
+    }
+    return std::nullopt;
+}
+
+auto UploadManager::get_command_list() -> daxa::CommandList& {
+    if(!command_list.has_value()) {
+        command_list = device.create_command_list({ .name = name + " batch" });
+        // host writes are visible at submit, this only has to keep copies into live buffers (streamed texture
+        // table patches) behind earlier reads of them
+        command_list->pipeline_barrier({
+            .src_access = daxa::AccessConsts::READ_WRITE,
+            .dst_access = daxa::AccessConsts::TRANSFER_WRITE,
+        });
+    }
+    return command_list.value();
+}
+
+auto UploadManager::flush_locked() -> u64 {
+    if(!command_list.has_value()) {
+        return last_submitted_value;
+    }
+
+    command_list->pipeline_barrier({
+        .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+        .dst_access = daxa::AccessConsts::READ_WRITE,
+    });
+    command_list->complete();
+
+    u64 timeline_value = next_timeline_value++;
+    device.submit_commands({
+        .command_lists = { std::move(command_list.value()) },
+        .signal_timeline_semaphores = { { timeline, timeline_value } },
+    });
+
+    command_list.reset();
+    last_submitted_value = timeline_value;
+    statistics.batch_count++;
+    return timeline_value;
+}
+
+void UploadManager::retire_completed() {
+    u64 completed_value = timeline.value();
+    while(!regions.empty() && regions.front().timeline_value <= completed_value) {
+        staging_bytes_in_use -= regions.front().size;
+        regions.pop_front();
+    }
+}
+
+void UploadManager::record_mip_chain(daxa::CommandList& cmd_list, const ImageUploadInfo& info, u32 mip_level_count) {
+    std::array<i32, 3> mip_size = { static_cast<i32>(info.size_x), static_cast<i32>(info.size_y), 1 };
+
+    for(u32 i = 1; i < mip_level_count; i++) {
+        cmd_list.pipeline_barrier_image_transition({
+            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+            .dst_access = daxa::AccessConsts::BLIT_READ,
+            .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+            .dst_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
+            .image_slice = {
+                .base_mip_level = i - 1,
+                .level_count = 1,
+                .base_array_layer = 0,
+                .layer_count = 1,
+            },
+            .image_id = info.image,
+        });
+
+        std::array<i32, 3> next_mip_size = {
+            std::max<i32>(1, mip_size[0] / 2),
+            std::max<i32>(1, mip_size[1] / 2),
+            std::max<i32>(1, mip_size[2] / 2),
+        };
+
+        cmd_list.blit_image_to_image({
+            .src_image = info.image,
+            .src_image_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
+            .dst_image = info.image,
+            .dst_image_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+            .src_slice = {
+                .mip_level = i - 1,
+                .base_array_layer = 0,
+                .layer_count = 1,
+            },
+            .src_offsets = {{{0, 0, 0}, {mip_size[0], mip_size[1], mip_size[2]}}},
+            .dst_slice = {
+                .mip_level = i,
+                .base_array_layer = 0,
+                .layer_count = 1,
+            },
+            .dst_offsets = {{{0, 0, 0}, {next_mip_size[0], next_mip_size[1], next_mip_size[2]}}},
+            .filter = daxa::Filter::LINEAR,
+        });
+
+        cmd_list.pipeline_barrier_image_transition({
+            .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+            .dst_access = daxa::AccessConsts::BLIT_READ,
+            .src_layout = daxa::ImageLayout::TRANSFER_SRC_OPTIMAL,
+            .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
+            .image_slice = {
+                .base_mip_level = i - 1,
+                .level_count = 1,
+                .base_array_layer = 0,
+                .layer_count = 1,
+            },
+            .image_id = info.image,
+        });
+
+        mip_size = next_mip_size;
+    }
+
+    cmd_list.pipeline_barrier_image_transition({
+        .src_access = daxa::AccessConsts::TRANSFER_READ_WRITE,
+        .dst_access = daxa::AccessConsts::READ_WRITE,
+        .src_layout = daxa::ImageLayout::TRANSFER_DST_OPTIMAL,
+        .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
+        .image_slice = {
+            .base_mip_level = mip_level_count - 1,
+            .level_count = 1,
+            .base_array_layer = 0,
+            .layer_count = 1,
+        },
+        .image_id = info.image,
+    });
+}
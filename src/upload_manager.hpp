@@ -0,0 +1,148 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+
+struct UploadManagerInfo {
+    // uploads bigger than the ring get a staging buffer of their own
+    usize staging_size = 64 * 1024 * 1024;
+    std::string name = "upload manager";
+};
+
+struct UploadStatistics {
+    usize uploaded_bytes = 0;
+    usize peak_staging_bytes = 0;
+    u32 batch_count = 0;
+    u32 buffer_copies = 0;
+    u32 image_copies = 0;
+    u32 overflow_buffers = 0;
+
+    void print() const;
+};
+
+struct BufferUploadInfo {
+    daxa::BufferId buffer = {};
+    usize offset = 0;
+    std::span<const std::byte> data = {};
+};
+
+// tightly packed RGBA8 or block compressed texels of mip 0, the other levels get blitted from it when generate_mips is set.
+// with mip_offsets data holds a whole chain instead, every level starts at its offset and goes up in the same copy batch
+struct ImageUploadInfo {
+    daxa::ImageId image = {};
+    u32 size_x = 0;
+    u32 size_y = 0;
+    std::span<const std::byte> data = {};
+    bool generate_mips = true;
+    std::span<const usize> mip_offsets = {};
+};
+
+// gpu side copy of every level of src_image into one layer of dst_image, both have to match in format, size and level
+// count. src_image has to be READ_ONLY_OPTIMAL like everything uploaded through an UploadManager leaves it, it stays in
+// TRANSFER_SRC_OPTIMAL afterwards since packing is the last thing anyone does with it
+struct ImageLayerCopyInfo {
+    daxa::ImageId src_image = {};
+    daxa::ImageId dst_image = {};
+    u32 dst_layer = 0;
+};
+
+struct UploadManager;
+
+// staging memory handed out by reserve for a producer that writes straight into it, like a decoder. it stays pinned
+// until the upload recorded with it is done, so a thread has to record that upload before it uploads anything else
+struct StagingReservation {
+    daxa::BufferId buffer = {};
+    usize offset = 0;
+    std::span<std::byte> memory = {};
+    bool overflow = false;
+};
+
+// resolves once the batch the upload was recorded into finished on the gpu
+struct UploadFuture {
+    UploadManager* manager = nullptr;
+    u64 timeline_value = 0;
+
+    auto is_ready() const -> bool;
+    void wait() const;
+};
+
+// copies everything into one sub allocated staging ring and records the copies of many resources into a single
+// command list, flush submits that batch and signals a timeline semaphore so the ring space can be reused.
+// uploads can be recorded from any thread
+struct UploadManager {
+    UploadManager(daxa::Device device, const UploadManagerInfo& info = {});
+    ~UploadManager();
+
+    UploadManager(const UploadManager&) = delete;
+    auto operator=(const UploadManager&) -> UploadManager& = delete;
+
+    auto upload_buffer(const BufferUploadInfo& info) -> UploadFuture;
+    auto upload_image(const ImageUploadInfo& info) -> UploadFuture;
+
+    // the staging memory gets filled without holding the lock, info.data is ignored and the whole reservation is uploaded
+    auto reserve(usize size) -> StagingReservation;
+    auto upload_image(const ImageUploadInfo& info, const StagingReservation& staging) -> UploadFuture;
+    // gives a reservation back without uploading anything, for producers that failed halfway
+    void release(const StagingReservation& staging);
+    // takes no staging memory, recorded into the open batch after whatever uploaded src_image
+    auto copy_image_to_layer(const ImageLayerCopyInfo& info) -> UploadFuture;
+
+    // submits the open batch, the returned future covers everything recorded so far
+    auto flush() -> UploadFuture;
+    void wait(u64 timeline_value);
+    auto get_completed_value() const -> u64;
+
+    auto get_statistics() const -> UploadStatistics;
+
+private:
+    // regions of reservations that nothing has been recorded for yet, they block the ring from wrapping over them
+    static constexpr u64 PENDING_TIMELINE_VALUE = ~0ull;
+
+    struct StagingRegion {
+        usize offset;
+        usize size;
+        u64 timeline_value;
+        bool overflow;
+    };
+
+    struct StagingAllocation {
+        daxa::BufferId buffer;
+        usize offset;
+        std::byte* host_address;
+    };
+
+    auto allocate(std::unique_lock<std::mutex>& lock, usize size, bool pending = false) -> StagingAllocation;
+    auto try_allocate_from_ring(usize size) -> std::optional<usize>;
+    auto get_command_list() -> daxa::CommandList&;
+    auto flush_locked() -> u64;
+    void retire_completed();
+    void unpin_locked(const StagingReservation& staging);
+    void record_image_upload(const ImageUploadInfo& info, daxa::BufferId buffer, usize offset, usize size);
+    void record_mip_chain(daxa::CommandList& cmd_list, const ImageUploadInfo& info, u32 mip_level_count);
+
+    daxa::Device device = {};
+    daxa::TimelineSemaphore timeline = {};
+    std::string name = {};
+
+    daxa::BufferId staging_buffer = {};
+    std::byte* staging_address = nullptr;
+    usize staging_size = 0;
+    usize ring_head = 0;
+    std::deque<StagingRegion> regions = {};
+    usize staging_bytes_in_use = 0;
+
+    std::optional<daxa::CommandList> command_list = {};
+    u64 next_timeline_value = 1;
+    u64 last_submitted_value = 0;
+
+    UploadStatistics statistics = {};
+    mutable std::mutex mutex = {};
+    std::condition_variable reservation_recorded = {};
+};
@@ -0,0 +1,211 @@
+#include "vertex_quantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numbers>
+
+namespace {
+    auto length(f32vec3 v) -> f32 {
+        return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+    }
+
+    auto angle_between(f32vec3 a, f32vec3 b) -> f32 {
+        f32 lengths = length(a) * length(b);
+        if(lengths <= 1e-12f) {
+            return 0.0f;
+        }
+        f32 cosine = std::clamp((a.x * b.x + a.y * b.y + a.z * b.z) / lengths, -1.0f, 1.0f);
+        return std::acos(cosine) * 180.0f / std::numbers::pi_v<f32>;
+    }
+
+    auto sign_not_zero(f32 value) -> f32 {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    auto to_snorm16(f32 value) -> u32 {
+        return static_cast<u32>(static_cast<u16>(static_cast<i16>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f))));
+    }
+
+    auto from_snorm16(u32 value) -> f32 {
+        return std::max(static_cast<f32>(static_cast<i16>(static_cast<u16>(value))) / 32767.0f, -1.0f);
+    }
+
+    auto quantize_unorm16(f32 value, f32 min, f32 max) -> u32 {
+        f32 extent = max - min;
+        if(extent <= 0.0f) {
+            return 0;
+        }
+        return static_cast<u32>(std::round(std::clamp((value - min) / extent, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    auto dequantize_unorm16(u32 value, f32 min, f32 max) -> f32 {
+        return min + static_cast<f32>(value) / 65535.0f * (max - min);
+    }
+}
+
+void QuantizationError::merge(const QuantizationError& other) {
+    vertex_count += other.vertex_count;
+    max_position_error = std::max(max_position_error, other.max_position_error);
+    sum_position_error += other.sum_position_error;
+    max_normal_error = std::max(max_normal_error, other.max_normal_error);
+    sum_normal_error += other.sum_normal_error;
+    max_tangent_error = std::max(max_tangent_error, other.max_tangent_error);
+    sum_tangent_error += other.sum_tangent_error;
+    max_uv_error = std::max(max_uv_error, other.max_uv_error);
+    sum_uv_error += other.sum_uv_error;
+}
+
+void QuantizationError::print() const {
+    f64 count = static_cast<f64>(std::max<usize>(vertex_count, 1));
+    std::cout << "vertex quantization of " << vertex_count << " vertices (" << sizeof(Vertex) << " -> " << sizeof(PackedVertex) << " bytes)"
+              << "\n  position error max " << max_position_error << " mean " << sum_position_error / count
+              << "\n  normal error max " << max_normal_error << " deg mean " << sum_normal_error / count << " deg"
+              << "\n  tangent error max " << max_tangent_error << " deg mean " << sum_tangent_error / count << " deg"
+              << "\n  uv error max " << max_uv_error << " mean " << sum_uv_error / count << std::endl;
+}
+
+auto f32_to_f16(f32 value) -> u16 {
+    u32 bits = 0;
+    std::memcpy(&bits, &value, sizeof(f32));
+
+    u32 sign = (bits >> 16) & 0x8000;
+    u32 magnitude = bits & 0x7fffffff;
+
+    // nan and infinity
+    if(magnitude >= 0x7f800000) {
+        return static_cast<u16>(sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00));
+    }
+
+    // everything from 65520 upwards rounds to infinity
+    if(magnitude >= 0x477ff000) {
+        return static_cast<u16>(sign | 0x7c00);
+    }
+
+    // subnormal halfs, let the fpu do the rounding
+    if(magnitude < 0x38800000) {
+        f32 absolute = 0.0f;
+        std::memcpy(&absolute, &magnitude, sizeof(f32));
+        return static_cast<u16>(sign | static_cast<u32>(std::nearbyint(absolute * 16777216.0f)));
+    }
+
+    // rebias the exponent and round to nearest even on the 13 dropped mantissa bits
+    u32 result = (magnitude >> 13) - (112 << 10);
+    u32 rest = magnitude & 0x1fff;
+    if(rest > 0x1000 || (rest == 0x1000 && (result & 1) != 0)) {
+        result++;
+    }
+    return static_cast<u16>(sign | result);
+}
+
+auto f16_to_f32(u16 value) -> f32 {
+    u32 sign = static_cast<u32>(value & 0x8000) << 16;
+    u32 exponent = (value >> 10) & 0x1f;
+    u32 mantissa = value & 0x3ff;
+
+    if(exponent == 0) {
+        f32 result = std::ldexp(static_cast<f32>(mantissa), -24);
+        return sign != 0 ? -result : result;
+    }
+
+    u32 bits = 0;
+    if(exponent == 31) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    f32 result = 0.0f;
+    std::memcpy(&result, &bits, sizeof(f32));
+    return result;
+}
+
+auto encode_octahedral(f32vec3 direction) -> u32 {
+    f32 l1_norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if(l1_norm <= 0.0f) {
+        return 0;
+    }
+
+    f32 x = direction.x / l1_norm;
+    f32 y = direction.y / l1_norm;
+    if(direction.z < 0.0f) {
+        f32 folded_x = (1.0f - std::abs(y)) * sign_not_zero(x);
+        f32 folded_y = (1.0f - std::abs(x)) * sign_not_zero(y);
+        x = folded_x;
+        y = folded_y;
+    }
+
+    return to_snorm16(x) | (to_snorm16(y) << 16);
+}
+
+auto decode_octahedral(u32 encoded) -> f32vec3 {
+    f32 x = from_snorm16(encoded & 0xffff);
+    f32 y = from_snorm16(encoded >> 16);
+    f32 z = 1.0f - std::abs(x) - std::abs(y);
+    if(z < 0.0f) {
+        f32 unfolded_x = (1.0f - std::abs(y)) * sign_not_zero(x);
+        f32 unfolded_y = (1.0f - std::abs(x)) * sign_not_zero(y);
+        x = unfolded_x;
+        y = unfolded_y;
+    }
+
+    f32 l2_norm = length({x, y, z});
+    return { x / l2_norm, y / l2_norm, z / l2_norm };
+}
+
+auto pack_vertex(const Vertex& vertex, const Primitive& primitive) -> PackedVertex {
+    u32 quantized_x = quantize_unorm16(vertex.position.x, primitive.aabb_min.x, primitive.aabb_max.x);
+    u32 quantized_y = quantize_unorm16(vertex.position.y, primitive.aabb_min.y, primitive.aabb_max.y);
+    u32 quantized_z = quantize_unorm16(vertex.position.z, primitive.aabb_min.z, primitive.aabb_max.z);
+    u32 tangent_sign = vertex.tangent.w < 0.0f ? 1u : 0u;
+
+    return PackedVertex {
+        .position = { quantized_x | (quantized_y << 16), quantized_z | (tangent_sign << 16) },
+        .normal = encode_octahedral(vertex.normal),
+        .tangent = encode_octahedral({ vertex.tangent.x, vertex.tangent.y, vertex.tangent.z }),
+        .uv = static_cast<u32>(f32_to_f16(vertex.uv.x)) | (static_cast<u32>(f32_to_f16(vertex.uv.y)) << 16),
+    };
+}
+
+auto unpack_vertex(const PackedVertex& packed_vertex, const Primitive& primitive) -> Vertex {
+    f32vec3 tangent = decode_octahedral(packed_vertex.tangent);
+
+    return Vertex {
+        .position = {
+            dequantize_unorm16(packed_vertex.position.x & 0xffff, primitive.aabb_min.x, primitive.aabb_max.x),
+            dequantize_unorm16(packed_vertex.position.x >> 16, primitive.aabb_min.y, primitive.aabb_max.y),
+            dequantize_unorm16(packed_vertex.position.y & 0xffff, primitive.aabb_min.z, primitive.aabb_max.z),
+        },
+        .normal = decode_octahedral(packed_vertex.normal),
+        .uv = { f16_to_f32(static_cast<u16>(packed_vertex.uv & 0xffff)), f16_to_f32(static_cast<u16>(packed_vertex.uv >> 16)) },
+        .tangent = { tangent.x, tangent.y, tangent.z, (packed_vertex.position.y >> 16) != 0 ? -1.0f : 1.0f },
+    };
+}
+
+auto pack_primitive_vertices(std::span<const Vertex> vertices, const Primitive& primitive, std::span<PackedVertex> packed_vertices) -> QuantizationError {
+    QuantizationError error = {};
+
+    for(u32 i = primitive.first_vertex; i < primitive.first_vertex + primitive.vertex_count; i++) {
+        const Vertex& vertex = vertices[i];
+        packed_vertices[i] = pack_vertex(vertex, primitive);
+        Vertex decoded = unpack_vertex(packed_vertices[i], primitive);
+
+        f32 position_error = length({ decoded.position.x - vertex.position.x, decoded.position.y - vertex.position.y, decoded.position.z - vertex.position.z });
+        f32 normal_error = angle_between(decoded.normal, vertex.normal);
+        f32 tangent_error = angle_between({ decoded.tangent.x, decoded.tangent.y, decoded.tangent.z }, { vertex.tangent.x, vertex.tangent.y, vertex.tangent.z });
+        f32 uv_error = std::max(std::abs(decoded.uv.x - vertex.uv.x), std::abs(decoded.uv.y - vertex.uv.y));
+
+        error.max_position_error = std::max(error.max_position_error, position_error);
+        error.sum_position_error += position_error;
+        error.max_normal_error = std::max(error.max_normal_error, normal_error);
+        error.sum_normal_error += normal_error;
+        error.max_tangent_error = std::max(error.max_tangent_error, tangent_error);
+        error.sum_tangent_error += tangent_error;
+        error.max_uv_error = std::max(error.max_uv_error, uv_error);
+        error.sum_uv_error += uv_error;
+    }
+
+    error.vertex_count = primitive.vertex_count;
+    return error;
+}
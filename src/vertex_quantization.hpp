@@ -0,0 +1,36 @@
+#pragma once
+
+#include <daxa/daxa.hpp>
+using namespace daxa::types;
+
+#include "common.inl"
+
+#include <span>
+
+// error introduced by packing, positions are in model units and directions in degrees
+struct QuantizationError {
+    usize vertex_count = 0;
+    f32 max_position_error = 0.0f;
+    f64 sum_position_error = 0.0;
+    f32 max_normal_error = 0.0f;
+    f64 sum_normal_error = 0.0;
+    f32 max_tangent_error = 0.0f;
+    f64 sum_tangent_error = 0.0;
+    f32 max_uv_error = 0.0f;
+    f64 sum_uv_error = 0.0;
+
+    void merge(const QuantizationError& other);
+    void print() const;
+};
+
+auto f32_to_f16(f32 value) -> u16;
+auto f16_to_f32(u16 value) -> f32;
+
+auto encode_octahedral(f32vec3 direction) -> u32;
+auto decode_octahedral(u32 encoded) -> f32vec3;
+
+auto pack_vertex(const Vertex& vertex, const Primitive& primitive) -> PackedVertex;
+auto unpack_vertex(const PackedVertex& packed_vertex, const Primitive& primitive) -> Vertex;
+
+// packs the primitives vertex range of vertices into packed_vertices and measures what it cost
+auto pack_primitive_vertices(std::span<const Vertex> vertices, const Primitive& primitive, std::span<PackedVertex> packed_vertices) -> QuantizationError;
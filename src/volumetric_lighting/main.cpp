@@ -10,6 +10,8 @@
 #include "shared.inl"
 
 #include "../model.hpp"
+#include "../resource_budget.hpp"
+#include "../sampler_cache.hpp"
 
 #include <daxa/utils/imgui.hpp>
 #include <imgui.h>
@@ -305,7 +307,7 @@ struct VolumetricLightingApp : public App {
             .name = "shadow pipeline"
         }).value();
 
-        depth_image = device.create_image({
+        depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -318,7 +320,7 @@ struct VolumetricLightingApp : public App {
             .name = "task depth image"
         }};
 
-        albedo_image = device.create_image({
+        albedo_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = swapchain.get_format(),
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -330,7 +332,7 @@ struct VolumetricLightingApp : public App {
             .name = "task albedo image"
         }};
 
-        normal_image = device.create_image({
+        normal_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::R16G16B16A16_SFLOAT,
             .size = { size_x, size_y, 1 },
             .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -342,7 +344,7 @@ struct VolumetricLightingApp : public App {
             .name = "task normal image"
         }};
 
-        sampler_id = device.create_sampler({
+        sampler_id = SamplerCache::get().acquire(device, {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -359,7 +361,7 @@ struct VolumetricLightingApp : public App {
             .enable_unnormalized_coordinates = false,
         });
 
-        shadow_image = device.create_image({
+        shadow_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
             .format = daxa::Format::D32_SFLOAT,
             .size = {1024, 1024, 1},
             .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
@@ -372,7 +374,7 @@ struct VolumetricLightingApp : public App {
             .name = "task shadow image"
         }};
 
-        shadow_sampler = device.create_sampler(daxa::SamplerInfo {
+        shadow_sampler = SamplerCache::get().acquire(device, daxa::SamplerInfo {
             .magnification_filter = daxa::Filter::LINEAR,
             .minification_filter = daxa::Filter::LINEAR,
             .mipmap_filter = daxa::Filter::LINEAR,
@@ -390,13 +392,13 @@ struct VolumetricLightingApp : public App {
             .enable_unnormalized_coordinates = false,
         });
 
-        light_buffer = device.create_buffer(daxa::BufferInfo {
+        light_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(LightInfo),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "light buffer"
         });
 
-        matrices_buffer = device.create_buffer(daxa::BufferInfo {
+        matrices_buffer = ResourceBudget::get().create_buffer(device, ResourceCategory::OTHER, daxa::BufferInfo {
             .size = sizeof(MatricesBuffer),
             .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
             .name = "matrices buffer"
@@ -474,14 +476,14 @@ struct VolumetricLightingApp : public App {
     }
 
     ~VolumetricLightingApp() {
-        device.destroy_image(depth_image);
-        device.destroy_image(albedo_image);
-        device.destroy_image(normal_image);
-        device.destroy_sampler(sampler_id);
-        device.destroy_image(shadow_image);
-        device.destroy_sampler(shadow_sampler);
-        device.destroy_buffer(light_buffer);
-        device.destroy_buffer(matrices_buffer);
+        ResourceBudget::get().destroy_image(device, depth_image);
+        ResourceBudget::get().destroy_image(device, albedo_image);
+        ResourceBudget::get().destroy_image(device, normal_image);
+        SamplerCache::get().release(device, sampler_id);
+        ResourceBudget::get().destroy_image(device, shadow_image);
+        SamplerCache::get().release(device, shadow_sampler);
+        ResourceBudget::get().destroy_buffer(device, light_buffer);
+        ResourceBudget::get().destroy_buffer(device, matrices_buffer);
     }
 
     void render() {
@@ -586,24 +588,24 @@ struct VolumetricLightingApp : public App {
             size_x = swapchain.get_surface_extent().x;
             size_y = swapchain.get_surface_extent().y;
         
-            device.destroy_image(depth_image);
-            depth_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, depth_image);
+            depth_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::D32_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
             });
             task_depth_image.set_images({.images = std::span{&depth_image, 1}});
 
-            device.destroy_image(albedo_image);
-            albedo_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, albedo_image);
+            albedo_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = swapchain.get_format(),
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
             });
             task_albedo_image.set_images({.images = std::span{&albedo_image, 1}});
 
-            device.destroy_image(normal_image);
-            normal_image = device.create_image({
+            ResourceBudget::get().destroy_image(device, normal_image);
+            normal_image = ResourceBudget::get().create_image(device, ResourceCategory::RENDER_TARGET, {
                 .format = daxa::Format::R16G16B16A16_SFLOAT,
                 .size = { size_x, size_y, 1 },
                 .usage = daxa::ImageUsageFlagBits::COLOR_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,